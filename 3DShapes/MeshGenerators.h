@@ -0,0 +1,313 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgenerators.h
+// ============
+// generate the vertex and index data of the fixed resolution primitives
+// while compiling
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+/***********************************************************
+ *  STATIC_MESH
+ *
+ *  The data of a generated mesh, in the interleaved layout
+ *  of the ShapeMeshes - a position, a normal and a texture
+ *  coordinate per vertex.  A mesh without indices is drawn
+ *  as one triangle strip.
+ ***********************************************************/
+template<size_t VertexCount, size_t IndexCount>
+struct STATIC_MESH
+{
+	static constexpr size_t FLOATS_PER_VERTEX = 8;
+	static constexpr size_t VERTEX_COUNT = VertexCount;
+	static constexpr size_t INDEX_COUNT = IndexCount;
+
+	std::array<float, VertexCount * FLOATS_PER_VERTEX> vertices;
+	std::array<uint32_t, IndexCount> indices;
+
+	// true when every index points at one of the vertices
+	constexpr bool AreIndicesInRange() const
+	{
+		for (size_t i = 0; i < IndexCount; i++)
+		{
+			if (indices[i] >= VertexCount)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+/***********************************************************
+ *  MeshGenerators
+ *
+ *  This class contains the code for building the meshes
+ *  of the basic shapes at compile time.  Every generator
+ *  is consteval, so the meshes are constants of the
+ *  program instead of code that runs when they are loaded,
+ *  and the resolution is a template parameter.
+ *
+ *  The flat shapes are grids of quads, split into two
+ *  triangles along the same diagonal as the literal tables
+ *  they replace.  The sphere is a ring of slices for every
+ *  stack, with a seam where the texture wraps around.
+ ***********************************************************/
+class MeshGenerators
+{
+public:
+	// a corner of a flat triangle, position and texture coordinate
+	struct FLAT_CORNER
+	{
+		float x, y, z;
+		float u, v;
+	};
+
+	// a triangle with one normal for its three corners
+	struct FLAT_TRIANGLE
+	{
+		float normal[3];
+		FLAT_CORNER corners[3];
+	};
+
+	// the plane at y = 0 from -1 to 1, with a grid of divisions by
+	// divisions quads, facing up
+	template<int Divisions>
+	static consteval STATIC_MESH<(Divisions + 1) * (Divisions + 1), Divisions * Divisions * 6> GeneratePlane()
+	{
+		static_assert(Divisions > 0, "a plane needs at least one division");
+
+		STATIC_MESH<(Divisions + 1) * (Divisions + 1), Divisions * Divisions * 6> mesh = {};
+		const GRID_FACE face = { { -1.0f, 0.0f, 1.0f }, { 2.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -2.0f }, { 0.0f, 1.0f, 0.0f } };
+		AddGridFace(mesh, 0, 0, face, Divisions, true);
+		return mesh;
+	}
+
+	// the unit box around the origin, every face a grid of
+	// divisions by divisions quads with its own texture coordinates
+	template<int Divisions>
+	static consteval STATIC_MESH<6 * (Divisions + 1) * (Divisions + 1), 6 * Divisions * Divisions * 6> GenerateBox()
+	{
+		static_assert(Divisions > 0, "a box needs at least one division");
+
+		STATIC_MESH<6 * (Divisions + 1) * (Divisions + 1), 6 * Divisions * Divisions * 6> mesh = {};
+		// back, bottom, left, right, top and front - the faces are
+		// seen from the outside with the texture upright
+		const GRID_FACE faces[6] = {
+			{ {  0.5f, -0.5f, -0.5f }, { -1.0f, 0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f }, {  0.0f,  0.0f, -1.0f } },
+			{ { -0.5f, -0.5f, -0.5f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, 0.0f,  1.0f }, {  0.0f, -1.0f,  0.0f } },
+			{ { -0.5f, -0.5f, -0.5f }, {  0.0f, 0.0f,  1.0f }, { 0.0f, 1.0f,  0.0f }, { -1.0f,  0.0f,  0.0f } },
+			{ {  0.5f, -0.5f,  0.5f }, {  0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f,  0.0f }, {  1.0f,  0.0f,  0.0f } },
+			{ { -0.5f,  0.5f,  0.5f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, 0.0f, -1.0f }, {  0.0f,  1.0f,  0.0f } },
+			{ { -0.5f, -0.5f,  0.5f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f }, {  0.0f,  0.0f,  1.0f } } };
+		for (int i = 0; i < 6; i++)
+		{
+			AddGridFace(mesh, i * (Divisions + 1) * (Divisions + 1), i * Divisions * Divisions * 6, faces[i], Divisions, false);
+		}
+		return mesh;
+	}
+
+	// the unit sphere around the origin with a point at each pole,
+	// and a ring of slices + 1 vertices for each of the stacks - 1
+	// latitudes between them, the extra vertex closes the seam
+	template<int Slices, int Stacks>
+	static consteval STATIC_MESH<2 + (Stacks - 1) * (Slices + 1), 6 * (Slices + 1) * (Stacks - 1)> GenerateSphere()
+	{
+		// the seam is at the back, halfway around, and drawing the
+		// first half of the indices draws the upper hemisphere
+		static_assert((Slices >= 4) && (Slices % 2 == 0), "the slices of a sphere have to be an even number");
+		static_assert((Stacks >= 2) && (Stacks % 2 == 0), "the stacks of a sphere have to be an even number");
+
+		constexpr int ringSize = Slices + 1;
+		constexpr uint32_t bottom = 1 + (Stacks - 1) * ringSize;
+		STATIC_MESH<2 + (Stacks - 1) * (Slices + 1), 6 * (Slices + 1) * (Stacks - 1)> mesh = {};
+
+		SetVertex(mesh, 0, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f, 1.0f);
+		for (int ring = 1; ring < Stacks; ring++)
+		{
+			double latitude = PI * ring / Stacks;
+			double radius = Sine(latitude);
+			double y = Cosine(latitude);
+			float v = (float)(1.0 - ((double)ring / Stacks));
+			for (int offset = 0; offset < ringSize; offset++)
+			{
+				// the front half runs from +z over +x to the seam at -z,
+				// then the seam is repeated for the back half over -x -
+				// the texture is wrapped by how far around the ring the
+				// vertex is, scaled to the size of the ring
+				int slice = (offset <= Slices / 2) ? offset : (offset - 1);
+				double around = (offset <= Slices / 2) ? ((double)slice / (Slices / 2)) : -((double)(Slices - slice) / (Slices / 2));
+				double longitude = 2.0 * PI * slice / Slices;
+				float x = (float)(radius * Sine(longitude));
+				float z = (float)(radius * Cosine(longitude));
+				// the normal of a point on the unit sphere is the point
+				SetVertex(mesh, 1 + (ring - 1) * ringSize, x, (float)y, z, x, (float)y, z,
+					(float)(0.5 + (radius * 0.5 * around)), v, offset);
+			}
+		}
+		SetVertex(mesh, bottom, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.0f);
+
+		// the triangles go around every ring starting at the back half,
+		// and end with the one between the two seam vertices
+		size_t index = 0;
+		for (int i = 0; i < ringSize; i++)
+		{
+			mesh.indices[index++] = 0;
+			mesh.indices[index++] = 1 + RingOffset<Slices>(i);
+			mesh.indices[index++] = 1 + RingOffset<Slices>(i + 1);
+		}
+		for (int ring = 1; ring < Stacks - 1; ring++)
+		{
+			uint32_t upper = 1 + (ring - 1) * ringSize;
+			uint32_t lower = upper + ringSize;
+			for (int i = 0; i < ringSize; i++)
+			{
+				uint32_t current = RingOffset<Slices>(i);
+				uint32_t next = RingOffset<Slices>(i + 1);
+				mesh.indices[index++] = upper + current;
+				mesh.indices[index++] = lower + current;
+				mesh.indices[index++] = lower + next;
+				mesh.indices[index++] = upper + current;
+				mesh.indices[index++] = upper + next;
+				mesh.indices[index++] = lower + next;
+			}
+		}
+		uint32_t lastRing = 1 + (Stacks - 2) * ringSize;
+		for (int i = 0; i < ringSize; i++)
+		{
+			mesh.indices[index++] = lastRing + RingOffset<Slices>(i);
+			mesh.indices[index++] = bottom;
+			mesh.indices[index++] = lastRing + RingOffset<Slices>(i + 1);
+		}
+		return mesh;
+	}
+
+	// a triangle strip of separate flat triangles - every triangle
+	// is written as its corners and the first corner again, so the
+	// strip draws it from both sides
+	template<size_t TriangleCount>
+	static consteval STATIC_MESH<TriangleCount * 4, 0> GenerateFlatStrip(const FLAT_TRIANGLE (&triangles)[TriangleCount])
+	{
+		STATIC_MESH<TriangleCount * 4, 0> mesh = {};
+		for (size_t i = 0; i < TriangleCount; i++)
+		{
+			const FLAT_TRIANGLE& triangle = triangles[i];
+			for (int k = 0; k < 4; k++)
+			{
+				const FLAT_CORNER& corner = triangle.corners[k % 3];
+				SetVertex(mesh, i * 4, corner.x, corner.y, corner.z,
+					triangle.normal[0], triangle.normal[1], triangle.normal[2], corner.u, corner.v, k);
+			}
+		}
+		return mesh;
+	}
+
+private:
+	static constexpr double PI = 3.14159265358979323846;
+
+	// a face of a grid mesh, the position at the texture coordinate
+	// (0, 0) and the edges along u and v
+	struct GRID_FACE
+	{
+		float origin[3];
+		float uEdge[3];
+		float vEdge[3];
+		float normal[3];
+	};
+
+	// the sine and cosine as series, for the angles of the shapes
+	// between -2 pi and 2 pi
+	static constexpr double Sine(double angle)
+	{
+		while (angle > PI)
+		{
+			angle -= 2.0 * PI;
+		}
+		while (angle < -PI)
+		{
+			angle += 2.0 * PI;
+		}
+
+		double term = angle;
+		double sum = angle;
+		for (int n = 1; n < 30; n++)
+		{
+			term *= -(angle * angle) / ((2.0 * n) * ((2.0 * n) + 1.0));
+			sum += term;
+		}
+		return sum;
+	}
+	static constexpr double Cosine(double angle)
+	{
+		return Sine(angle + (PI / 2.0));
+	}
+
+	// the vertex of a ring at a step around it, where the steps
+	// start at the back half and wrap around
+	template<int Slices>
+	static constexpr uint32_t RingOffset(int step)
+	{
+		return (uint32_t)((step + (Slices / 2) + 1) % (Slices + 1));
+	}
+
+	template<typename MESH>
+	static constexpr void SetVertex(MESH& mesh, size_t first, float x, float y, float z,
+		float nx, float ny, float nz, float u, float v, size_t offset = 0)
+	{
+		size_t at = (first + offset) * MESH::FLOATS_PER_VERTEX;
+		mesh.vertices[at + 0] = x;
+		mesh.vertices[at + 1] = y;
+		mesh.vertices[at + 2] = z;
+		mesh.vertices[at + 3] = nx;
+		mesh.vertices[at + 4] = ny;
+		mesh.vertices[at + 5] = nz;
+		mesh.vertices[at + 6] = u;
+		mesh.vertices[at + 7] = v;
+	}
+
+	// add the vertices and the triangles of a face split into a
+	// grid, with the diagonal of the quads rising from (0, 0) to
+	// (1, 1) or falling from (0, 1) to (1, 0)
+	template<typename MESH>
+	static constexpr void AddGridFace(MESH& mesh, size_t firstVertex, size_t firstIndex,
+		const GRID_FACE& face, int divisions, bool bRisingDiagonal)
+	{
+		for (int j = 0; j <= divisions; j++)
+		{
+			for (int i = 0; i <= divisions; i++)
+			{
+				float u = (float)i / (float)divisions;
+				float v = (float)j / (float)divisions;
+				float position[3] = {};
+				for (int axis = 0; axis < 3; axis++)
+				{
+					position[axis] = face.origin[axis] + (face.uEdge[axis] * u) + (face.vEdge[axis] * v);
+				}
+				SetVertex(mesh, firstVertex, position[0], position[1], position[2],
+					face.normal[0], face.normal[1], face.normal[2], u, v, (j * (divisions + 1)) + i);
+			}
+		}
+
+		size_t index = firstIndex;
+		for (int j = 0; j < divisions; j++)
+		{
+			for (int i = 0; i < divisions; i++)
+			{
+				uint32_t bottomLeft = (uint32_t)(firstVertex + (j * (divisions + 1)) + i);
+				uint32_t bottomRight = bottomLeft + 1;
+				uint32_t topLeft = bottomLeft + (uint32_t)(divisions + 1);
+				uint32_t topRight = topLeft + 1;
+				const uint32_t rising[6] = { bottomLeft, bottomRight, topRight, bottomLeft, topLeft, topRight };
+				const uint32_t falling[6] = { topLeft, bottomLeft, bottomRight, topLeft, topRight, bottomRight };
+				for (int k = 0; k < 6; k++)
+				{
+					mesh.indices[index++] = bRisingDiagonal ? rising[k] : falling[k];
+				}
+			}
+		}
+	}
+};
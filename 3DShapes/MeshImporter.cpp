@@ -0,0 +1,1256 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.cpp
+// ============
+// import the triangles of OBJ and glTF 2.0 files into welded, indexed meshes
+// in the interleaved layout of the ShapeMeshes, and compile them into a
+// binary form that is loaded without parsing
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshImporter.h"
+#include "TraceRecorder.h"
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+
+// declaration of global variables
+namespace
+{
+	const char g_MeshMagic[4] = { 'M', 'S', 'H', 'B' };
+	const char g_GlbMagic[4] = { 'g', 'l', 'T', 'F' };
+	const uint32_t g_GlbJsonChunk = 0x4E4F534A;
+	const uint32_t g_GlbBinaryChunk = 0x004E4942;
+
+	// JSON values nested deeper than this are not read
+	const int g_MaxJsonDepth = 64;
+
+	static_assert(sizeof(ShapeMeshes::MESH_VERTEX) == 8 * sizeof(float), "the vertices are written as they are in memory");
+
+	// the hash of a run of bytes, FNV-1a
+	size_t HashBytes(const void* data, size_t size)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return (size_t)hash;
+	}
+
+	// the vertices are welded by the exact values of all of
+	// their attributes
+	struct VERTEX_HASH
+	{
+		size_t operator()(const ShapeMeshes::MESH_VERTEX& vertex) const
+		{
+			return HashBytes(&vertex, sizeof(vertex));
+		}
+	};
+	struct VERTEX_EQUAL
+	{
+		bool operator()(const ShapeMeshes::MESH_VERTEX& a, const ShapeMeshes::MESH_VERTEX& b) const
+		{
+			return memcmp(&a, &b, sizeof(a)) == 0;
+		}
+	};
+	typedef std::unordered_map<ShapeMeshes::MESH_VERTEX, uint32_t, VERTEX_HASH, VERTEX_EQUAL> VERTEX_MAP;
+
+	// get the index of a vertex, adding it to the mesh when no
+	// vertex with the same values was added before
+	uint32_t WeldVertex(MeshImporter::IMPORTED_MESH& mesh, VERTEX_MAP& welded, const ShapeMeshes::MESH_VERTEX& vertex)
+	{
+		std::pair<VERTEX_MAP::iterator, bool> result = welded.insert(std::make_pair(vertex, (uint32_t)mesh.vertices.size()));
+		if (result.second)
+		{
+			mesh.vertices.push_back(vertex);
+		}
+		return result.first->second;
+	}
+
+	// a corner of an OBJ face, the indices of its position,
+	// texture coordinate and normal, or -1 for none
+	struct OBJ_CORNER
+	{
+		int position;
+		int textureCoordinate;
+		int normal;
+
+		bool operator==(const OBJ_CORNER& other) const
+		{
+			return (position == other.position) && (textureCoordinate == other.textureCoordinate) && (normal == other.normal);
+		}
+	};
+	struct OBJ_CORNER_HASH
+	{
+		size_t operator()(const OBJ_CORNER& corner) const
+		{
+			return HashBytes(&corner, sizeof(corner));
+		}
+	};
+
+	// read the next whole line of a file, of any length
+	bool ReadLine(FILE* file, std::string& line)
+	{
+		line.clear();
+		char buffer[1024];
+		while (fgets(buffer, sizeof(buffer), file) != NULL)
+		{
+			line += buffer;
+			if (!line.empty() && (line[line.size() - 1] == '\n'))
+			{
+				break;
+			}
+		}
+		return !line.empty();
+	}
+
+	// read an OBJ index, which counts from one, or back from the
+	// end of the list when it is negative
+	bool ReadObjIndex(const char*& pText, int count, int& index)
+	{
+		char* pEnd = NULL;
+		long value = strtol(pText, &pEnd, 10);
+		if (pEnd == pText)
+		{
+			return false;
+		}
+		pText = pEnd;
+
+		index = (value > 0) ? (int)(value - 1) : (int)(count + value);
+		return (value != 0) && (index >= 0) && (index < count);
+	}
+
+	// a value of a glTF file
+	struct JSON_VALUE
+	{
+		enum VALUE_TYPE
+		{
+			JSON_NULL,
+			JSON_BOOLEAN,
+			JSON_NUMBER,
+			JSON_STRING,
+			JSON_ARRAY,
+			JSON_OBJECT
+		};
+
+		VALUE_TYPE type;
+		double number;
+		std::string text;
+		// the items of an array, or the values of an object
+		// with the key of each one
+		std::vector<JSON_VALUE> items;
+		std::vector<std::string> keys;
+
+		JSON_VALUE() : type(JSON_NULL), number(0.0) {}
+
+		const JSON_VALUE* Find(const char* key) const
+		{
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				if (keys[i] == key)
+				{
+					return &items[i];
+				}
+			}
+			return NULL;
+		}
+
+		// a member of an object, or an item of an array by index,
+		// as a number with a default for a missing one
+		double GetNumber(const char* key, double defaultValue) const
+		{
+			const JSON_VALUE* pValue = Find(key);
+			return ((NULL != pValue) && (pValue->type == JSON_NUMBER)) ? pValue->number : defaultValue;
+		}
+		const JSON_VALUE* GetItem(const char* key, double index) const
+		{
+			const JSON_VALUE* pArray = Find(key);
+			if ((NULL == pArray) || (pArray->type != JSON_ARRAY) || (index < 0.0) || (index >= (double)pArray->items.size()))
+			{
+				return NULL;
+			}
+			return &pArray->items[(size_t)index];
+		}
+	};
+
+	// the position of the parser in a JSON text
+	struct JSON_READER
+	{
+		const char* pText;
+		const char* pEnd;
+	};
+
+	void SkipJsonSpace(JSON_READER& reader)
+	{
+		while ((reader.pText < reader.pEnd) &&
+			((*reader.pText == ' ') || (*reader.pText == '\t') || (*reader.pText == '\r') || (*reader.pText == '\n')))
+		{
+			reader.pText++;
+		}
+	}
+
+	// true and past a word when the text continues with it
+	bool SkipJsonWord(JSON_READER& reader, const char* word)
+	{
+		size_t length = strlen(word);
+		if (((size_t)(reader.pEnd - reader.pText) >= length) && (strncmp(reader.pText, word, length) == 0))
+		{
+			reader.pText += length;
+			return true;
+		}
+		return false;
+	}
+
+	bool ReadJsonString(JSON_READER& reader, std::string& text)
+	{
+		// past the opening quote
+		reader.pText++;
+		while ((reader.pText < reader.pEnd) && (*reader.pText != '"'))
+		{
+			char c = *reader.pText++;
+			if (c != '\\')
+			{
+				text += c;
+				continue;
+			}
+			if (reader.pText >= reader.pEnd)
+			{
+				return false;
+			}
+
+			c = *reader.pText++;
+			switch (c)
+			{
+			case 'b': text += '\b'; break;
+			case 'f': text += '\f'; break;
+			case 'n': text += '\n'; break;
+			case 'r': text += '\r'; break;
+			case 't': text += '\t'; break;
+			case 'u':
+			{
+				// a character of the basic plane as UTF-8, the
+				// names in the files that are used are plain ASCII
+				if (reader.pEnd - reader.pText < 4)
+				{
+					return false;
+				}
+				char digits[5] = { reader.pText[0], reader.pText[1], reader.pText[2], reader.pText[3], '\0' };
+				unsigned long code = strtoul(digits, NULL, 16);
+				reader.pText += 4;
+				if (code < 0x80)
+				{
+					text += (char)code;
+				}
+				else if (code < 0x800)
+				{
+					text += (char)(0xC0 | (code >> 6));
+					text += (char)(0x80 | (code & 0x3F));
+				}
+				else
+				{
+					text += (char)(0xE0 | (code >> 12));
+					text += (char)(0x80 | ((code >> 6) & 0x3F));
+					text += (char)(0x80 | (code & 0x3F));
+				}
+				break;
+			}
+			default: text += c; break;
+			}
+		}
+
+		if (reader.pText >= reader.pEnd)
+		{
+			return false;
+		}
+		reader.pText++;
+		return true;
+	}
+
+	bool ReadJsonValue(JSON_READER& reader, JSON_VALUE& value, int depth)
+	{
+		SkipJsonSpace(reader);
+		if ((reader.pText >= reader.pEnd) || (depth > g_MaxJsonDepth))
+		{
+			return false;
+		}
+
+		char c = *reader.pText;
+		if ((c == '{') || (c == '['))
+		{
+			bool bObject = (c == '{');
+			char close = bObject ? '}' : ']';
+			value.type = bObject ? JSON_VALUE::JSON_OBJECT : JSON_VALUE::JSON_ARRAY;
+			reader.pText++;
+
+			SkipJsonSpace(reader);
+			if ((reader.pText < reader.pEnd) && (*reader.pText == close))
+			{
+				reader.pText++;
+				return true;
+			}
+
+			for (;;)
+			{
+				if (bObject)
+				{
+					SkipJsonSpace(reader);
+					std::string key;
+					if ((reader.pText >= reader.pEnd) || (*reader.pText != '"') || !ReadJsonString(reader, key))
+					{
+						return false;
+					}
+					SkipJsonSpace(reader);
+					if ((reader.pText >= reader.pEnd) || (*reader.pText != ':'))
+					{
+						return false;
+					}
+					reader.pText++;
+					value.keys.push_back(key);
+				}
+
+				value.items.push_back(JSON_VALUE());
+				if (!ReadJsonValue(reader, value.items.back(), depth + 1))
+				{
+					return false;
+				}
+
+				SkipJsonSpace(reader);
+				if (reader.pText >= reader.pEnd)
+				{
+					return false;
+				}
+				if (*reader.pText == ',')
+				{
+					reader.pText++;
+				}
+				else if (*reader.pText == close)
+				{
+					reader.pText++;
+					return true;
+				}
+				else
+				{
+					return false;
+				}
+			}
+		}
+
+		if (c == '"')
+		{
+			value.type = JSON_VALUE::JSON_STRING;
+			return ReadJsonString(reader, value.text);
+		}
+		if (SkipJsonWord(reader, "true") || SkipJsonWord(reader, "false"))
+		{
+			value.type = JSON_VALUE::JSON_BOOLEAN;
+			value.number = (reader.pText[-1] == 'e') && (reader.pText[-2] == 'u') ? 1.0 : 0.0;
+			return true;
+		}
+		if (SkipJsonWord(reader, "null"))
+		{
+			value.type = JSON_VALUE::JSON_NULL;
+			return true;
+		}
+
+		// the number is copied out, the text does not end with a zero
+		char digits[64];
+		size_t length = 0;
+		while ((reader.pText < reader.pEnd) && (length + 1 < sizeof(digits)) && (strchr("+-.0123456789eE", *reader.pText) != NULL))
+		{
+			digits[length++] = *reader.pText++;
+		}
+		digits[length] = '\0';
+
+		char* pEnd = NULL;
+		value.type = JSON_VALUE::JSON_NUMBER;
+		value.number = strtod(digits, &pEnd);
+		return (length > 0) && (*pEnd == '\0');
+	}
+
+	// decode the base64 data of a data URI
+	bool DecodeBase64(const std::string& text, size_t start, std::vector<uint8_t>& data)
+	{
+		unsigned int bits = 0;
+		int bitCount = 0;
+		for (size_t i = start; i < text.size(); i++)
+		{
+			char c = text[i];
+			int value;
+			if ((c >= 'A') && (c <= 'Z')) value = c - 'A';
+			else if ((c >= 'a') && (c <= 'z')) value = c - 'a' + 26;
+			else if ((c >= '0') && (c <= '9')) value = c - '0' + 52;
+			else if (c == '+') value = 62;
+			else if (c == '/') value = 63;
+			else if (c == '=') break;
+			else return false;
+
+			bits = (bits << 6) | (unsigned int)value;
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				data.push_back((uint8_t)(bits >> bitCount));
+			}
+		}
+		return true;
+	}
+
+	// read a whole file
+	bool ReadFile(const char* filename, std::vector<uint8_t>& data)
+	{
+		FILE* file = fopen(filename, "rb");
+		if (NULL == file)
+		{
+			return false;
+		}
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		data.resize((size > 0) ? (size_t)size : 0);
+		bool bRead = data.empty() || (fread(&data[0], 1, data.size(), file) == data.size());
+		fclose(file);
+		return bRead;
+	}
+
+	// the elements of a glTF accessor, read in place from its buffer
+	struct ACCESSOR_VIEW
+	{
+		const uint8_t* pData;
+		size_t stride;
+		size_t count;
+		int componentType;
+		int components;
+		bool bNormalized;
+	};
+
+	// the bytes of a component type
+	size_t GetComponentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case 5120: case 5121: return 1;		// byte, unsigned byte
+		case 5122: case 5123: return 2;		// short, unsigned short
+		case 5125: case 5126: return 4;		// unsigned int, float
+		}
+		return 0;
+	}
+
+	// find the data of an accessor, checking that every element
+	// is inside its buffer
+	bool GetAccessor(const JSON_VALUE& root, const std::vector<std::vector<uint8_t> >& buffers, double index, int components, ACCESSOR_VIEW& view)
+	{
+		const JSON_VALUE* pAccessor = root.GetItem("accessors", index);
+		if ((NULL == pAccessor) || (NULL != pAccessor->Find("sparse")))
+		{
+			return false;
+		}
+
+		const JSON_VALUE* pType = pAccessor->Find("type");
+		const char* typeNames[] = { "SCALAR", "VEC2", "VEC3", "VEC4" };
+		if ((NULL == pType) || (components < 1) || (components > 4) || (pType->text != typeNames[components - 1]))
+		{
+			return false;
+		}
+
+		const JSON_VALUE* pBufferView = root.GetItem("bufferViews", pAccessor->GetNumber("bufferView", -1.0));
+		if (NULL == pBufferView)
+		{
+			return false;
+		}
+		double bufferIndex = pBufferView->GetNumber("buffer", -1.0);
+		if ((bufferIndex < 0.0) || (bufferIndex >= (double)buffers.size()))
+		{
+			return false;
+		}
+		const std::vector<uint8_t>& buffer = buffers[(size_t)bufferIndex];
+
+		view.componentType = (int)pAccessor->GetNumber("componentType", 0.0);
+		view.components = components;
+		view.count = (size_t)std::max(pAccessor->GetNumber("count", 0.0), 0.0);
+		const JSON_VALUE* pNormalized = pAccessor->Find("normalized");
+		view.bNormalized = (NULL != pNormalized) && (pNormalized->number != 0.0);
+
+		size_t elementSize = GetComponentSize(view.componentType) * (size_t)components;
+		double viewOffset = pBufferView->GetNumber("byteOffset", 0.0);
+		double viewLength = pBufferView->GetNumber("byteLength", 0.0);
+		double accessorOffset = pAccessor->GetNumber("byteOffset", 0.0);
+		view.stride = (size_t)pBufferView->GetNumber("byteStride", (double)elementSize);
+		if ((elementSize == 0) || (view.stride < elementSize) || (viewOffset < 0.0) || (viewLength < 0.0) ||
+			(accessorOffset < 0.0) || (viewOffset + viewLength > (double)buffer.size()))
+		{
+			return false;
+		}
+
+		double lastByte = accessorOffset + ((view.count > 0) ? ((double)view.stride * (double)(view.count - 1) + (double)elementSize) : 0.0);
+		if (lastByte > viewLength)
+		{
+			return false;
+		}
+
+		view.pData = buffer.data() + (size_t)viewOffset + (size_t)accessorOffset;
+		return true;
+	}
+
+	// read a component of an element of an accessor as a float
+	float ReadComponent(const ACCESSOR_VIEW& view, size_t element, int component)
+	{
+		const uint8_t* pComponent = view.pData + (element * view.stride) + (component * GetComponentSize(view.componentType));
+		switch (view.componentType)
+		{
+		case 5120: { int8_t value; memcpy(&value, pComponent, 1); return view.bNormalized ? std::max(value / 127.0f, -1.0f) : (float)value; }
+		case 5121: { uint8_t value = *pComponent; return view.bNormalized ? (value / 255.0f) : (float)value; }
+		case 5122: { int16_t value; memcpy(&value, pComponent, 2); return view.bNormalized ? std::max(value / 32767.0f, -1.0f) : (float)value; }
+		case 5123: { uint16_t value; memcpy(&value, pComponent, 2); return view.bNormalized ? (value / 65535.0f) : (float)value; }
+		case 5125: { uint32_t value; memcpy(&value, pComponent, 4); return (float)value; }
+		default: { float value; memcpy(&value, pComponent, 4); return value; }
+		}
+	}
+
+	// read an index of an accessor, which has to be unsigned
+	uint32_t ReadIndex(const ACCESSOR_VIEW& view, size_t element)
+	{
+		const uint8_t* pIndex = view.pData + (element * view.stride);
+		switch (view.componentType)
+		{
+		case 5121: return *pIndex;
+		case 5123: { uint16_t value; memcpy(&value, pIndex, 2); return value; }
+		default: { uint32_t value; memcpy(&value, pIndex, 4); return value; }
+		}
+	}
+
+	// the local transformation of a glTF node
+	glm::mat4 GetNodeMatrix(const JSON_VALUE& node)
+	{
+		const JSON_VALUE* pMatrix = node.Find("matrix");
+		if ((NULL != pMatrix) && (pMatrix->items.size() == 16))
+		{
+			glm::mat4 matrix;
+			for (int i = 0; i < 16; i++)
+			{
+				matrix[i / 4][i % 4] = (float)pMatrix->items[i].number;
+			}
+			return matrix;
+		}
+
+		glm::vec3 translation(0.0f);
+		glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 scale(1.0f);
+		const JSON_VALUE* pValue = node.Find("translation");
+		if ((NULL != pValue) && (pValue->items.size() == 3))
+		{
+			translation = glm::vec3((float)pValue->items[0].number, (float)pValue->items[1].number, (float)pValue->items[2].number);
+		}
+		pValue = node.Find("rotation");
+		if ((NULL != pValue) && (pValue->items.size() == 4))
+		{
+			// stored as x, y, z, w
+			rotation = glm::quat((float)pValue->items[3].number, (float)pValue->items[0].number, (float)pValue->items[1].number, (float)pValue->items[2].number);
+		}
+		pValue = node.Find("scale");
+		if ((NULL != pValue) && (pValue->items.size() == 3))
+		{
+			scale = glm::vec3((float)pValue->items[0].number, (float)pValue->items[1].number, (float)pValue->items[2].number);
+		}
+
+		glm::mat3 linear = glm::mat3_cast(rotation);
+		return glm::mat4(
+			glm::vec4(linear[0] * scale.x, 0.0f),
+			glm::vec4(linear[1] * scale.y, 0.0f),
+			glm::vec4(linear[2] * scale.z, 0.0f),
+			glm::vec4(translation, 1.0f));
+	}
+
+	// add the triangle primitives of a glTF mesh, placed in the
+	// model by a node - returns false for a damaged primitive,
+	// and counts the ones that are not triangles
+	bool ImportGltfMesh(const JSON_VALUE& root, const std::vector<std::vector<uint8_t> >& buffers, const JSON_VALUE& gltfMesh,
+		const glm::mat4& world, MeshImporter::IMPORTED_MESH& mesh, VERTEX_MAP& welded, int& skipped)
+	{
+		const JSON_VALUE* pPrimitives = gltfMesh.Find("primitives");
+		if (NULL == pPrimitives)
+		{
+			return true;
+		}
+
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(world)));
+		// a mirroring node turns the triangles around
+		bool bMirrored = glm::determinant(glm::mat3(world)) < 0.0f;
+
+		for (size_t p = 0; p < pPrimitives->items.size(); p++)
+		{
+			const JSON_VALUE& primitive = pPrimitives->items[p];
+			const JSON_VALUE* pAttributes = primitive.Find("attributes");
+			if ((primitive.GetNumber("mode", 4.0) != 4.0) || (NULL == pAttributes))
+			{
+				skipped++;
+				continue;
+			}
+
+			ACCESSOR_VIEW positions;
+			ACCESSOR_VIEW normals;
+			ACCESSOR_VIEW textureCoordinates;
+			ACCESSOR_VIEW indices;
+			if (!GetAccessor(root, buffers, pAttributes->GetNumber("POSITION", -1.0), 3, positions))
+			{
+				return false;
+			}
+			bool bNormals = (NULL != pAttributes->Find("NORMAL"));
+			bool bTextureCoordinates = (NULL != pAttributes->Find("TEXCOORD_0"));
+			bool bIndices = (NULL != primitive.Find("indices"));
+			if ((bNormals && (!GetAccessor(root, buffers, pAttributes->GetNumber("NORMAL", -1.0), 3, normals) || (normals.count < positions.count))) ||
+				(bTextureCoordinates && (!GetAccessor(root, buffers, pAttributes->GetNumber("TEXCOORD_0", -1.0), 2, textureCoordinates) || (textureCoordinates.count < positions.count))) ||
+				(bIndices && (!GetAccessor(root, buffers, primitive.GetNumber("indices", -1.0), 1, indices) ||
+					((indices.componentType != 5121) && (indices.componentType != 5123) && (indices.componentType != 5125)))))
+			{
+				return false;
+			}
+
+			size_t cornerCount = bIndices ? indices.count : positions.count;
+			for (size_t corner = 0; corner + 2 < cornerCount; corner += 3)
+			{
+				uint32_t triangle[3];
+				for (int k = 0; k < 3; k++)
+				{
+					size_t element = bIndices ? ReadIndex(indices, corner + k) : (corner + k);
+					if (element >= positions.count)
+					{
+						return false;
+					}
+
+					ShapeMeshes::MESH_VERTEX vertex;
+					glm::vec3 position(ReadComponent(positions, element, 0), ReadComponent(positions, element, 1), ReadComponent(positions, element, 2));
+					vertex.position = glm::vec3(world * glm::vec4(position, 1.0f));
+					vertex.normal = glm::vec3(0.0f);
+					if (bNormals)
+					{
+						glm::vec3 normal(ReadComponent(normals, element, 0), ReadComponent(normals, element, 1), ReadComponent(normals, element, 2));
+						normal = normalMatrix * normal;
+						float length = glm::length(normal);
+						vertex.normal = (length > 0.0f) ? (normal / length) : normal;
+					}
+					vertex.textureCoordinate = glm::vec2(0.0f);
+					if (bTextureCoordinates)
+					{
+						// glTF starts the texture at the top
+						vertex.textureCoordinate = glm::vec2(ReadComponent(textureCoordinates, element, 0), 1.0f - ReadComponent(textureCoordinates, element, 1));
+					}
+					triangle[k] = WeldVertex(mesh, welded, vertex);
+				}
+
+				mesh.indices.push_back(triangle[0]);
+				mesh.indices.push_back(triangle[bMirrored ? 2 : 1]);
+				mesh.indices.push_back(triangle[bMirrored ? 1 : 2]);
+			}
+		}
+
+		return true;
+	}
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used to load a mesh file of any of the
+ *  supported formats.  The compiled meshes and the .glb
+ *  files are found by their first bytes, the others by
+ *  their extension.
+ ***********************************************************/
+bool MeshImporter::Load(const char* filename, IMPORTED_MESH& mesh)
+{
+	FILE* file = fopen(filename, "rb");
+	if (NULL == file)
+	{
+		printf("Unable to read mesh %s\n", filename);
+		return false;
+	}
+	char magic[4] = { 0, 0, 0, 0 };
+	size_t magicSize = fread(magic, 1, sizeof(magic), file);
+	fclose(file);
+
+	std::string extension(filename);
+	size_t dot = extension.find_last_of('.');
+	extension = (dot != std::string::npos) ? extension.substr(dot) : std::string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+
+	if ((magicSize == sizeof(magic)) && (memcmp(magic, g_MeshMagic, sizeof(magic)) == 0))
+	{
+		return LoadCompiled(filename, mesh);
+	}
+	if (((magicSize == sizeof(magic)) && (memcmp(magic, g_GlbMagic, sizeof(magic)) == 0)) || (extension == ".gltf"))
+	{
+		return ImportGLTF(filename, mesh);
+	}
+	if (extension == ".obj")
+	{
+		return ImportOBJ(filename, mesh);
+	}
+
+	printf("%s is not a compiled mesh, an OBJ or a glTF file\n", filename);
+	return false;
+}
+
+/***********************************************************
+ *  ImportOBJ()
+ *
+ *  This method is used to import the faces of an OBJ file.
+ *  The lines are read one at a time, and every corner of a
+ *  face is added to the mesh the first time its indices
+ *  are used.  The materials and the groups are left out.
+ ***********************************************************/
+bool MeshImporter::ImportOBJ(const char* filename, IMPORTED_MESH& mesh)
+{
+	TRACE_SCOPE("ImportOBJ", filename);
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	FILE* file = fopen(filename, "r");
+	if (NULL == file)
+	{
+		printf("Unable to read mesh %s\n", filename);
+		return false;
+	}
+
+	// the attributes that the faces point into
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> textureCoordinates;
+	std::unordered_map<OBJ_CORNER, uint32_t, OBJ_CORNER_HASH> welded;
+
+	std::string line;
+	int lineNumber = 0;
+	bool bValid = true;
+	while (bValid && ReadLine(file, line))
+	{
+		lineNumber++;
+		const char* pText = line.c_str();
+		while ((*pText == ' ') || (*pText == '\t'))
+		{
+			pText++;
+		}
+
+		if ((pText[0] == 'v') && ((pText[1] == ' ') || (pText[1] == '\t')))
+		{
+			glm::vec3 position;
+			char* pEnd = (char*)pText + 1;
+			for (int i = 0; i < 3; i++)
+			{
+				const char* pStart = pEnd;
+				position[i] = strtof(pStart, &pEnd);
+				bValid = bValid && (pEnd != pStart);
+			}
+			positions.push_back(position);
+		}
+		else if ((pText[0] == 'v') && (pText[1] == 'n'))
+		{
+			glm::vec3 normal;
+			char* pEnd = (char*)pText + 2;
+			for (int i = 0; i < 3; i++)
+			{
+				const char* pStart = pEnd;
+				normal[i] = strtof(pStart, &pEnd);
+				bValid = bValid && (pEnd != pStart);
+			}
+			float length = glm::length(normal);
+			normals.push_back((length > 0.0f) ? (normal / length) : normal);
+		}
+		else if ((pText[0] == 'v') && (pText[1] == 't'))
+		{
+			glm::vec2 textureCoordinate;
+			char* pEnd = (char*)pText + 2;
+			for (int i = 0; i < 2; i++)
+			{
+				const char* pStart = pEnd;
+				textureCoordinate[i] = strtof(pStart, &pEnd);
+				bValid = bValid && (pEnd != pStart);
+			}
+			textureCoordinates.push_back(textureCoordinate);
+		}
+		else if ((pText[0] == 'f') && ((pText[1] == ' ') || (pText[1] == '\t')))
+		{
+			// the face is split into a fan around its first corner
+			pText++;
+			uint32_t first = 0;
+			uint32_t previous = 0;
+			int cornerCount = 0;
+			for (;;)
+			{
+				while ((*pText == ' ') || (*pText == '\t') || (*pText == '\r') || (*pText == '\n'))
+				{
+					pText++;
+				}
+				if (*pText == '\0')
+				{
+					break;
+				}
+
+				OBJ_CORNER corner = { -1, -1, -1 };
+				bValid = ReadObjIndex(pText, (int)positions.size(), corner.position);
+				if (bValid && (*pText == '/'))
+				{
+					pText++;
+					if (*pText != '/')
+					{
+						bValid = ReadObjIndex(pText, (int)textureCoordinates.size(), corner.textureCoordinate);
+					}
+					if (bValid && (*pText == '/'))
+					{
+						pText++;
+						bValid = ReadObjIndex(pText, (int)normals.size(), corner.normal);
+					}
+				}
+				if (!bValid)
+				{
+					break;
+				}
+
+				std::unordered_map<OBJ_CORNER, uint32_t, OBJ_CORNER_HASH>::const_iterator found = welded.find(corner);
+				uint32_t index;
+				if (found != welded.end())
+				{
+					index = found->second;
+				}
+				else
+				{
+					ShapeMeshes::MESH_VERTEX vertex;
+					vertex.position = positions[corner.position];
+					vertex.normal = (corner.normal >= 0) ? normals[corner.normal] : glm::vec3(0.0f);
+					vertex.textureCoordinate = (corner.textureCoordinate >= 0) ? textureCoordinates[corner.textureCoordinate] : glm::vec2(0.0f);
+					index = (uint32_t)mesh.vertices.size();
+					mesh.vertices.push_back(vertex);
+					welded[corner] = index;
+				}
+
+				if (cornerCount == 0)
+				{
+					first = index;
+				}
+				else if (cornerCount >= 2)
+				{
+					mesh.indices.push_back(first);
+					mesh.indices.push_back(previous);
+					mesh.indices.push_back(index);
+				}
+				previous = index;
+				cornerCount++;
+			}
+		}
+	}
+	fclose(file);
+
+	if (!bValid)
+	{
+		printf("%s(%d): the line is not a valid vertex or face\n", filename, lineNumber);
+		return false;
+	}
+
+	GenerateNormals(mesh);
+	CalculateBounds(mesh);
+	printf("Successfully imported mesh:%s, vertices:%d, triangles:%d\n", filename, (int)mesh.vertices.size(), (int)(mesh.indices.size() / 3));
+	return true;
+}
+
+/***********************************************************
+ *  ImportGLTF()
+ *
+ *  This method is used to import the triangles of the
+ *  meshes of the default scene of a glTF 2.0 file, with
+ *  the transformations of their nodes applied.  The other
+ *  primitive modes, the skins and the morph targets are
+ *  left out.
+ ***********************************************************/
+bool MeshImporter::ImportGLTF(const char* filename, IMPORTED_MESH& mesh)
+{
+	TRACE_SCOPE("ImportGLTF", filename);
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	std::vector<uint8_t> file;
+	if (!ReadFile(filename, file))
+	{
+		printf("Unable to read mesh %s\n", filename);
+		return false;
+	}
+
+	// a .glb file is a header, a JSON chunk and a binary chunk
+	// that the first buffer without a URI refers to
+	const char* pJson = (const char*)file.data();
+	size_t jsonLength = file.size();
+	std::vector<uint8_t> binaryChunk;
+	if ((file.size() >= 12) && (memcmp(file.data(), g_GlbMagic, sizeof(g_GlbMagic)) == 0))
+	{
+		jsonLength = 0;
+		size_t offset = 12;
+		while (offset + 8 <= file.size())
+		{
+			uint32_t chunk[2];
+			memcpy(chunk, &file[offset], sizeof(chunk));
+			if (chunk[0] > file.size() - offset - 8)
+			{
+				break;
+			}
+			if ((chunk[1] == g_GlbJsonChunk) && (jsonLength == 0))
+			{
+				pJson = (const char*)&file[offset + 8];
+				jsonLength = chunk[0];
+			}
+			else if ((chunk[1] == g_GlbBinaryChunk) && binaryChunk.empty())
+			{
+				binaryChunk.assign(file.begin() + offset + 8, file.begin() + offset + 8 + chunk[0]);
+			}
+			offset += 8 + chunk[0];
+		}
+	}
+
+	JSON_VALUE root;
+	JSON_READER reader = { pJson, pJson + jsonLength };
+	if ((jsonLength == 0) || !ReadJsonValue(reader, root, 0) || (root.type != JSON_VALUE::JSON_OBJECT))
+	{
+		printf("%s is not a valid glTF file\n", filename);
+		return false;
+	}
+
+	// the buffers are embedded, in the binary chunk, or files
+	// next to the glTF file
+	std::string directory(filename);
+	size_t separator = directory.find_last_of("/\\");
+	directory = (separator != std::string::npos) ? directory.substr(0, separator + 1) : std::string();
+
+	std::vector<std::vector<uint8_t> > buffers;
+	const JSON_VALUE* pBuffers = root.Find("buffers");
+	for (size_t i = 0; (NULL != pBuffers) && (i < pBuffers->items.size()); i++)
+	{
+		const JSON_VALUE& buffer = pBuffers->items[i];
+		const JSON_VALUE* pUri = buffer.Find("uri");
+		buffers.push_back(std::vector<uint8_t>());
+
+		bool bLoaded;
+		if (NULL == pUri)
+		{
+			buffers.back().swap(binaryChunk);
+			bLoaded = true;
+		}
+		else if (pUri->text.compare(0, 5, "data:") == 0)
+		{
+			size_t comma = pUri->text.find(";base64,");
+			bLoaded = (comma != std::string::npos) && DecodeBase64(pUri->text, comma + 8, buffers.back());
+		}
+		else
+		{
+			bLoaded = ReadFile((directory + pUri->text).c_str(), buffers.back());
+		}
+
+		if (!bLoaded || ((double)buffers.back().size() < buffer.GetNumber("byteLength", 0.0)))
+		{
+			printf("Unable to read buffer %d of %s\n", (int)i, filename);
+			return false;
+		}
+	}
+
+	// the nodes of the default scene are walked from their roots,
+	// or every mesh is imported once without a scene
+	VERTEX_MAP welded;
+	int skipped = 0;
+	bool bValid = true;
+	const JSON_VALUE* pScene = root.GetItem("scenes", root.GetNumber("scene", 0.0));
+	const JSON_VALUE* pNodes = root.Find("nodes");
+	if ((NULL != pScene) && (NULL != pNodes))
+	{
+		const JSON_VALUE* pRoots = pScene->Find("nodes");
+		std::vector<std::pair<double, glm::mat4> > stack;
+		for (size_t i = 0; (NULL != pRoots) && (i < pRoots->items.size()); i++)
+		{
+			stack.push_back(std::make_pair(pRoots->items[i].number, glm::mat4(1.0f)));
+		}
+
+		// the node tree has no cycles, so no node is visited more
+		// often than there are nodes
+		size_t visits = 0;
+		while (bValid && !stack.empty())
+		{
+			std::pair<double, glm::mat4> entry = stack.back();
+			stack.pop_back();
+			const JSON_VALUE* pNode = root.GetItem("nodes", entry.first);
+			if ((NULL == pNode) || (++visits > pNodes->items.size()))
+			{
+				bValid = false;
+				break;
+			}
+
+			glm::mat4 world = entry.second * GetNodeMatrix(*pNode);
+			const JSON_VALUE* pMesh = root.GetItem("meshes", pNode->GetNumber("mesh", -1.0));
+			if (NULL != pMesh)
+			{
+				bValid = ImportGltfMesh(root, buffers, *pMesh, world, mesh, welded, skipped);
+			}
+
+			const JSON_VALUE* pChildren = pNode->Find("children");
+			for (size_t i = 0; (NULL != pChildren) && (i < pChildren->items.size()); i++)
+			{
+				stack.push_back(std::make_pair(pChildren->items[i].number, world));
+			}
+		}
+	}
+	else
+	{
+		const JSON_VALUE* pMeshes = root.Find("meshes");
+		for (size_t i = 0; bValid && (NULL != pMeshes) && (i < pMeshes->items.size()); i++)
+		{
+			bValid = ImportGltfMesh(root, buffers, pMeshes->items[i], glm::mat4(1.0f), mesh, welded, skipped);
+		}
+	}
+
+	if (!bValid)
+	{
+		printf("%s has a node, accessor or primitive that cannot be read\n", filename);
+		return false;
+	}
+	if (skipped > 0)
+	{
+		printf("INFO: %d primitives of %s are not triangles, they are left out\n", skipped, filename);
+	}
+
+	GenerateNormals(mesh);
+	CalculateBounds(mesh);
+	printf("Successfully imported mesh:%s, vertices:%d, triangles:%d\n", filename, (int)mesh.vertices.size(), (int)(mesh.indices.size() / 3));
+	return true;
+}
+
+/***********************************************************
+ *  GenerateNormals()
+ *
+ *  This method is used to make the normals that a file did
+ *  not have, which are left at zero by the importers.  The
+ *  triangles around a position add their normals weighted
+ *  by their area, so the vertices at the same position are
+ *  smooth across the seams of the texture.
+ ***********************************************************/
+void MeshImporter::GenerateNormals(IMPORTED_MESH& mesh)
+{
+	std::vector<bool> bMissing(mesh.vertices.size());
+	bool bAnyMissing = false;
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		bMissing[i] = (mesh.vertices[i].normal == glm::vec3(0.0f));
+		bAnyMissing = bAnyMissing || bMissing[i];
+	}
+	if (!bAnyMissing)
+	{
+		return;
+	}
+
+	// one sum for every position of the vertices without normals
+	struct POSITION_HASH
+	{
+		size_t operator()(const glm::vec3& position) const
+		{
+			return HashBytes(&position, sizeof(position));
+		}
+	};
+	std::unordered_map<glm::vec3, size_t, POSITION_HASH> sumIndices;
+	std::vector<size_t> vertexSums(mesh.vertices.size(), 0);
+	std::vector<glm::vec3> sums;
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		if (bMissing[i])
+		{
+			std::pair<std::unordered_map<glm::vec3, size_t, POSITION_HASH>::iterator, bool> result =
+				sumIndices.insert(std::make_pair(mesh.vertices[i].position, sums.size()));
+			if (result.second)
+			{
+				sums.push_back(glm::vec3(0.0f));
+			}
+			vertexSums[i] = result.first->second;
+		}
+	}
+
+	// the cross product is twice the area of the triangle
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		const uint32_t* corners = &mesh.indices[i];
+		glm::vec3 normal = glm::cross(
+			mesh.vertices[corners[1]].position - mesh.vertices[corners[0]].position,
+			mesh.vertices[corners[2]].position - mesh.vertices[corners[0]].position);
+		for (int k = 0; k < 3; k++)
+		{
+			if (bMissing[corners[k]])
+			{
+				sums[vertexSums[corners[k]]] += normal;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		if (bMissing[i])
+		{
+			glm::vec3 sum = sums[vertexSums[i]];
+			float length = glm::length(sum);
+			mesh.vertices[i].normal = (length > 0.0f) ? (sum / length) : glm::vec3(0.0f, 1.0f, 0.0f);
+		}
+	}
+}
+
+/***********************************************************
+ *  CalculateBounds()
+ *
+ *  This method is used to set the box around the vertices
+ *  of a mesh.
+ ***********************************************************/
+void MeshImporter::CalculateBounds(IMPORTED_MESH& mesh)
+{
+	mesh.boundsMin = glm::vec3(0.0f);
+	mesh.boundsMax = glm::vec3(0.0f);
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		mesh.boundsMin = (i == 0) ? mesh.vertices[i].position : glm::min(mesh.boundsMin, mesh.vertices[i].position);
+		mesh.boundsMax = (i == 0) ? mesh.vertices[i].position : glm::max(mesh.boundsMax, mesh.vertices[i].position);
+	}
+}
+
+/***********************************************************
+ *  SaveCompiled()
+ *
+ *  This method is used to write a mesh as a header and its
+ *  vertices and indices as they are in memory.
+ ***********************************************************/
+bool MeshImporter::SaveCompiled(const char* filename, const IMPORTED_MESH& mesh)
+{
+	MESH_HEADER header;
+	memcpy(header.magic, g_MeshMagic, sizeof(header.magic));
+	header.version = VERSION;
+	header.vertexCount = (uint32_t)mesh.vertices.size();
+	header.indexCount = (uint32_t)mesh.indices.size();
+	memcpy(header.boundsMin, glm::value_ptr(mesh.boundsMin), sizeof(header.boundsMin));
+	memcpy(header.boundsMax, glm::value_ptr(mesh.boundsMax), sizeof(header.boundsMax));
+
+	FILE* file = fopen(filename, "wb");
+	bool bWritten = (NULL != file) &&
+		(fwrite(&header, sizeof(header), 1, file) == 1) &&
+		(mesh.vertices.empty() || (fwrite(mesh.vertices.data(), sizeof(ShapeMeshes::MESH_VERTEX), mesh.vertices.size(), file) == mesh.vertices.size())) &&
+		(mesh.indices.empty() || (fwrite(mesh.indices.data(), sizeof(uint32_t), mesh.indices.size(), file) == mesh.indices.size()));
+	if (NULL != file)
+	{
+		bWritten = (fclose(file) == 0) && bWritten;
+	}
+	if (!bWritten)
+	{
+		printf("Unable to write mesh %s\n", filename);
+		return false;
+	}
+
+	printf("INFO: Compiled %d vertices and %d triangles into %s\n", (int)mesh.vertices.size(), (int)(mesh.indices.size() / 3), filename);
+	return true;
+}
+
+/***********************************************************
+ *  LoadCompiled()
+ *
+ *  This method is used to read a compiled mesh.  The size
+ *  of the file is checked against the header before the
+ *  vertices and indices are read straight into the mesh,
+ *  and the indices are checked before they are drawn.
+ ***********************************************************/
+bool MeshImporter::LoadCompiled(const char* filename, IMPORTED_MESH& mesh)
+{
+	TRACE_SCOPE("LoadCompiledMesh", filename);
+
+	FILE* file = fopen(filename, "rb");
+	if (NULL == file)
+	{
+		printf("Unable to read mesh %s\n", filename);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	MESH_HEADER header;
+	bool bValid = (fread(&header, sizeof(header), 1, file) == 1) &&
+		(memcmp(header.magic, g_MeshMagic, sizeof(header.magic)) == 0) &&
+		(header.version == VERSION) &&
+		((header.indexCount % 3) == 0) &&
+		((uint64_t)fileSize == sizeof(header) + ((uint64_t)header.vertexCount * sizeof(ShapeMeshes::MESH_VERTEX)) + ((uint64_t)header.indexCount * sizeof(uint32_t)));
+	if (bValid)
+	{
+		mesh.vertices.resize(header.vertexCount);
+		mesh.indices.resize(header.indexCount);
+		bValid = (mesh.vertices.empty() || (fread(mesh.vertices.data(), sizeof(ShapeMeshes::MESH_VERTEX), mesh.vertices.size(), file) == mesh.vertices.size())) &&
+			(mesh.indices.empty() || (fread(mesh.indices.data(), sizeof(uint32_t), mesh.indices.size(), file) == mesh.indices.size()));
+	}
+	fclose(file);
+
+	for (size_t i = 0; bValid && (i < mesh.indices.size()); i++)
+	{
+		bValid = (mesh.indices[i] < header.vertexCount);
+	}
+	if (!bValid)
+	{
+		printf("%s is not a compiled mesh of version %u\n", filename, VERSION);
+		mesh.vertices.clear();
+		mesh.indices.clear();
+		return false;
+	}
+
+	mesh.boundsMin = glm::make_vec3(header.boundsMin);
+	mesh.boundsMax = glm::make_vec3(header.boundsMax);
+	return true;
+}
+
+/***********************************************************
+ *  ReadBounds()
+ *
+ *  This method is used to get the box around a mesh without
+ *  keeping its data.  A compiled mesh has the box in its
+ *  header, so only the header is read, and the size of the
+ *  file is checked against it like a full load does.
+ ***********************************************************/
+bool MeshImporter::ReadBounds(const char* filename, glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+	FILE* file = fopen(filename, "rb");
+	if (NULL == file)
+	{
+		printf("Unable to read mesh %s\n", filename);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	MESH_HEADER header;
+	bool bCompiled = (fread(&header, sizeof(header), 1, file) == 1) &&
+		(memcmp(header.magic, g_MeshMagic, sizeof(header.magic)) == 0);
+	fclose(file);
+
+	if (bCompiled)
+	{
+		if ((header.version != VERSION) ||
+			((uint64_t)fileSize != sizeof(header) + ((uint64_t)header.vertexCount * sizeof(ShapeMeshes::MESH_VERTEX)) + ((uint64_t)header.indexCount * sizeof(uint32_t))))
+		{
+			printf("%s is not a compiled mesh of version %u\n", filename, VERSION);
+			return false;
+		}
+		boundsMin = glm::make_vec3(header.boundsMin);
+		boundsMax = glm::make_vec3(header.boundsMax);
+		return true;
+	}
+
+	IMPORTED_MESH mesh;
+	if (!Load(filename, mesh))
+	{
+		return false;
+	}
+	boundsMin = mesh.boundsMin;
+	boundsMax = mesh.boundsMax;
+	return true;
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.h
+// ============
+// import the triangles of OBJ and glTF 2.0 files into welded, indexed meshes
+// in the interleaved layout of the ShapeMeshes, and compile them into a
+// binary form that is loaded without parsing
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeMeshes.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MeshImporter
+ *
+ *  This class contains the code for importing meshes from
+ *  the files of modelling tools:
+ *
+ *  - OBJ files are read one line at a time, the faces are
+ *    split into fans of triangles and every corner is
+ *    welded by its position, normal and texture indices
+ *  - glTF 2.0 files, as .gltf with .bin or embedded data
+ *    buffers or as .glb, have the triangle primitives of
+ *    the meshes of their default scene read straight from
+ *    the buffers, placed by the node transformations and
+ *    welded by the values of their vertices
+ *
+ *  The corners go into the vertices of the mesh as they are
+ *  read, without a list of triangles in between.  Normals
+ *  that the file does not have are made from the triangles
+ *  around the vertex, weighted by their area, and the glTF
+ *  texture coordinates are flipped to start at the bottom
+ *  like the ones of the textures.
+ *
+ *  A compiled mesh is a header followed by the vertices and
+ *  the indices as they are stored in memory, so loading it
+ *  is one read of each into the mesh.
+ ***********************************************************/
+class MeshImporter
+{
+public:
+	// the version of the layout of a compiled mesh
+	static const uint32_t VERSION = 1;
+
+	// an imported mesh, drawn as indexed triangles
+	struct IMPORTED_MESH
+	{
+		std::vector<ShapeMeshes::MESH_VERTEX> vertices;
+		std::vector<uint32_t> indices;
+		// the corners of the box around the vertices
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// the start of a compiled mesh, followed by the vertices and
+	// then the indices
+	struct MESH_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	// load a compiled mesh, or import an .obj, .gltf or .glb
+	// file, told apart by the first bytes and the extension
+	static bool Load(const char* filename, IMPORTED_MESH& mesh);
+	// import the triangles of an OBJ or glTF file
+	static bool ImportOBJ(const char* filename, IMPORTED_MESH& mesh);
+	static bool ImportGLTF(const char* filename, IMPORTED_MESH& mesh);
+
+	// write a mesh in its compiled form, and read it back
+	static bool SaveCompiled(const char* filename, const IMPORTED_MESH& mesh);
+	static bool LoadCompiled(const char* filename, IMPORTED_MESH& mesh);
+	// read only the box around a mesh, from the header of a
+	// compiled mesh or by importing any other file
+	static bool ReadBounds(const char* filename, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+private:
+	// make the normals of the vertices that have none, from
+	// the triangles around their positions
+	static void GenerateNormals(IMPORTED_MESH& mesh);
+	// set the box around the vertices
+	static void CalculateBounds(IMPORTED_MESH& mesh);
+};
@@ -8,34 +8,132 @@
 //	Created for CS-330-Computational Graphics and Visualization, Nov. 7th, 2022
 ///////////////////////////////////////////////////////////////////////////////
 
-#include "shapemeshes.h"
+#include "ShapeMeshes.h"
+#include "FrameProfiler.h"
+#include "MeshGenerators.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
 
+#include <stddef.h>
 #include <vector>
 
 namespace
 {
+#ifndef M_PI
 	const double M_PI = 3.14159265358979323846f;
+#endif
+#ifndef M_PI_2
 	const double M_PI_2 = 1.571428571428571;
+#endif
 	const GLuint g_FloatsPerVertex = 3;	// Number of coordinates per vertex
 	const GLuint g_FloatsPerNormal = 3;	// Number of values per vertex color
 	const GLuint g_FloatsPerUV = 2;		// Number of texture coordinate values
+
+	// the meshes with a fixed resolution are generated while
+	// compiling, and kept with the constants of the program
+	constexpr auto g_BoxData = MeshGenerators::GenerateBox<1>();
+	constexpr auto g_PlaneData = MeshGenerators::GeneratePlane<1>();
+	constexpr auto g_SphereData = MeshGenerators::GenerateSphere<16, 16>();
+
+	// the faces of the prism and the pyramids, drawn as one
+	// triangle strip each
+	//		normal					corners: position, texture coords
+	constexpr MeshGenerators::FLAT_TRIANGLE g_PrismTriangles[] = {
+		// back face
+		{ { 0.0f, 0.0f, -1.0f },	{ { 0.5f, 0.5f, -0.5f, 0.0f, 1.0f }, { 0.5f, -0.5f, -0.5f, 0.0f, 0.0f }, { -0.5f, -0.5f, -0.5f, 1.0f, 0.0f } } },
+		{ { 0.0f, 0.0f, -1.0f },	{ { 0.5f, 0.5f, -0.5f, 0.0f, 1.0f }, { -0.5f, 0.5f, -0.5f, 1.0f, 1.0f }, { -0.5f, -0.5f, -0.5f, 1.0f, 0.0f } } },
+		// bottom face
+		{ { 0.0f, -1.0f, 0.0f },	{ { 0.5f, -0.5f, -0.5f, 0.0f, 0.0f }, { -0.5f, -0.5f, -0.5f, 1.0f, 0.0f }, { 0.0f, -0.5f, 0.5f, 0.5f, 1.0f } } },
+		// left face / slanted
+		{ { 0.894427180f, 0.0f, -0.447213590f },	{ { -0.5f, -0.5f, -0.5f, 0.0f, 0.0f }, { -0.5f, 0.5f, -0.5f, 0.0f, 1.0f }, { 0.0f, 0.5f, 0.5f, 1.0f, 1.0f } } },
+		{ { 0.894427180f, 0.0f, -0.447213590f },	{ { -0.5f, -0.5f, -0.5f, 0.0f, 0.0f }, { 0.0f, -0.5f, 0.5f, 1.0f, 0.0f }, { 0.0f, 0.5f, 0.5f, 1.0f, 1.0f } } },
+		// right face / slanted
+		{ { -0.894427180f, 0.0f, -0.447213590f },	{ { 0.0f, 0.5f, 0.5f, 0.0f, 1.0f }, { 0.5f, 0.5f, -0.5f, 1.0f, 1.0f }, { 0.5f, -0.5f, -0.5f, 1.0f, 0.0f } } },
+		{ { -0.894427180f, 0.0f, -0.447213590f },	{ { 0.0f, 0.5f, 0.5f, 0.0f, 1.0f }, { 0.0f, -0.5f, 0.5f, 0.0f, 0.0f }, { 0.5f, -0.5f, -0.5f, 1.0f, 0.0f } } },
+		// top face
+		{ { 0.0f, 1.0f, 0.0f },		{ { 0.5f, 0.5f, -0.5f, 0.0f, 0.0f }, { 0.0f, 0.5f, 0.5f, 0.5f, 1.0f }, { -0.5f, 0.5f, -0.5f, 1.0f, 0.0f } } } };
+	constexpr MeshGenerators::FLAT_TRIANGLE g_Pyramid3Triangles[] = {
+		// left side: top point, back center, front bottom left
+		{ { -0.894427180f, 0.0f, -0.447213590f },	{ { 0.0f, 0.5f, 0.0f, 0.5f, 1.0f }, { 0.0f, -0.5f, -0.5f, 0.0f, 0.0f }, { -0.5f, -0.5f, 0.5f, 1.0f, 0.0f } } },
+		// right side: top point, front bottom right, back center
+		{ { 0.894427180f, 0.0f, -0.447213590f },	{ { 0.0f, 0.5f, 0.0f, 0.5f, 1.0f }, { 0.5f, -0.5f, 0.5f, 0.0f, 0.0f }, { 0.0f, -0.5f, -0.5f, 1.0f, 0.0f } } },
+		// front side: top point, front bottom left, front bottom right
+		{ { 0.0f, 0.0f, 1.0f },		{ { 0.0f, 0.5f, 0.0f, 0.5f, 1.0f }, { -0.5f, -0.5f, 0.5f, 0.0f, 0.0f }, { 0.5f, -0.5f, 0.5f, 1.0f, 0.0f } } },
+		// bottom side: front bottom left, front bottom right, back center
+		{ { 0.0f, -1.0f, 0.0f },	{ { -0.5f, -0.5f, 0.5f, 0.0f, 1.0f }, { 0.5f, -0.5f, 0.5f, 1.0f, 1.0f }, { 0.0f, -0.5f, -0.5f, 0.5f, 0.0f } } } };
+	constexpr MeshGenerators::FLAT_TRIANGLE g_Pyramid4Triangles[] = {
+		// bottom side
+		{ { 0.0f, -1.0f, 0.0f },	{ { -0.5f, -0.5f, 0.5f, 0.0f, 1.0f }, { -0.5f, -0.5f, -0.5f, 0.0f, 0.0f }, { 0.5f, -0.5f, -0.5f, 1.0f, 0.0f } } },
+		{ { 0.0f, -1.0f, 0.0f },	{ { -0.5f, -0.5f, 0.5f, 0.0f, 1.0f }, { 0.5f, -0.5f, 0.5f, 1.0f, 1.0f }, { 0.5f, -0.5f, -0.5f, 1.0f, 0.0f } } },
+		// back side
+		{ { 0.0f, 0.0f, -1.0f },	{ { 0.0f, 0.5f, 0.0f, 0.5f, 1.0f }, { 0.5f, -0.5f, -0.5f, 0.0f, 0.0f }, { -0.5f, -0.5f, -0.5f, 1.0f, 0.0f } } },
+		// left side
+		{ { -1.0f, 0.0f, 0.0f },	{ { 0.0f, 0.5f, 0.0f, 0.5f, 1.0f }, { -0.5f, -0.5f, -0.5f, 0.0f, 0.0f }, { -0.5f, -0.5f, 0.5f, 1.0f, 0.0f } } },
+		// right side
+		{ { 1.0f, 0.0f, 0.0f },		{ { 0.0f, 0.5f, 0.0f, 0.5f, 1.0f }, { 0.5f, -0.5f, 0.5f, 0.0f, 0.0f }, { 0.5f, -0.5f, -0.5f, 1.0f, 0.0f } } },
+		// front side
+		{ { 0.0f, 0.0f, 1.0f },		{ { 0.0f, 0.5f, 0.0f, 0.5f, 1.0f }, { -0.5f, -0.5f, 0.5f, 0.0f, 0.0f }, { 0.5f, -0.5f, 0.5f, 1.0f, 0.0f } } } };
+
+	constexpr auto g_PrismData = MeshGenerators::GenerateFlatStrip(g_PrismTriangles);
+	constexpr auto g_Pyramid3Data = MeshGenerators::GenerateFlatStrip(g_Pyramid3Triangles);
+	constexpr auto g_Pyramid4Data = MeshGenerators::GenerateFlatStrip(g_Pyramid4Triangles);
+
+	// the draw methods depend on these counts, the half sphere is
+	// the first half of the indices
+	static_assert((g_BoxData.VERTEX_COUNT == 24) && (g_BoxData.INDEX_COUNT == 36), "the box has 6 faces of 2 triangles");
+	static_assert((g_PlaneData.VERTEX_COUNT == 4) && (g_PlaneData.INDEX_COUNT == 6), "the plane has 2 triangles");
+	static_assert((g_SphereData.VERTEX_COUNT == 257) && (g_SphereData.INDEX_COUNT == 1530), "the sphere has 16 slices and 16 stacks");
+	static_assert((g_SphereData.INDEX_COUNT / 2) % 3 == 0, "the half sphere ends with a whole triangle");
+	static_assert(g_PrismData.VERTEX_COUNT == 32, "the prism strip has 8 triangles");
+	static_assert(g_Pyramid3Data.VERTEX_COUNT == 16, "the 3-sided pyramid strip has 4 triangles");
+	static_assert(g_Pyramid4Data.VERTEX_COUNT == 24, "the 4-sided pyramid strip has 6 triangles");
+	static_assert(g_BoxData.AreIndicesInRange() && g_PlaneData.AreIndicesInRange() && g_SphereData.AreIndicesInRange(),
+		"an index is outside of its mesh");
+	static_assert(g_BoxData.FLOATS_PER_VERTEX == g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV,
+		"the generated vertices have the layout of SetShaderMemoryLayout()");
+
+	// convert vertices to the packed layout of the imported meshes
+	void PackVertices(const ShapeMeshes::MESH_VERTEX* vertices, size_t vertexCount, std::vector<ShapeMeshes::PACKED_VERTEX>& packed)
+	{
+		packed.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			packed[i].position = vertices[i].position;
+			packed[i].normal = glm::packSnorm3x10_1x2(glm::vec4(vertices[i].normal, 0.0f));
+			packed[i].textureCoordinate = glm::packHalf2x16(vertices[i].textureCoordinate);
+		}
+	}
 }
 
 ShapeMeshes::ShapeMeshes()
 {
 	m_bMemoryLayoutDone = false;
+	m_bUploadEnabled = true;
+	m_pCapture = NULL;
+	m_LightmappedMesh.vao = 0;
+	m_LightmappedMesh.vbos[0] = 0;
+	m_LightmappedMesh.vbos[1] = 0;
+	m_LightmappedMesh.nVertices = 0;
+	m_LightmappedMesh.nIndices = 0;
+	m_ImportedMesh.vao = 0;
+	m_ImportedMesh.vbos[0] = 0;
+	m_ImportedMesh.vbos[1] = 0;
+	m_ImportedMesh.nVertices = 0;
+	m_ImportedMesh.nIndices = 0;
+	m_bPackImportedMeshes = false;
+	m_poolSize = 0;
+	ResetDrawStatistics();
 }
 
 ///////////////////////////////////////////////////
 //	LoadBoxMesh()
 //
-//	Create a box mesh by specifying the vertices and 
-//  store it in a VAO/VBO.  The normals and texture
+//	Create a box mesh from the vertices generated 
+//  while compiling and store it in a VAO/VBO.  The normals and texture
 //  coordinates are also set.
 //
 //	Correct triangle drawing command:
@@ -44,66 +142,17 @@ ShapeMeshes::ShapeMeshes()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadBoxMesh()
 {
-	// Position and Color data
-	GLfloat verts[] = {
-		//Positions				//Normals
-		// ------------------------------------------------------
-
-		//Back Face				//Negative Z Normal  Texture Coords.
-		0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,  0.0f, 1.0f,   //0
-		0.5f, -0.5f, -0.5f,		0.0f,  0.0f, -1.0f,  0.0f, 0.0f,   //1
-		-0.5f, -0.5f, -0.5f,	0.0f,  0.0f, -1.0f,  1.0f, 0.0f,   //2
-		-0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,  1.0f, 1.0f,   //3
-
-		//Bottom Face			//Negative Y Normal
-		-0.5f, -0.5f, 0.5f,		0.0f, -1.0f,  0.0f,  0.0f, 1.0f,  //4
-		-0.5f, -0.5f, -0.5f,	0.0f, -1.0f,  0.0f,  0.0f, 0.0f,  //5
-		0.5f, -0.5f, -0.5f,		0.0f, -1.0f,  0.0f,  1.0f, 0.0f,  //6
-		0.5f, -0.5f,  0.5f,		0.0f, -1.0f,  0.0f,  1.0f, 1.0f,  //7
-
-		//Left Face				//Negative X Normal
-		-0.5f, 0.5f, -0.5f,		-1.0f,  0.0f,  0.0f,  0.0f, 1.0f,  //8
-		-0.5f, -0.5f,  -0.5f,	-1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //9
-		-0.5f,  -0.5f,  0.5f,	-1.0f,  0.0f,  0.0f,  1.0f, 0.0f,  //10
-		-0.5f,  0.5f,  0.5f,	-1.0f,  0.0f,  0.0f,  1.0f, 1.0f,  //11
-
-		//Right Face			//Positive X Normal
-		0.5f,  0.5f,  0.5f,		1.0f,  0.0f,  0.0f,  0.0f, 1.0f,  //12
-		0.5f,  -0.5f, 0.5f,		1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //13
-		0.5f, -0.5f, -0.5f,		1.0f,  0.0f,  0.0f,  1.0f, 0.0f,  //14
-		0.5f, 0.5f, -0.5f,		1.0f,  0.0f,  0.0f,  1.0f, 1.0f,  //15
-
-		//Top Face				//Positive Y Normal
-		-0.5f,  0.5f, -0.5f,	0.0f,  1.0f,  0.0f,  0.0f, 1.0f, //16
-		-0.5f,  0.5f, 0.5f,		0.0f,  1.0f,  0.0f,  0.0f, 0.0f, //17
-		0.5f,  0.5f,  0.5f,		0.0f,  1.0f,  0.0f,  1.0f, 0.0f, //18
-		0.5f,  0.5f,  -0.5f,	0.0f,  1.0f,  0.0f,  1.0f, 1.0f, //19
-
-		//Front Face			//Positive Z Normal
-		-0.5f, 0.5f,  0.5f,	    0.0f,  0.0f,  1.0f,  0.0f, 1.0f, //20
-		-0.5f, -0.5f,  0.5f,	0.0f,  0.0f,  1.0f,  0.0f, 0.0f, //21
-		0.5f,  -0.5f,  0.5f,	0.0f,  0.0f,  1.0f,  1.0f, 0.0f, //22
-		0.5f,  0.5f,  0.5f,		0.0f,  0.0f,  1.0f,  1.0f, 1.0f, //23
-	};
+	TRACE_SCOPE("LoadBoxMesh");
 
-	// Index data
-	GLuint indices[] = {
-		0,1,2,
-		0,3,2,
-		4,5,6,
-		4,7,6,
-		8,9,10,
-		8,11,10,
-		12,13,14,
-		12,15,14,
-		16,17,18,
-		16,19,18,
-		20,21,22,
-		20,23,22
-	};
+	m_BoxMesh.nVertices = (GLuint)g_BoxData.VERTEX_COUNT;
+	m_BoxMesh.nIndices = (GLuint)g_BoxData.INDEX_COUNT;
 
-	m_BoxMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
-	m_BoxMesh.nIndices = sizeof(indices) / sizeof(indices[0]);
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_BoxMesh, g_BoxData.vertices.data(), g_BoxData.vertices.size(), g_BoxData.indices.data(), g_BoxData.indices.size());
+	if (m_bUploadEnabled == false)
+	{
+		return;
+	}
 
 	glGenVertexArrays(1, &m_BoxMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_BoxMesh.vao);
@@ -111,10 +160,10 @@ void ShapeMeshes::LoadBoxMesh()
 	// Create 2 buffers: first one for the vertex data; second one for the indices
 	glGenBuffers(2, m_BoxMesh.vbos);
 	glBindBuffer(GL_ARRAY_BUFFER, m_BoxMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_BoxData.vertices), g_BoxData.vertices.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BoxMesh.vbos[1]); // Activates the buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(g_BoxData.indices), g_BoxData.indices.data(), GL_STATIC_DRAW);
 
 	if (m_bMemoryLayoutDone == false)
 	{
@@ -136,6 +185,8 @@ void ShapeMeshes::LoadBoxMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadConeMesh()
 {
+	TRACE_SCOPE("LoadConeMesh");
+
 	GLfloat verts[] = {
 		// cone bottom			// normals			// texture coords
 		1.0f, 0.0f, 0.0f,		0.0f, -1.0f, 0.0f,	0.5f,1.0f,
@@ -291,6 +342,13 @@ void ShapeMeshes::LoadConeMesh()
 	m_ConeMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 	m_ConeMesh.nIndices = 0;
 
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_ConeMesh, verts, sizeof(verts) / sizeof(verts[0]), NULL, 0);
+	if (m_bUploadEnabled == false)
+	{
+		return;
+	}
+
 	// Create VAO
 	glGenVertexArrays(1, &m_ConeMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_ConeMesh.vao);
@@ -321,6 +379,8 @@ void ShapeMeshes::LoadConeMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadCylinderMesh()
 {
+	TRACE_SCOPE("LoadCylinderMesh");
+
 	GLfloat verts[] = {
 		// cylinder bottom		// normals			// texture coords
 		1.0f, 0.0f, 0.0f,		0.0f, -1.0f, 0.0f,	0.5f,1.0f,
@@ -555,6 +615,13 @@ void ShapeMeshes::LoadCylinderMesh()
 	m_CylinderMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 	m_CylinderMesh.nIndices = 0;
 
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_CylinderMesh, verts, sizeof(verts) / sizeof(verts[0]), NULL, 0);
+	if (m_bUploadEnabled == false)
+	{
+		return;
+	}
+
 	// Create VAO
 	glGenVertexArrays(1, &m_CylinderMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_CylinderMesh.vao);
@@ -573,8 +640,8 @@ void ShapeMeshes::LoadCylinderMesh()
 ///////////////////////////////////////////////////
 //	LoadPlaneMesh()
 //
-//	Create a plane mesh by specifying the vertices and 
-//  store it in a VAO/VBO.  The normals and texture
+//	Create a plane mesh from the vertices generated 
+//  while compiling and store it in a VAO/VBO.  The normals and texture
 //  coordinates are also set.
 // 
 //  Correct triangle drawing command:
@@ -583,24 +650,18 @@ void ShapeMeshes::LoadCylinderMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadPlaneMesh()
 {
-	// Vertex data
-	GLfloat verts[] = {
-		// Vertex Positions		// Normals			// Texture coords	// Index
-		-1.0f, 0.0f, 1.0f,		0.0f, 1.0f, 0.0f,	0.0f, 0.0f,			//0
-		1.0f, 0.0f, 1.0f,		0.0f, 1.0f, 0.0f,	1.0f, 0.0f,			//1
-		1.0f,  0.0f, -1.0f,		0.0f, 1.0f, 0.0f,	1.0f, 1.0f,			//2
-		-1.0f, 0.0f, -1.0f,		0.0f, 1.0f, 0.0f,	0.0f, 1.0f,			//3
-	};
-
-	// Index data
-	GLuint indices[] = {
-		0,1,2,
-		0,3,2
-	};
+	TRACE_SCOPE("LoadPlaneMesh");
 
 	// store vertex and index count
-	m_PlaneMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
-	m_PlaneMesh.nIndices = sizeof(indices) / sizeof(indices[0]);
+	m_PlaneMesh.nVertices = (GLuint)g_PlaneData.VERTEX_COUNT;
+	m_PlaneMesh.nIndices = (GLuint)g_PlaneData.INDEX_COUNT;
+
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_PlaneMesh, g_PlaneData.vertices.data(), g_PlaneData.vertices.size(), g_PlaneData.indices.data(), g_PlaneData.indices.size());
+	if (m_bUploadEnabled == false)
+	{
+		return;
+	}
 
 	// Generate the VAO for the mesh
 	glGenVertexArrays(1, &m_PlaneMesh.vao);
@@ -609,10 +670,10 @@ void ShapeMeshes::LoadPlaneMesh()
 	// Create VBOs for the mesh
 	glGenBuffers(2, m_PlaneMesh.vbos);
 	glBindBuffer(GL_ARRAY_BUFFER, m_PlaneMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends data to the GPU
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_PlaneData.vertices), g_PlaneData.vertices.data(), GL_STATIC_DRAW); // Sends data to the GPU
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_PlaneMesh.vbos[1]); // Activates the buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(g_PlaneData.indices), g_PlaneData.indices.data(), GL_STATIC_DRAW);
 
 	if (m_bMemoryLayoutDone == false)
 	{
@@ -623,8 +684,8 @@ void ShapeMeshes::LoadPlaneMesh()
 ///////////////////////////////////////////////////
 //	LoadPrismMesh()
 //
-//	Create a prism mesh by specifying the vertices and 
-//  store it in a VAO/VBO.  The normals and texture
+//	Create a prism mesh from the vertices generated 
+//  while compiling and store it in a VAO/VBO.  The normals and texture
 //  coordinates are also set.
 //
 //	Correct triangle drawing command:
@@ -633,56 +694,16 @@ void ShapeMeshes::LoadPlaneMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadPrismMesh()
 {
-	// Vertex data
-	GLfloat verts[] = {
-		//Positions				//Normals
-		// ------------------------------------------------------
-
-		//Back Face				//Negative Z Normal  
-		0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
-		0.5f, -0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f,	0.0f,  0.0f, -1.0f,		1.0f, 0.0f,
-		0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
-		0.5f,  0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
-		-0.5f,  0.5f, -0.5f,	0.0f,  0.0f, -1.0f,		1.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,	0.0f,  0.0f, -1.0f,		1.0f, 0.0f,
-		0.5f,  0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
-
-		//Bottom Face			//Negative Y Normal
-		0.5f, -0.5f, -0.5f,		0.0f, -1.0f,  0.0f,		0.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f,	0.0f, -1.0f,  0.0f,		1.0f, 0.0f,
-		0.0f, -0.5f,  0.5f,		0.0f, -1.0f,  0.0f,		0.5f, 1.0f,
-		-0.5f, -0.5f,  -0.5f,	0.0f, -1.0f,  0.0f,		0.0f, 0.0f,
-
-		//Left Face/slanted		//Normals
-		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
-		-0.5f, 0.5f,  -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 1.0f,
-		0.0f, 0.5f,  0.5f,		0.894427180f,  0.0f,  -0.447213590f,	1.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
-		0.0f, -0.5f,  0.5f,		0.894427180f,  0.0f,  -0.447213590f,	1.0f, 0.0f,
-		0.0f, 0.5f,  0.5f,		0.894427180f,  0.0f,  -0.447213590f,	1.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
-
-		//Right Face/slanted	//Normals
-		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
-		0.5f, 0.5f, -0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		1.0f, 1.0f,
-		0.5f, -0.5f, -0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		1.0f, 0.0f,
-		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
-		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
-		0.0f, -0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 0.0f,
-		0.5f, -0.5f, -0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		1.0f, 0.0f,
-		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
-
-		//Top Face				//Positive Y Normal		//Texture Coords.
-		0.5f, 0.5f, -0.5f,		0.0f,  1.0f,  0.0f,		0.0f, 0.0f,
-		0.0f,  0.5f,  0.5f,		0.0f,  1.0f,  0.0f,		0.5f, 1.0f,
-		-0.5f,  0.5f, -0.5f,	0.0f,  1.0f,  0.0f,		1.0f, 0.0f,
-		0.5f, 0.5f, -0.5f,		0.0f,  1.0f,  0.0f,		0.0f, 0.0f,
+	TRACE_SCOPE("LoadPrismMesh");
 
-	};
+	m_PrismMesh.nVertices = (GLuint)g_PrismData.VERTEX_COUNT;
 
-	m_PrismMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_PrismMesh, g_PrismData.vertices.data(), g_PrismData.vertices.size(), NULL, 0);
+	if (m_bUploadEnabled == false)
+	{
+		return;
+	}
 
 	glGenVertexArrays(1, &m_PrismMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_PrismMesh.vao);
@@ -690,7 +711,7 @@ void ShapeMeshes::LoadPrismMesh()
 	// Create 2 buffers: first one for the vertex data; second one for the indices
 	glGenBuffers(1, m_PrismMesh.vbos);
 	glBindBuffer(GL_ARRAY_BUFFER, m_PrismMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_PrismData.vertices), g_PrismData.vertices.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
 	if (m_bMemoryLayoutDone == false)
 	{
@@ -701,8 +722,8 @@ void ShapeMeshes::LoadPrismMesh()
 ///////////////////////////////////////////////////
 //	LoadPyramid3Mesh()
 //
-//	Create a 3-sided pyramid mesh by specifying the 
-//  vertices and store it in a VAO/VBO.  The normals 
+//	Create a 3-sided pyramid mesh from the vertices 
+//  generated while compiling and store it in a VAO/VBO.  The normals 
 //  and texture coordinates are also set.
 //
 //  Correct triangle drawing command:
@@ -711,40 +732,24 @@ void ShapeMeshes::LoadPrismMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadPyramid3Mesh()
 {
-	// Vertex data
-	GLfloat verts[] = {
-		// Vertex Positions		// Normals			// Texture coords
-		//left side
-		0.0f, 0.5f, 0.0f,		-0.894427180f, 0.0f, -0.447213590f,	0.5f, 1.0f,		//top point	
-		0.0f, -0.5f, -0.5f,		-0.894427180f, 0.0f, -0.447213590f,	0.0f, 0.0f,		//back center
-		-0.5f, -0.5f, 0.5f,		-0.894427180f, 0.0f, -0.447213590f,	1.0f, 0.0f,     //front bottom left
-		0.0f, 0.5f, 0.0f,		-0.894427180f, 0.0f, -0.447213590f,	0.5f, 1.0f,		//top point	
-		//right side
-		0.0f, 0.5f, 0.0f,		0.894427180f, 0.0f, -0.447213590f,	0.5f, 1.0f,		//top point	
-		0.5f, -0.5f, 0.5f,		0.894427180f, 0.0f, -0.447213590f,	0.0f, 0.0f,     //front bottom right
-		0.0f, -0.5f, -0.5f,		0.894427180f, 0.0f, -0.447213590f,	1.0f, 0.0f,		//back center	
-		0.0f, 0.5f, 0.0f,		0.894427180f, 0.0f, -0.447213590f,	0.5f, 1.0f,		//top point	
-		//front side
-		0.0f, 0.5f, 0.0f,		0.0f, 0.0f, 1.0f,	0.5f, 1.0f,		//top point			
-		-0.5f, -0.5f, 0.5f,		0.0f, 0.0f, 1.0f,	0.0f, 0.0f,     //front bottom left	
-		0.5f, -0.5f, 0.5f,		0.0f, 0.0f, 1.0f,	1.0f, 0.0f,     //front bottom right
-		0.0f, 0.5f, 0.0f,		0.0f, 0.0f, 1.0f,	0.5f, 1.0f,		//top point	
-		//bottom side
-		-0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,	0.0f, 1.0f,     //front bottom left
-		0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,	1.0f, 1.0f,     //front bottom right
-		0.0f, -0.5f, -0.5f,		0.0f, -1.0f, 0.0f,	0.5f, 0.0f,		//back center	
-		-0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,	0.0f, 1.0f,     //front bottom left
-	};
+	TRACE_SCOPE("LoadPyramid3Mesh");
 
 	// Calculate total defined vertices
-	m_Pyramid3Mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
+	m_Pyramid3Mesh.nVertices = (GLuint)g_Pyramid3Data.VERTEX_COUNT;
+
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_Pyramid3Mesh, g_Pyramid3Data.vertices.data(), g_Pyramid3Data.vertices.size(), NULL, 0);
+	if (m_bUploadEnabled == false)
+	{
+		return;
+	}
 
 	glGenVertexArrays(1, &m_Pyramid3Mesh.vao);				// Creates 1 VAO
 	glGenBuffers(1, m_Pyramid3Mesh.vbos);					// Creates 1 VBO
 	glBindVertexArray(m_Pyramid3Mesh.vao);					// Activates the VAO
 	glBindBuffer(GL_ARRAY_BUFFER, m_Pyramid3Mesh.vbos[0]);	// Activates the VBO
 	// Sends vertex or coordinate data to the GPU
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_Pyramid3Data.vertices), g_Pyramid3Data.vertices.data(), GL_STATIC_DRAW);
 
 	if (m_bMemoryLayoutDone == false)
 	{
@@ -755,8 +760,8 @@ void ShapeMeshes::LoadPyramid3Mesh()
 ///////////////////////////////////////////////////
 //	LoadPyramid4Mesh()
 //
-//	Create a 4-sided pyramid mesh by specifying the 
-//  vertices and store it in a VAO/VBO.  The normals 
+//	Create a 4-sided pyramid mesh from the vertices 
+//  generated while compiling and store it in a VAO/VBO.  The normals 
 //  and texture coordinates are also set.
 //
 //  Correct triangle drawing command:
@@ -765,49 +770,24 @@ void ShapeMeshes::LoadPyramid3Mesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadPyramid4Mesh()
 {
-	// Vertex data
-	GLfloat verts[] = {
-		// Vertex Positions		// Normals			// Texture coords
-		//bottom side
-		-0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,	0.0f, 1.0f,     //front bottom left
-		-0.5f, -0.5f, -0.5f,	0.0f, -1.0f, 0.0f,	0.0f, 0.0f,		//back bottom left
-		0.5f, -0.5f, -0.5f,		0.0f, -1.0f, 0.0f,	1.0f, 0.0f,		//back bottom right	
-		-0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,	0.0f, 1.0f,     //front bottom left
-		-0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,	0.0f, 1.0f,     //front bottom left
-		0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,	1.0f, 1.0f,     //front bottom right
-		0.5f, -0.5f, -0.5f,		0.0f, -1.0f, 0.0f,	1.0f, 0.0f,		//back bottom right	
-		-0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,	0.0f, 1.0f,     //front bottom left
-		//back side
-		0.0f, 0.5f, 0.0f,		0.0f, 0.0f, -1.0f,	0.5f, 1.0f,		//top point	
-		0.5f, -0.5f, -0.5f,		0.0f, 0.0f, -1.0f,	0.0f, 0.0f,		//back bottom right	
-		-0.5f, -0.5f, -0.5f,	0.0f, 0.0f, -1.0f,	1.0f, 0.0f,		//back bottom left
-		0.0f, 0.5f, 0.0f,		0.0f, 0.0f, -1.0f,	0.5f, 1.0f,		//top point	
-		//left side
-		0.0f, 0.5f, 0.0f,		-1.0f, 0.0f, 0.0f,	0.5f, 1.0f,		//top point	
-		-0.5f, -0.5f, -0.5f,	-1.0f, 0.0f, 0.0f,	0.0f, 0.0f,		//back bottom left	
-		-0.5f, -0.5f, 0.5f,		-1.0f, 0.0f, 0.0f,	1.0f, 0.0f,     //front bottom left
-		0.0f, 0.5f, 0.0f,		-1.0f, 0.0f, 0.0f,	0.5f, 1.0f,		//top point	
-		//right side
-		0.0f, 0.5f, 0.0f,		1.0f, 0.0f, 0.0f,	0.5f, 1.0f,		//top point	
-		0.5f, -0.5f, 0.5f,		1.0f, 0.0f, 0.0f,	0.0f, 0.0f,     //front bottom right
-		0.5f, -0.5f, -0.5f,		1.0f, 0.0f, 0.0f,	1.0f, 0.0f,		//back bottom right	
-		0.0f, 0.5f, 0.0f,		1.0f, 0.0f, 0.0f,	0.5f, 1.0f,		//top point	
-		//front side
-		0.0f, 0.5f, 0.0f,		0.0f, 0.0f, 1.0f,	0.5f, 1.0f,		//top point			
-		-0.5f, -0.5f, 0.5f,		0.0f, 0.0f, 1.0f,	0.0f, 0.0f,     //front bottom left	
-		0.5f, -0.5f, 0.5f,		0.0f, 0.0f, 1.0f,	1.0f, 0.0f,     //front bottom right
-		0.0f, 0.5f, 0.0f,		0.0f, 0.0f, 1.0f,	0.5f, 1.0f,		//top point
-	};
+	TRACE_SCOPE("LoadPyramid4Mesh");
 
 	// Calculate total defined vertices
-	m_Pyramid4Mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
+	m_Pyramid4Mesh.nVertices = (GLuint)g_Pyramid4Data.VERTEX_COUNT;
+
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_Pyramid4Mesh, g_Pyramid4Data.vertices.data(), g_Pyramid4Data.vertices.size(), NULL, 0);
+	if (m_bUploadEnabled == false)
+	{
+		return;
+	}
 
 	glGenVertexArrays(1, &m_Pyramid4Mesh.vao);				// Creates 1 VAO
 	glGenBuffers(1, m_Pyramid4Mesh.vbos);					// Creates 1 VBO
 	glBindVertexArray(m_Pyramid4Mesh.vao);					// Activates the VAO
 	glBindBuffer(GL_ARRAY_BUFFER, m_Pyramid4Mesh.vbos[0]);	// Activates the VBO
 	// Sends vertex or coordinate data to the GPU
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_Pyramid4Data.vertices), g_Pyramid4Data.vertices.data(), GL_STATIC_DRAW);
 
 	if (m_bMemoryLayoutDone == false)
 	{
@@ -818,8 +798,8 @@ void ShapeMeshes::LoadPyramid4Mesh()
 ///////////////////////////////////////////////////
 //	LoadSphereMesh()
 //
-//	Create a sphere mesh by specifying the vertices and 
-//  store it in a VAO/VBO.  The normals and texture
+//	Create a sphere mesh from the vertices generated 
+//  while compiling and store it in a VAO/VBO.  The normals and texture
 //  coordinates are also set.
 //
 //  Correct triangle drawing command:
@@ -828,859 +808,17 @@ void ShapeMeshes::LoadPyramid4Mesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadSphereMesh()
 {
-	GLfloat verts[] = {
-		// vertex data					// texture coords			// index
-		// top center point
-		0.0f, 1.0f, 0.0f,				0.5f, 1.0f,					//0
-		// ring 1
-		0.0f, 0.9808f, 0.1951f,			0.5f, 0.9375f,				//1
-		0.0747f, 0.9808f, 0.1802f,		0.51219375f, 0.9375f,		//2
-		0.1379f, 0.9808f, 0.1379f,		0.5243875f, 0.9375f,		//3
-		0.1802f, 0.9808f, 0.0747f,		0.53658125f, 0.9375f,		//4
-		0.1951f, 0.9808, 0.0f,			0.548775f, 0.9375f,			//5
-		0.1802f, 0.9808f, -0.0747f,		0.56096875f, 0.9375f,		//6
-		0.1379f, 0.9808f, -0.1379f,		0.5731625f, 0.9375f,		//7
-		0.0747f, 0.9808f, -0.1802f,		0.58535625f, 0.9375f,		//8
-		0.0f, 0.9808f, -0.1951f,		0.59755f, 0.9375f,			//9 - seam
-		0.0f, 0.9808f, -0.1951f,		0.40245f, 0.9375f,			//10 - seam
-		-0.0747f, 0.9808f, -0.1802f,	0.41464375f, 0.9375f,		//11
-		-0.1379f, 0.9808f, -0.1379f,	0.4268375f, 0.9375f,		//12
-		-0.1802f, 0.9808f, -0.0747f,	0.43903125f, 0.9375f,		//13
-		-0.1951f, 0.9808, 0.0f,			0.451225f, 0.9375f,			//14
-		-0.1802f, 0.9808f, 0.0747f,		0.46341875f, 0.9375f,		//15
-		-0.1379f, 0.9808f, 0.1379f,		0.4756125f, 0.9375f,		//16
-		-0.0747f, 0.9808f, 0.1802f,		0.48780625f, 0.9375f,		//17
-		// ring 2
-		0.0f, 0.9239f, 0.3827f,			0.5f, 0.875f,				//18
-		0.1464f, 0.9239f, 0.3536f,		0.52391875f, 0.875f,		//19
-		0.2706f, 0.9239f, 0.2706f,		0.5478375f, 0.875f,			//20
-		0.3536f, 0.9239f, 0.1464f,		0.57175625f, 0.875f,		//21
-		0.3827f, 0.9239f, 0.0f,			0.5956755f, 0.875f,			//22
-		0.3536f, 0.9239f, -0.1464f,		0.61959425f, 0.875f,		//23
-		0.2706f, 0.9239f, -0.2706f,		0.643513f, 0.875f,			//24
-		0.1464f, 0.9239f, -0.3536f,		0.66743175f, 0.875f,		//25
-		0.0f, 0.9239f, -0.3827f,		0.6913505f, 0.875f,			//26 - seam
-		0.0f, 0.9239f, -0.3827f,		0.3086495f, 0.875f,			//27 - seam
-		-0.1464f, 0.9239f, -0.3536f,	0.33256825f, 0.875f,		//28
-		-0.2706f, 0.9239f, -0.2706f,	0.356487f, 0.875f,			//29
-		-0.3536f, 0.9239f, -0.1464f,	0.38040575f, 0.875f,		//30
-		-0.3827f, 0.9239f, 0.0f,		0.4043245f, 0.875f,			//31
-		-0.3536f, 0.9239f, 0.1464f,		0.42824325f, 0.875f,		//32
-		-0.2706f, 0.9239f, 0.2706f,		0.452162f, 0.875f,			//33
-		-0.1464f, 0.9239f, 0.3536f,		0.47608075f, 0.875f,		//34
-		// ring 3
-		0.0f, 0.8315f, 0.5556f,			0.5f, 0.8125f,				//35
-		0.2126f, 0.8315f, 0.5133f,		0.534725f, 0.8125f,			//36
-		0.3928f, 0.8315f, 0.3928f,		0.56945f, 0.8125f,			//37
-		0.5133f, 0.8315f, 0.2126f,		0.604175f, 0.8125f,			//38
-		0.5556f, 0.8315f, 0.0f,			0.6389f, 0.8125f,			//39
-		0.5133f, 0.8315f, -0.2126f,		0.673625f, 0.8125f,			//40
-		0.3928f, 0.8315f, -0.3928f,		0.70835f, 0.8125f,			//41
-		0.2126f, 0.8315f, -0.5133f,		0.743075f, 0.8125f,			//42
-		0.0f, 0.8315f, -0.5556f,		0.7778f, 0.8125f,			//43 - seam
-		0.0f, 0.8315f, -0.5556f,		0.2222f, 0.8125f,			//44 - seam
-		-0.2126f, 0.8315f, -0.5133f,	0.256925f, 0.8125f,			//45
-		-0.3928f, 0.8315f, -0.3928f,	0.29165f, 0.8125f,			//46
-		-0.5133f, 0.8315f, -0.2126f,	0.326375f, 0.8125f,			//47
-		-0.5556f, 0.8315f, 0.0f,		0.3611f, 0.8125f,			//48
-		-0.5133f, 0.8315f, 0.2126f,		0.395825f, 0.8125f,			//49
-		-0.3928f, 0.8315f, 0.3928f,		0.43055f, 0.8125f,			//50
-		-0.2126f, 0.8315f, 0.5133f,		0.465275f, 0.8125f,			//51
-		// ring 4
-		0.0f, 0.7071f, 0.7071f,			0.5f, 0.75f,				//52
-		0.2706f, 0.7071f, 0.6533f,		0.54419375f, 0.75f,			//53
-		0.5f, 0.7071f, 0.5f,			0.5883875f, 0.75f,			//54
-		0.6533f, 0.7071f, 0.2706f,		0.63258125f, 0.75f,			//55
-		0.7071f, 0.7071f, 0.0f,			0.676775f, 0.75f,			//56
-		0.6533f, 0.7071f, -0.2706f,		0.72096875f, 0.75f,			//57
-		0.5f, 0.7071f, -0.5f,			0.7651625f, 0.75f,			//58
-		0.2706f, 0.7071f, -0.6533f,		0.80935625f, 0.75f,			//59
-		0.0f, 0.7071f, -0.7071f,		0.85355f, 0.75f,			//60 - seam
-		0.0f, 0.7071f, -0.7071f,		0.14645f, 0.75f,			//61 - seam
-		-0.2706f, 0.7071f, -0.6533f,	0.19064375f, 0.75f,			//62
-		-0.5f, 0.7071f, -0.5f,			0.2348375f, 0.75f,			//63
-		-0.6533f, 0.7071f, -0.2706f,	0.27903135f, 0.75f,			//64
-		-0.7071f, 0.7071f, 0.0f,		0.323225f, 0.75f,			//65
-		-0.6533f, 0.7071f, 0.2706f,		0.36741875f, 0.75f,			//66
-		-0.5f, 0.7071f, 0.5f,			0.4116125f, 0.75f,			//67
-		-0.2706f, 0.7071f, 0.6533f,		0.45580625f, 0.75f,			//68
-		// ring 5
-		0.0f, 0.5556f, 0.8315f,			0.5f, 0.6875f,				//69
-		0.3182f, 0.5556f, 0.7682f,		0.55196875f, 0.6875f,		//70
-		0.5879f, 0.5556f, 0.5879f,		0.6039375f, 0.6875f,		//71
-		0.7682f, 0.5556f, 0.3182f,		0.65590625f, 0.6875f,		//72
-		0.8315f, 0.5556f, 0.0f,			0.707875f, 0.6875f,			//73
-		0.7682f, 0.5556f, -0.3182f,		0.75984375f, 0.6875f,		//74
-		0.5879f, 0.5556f, -0.5879f,		0.8118125f, 0.6875f,		//75
-		0.3182f, 0.5556f, -0.7682f,		0.86378125f, 0.6875f,		//76
-		0.0f, 0.5556f, -0.8315f,		0.91575f, 0.6875f,			//77 - seam
-		0.0f, 0.5556f, -0.8315f,		0.08425f, 0.6875f,			//78 - seam
-		-0.3182f, 0.5556f, -0.7682f,	0.13621875f, 0.6875f,		//79
-		-0.5879f, 0.5556f, -0.5879f,	0.1881875f, 0.6875f,		//80
-		-0.7682f, 0.5556f, -0.3182f,	0.24015625f, 0.6875f,		//81
-		-0.8315f, 0.5556f, 0.0f,		0.292125f, 0.6875f,			//82
-		-0.7682f, 0.5556f, 0.3182f,		0.34409375f, 0.6875f,		//83
-		-0.5879f, 0.5556f, 0.5879f,		0.3960625f, 0.6875f,		//84
-		-0.3182f, 0.5556f, 0.7682f,		0.44803125f, 0.6875f,		//85
-		//ring 6
-		0.0f, 0.3827f, 0.9239f,			0.5f, 0.625f,				//86
-		0.3536f, 0.3827f, 0.8536f,		0.55774375f, 0.625f,		//87
-		0.6533f, 0.3827f, 0.6533f,		0.6154875f, 0.625f,			//88
-		0.8536f, 0.3827f, 0.3536f,		0.67323125f, 0.625f,		//89
-		0.9239f, 0.3827f, 0.0f,			0.730975f, 0.625f,			//90
-		0.8536f, 0.3827f, -0.3536f,		0.78871875f, 0.625f,		//91
-		0.6533f, 0.3827f, -0.6533f,		0.8464625f, 0.625f,			//92
-		0.3536f, 0.3827f, -0.8536f,		0.90420625f, 0.625f,		//93
-		0.0f, 0.3827f, -0.9239f,		0.96195f, 0.625f,			//94 - seam
-		0.0f, 0.3827f, -0.9239f,		0.03805f, 0.625f,			//95 - seam
-		-0.3536f, 0.3827f, -0.8536f,	0.09579375f, 0.625f,		//96
-		-0.6533f, 0.3827f, -0.6533f,	0.1535375f, 0.625f,			//97
-		-0.8536f, 0.3827f, -0.3536f,	0.21128125f, 0.625f,		//98
-		-0.9239f, 0.3827f, 0.0f,		0.269025f, 0.625f,			//99
-		-0.8536f, 0.3827f, 0.3536f,		0.32676875f, 0.625f,		//100
-		-0.6533f, 0.3827f, 0.6533f,		0.3845125f, 0.625f,			//101
-		-0.3536f, 0.3827f, 0.8536f,		0.44225625f, 0.625f,		//102
-		// ring 7
-		0.0f, 0.1951f, 0.9808f,			0.5f, 0.5625f,				//103
-		0.3753f, 0.1915f, 0.9061f,		0.5613f, 0.5625f,			//104
-		0.6935f, 0.1915f, 0.6935f,		0.6226f, 0.5625f,			//105
-		0.9061f, 0.1915f, 0.3753f,		0.6839f, 0.5625f,			//106
-		0.9808f, 0.1915f, 0.0f,			0.7452f, 0.5625f,			//107
-		0.9061f, 0.1915f, -0.3753f,		0.8065f, 0.5625f,			//108
-		0.6935f, 0.1915f, -0.6935f,		0.8678f, 0.5625f,			//109
-		0.3753f, 0.1915f, -0.9061f,		0.9291f, 0.5625f,			//110
-		0.0f, 0.1915f, -0.9808f,		0.9904f, 0.5625f,			//111 - seam
-		0.0f, 0.1915f, -0.9808f,		0.0096f, 0.5625f,			//112 - seam
-		-0.3753f, 0.1915f, -0.9061f,	0.0709f, 0.5625f,			//113
-		-0.6935f, 0.1915f, -0.6935f,	0.1322f, 0.5625f,			//114
-		-0.9061f, 0.1915f, -0.3753f,	0.1935f, 0.5625f,			//115
-		-0.9808f, 0.1915f, 0.0f,		0.2548f, 0.5625f,			//116
-		-0.9061f, 0.1915f, 0.3753f,		0.3161f, 0.5625f,			//117
-		-0.6935f, 0.1915f, 0.6935f,		0.3774f, 0.5625f,			//118
-		-0.3753f, 0.1915f, 0.9061f,		0.4387f, 0.5625f,			//119
-		// ring 8
-		0.0f, 0.0f, 1.0f,				0.5f, 0.5f,					//120
-		0.3827f, 0.0f, 0.9239f,			0.5625f, 0.5f,				//121
-		0.7071f, 0.0f, 0.7071f,			0.625f, 0.5f,				//122
-		0.9239f, 0.0f, 0.3827f,			0.6875f, 0.5f,				//123
-		1.0f, 0.0f, 0.0f,				0.75f, 0.5f,				//124
-		0.9239f, 0.0f, -0.3827f,		0.8125f, 0.5f,				//125
-		0.7071f, 0.0f, -0.7071f,		0.875f, 0.5f,				//126
-		0.3827f, 0.0f, -0.9239f,		0.9375f, 0.5f,				//127
-		0.0f, 0.0f, -1.0f,				1.0f, 0.5f,					//128 - seam
-		0.0f, 0.0f, -1.0f, 				0.0f, 0.5f,					//129 - seam
-		-0.3827f, 0.0f, -0.9239f,		0.0625f, 0.5f,				//130
-		-0.7071f, 0.0f, -0.7071f,		0.125f, 0.5f,				//131
-		-0.9239f, 0.0f, -0.3827f,		0.1875f, 0.5f,				//132
-		-1.0f, 0.0f, 0.0f,				0.25f, 0.5f,				//133
-		-0.9239f, 0.0f, 0.3827f,		0.3125f, 0.5f,				//134
-		-0.7071, 0.0, 0.7071f,			0.375f, 0.5f,				//135
-		-0.3827f, 0.0f, 0.9239f,		0.4375f, 0.5f,				//136
-		// ring 9
-		0.0f, -0.1915f, 0.9808f,		0.5f, 0.4375f,				//137
-		0.3753f, -0.1915f, 0.9061f,		0.5613f, 0.4375f,			//138
-		0.6935f, -0.1915f, 0.6935f,		0.6226f, 0.4375f,			//139
-		0.9061f, -0.1915f, 0.3753f,		0.6839f, 0.4375f,			//140
-		0.9808f, -0.1915f, 0.0f,		0.7452f, 0.4375f,			//141
-		0.9061f, -0.1915f, -0.3753f,	0.8065f, 0.4375f,			//142
-		0.6935f, -0.1915f, -0.6935f,	0.8678f, 0.4375f,			//143
-		0.3753f, -0.1915f, -0.9061f,	0.9261f, 0.4375f,			//144
-		0.0f, -0.1915f, -0.9808f,		0.9904f, 0.4375f,			//145 - seam
-		0.0f, -0.1915f, -0.9808f,		0.0096f, 0.4375f,			//146 - seam
-		-0.3753f, -0.1915f, -0.9061f,	0.0709f, 0.4375f,			//147
-		-0.6935f, -0.1915f, -0.6935f,	0.1322f, 0.4375f,			//148
-		-0.9061f, -0.1915f, -0.3753f,	0.1935f, 0.4375f,			//149
-		-0.9808f, -0.1915f, 0.0f,		0.2548f, 0.4375f,			//150
-		-0.9061f, -0.1915f, 0.3753f,	0.3161f, 0.4375f,			//151
-		-0.6935f, -0.1915f, 0.6935f,	0.3774f, 0.4375f,			//152
-		-0.3753f, -0.1915f, 0.9061f,	0.4387f, 0.4375f,			//153
-		// ring 10
-		0.0f, -0.3827f, 0.9239f,		0.5f, 0.375f,				//154
-		0.3536f, -0.3827f, 0.8536f,		0.55774375f, 0.375f,		//155
-		0.6533f, -0.3827f, 0.6533f,		0.6154875f, 0.375f,			//156
-		0.8536f, -0.3827f, 0.3536f,		0.67323125f, 0.375f,		//157
-		0.9239f, -0.3827f, 0.0f,		0.730975f, 0.375f,			//158
-		0.8536f, -0.3827f, -0.3536f,	0.78871875f, 0.375f,		//159
-		0.6533f, -0.3827f, -0.6533f,	0.8464625f, 0.375f,			//160
-		0.3536f, -0.3827f, -0.8536f,	0.90420625f, 0.375f,		//161
-		0.0f, -0.3827f, -0.9239f,		0.96195f, 0.375f,			//162 - seam
-		0.0f, -0.3827f, -0.9239f,		0.03805f, 0.375f,			//163 - seam
-		-0.3536f, -0.3827f, -0.8536f,	0.09579375f, 0.375f,		//164
-		-0.6533f, -0.3827f, -0.6533f,	0.1535375f, 0.375f,			//165
-		-0.8536f, -0.3827f, -0.3536f,	0.21128125f, 0.375f,		//166
-		-0.9239f, -0.3827f, 0.0f,		0.269025f, 0.375f,			//167
-		-0.8536f, -0.3827f, 0.3536f,	0.32676875f, 0.375f,		//168
-		-0.6533f, -0.3827f, 0.6533f,	0.3845125f, 0.375f,			//169
-		-0.3536f, -0.3827f, 0.8536f,	0.44225625f, 0.375f,		//170
-		// ring 11
-		0.0f, -0.5556f, 0.8315f,		0.5f, 0.3125f,				//171
-		0.3182f, -0.5556f, 0.7682f,		0.55196875f, 0.3125f,		//172
-		0.5879f, -0.5556f, 0.5879f,		0.6039375f, 0.3125f,		//173
-		0.7682f, -0.5556f, 0.3182f,		0.65590625f, 0.3125f,		//174
-		0.8315f, -0.5556f, 0.0f,		0.707875f, 0.3125f,			//175
-		0.7682f, -0.5556f, -0.3182f,	0.75984375f, 0.3125f,		//176
-		0.5879f, -0.5556f, -0.5879f,	0.8118125f, 0.3125f,		//177
-		0.3182f, -0.5556f, -0.7682f,	0.86378125f, 0.3125f,		//178
-		0.0f, -0.5556f, -0.8315f,		0.91575f, 0.3125f,			//179 - seam
-		0.0f, -0.5556f, -0.8315f,		0.08425f, 0.3125f,			//180 - seam
-		-0.3182f, -0.5556f, -0.7682f,	0.13621875f, 0.3125f,		//181
-		-0.5879f, 0.5556f, -0.5879f,	0.1881875f, 0.3125f,		//182
-		-0.7682f, -0.5556f, -0.3182f,	0.24015625f, 0.3125f,		//183
-		-0.8315f, -0.5556f, 0.0f,		0.292125f, 0.3125f,			//184
-		-0.7682f, -0.5556f, 0.3182f,	0.34409375f, 0.3125f,		//185
-		-0.5879f, -0.5556f, 0.5879f,	0.3960625f, 0.3125f,		//186
-		-0.3182f, -0.5556f, 0.7682f,	0.44803125f, 0.3125f,		//187
-		// ring 12
-		0.0f, -0.7071f, 0.7071f,		0.5f, 0.25f,				//188
-		0.2706f, -0.7071f, 0.6533f,		0.54419375f, 0.25f,			//189
-		0.5f, -0.7071f, 0.5f,			0.5883875f, 0.25f,			//190
-		0.6533f, -0.7071f, 0.2706f,		0.63258125f, 0.25f,			//191
-		0.7071f, -0.7071f, 0.0f,		0.676775f, 0.25f,			//192
-		0.6533f, -0.7071f, -0.2706f,	0.72096875f, 0.25f,			//193
-		0.5f, -0.7071f, -0.5f,			0.7651625f, 0.25f,			//194
-		0.2706f, -0.7071f, -0.6533f,	0.80935625f, 0.25f,			//195
-		0.0f, -0.7071f, -0.7071f,		0.85355f, 0.25f,			//196 - seam
-		0.0f, -0.7071f, -0.7071f,		0.14645f, 0.25f,			//197 - seam
-		-0.2706f, -0.7071f, -0.6533f,	0.19064375f, 0.25f,			//198
-		-0.5f, -0.7071f, -0.5f,			0.2348375f, 0.25f,			//199
-		-0.6533f, -0.7071f, -0.2706f,	0.27903135f, 0.25f,			//200
-		-0.7071f, -0.7071f, 0.0f,		0.323225f, 0.25f,			//201
-		-0.6533f, -0.7071f, 0.2706f,	0.36741875f, 0.25f,			//202
-		-0.5f, -0.7071f, 0.5f,			0.4116125f, 0.25f,			//203
-		-0.2706f, -0.7071f, 0.6533f,	0.45580625f, 0.25f,			//204
-		// ring 13
-		0.0f, -0.8315f, 0.5556f,		0.5f, 0.1875f,				//205
-		0.2126f, -0.8315f, 0.5133f,		0.534725f, 0.1875f,			//206
-		0.3928f, -0.8315f, 0.3928f,		0.56945f, 0.1875f,			//207
-		0.5133f, -0.8315f, 0.2126f,		0.604175f, 0.1875f,			//208
-		0.5556f, -0.8315f, 0.0f,		0.6389f, 0.1875f,			//209
-		0.5133f, -0.8315f, -0.2126f,	0.673625f, 0.1875f,			//210
-		0.3928f, -0.8315f, -0.3928f,	0.70835f, 0.1875f,			//211
-		0.2126f, -0.8315f, -0.5133f,	0.743075f, 0.1875f,			//212
-		0.0f, -0.8315f, -0.5556f,		0.7778f, 0.1875f,			//213 - seam
-		0.0f, -0.8315f, -0.5556f,		0.2222f, 0.1875f,			//214 - seam
-		-0.2126f, -0.8315f, -0.5133f,	0.256925f, 0.1875f,			//215
-		-0.3928f, -0.8315f, -0.3928f,	0.29165f, 0.1875f,			//216
-		-0.5133f, -0.8315f, -0.2126f,	0.326375f, 0.1875f,			//217
-		-0.5556f, -0.8315f, 0.0f,		0.3611f, 0.1875f,			//218
-		-0.5133f, -0.8315f, 0.2126f,	0.395825f, 0.1875f,			//219
-		-0.3928f, -0.8315f, 0.3928f,	0.43055f, 0.1875f,			//220
-		-0.2126f, -0.8315f, 0.5133f,	0.465275f, 0.1875f,			//221
-		// ring 14
-		0.0f, -0.9239f, 0.3827f,		0.5f, 0.125f,				//222
-		0.1464f, -0.9239f, 0.3536f,		0.52391875f, 0.125f,		//223
-		0.2706f, -0.9239f, 0.2706f,		0.5478375f, 0.125f,			//224
-		0.3536f, -0.9239f, 0.1464f,		0.57175625f, 0.125f,		//225
-		0.3827f, -0.9239f, 0.0f,		0.5956755f, 0.125f,			//226
-		0.3536f, -0.9239f, -0.1464f,	0.61959425f, 0.125f,		//227
-		0.2706f, -0.9239f, -0.2706f,	0.643513f, 0.125f,			//228
-		0.1464f, -0.9239f, -0.3536f,	0.66743175f, 0.125f,		//229
-		0.0f, -0.9239f, -0.3827f,		0.6913505f, 0.125f,			//230 - seam
-		0.0f, -0.9239f, -0.3827f,		0.3086495f, 0.125f,			//231 - seam
-		-0.1464f, -0.9239f, -0.3536f,	0.33256825f, 0.125f,		//232
-		-0.2706f, -0.9239f, -0.2706f,	0.356487f, 0.125f,			//233
-		-0.3536f, -0.9239f, -0.1464f,	0.38040575f, 0.125f,		//234
-		-0.3827f, -0.9239f, 0.0f,		0.4043245f, 0.125f,			//235
-		-0.3536f, -0.9239f, 0.1464f,	0.42824325f, 0.125f,		//236
-		-0.2706f, -0.9239f, 0.2706f,	0.452162f, 0.125f,			//237
-		-0.1464f, -0.9239f, 0.3536f,	0.47608075f, 0.125f,		//238
-		// ring 15
-		0.0f, -0.9808f, 0.1951f,		0.5f, 0.0625f,				//239
-		0.0747f, -0.9808f, 0.1802f,		0.51219375f, 0.0625f,		//240
-		0.1379f, -0.9808f, 0.1379f,		0.5243875f, 0.0625f,		//241
-		0.1802f, -0.9808f, 0.0747f,		0.53658125f, 0.0625f,		//242
-		0.1951f, -0.9808, 0.0f,			0.548775f, 0.0625f,			//243
-		0.1802f, -0.9808f, -0.0747f,	0.56096875f, 0.0625f,		//244
-		0.1379f, -0.9808f, -0.1379f,	0.5731625f, 0.0625f,		//245
-		0.0747f, -0.9808f, -0.1802f,	0.58535625f, 0.0625f,		//246
-		0.0f, -0.9808f, -0.1951f,		0.59755f, 0.0625f,			//247 - seam
-		0.0f, -0.9808f, -0.1951f,		0.40245f, 0.0625f,			//248 - seam
-		-0.0747f, -0.9808f, -0.1802f,	0.41464375f, 0.0625f,		//249
-		-0.1379f, -0.9808f, -0.1379f,	0.4268375f, 0.0625f,		//250
-		-0.1802f, -0.9808f, -0.0747f,	0.43903125f, 0.0625f,		//251
-		-0.1951f, -0.9808, 0.0f,		0.451225f, 0.0625f,			//252
-		-0.1802f, -0.9808f, 0.0747f,	0.46341875f, 0.0625f,		//253
-		-0.1379f, -0.9808f, 0.1379f,	0.4756125f, 0.0625f,		//254
-		-0.0747f, -0.9808f, 0.1802f,	0.48780625f, 0.0625f,		//255
-		// bottom center point
-		0.0f, -1.0f, 0.0f,				0.5f, 0.0f					//256
-	};
-
-	// index data
-	GLuint indices[] = {
-		//ring 1 - top
-		0,10,11,
-		0,11,12,
-		0,12,13,
-		0,13,14,
-		0,14,15,
-		0,15,16,
-		0,16,17,
-		0,17,1,
-		0,1,2,
-		0,2,3,
-		0,3,4,
-		0,4,5,
-		0,5,6,
-		0,6,7,
-		0,7,8,
-		0,8,9,
-		0,9,10,
-
-		// ring 1 to ring 2
-		10,27,28,
-		10,11,28,
-		11,28,29,
-		11,12,29,
-		12,29,30,
-		12,13,30,
-		13,30,31,
-		13,14,31,
-		14,31,32,
-		14,15,32,
-		15,32,33,
-		15,16,33,
-		16,33,34,
-		16,17,34,
-		17,34,18,
-		17,1,18,
-		1,18,19,
-		1,2,19,
-		2,19,20,
-		2,3,20,
-		3,20,21,
-		3,4,21,
-		4,21,22,
-		4,5,22,
-		5,22,23,
-		5,6,23,
-		6,23,24,
-		6,7,24,
-		7,24,25,
-		7,8,25,
-		8,25,26,
-		8,9,26,
-		9,26,27,
-		9,10,27,
-
-		// ring 2 to ring 3
-		27,44,45,
-		27,28,45,
-		28,45,46,
-		28,29,46,
-		29,46,47,
-		29,30,47,
-		30,47,48,
-		30,31,48,
-		31,48,49,
-		31,32,49,
-		32,49,50,
-		32,33,50,
-		33,50,51,
-		33,34,51,
-		34,51,35,
-		34,18,35,
-		18,35,36,
-		18,19,36,
-		19,36,37,
-		19,20,37,
-		20,37,38,
-		20,21,38,
-		21,38,39,
-		21,22,39,
-		22,39,40,
-		22,23,40,
-		23,40,41,
-		23,24,41,
-		24,41,42,
-		24,25,42,
-		25,42,43,
-		25,26,43,
-		26,43,44,
-		26,27,44,
-
-		// ring 3 to ring 4
-		44,61,62,
-		44,45,62,
-		45,62,63,
-		45,46,63,
-		46,63,64,
-		46,47,64,
-		47,64,65,
-		47,48,65,
-		48,65,66,
-		48,49,66,
-		49,66,67,
-		49,50,67,
-		50,67,68,
-		50,51,68,
-		51,68,52,
-		51,35,52,
-		35,52,53,
-		35,36,53,
-		36,53,54,
-		36,37,54,
-		37,54,55,
-		37,38,55,
-		38,55,56,
-		38,39,56,
-		39,56,57,
-		39,40,57,
-		40,57,58,
-		40,41,58,
-		41,58,59,
-		41,42,59,
-		42,59,60,
-		42,43,60,
-		43,60,61,
-		43,44,61,
-
-		// ring 4 to ring 5
-		61,78,79,
-		61,62,79,
-		62,79,80,
-		62,63,80,
-		63,80,81,
-		63,64,81,
-		64,81,82,
-		64,65,82,
-		65,82,83,
-		65,66,83,
-		66,83,84,
-		66,67,84,
-		67,84,85,
-		67,68,85,
-		68,85,69,
-		68,52,69,
-		52,69,70,
-		52,53,70,
-		53,70,71,
-		53,54,71,
-		54,71,72,
-		54,55,72,
-		55,72,73,
-		55,56,73,
-		56,73,74,
-		56,57,74,
-		57,74,75,
-		57,58,75,
-		58,75,76,
-		58,59,76,
-		59,76,77,
-		59,60,77,
-		60,77,78,
-		60,61,78,
-
-		// ring 5 to ring 6
-		78,95,96,
-		78,79,96,
-		79,96,97,
-		79,80,97,
-		80,97,98,
-		80,81,98,
-		81,98,99,
-		81,82,99,
-		82,99,100,
-		82,83,100,
-		83,100,101,
-		83,84,101,
-		84,101,102,
-		84,85,102,
-		85,102,86,
-		85,69,86,
-		69,86,87,
-		69,70,87,
-		70,87,88,
-		70,71,88,
-		71,88,89,
-		71,72,89,
-		72,89,90,
-		72,73,90,
-		73,90,91,
-		73,74,91,
-		74,91,92,
-		74,75,92,
-		75,92,93,
-		75,76,93,
-		76,93,94,
-		76,77,94,
-		77,94,95,
-		77,78,95,
-
-		// ring 6 to ring 7
-		95,112,113,
-		95,96,113,
-		96,113,114,
-		96,97,114,
-		97,114,115,
-		97,98,115,
-		98,115,116,
-		98,99,116,
-		99,116,117,
-		99,100,117,
-		100,117,118,
-		100,101,118,
-		101,118,119,
-		101,102,119,
-		102,119,103,
-		102,86,103,
-		86,103,104,
-		86,87,104,
-		87,104,105,
-		87,88,105,
-		88,105,106,
-		88,89,106,
-		89,106,107,
-		89,90,107,
-		90,107,108,
-		90,91,108,
-		91,108,109,
-		91,92,109,
-		92,109,110,
-		92,93,110,
-		93,110,111,
-		93,94,111,
-		94,111,112,
-		94,95,112,
-
-		// ring 7 to ring 8
-		112,129,130,
-		112,113,130,
-		113,130,131,
-		113,114,131,
-		114,131,132,
-		114,115,132,
-		115,132,133,
-		115,116,133,
-		116,133,134,
-		116,117,134,
-		117,134,135,
-		117,118,135,
-		118,135,136,
-		118,119,136,
-		119,136,120,
-		119,103,120,
-		103,120,121,
-		103,104,121,
-		104,121,122,
-		104,105,122,
-		105,122,123,
-		105,106,123,
-		106,123,124,
-		106,107,124,
-		107,124,125,
-		107,108,125,
-		108,125,126,
-		108,109,126,
-		109,126,127,
-		109,110,127,
-		110,127,128,
-		110,111,128,
-		111,128,129,
-		111,112,129,
-
-		// ring 8 to ring 9
-		129,146,147,
-		129,130,147,
-		130,147,148,
-		130,131,148,
-		131,148,149,
-		131,132,149,
-		132,149,150,
-		132,133,150,
-		133,150,151,
-		133,134,151,
-		134,151,152,
-		134,135,152,
-		135,152,153,
-		135,136,153,
-		136,153,137,
-		136,120,137,
-		120,137,138,
-		120,121,138,
-		121,138,139,
-		121,122,139,
-		122,139,140,
-		122,123,140,
-		123,140,141,
-		123,124,141,
-		124,141,142,
-		124,125,142,
-		125,142,143,
-		125,126,143,
-		126,143,144,
-		126,127,144,
-		127,144,145,
-		127,128,145,
-		128,145,146,
-		128,129,146,
-
-		// ring 9 to ring 10
-		146,163,164,
-		146,147,164,
-		147,164,165,
-		147,148,165,
-		148,165,166,
-		148,149,166,
-		149,166,167,
-		149,150,167,
-		150,167,168,
-		150,151,168,
-		151,168,169,
-		151,152,169,
-		152,169,170,
-		152,153,170,
-		153,170,154,
-		153,137,154,
-		137,154,155,
-		137,138,155,
-		138,155,156,
-		138,139,156,
-		139,156,157,
-		139,140,157,
-		140,157,158,
-		140,141,158,
-		141,158,159,
-		141,142,159,
-		142,159,160,
-		142,143,160,
-		143,160,161,
-		143,144,161,
-		144,161,162,
-		144,145,162,
-		145,162,163,
-		145,146,163,
-
-		// ring 10 to ring 11
-		163,180,181,
-		163,164,181,
-		164,181,182,
-		164,165,182,
-		165,182,183,
-		165,166,183,
-		166,183,184,
-		166,167,184,
-		167,184,185,
-		167,168,185,
-		168,185,186,
-		168,169,186,
-		169,186,187,
-		169,170,187,
-		170,187,171,
-		170,154,171,
-		154,171,172,
-		154,155,172,
-		155,172,173,
-		155,156,173,
-		156,173,174,
-		156,157,174,
-		157,174,175,
-		157,158,175,
-		158,175,176,
-		158,159,176,
-		159,176,177,
-		159,160,177,
-		160,177,178,
-		160,161,178,
-		161,178,179,
-		161,162,179,
-		162,179,180,
-		162,163,180,
-
-		// ring 11 to ring 12
-		180,197,198,
-		180,181,198,
-		181,198,199,
-		181,182,199,
-		182,199,200,
-		182,183,200,
-		183,200,201,
-		183,184,201,
-		184,201,202,
-		184,185,202,
-		185,202,203,
-		185,186,203,
-		186,203,204,
-		186,187,204,
-		187,204,188,
-		187,171,188,
-		171,188,189,
-		171,172,189,
-		172,189,190,
-		172,173,190,
-		173,190,191,
-		173,174,191,
-		174,191,192,
-		174,175,192,
-		175,192,193,
-		175,176,193,
-		176,193,194,
-		176,177,194,
-		177,194,195,
-		177,178,195,
-		178,195,196,
-		178,179,196,
-		179,196,197,
-		179,180,197,
-
-		// ring 12 to ring 13
-		197,214,215,
-		197,198,215,
-		198,215,216,
-		198,199,216,
-		199,216,217,
-		199,200,217,
-		200,217,218,
-		200,201,218,
-		201,218,219,
-		201,202,219,
-		202,219,220,
-		202,203,220,
-		203,220,221,
-		203,204,221,
-		204,221,205,
-		204,188,205,
-		188,205,206,
-		188,189,206,
-		189,206,207,
-		189,190,207,
-		190,207,208,
-		190,191,208,
-		191,208,209,
-		191,192,209,
-		192,209,210,
-		192,193,210,
-		193,210,211,
-		193,194,211,
-		194,211,212,
-		194,195,212,
-		195,212,213,
-		195,196,213,
-		196,213,214,
-		196,197,214,
-
-		// ring 13 to ring 14
-		214,231,232,
-		214,215,232,
-		215,232,233,
-		215,216,233,
-		216,233,234,
-		216,217,234,
-		217,234,235,
-		217,218,235,
-		218,235,236,
-		218,219,236,
-		219,236,237,
-		219,220,237,
-		220,237,238,
-		220,221,238,
-		221,238,222,
-		221,205,222,
-		205,222,223,
-		205,206,223,
-		206,223,224,
-		206,207,224,
-		207,224,225,
-		207,208,225,
-		208,225,226,
-		208,209,226,
-		209,226,227,
-		209,210,227,
-		210,227,228,
-		210,211,228,
-		211,228,229,
-		211,212,229,
-		212,229,230,
-		212,213,230,
-		213,230,231,
-		213,214,231,
-
-		// ring 14 to ring 15
-		231,248,249,
-		231,232,249,
-		232,249,250,
-		232,233,250,
-		233,250,251,
-		233,234,251,
-		234,251,252,
-		234,235,252,
-		235,252,253,
-		235,236,253,
-		236,253,254,
-		236,237,254,
-		237,254,255,
-		237,238,255,
-		238,255,239,
-		238,222,239,
-		222,239,240,
-		222,223,240,
-		223,240,241,
-		223,224,241,
-		224,241,242,
-		224,225,242,
-		225,242,243,
-		225,226,243,
-		226,243,244,
-		226,227,244,
-		227,244,245,
-		227,228,245,
-		228,245,246,
-		228,229,246,
-		229,246,247,
-		229,230,247,
-		230,247,248,
-		230,231,248,
-
-		// ring 15 - bottom
-		248,256,249,
-		249,256,250,
-		250,256,251,
-		251,256,252,
-		252,256,253,
-		253,256,254,
-		254,256,255,
-		255,256,239,
-		239,256,240,
-		240,256,241,
-		241,256,242,
-		242,256,243,
-		243,256,244,
-		244,256,245,
-		245,256,246,
-		246,256,247,
-		247,256,248
-	};
-
-	// total float values per each type
-	const GLuint floatsPerVertex = 3;
-	const GLuint floatsPerNormal = 3;
-	const GLuint floatsPerUV = 2;
+	TRACE_SCOPE("LoadSphereMesh");
 
 	// store vertex and index count
-	m_SphereMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex));
-	m_SphereMesh.nIndices = sizeof(indices) / (sizeof(indices[0]));
+	m_SphereMesh.nVertices = (GLuint)g_SphereData.VERTEX_COUNT;
+	m_SphereMesh.nIndices = (GLuint)g_SphereData.INDEX_COUNT;
 
-	glm::vec3 normal;
-	glm::vec3 vert;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	float u, v;
-	std::vector<GLfloat> combined_values;
-
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < sizeof(verts) / (sizeof(verts[0])); i += 5)
-	{
-		vert = glm::vec3(verts[i], verts[i + 1], verts[i + 2]);
-		normal = normalize(vert - center);
-		//u = atan2(normal.x, normal.z) / (2 * M_PI) + 0.5;
-		//v = normal.y * 0.5 + 0.5;
-		combined_values.push_back(vert.x);
-		combined_values.push_back(vert.y);
-		combined_values.push_back(vert.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(verts[i + 3]);
-		combined_values.push_back(verts[i + 4]);
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_SphereMesh, g_SphereData.vertices.data(), g_SphereData.vertices.size(), g_SphereData.indices.data(), g_SphereData.indices.size());
+	if (m_bUploadEnabled == false)
+	{
+		return;
 	}
 
 	// Create VAO
@@ -1690,10 +828,10 @@ void ShapeMeshes::LoadSphereMesh()
 	// Create VBOs
 	glGenBuffers(2, m_SphereMesh.vbos);
 	glBindBuffer(GL_ARRAY_BUFFER, m_SphereMesh.vbos[0]); // Activates the vertex buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_SphereData.vertices), g_SphereData.vertices.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SphereMesh.vbos[1]); // Activates the index buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(g_SphereData.indices), g_SphereData.indices.data(), GL_STATIC_DRAW);
 
 	if (m_bMemoryLayoutDone == false)
 	{
@@ -1716,6 +854,8 @@ void ShapeMeshes::LoadSphereMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadTaperedCylinderMesh()
 {
+	TRACE_SCOPE("LoadTaperedCylinderMesh");
+
 	GLfloat verts[] = {
 		// cylinder bottom		// normals			// texture coords
 		1.0f, 0.0f, 0.0f,		0.0f, -1.0f, 0.0f,	0.5f,1.0f,
@@ -1946,6 +1086,13 @@ void ShapeMeshes::LoadTaperedCylinderMesh()
 	m_TaperedCylinderMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 	m_TaperedCylinderMesh.nIndices = 0;
 
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_TaperedCylinderMesh, verts, sizeof(verts) / sizeof(verts[0]), NULL, 0);
+	if (m_bUploadEnabled == false)
+	{
+		return;
+	}
+
 	// Create VAO
 	glGenVertexArrays(1, &m_TaperedCylinderMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_TaperedCylinderMesh.vao);
@@ -1974,6 +1121,8 @@ void ShapeMeshes::LoadTaperedCylinderMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadTorusMesh(float thickness)
 {
+	TRACE_SCOPE("LoadTorusMesh");
+
 	int _mainSegments = 30;
 	int _tubeSegments = 30;
 	float _mainRadius = 1.0f;
@@ -2169,6 +1318,13 @@ void ShapeMeshes::LoadTorusMesh(float thickness)
 	m_TorusMesh.nVertices = vertex_list.size();
 	m_TorusMesh.nIndices = 0;
 
+	// keep a copy in memory, which is all there is without OpenGL
+	KeepMeshData(m_TorusMesh, combined_values.data(), combined_values.size(), NULL, 0);
+	if (m_bUploadEnabled == false)
+	{
+		return;
+	}
+
 	// Create VAO
 	glGenVertexArrays(1, &m_TorusMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_TorusMesh.vao);
@@ -2194,11 +1350,13 @@ void ShapeMeshes::LoadTorusMesh(float thickness)
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawBoxMesh()
 {
-	glBindVertexArray(m_BoxMesh.vao);
+	PROFILE_SCOPE("DrawBoxMesh");
 
-	glDrawElements(GL_TRIANGLES, m_BoxMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	BindMesh(&m_BoxMesh);
 
-	glBindVertexArray(0);
+	DrawElements(m_BoxMesh, m_BoxMesh.nIndices);
+
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2210,15 +1368,17 @@ void ShapeMeshes::DrawBoxMesh()
 void ShapeMeshes::DrawConeMesh(
 	bool bDrawBottom)
 {
-	glBindVertexArray(m_ConeMesh.vao);
+	PROFILE_SCOPE("DrawConeMesh");
+
+	BindMesh(&m_ConeMesh);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
+		DrawArrays(m_ConeMesh, GL_TRIANGLE_FAN, 0, 36);		//bottom
 	}
-	glDrawArrays(GL_TRIANGLE_STRIP, 36, 108);	//sides
+	DrawArrays(m_ConeMesh, GL_TRIANGLE_STRIP, 36, 108);	//sides
 
-	glBindVertexArray(0);
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2232,22 +1392,24 @@ void ShapeMeshes::DrawCylinderMesh(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_CylinderMesh.vao);
+	PROFILE_SCOPE("DrawCylinderMesh");
+
+	BindMesh(&m_CylinderMesh);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
+		DrawArrays(m_CylinderMesh, GL_TRIANGLE_FAN, 0, 36);	//bottom
 	}
 	if (bDrawTop == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 36, 36);	//top
+		DrawArrays(m_CylinderMesh, GL_TRIANGLE_FAN, 36, 36);	//top
 	}
 	if (bDrawSides == true)
 	{
-		glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
+		DrawArrays(m_CylinderMesh, GL_TRIANGLE_STRIP, 72, 146);	//sides
 	}
 
-	glBindVertexArray(0);
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2258,11 +1420,13 @@ void ShapeMeshes::DrawCylinderMesh(
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPlaneMesh()
 {
-	glBindVertexArray(m_PlaneMesh.vao);
+	PROFILE_SCOPE("DrawPlaneMesh");
+
+	BindMesh(&m_PlaneMesh);
 
-	glDrawElements(GL_TRIANGLES, m_PlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawElements(m_PlaneMesh, m_PlaneMesh.nIndices);
 	
-	glBindVertexArray(0);
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2273,11 +1437,13 @@ void ShapeMeshes::DrawPlaneMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPrismMesh()
 {
-	glBindVertexArray(m_PrismMesh.vao);
+	PROFILE_SCOPE("DrawPrismMesh");
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices);
+	BindMesh(&m_PrismMesh);
 
-	glBindVertexArray(0);
+	DrawArrays(m_PrismMesh, GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices);
+
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2288,11 +1454,13 @@ void ShapeMeshes::DrawPrismMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPyramid3Mesh()
 {
-	glBindVertexArray(m_Pyramid3Mesh.vao);
+	PROFILE_SCOPE("DrawPyramid3Mesh");
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid3Mesh.nVertices);
+	BindMesh(&m_Pyramid3Mesh);
 
-	glBindVertexArray(0);
+	DrawArrays(m_Pyramid3Mesh, GL_TRIANGLE_STRIP, 0, m_Pyramid3Mesh.nVertices);
+
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2303,11 +1471,13 @@ void ShapeMeshes::DrawPyramid3Mesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPyramid4Mesh()
 {
-	glBindVertexArray(m_Pyramid4Mesh.vao);
+	PROFILE_SCOPE("DrawPyramid4Mesh");
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices);
+	BindMesh(&m_Pyramid4Mesh);
 
-	glBindVertexArray(0);
+	DrawArrays(m_Pyramid4Mesh, GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices);
+
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2318,11 +1488,13 @@ void ShapeMeshes::DrawPyramid4Mesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawSphereMesh()
 {
-	glBindVertexArray(m_SphereMesh.vao);
+	PROFILE_SCOPE("DrawSphereMesh");
 
-	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	BindMesh(&m_SphereMesh);
 
-	glBindVertexArray(0);
+	DrawElements(m_SphereMesh, m_SphereMesh.nIndices);
+
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2333,11 +1505,13 @@ void ShapeMeshes::DrawSphereMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfSphereMesh()
 {
-	glBindVertexArray(m_SphereMesh.vao);
+	PROFILE_SCOPE("DrawHalfSphereMesh");
 
-	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices/2, GL_UNSIGNED_INT, (void*)0);
+	BindMesh(&m_SphereMesh);
 
-	glBindVertexArray(0);
+	DrawElements(m_SphereMesh, m_SphereMesh.nIndices/2);
+
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2351,22 +1525,24 @@ void ShapeMeshes::DrawTaperedCylinderMesh(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
+	PROFILE_SCOPE("DrawTaperedCylinderMesh");
+
+	BindMesh(&m_TaperedCylinderMesh);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
+		DrawArrays(m_TaperedCylinderMesh, GL_TRIANGLE_FAN, 0, 36);	//bottom
 	}
 	if (bDrawTop == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 36, 72);	//top
+		DrawArrays(m_TaperedCylinderMesh, GL_TRIANGLE_FAN, 36, 72);	//top
 	}
 	if (bDrawSides == true)
 	{
-		glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
+		DrawArrays(m_TaperedCylinderMesh, GL_TRIANGLE_STRIP, 72, 146);	//sides
 	}
 
-	glBindVertexArray(0);
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2377,11 +1553,13 @@ void ShapeMeshes::DrawTaperedCylinderMesh(
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawTorusMesh()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	PROFILE_SCOPE("DrawTorusMesh");
 
-	glDrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices);
+	BindMesh(&m_TorusMesh);
 
-	glBindVertexArray(0);
+	DrawArrays(m_TorusMesh, GL_TRIANGLES, 0, m_TorusMesh.nVertices);
+
+	BindMesh(NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2392,11 +1570,619 @@ void ShapeMeshes::DrawTorusMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfTorusMesh()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	PROFILE_SCOPE("DrawHalfTorusMesh");
+
+	BindMesh(&m_TorusMesh);
+
+	DrawArrays(m_TorusMesh, GL_TRIANGLES, 0, m_TorusMesh.nVertices/2);
+
+	BindMesh(NULL);
+}
+
+///////////////////////////////////////////////////
+//	LoadLightmappedMesh()
+//
+//	Store triangles with lightmap coordinates in a VAO/VBO.
+//  The vertices have the layout of the other meshes with
+//  the lightmap coordinates added as attribute 3, and the
+//  previous triangles are freed.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadLightmappedMesh(const std::vector<LIGHTMAP_VERTEX>& vertices)
+{
+	TRACE_SCOPE("LoadLightmappedMesh");
+
+	if (m_LightmappedMesh.vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_LightmappedMesh.vao);
+		glDeleteBuffers(1, m_LightmappedMesh.vbos);
+		m_LightmappedMesh.vao = 0;
+		m_LightmappedMesh.vbos[0] = 0;
+	}
+	m_LightmappedMesh.nVertices = (GLuint)vertices.size();
+	if ((m_bUploadEnabled == false) || vertices.empty())
+	{
+		return;
+	}
+
+	glGenVertexArrays(1, &m_LightmappedMesh.vao);
+	glBindVertexArray(m_LightmappedMesh.vao);
+
+	glGenBuffers(1, m_LightmappedMesh.vbos);
+	glBindBuffer(GL_ARRAY_BUFFER, m_LightmappedMesh.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(LIGHTMAP_VERTEX), &vertices[0], GL_STATIC_DRAW);
+
+	// the layout of SetShaderMemoryLayout() with one more attribute,
+	// which the other meshes leave disabled
+	GLint stride = sizeof(LIGHTMAP_VERTEX);
+	glVertexAttribPointer(0, g_FloatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, g_FloatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * g_FloatsPerVertex));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, g_FloatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (g_FloatsPerVertex + g_FloatsPerNormal)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(3, g_FloatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV)));
+	glEnableVertexAttribArray(3);
+
+	glBindVertexArray(0);
+}
+
+///////////////////////////////////////////////////
+//	DrawLightmappedMesh()
+//
+//	Draw a range of the lightmapped triangles
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawLightmappedMesh(GLint first, GLsizei count)
+{
+	PROFILE_SCOPE("DrawLightmappedMesh");
+
+	BindMesh(&m_LightmappedMesh);
+
+	DrawArrays(m_LightmappedMesh, GL_TRIANGLES, first, count);
+
+	BindMesh(NULL);
+}
+
+///////////////////////////////////////////////////
+//	AddImportedMesh()
+//
+//	Add the vertices and indexed triangles of an
+//  imported mesh to the end of the shared imported
+//  meshes.  The indices stay relative to the mesh,
+//  it is drawn from its base vertex.
+///////////////////////////////////////////////////
+int ShapeMeshes::AddImportedMesh(const MESH_VERTEX* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount)
+{
+	IMPORTED_RANGE range;
+	range.firstIndex = (GLuint)m_ImportedMesh.indexData.size();
+	range.indexCount = (GLuint)(indexCount - (indexCount % 3));
+	range.baseVertex = (GLint)m_ImportedMesh.nVertices;
+	range.vertexOffset = 0;
+	range.vertexBytes = 0;
+	range.indexOffset = 0;
+	range.indexBytes = 0;
+	m_importedRanges.push_back(range);
+
+	const GLfloat* pFloats = (const GLfloat*)vertices;
+	m_ImportedMesh.vertexData.insert(m_ImportedMesh.vertexData.end(), pFloats, pFloats + (vertexCount * sizeof(MESH_VERTEX) / sizeof(GLfloat)));
+	m_ImportedMesh.indexData.insert(m_ImportedMesh.indexData.end(), indices, indices + range.indexCount);
+	m_ImportedMesh.nVertices += (GLuint)vertexCount;
+	m_ImportedMesh.nIndices += range.indexCount;
+
+	return (int)m_importedRanges.size() - 1;
+}
+
+///////////////////////////////////////////////////
+//	UploadImportedMeshes()
+//
+//	Store all of the imported meshes in one VAO with
+//  one vertex and one index buffer, replacing the
+//  ones of an earlier upload.  The packed vertices
+//  give the shaders the same attributes, normalized
+//  from 10 bit integers and half floats.
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadImportedMeshes()
+{
+	TRACE_SCOPE("UploadImportedMeshes");
+
+	if (m_ImportedMesh.vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_ImportedMesh.vao);
+		glDeleteBuffers(2, m_ImportedMesh.vbos);
+		m_ImportedMesh.vao = 0;
+		m_ImportedMesh.vbos[0] = 0;
+		m_ImportedMesh.vbos[1] = 0;
+	}
+	if ((m_bUploadEnabled == false) || (m_ImportedMesh.nVertices == 0))
+	{
+		return;
+	}
+
+	glGenVertexArrays(1, &m_ImportedMesh.vao);
+	glBindVertexArray(m_ImportedMesh.vao);
+	glGenBuffers(2, m_ImportedMesh.vbos);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_ImportedMesh.vbos[0]);
+	if (m_bPackImportedMeshes)
+	{
+		std::vector<PACKED_VERTEX> packed;
+		PackVertices((const MESH_VERTEX*)m_ImportedMesh.vertexData.data(), m_ImportedMesh.nVertices, packed);
+		glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PACKED_VERTEX), packed.data(), GL_STATIC_DRAW);
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, m_ImportedMesh.vertexData.size() * sizeof(GLfloat), m_ImportedMesh.vertexData.data(), GL_STATIC_DRAW);
+	}
+	SetImportedMemoryLayout();
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ImportedMesh.vbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_ImportedMesh.indexData.size() * sizeof(GLuint), m_ImportedMesh.indexData.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+}
+
+///////////////////////////////////////////////////
+//	DrawImportedMesh()
+//
+//	Draw the triangles of an imported mesh, or add
+//  them to the captured triangles
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawImportedMesh(int index)
+{
+	PROFILE_SCOPE("DrawImportedMesh");
+
+	if ((index < 0) || (index >= (int)m_importedRanges.size()))
+	{
+		return;
+	}
+	const IMPORTED_RANGE& range = m_importedRanges[index];
+	if (range.indexCount == 0)
+	{
+		return;
+	}
+
+	if (NULL != m_pCapture)
+	{
+		// the meshes of a pool have no copy in memory to capture
+		for (GLuint i = 0; (i + 2 < range.indexCount) && ((size_t)range.firstIndex + i + 2 < m_ImportedMesh.indexData.size()); i += 3)
+		{
+			const GLuint* pIndices = &m_ImportedMesh.indexData[range.firstIndex + i];
+			AddCapturedTriangle(m_ImportedMesh, range.baseVertex + pIndices[0], range.baseVertex + pIndices[1], range.baseVertex + pIndices[2]);
+		}
+		return;
+	}
+
+	BindMesh(&m_ImportedMesh);
+
+	glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, (void*)(range.firstIndex * sizeof(GLuint)), range.baseVertex);
+	CountDraw(GL_TRIANGLES, range.indexCount);
+
+	BindMesh(NULL);
+}
+
+///////////////////////////////////////////////////
+//	SetPackedImportedMeshes()
+//
+//	Upload the following imported meshes as packed
+//  vertices, or as the interleaved floats
+///////////////////////////////////////////////////
+void ShapeMeshes::SetPackedImportedMeshes(bool bPacked)
+{
+	m_bPackImportedMeshes = bPacked;
+}
+
+///////////////////////////////////////////////////
+//	CreateImportedMeshPool()
+//
+//	Store the imported meshes in one buffer of a fixed
+//  size, which holds both the vertices and the indices
+//  of the meshes that are loaded into it.  The meshes
+//  come and go, so nothing is kept in memory.
+///////////////////////////////////////////////////
+bool ShapeMeshes::CreateImportedMeshPool(size_t bytes)
+{
+	TRACE_SCOPE("CreateImportedMeshPool");
 
-	glDrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices/2);
+	if ((m_bUploadEnabled == false) || (bytes == 0) || !m_importedRanges.empty())
+	{
+		return false;
+	}
 
+	glGenVertexArrays(1, &m_ImportedMesh.vao);
+	glBindVertexArray(m_ImportedMesh.vao);
+	glGenBuffers(1, m_ImportedMesh.vbos);
+	m_ImportedMesh.vbos[1] = 0;
+
+	// the element binding is part of the VAO, so the indices are
+	// read from the same buffer
+	glBindBuffer(GL_ARRAY_BUFFER, m_ImportedMesh.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ImportedMesh.vbos[0]);
+	SetImportedMemoryLayout();
 	glBindVertexArray(0);
+
+	m_poolSize = bytes;
+	m_poolFree.clear();
+	POOL_BLOCK block = { 0, bytes };
+	m_poolFree.push_back(block);
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	ReserveImportedMesh()
+//
+//	Add an imported mesh without any triangles, which
+//  draws nothing until its data is loaded
+///////////////////////////////////////////////////
+int ShapeMeshes::ReserveImportedMesh()
+{
+	IMPORTED_RANGE range = { 0, 0, 0, 0, 0, 0, 0 };
+	m_importedRanges.push_back(range);
+	return (int)m_importedRanges.size() - 1;
+}
+
+///////////////////////////////////////////////////
+//	LoadImportedMesh()
+//
+//	Copy the data of a reserved mesh into free parts
+//  of the pool.  The vertices start at a multiple of
+//  their size, so that the mesh is drawn from its
+//  base vertex like the meshes of the shared buffers.
+///////////////////////////////////////////////////
+bool ShapeMeshes::LoadImportedMesh(int index, const MESH_VERTEX* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount)
+{
+	TRACE_SCOPE("LoadImportedMesh");
+
+	if ((m_poolSize == 0) || (index < 0) || (index >= (int)m_importedRanges.size()))
+	{
+		return false;
+	}
+	UnloadImportedMesh(index);
+
+	IMPORTED_RANGE& range = m_importedRanges[index];
+	size_t vertexSize = GetImportedVertexSize();
+	size_t vertexBytes = vertexCount * vertexSize;
+	size_t indexBytes = (indexCount - (indexCount % 3)) * sizeof(GLuint);
+	size_t vertexOffset = 0;
+	size_t indexOffset = 0;
+	if ((vertexBytes == 0) || (indexBytes == 0) || !AllocatePoolBlock(vertexBytes, vertexSize, vertexOffset))
+	{
+		return false;
+	}
+	if (!AllocatePoolBlock(indexBytes, sizeof(GLuint), indexOffset))
+	{
+		FreePoolBlock(vertexOffset, vertexBytes);
+		return false;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_ImportedMesh.vbos[0]);
+	if (m_bPackImportedMeshes)
+	{
+		std::vector<PACKED_VERTEX> packed;
+		PackVertices(vertices, vertexCount, packed);
+		glBufferSubData(GL_ARRAY_BUFFER, vertexOffset, vertexBytes, packed.data());
+	}
+	else
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, vertexOffset, vertexBytes, vertices);
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, indexOffset, indexBytes, indices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	range.firstIndex = (GLuint)(indexOffset / sizeof(GLuint));
+	range.indexCount = (GLuint)(indexBytes / sizeof(GLuint));
+	range.baseVertex = (GLint)(vertexOffset / vertexSize);
+	range.vertexOffset = vertexOffset;
+	range.vertexBytes = vertexBytes;
+	range.indexOffset = indexOffset;
+	range.indexBytes = indexBytes;
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	UnloadImportedMesh()
+//
+//	Give the parts of the pool that a mesh was loaded
+//  into back, the mesh draws nothing until it is
+//  loaded again
+///////////////////////////////////////////////////
+void ShapeMeshes::UnloadImportedMesh(int index)
+{
+	if ((m_poolSize == 0) || (index < 0) || (index >= (int)m_importedRanges.size()))
+	{
+		return;
+	}
+
+	IMPORTED_RANGE& range = m_importedRanges[index];
+	if (range.indexBytes > 0)
+	{
+		FreePoolBlock(range.vertexOffset, range.vertexBytes);
+		FreePoolBlock(range.indexOffset, range.indexBytes);
+	}
+	range.indexCount = 0;
+	range.vertexBytes = 0;
+	range.indexBytes = 0;
+}
+
+///////////////////////////////////////////////////
+//	IsImportedMeshLoaded()
+//
+//	True when an imported mesh has triangles to draw
+///////////////////////////////////////////////////
+bool ShapeMeshes::IsImportedMeshLoaded(int index) const
+{
+	return (index >= 0) && (index < (int)m_importedRanges.size()) && (m_importedRanges[index].indexCount > 0);
+}
+
+///////////////////////////////////////////////////
+//	AllocatePoolBlock()
+//
+//	Take the first free part of the pool that holds
+//  the size from an aligned offset.  The bytes that
+//  are skipped for the alignment stay free.
+///////////////////////////////////////////////////
+bool ShapeMeshes::AllocatePoolBlock(size_t size, size_t alignment, size_t& offset)
+{
+	for (size_t i = 0; i < m_poolFree.size(); i++)
+	{
+		POOL_BLOCK block = m_poolFree[i];
+		size_t start = ((block.offset + alignment - 1) / alignment) * alignment;
+		if (start + size > block.offset + block.size)
+		{
+			continue;
+		}
+
+		// the block is split into the part before the start, the
+		// taken part and the part after it
+		m_poolFree.erase(m_poolFree.begin() + i);
+		size_t end = start + size;
+		if (end < block.offset + block.size)
+		{
+			POOL_BLOCK after = { end, block.offset + block.size - end };
+			m_poolFree.insert(m_poolFree.begin() + i, after);
+		}
+		if (start > block.offset)
+		{
+			POOL_BLOCK before = { block.offset, start - block.offset };
+			m_poolFree.insert(m_poolFree.begin() + i, before);
+		}
+		offset = start;
+		return true;
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////
+//	FreePoolBlock()
+//
+//	Give a part of the pool back, joined with the free
+//  parts on either side of it
+///////////////////////////////////////////////////
+void ShapeMeshes::FreePoolBlock(size_t offset, size_t size)
+{
+	size_t i = 0;
+	while ((i < m_poolFree.size()) && (m_poolFree[i].offset < offset))
+	{
+		i++;
+	}
+	POOL_BLOCK block = { offset, size };
+	m_poolFree.insert(m_poolFree.begin() + i, block);
+
+	if ((i + 1 < m_poolFree.size()) && (m_poolFree[i].offset + m_poolFree[i].size == m_poolFree[i + 1].offset))
+	{
+		m_poolFree[i].size += m_poolFree[i + 1].size;
+		m_poolFree.erase(m_poolFree.begin() + i + 1);
+	}
+	if ((i > 0) && (m_poolFree[i - 1].offset + m_poolFree[i - 1].size == m_poolFree[i].offset))
+	{
+		m_poolFree[i - 1].size += m_poolFree[i].size;
+		m_poolFree.erase(m_poolFree.begin() + i);
+	}
+}
+
+///////////////////////////////////////////////////
+//	SetImportedMemoryLayout()
+//
+//	Set the attributes of the imported meshes, which
+//  are the ones of SetShaderMemoryLayout() unless the
+//  vertices are packed
+///////////////////////////////////////////////////
+void ShapeMeshes::SetImportedMemoryLayout()
+{
+	if (m_bPackImportedMeshes == false)
+	{
+		SetShaderMemoryLayout();
+		return;
+	}
+
+	GLint stride = sizeof(PACKED_VERTEX);
+	glVertexAttribPointer(0, g_FloatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PACKED_VERTEX, normal));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, g_FloatsPerUV, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PACKED_VERTEX, textureCoordinate));
+	glEnableVertexAttribArray(2);
+}
+
+///////////////////////////////////////////////////
+//	ResetDrawStatistics()
+//
+//	Clear the draw call and triangle counts
+///////////////////////////////////////////////////
+void ShapeMeshes::ResetDrawStatistics()
+{
+	m_drawStatistics.drawCalls = 0;
+	m_drawStatistics.triangles = 0;
+}
+
+///////////////////////////////////////////////////
+//	CountDraw()
+//
+//	Add a submitted draw call to the draw statistics
+///////////////////////////////////////////////////
+void ShapeMeshes::CountDraw(GLenum mode, GLsizei count)
+{
+	m_drawStatistics.drawCalls++;
+	if (mode == GL_TRIANGLES)
+	{
+		m_drawStatistics.triangles += count / 3;
+	}
+	else if (count > 2)
+	{
+		// strips and fans add one triangle per vertex after the first two
+		m_drawStatistics.triangles += count - 2;
+	}
+}
+
+///////////////////////////////////////////////////
+//	SetUploadEnabled()
+//
+//	Load the meshes into OpenGL buffers, or keep them
+//  in memory only
+///////////////////////////////////////////////////
+void ShapeMeshes::SetUploadEnabled(bool bEnabled)
+{
+	m_bUploadEnabled = bEnabled;
+}
+
+///////////////////////////////////////////////////
+//	CaptureTriangles()
+//
+//	Collect the triangles of the following Draw calls
+//  instead of drawing them.  The triangles come out in
+//  the order that OpenGL assembles them, so a CPU
+//  renderer draws exactly what the GPU would.
+///////////////////////////////////////////////////
+void ShapeMeshes::CaptureTriangles(std::vector<MESH_VERTEX>* pTriangles)
+{
+	m_pCapture = pTriangles;
+}
+
+///////////////////////////////////////////////////
+//	KeepMeshData()
+//
+//	Keep a copy of the interleaved vertices and the
+//  indices of a mesh in memory
+///////////////////////////////////////////////////
+void ShapeMeshes::KeepMeshData(GLMesh& mesh, const GLfloat* vertices, size_t vertexFloats, const GLuint* indices, size_t indexCount)
+{
+	mesh.vertexData.assign(vertices, vertices + vertexFloats);
+	mesh.indexData.clear();
+	if (NULL != indices)
+	{
+		mesh.indexData.assign(indices, indices + indexCount);
+	}
+}
+
+///////////////////////////////////////////////////
+//	BindMesh()
+//
+//	Bind the vertex array of a mesh, nothing is bound
+//  while the triangles are captured
+///////////////////////////////////////////////////
+void ShapeMeshes::BindMesh(const GLMesh* pMesh)
+{
+	if (NULL != m_pCapture)
+	{
+		return;
+	}
+	glBindVertexArray((NULL != pMesh) ? pMesh->vao : 0);
+}
+
+///////////////////////////////////////////////////
+//	DrawArrays()
+//
+//	Draw a range of the vertices of a mesh, or add the
+//  triangles of the range to the captured triangles
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawArrays(const GLMesh& mesh, GLenum mode, GLint first, GLsizei count)
+{
+	if (NULL == m_pCapture)
+	{
+		glDrawArrays(mode, first, count);
+		CountDraw(mode, count);
+		return;
+	}
+
+	GLuint base = (GLuint)first;
+	switch (mode)
+	{
+	case GL_TRIANGLES:
+		for (GLsizei i = 0; i + 2 < count; i += 3)
+		{
+			AddCapturedTriangle(mesh, base + i, base + i + 1, base + i + 2);
+		}
+		break;
+	case GL_TRIANGLE_STRIP:
+		// every other triangle of a strip is flipped to keep the winding
+		for (GLsizei i = 0; i + 2 < count; i++)
+		{
+			if ((i % 2) == 0)
+			{
+				AddCapturedTriangle(mesh, base + i, base + i + 1, base + i + 2);
+			}
+			else
+			{
+				AddCapturedTriangle(mesh, base + i + 1, base + i, base + i + 2);
+			}
+		}
+		break;
+	case GL_TRIANGLE_FAN:
+		for (GLsizei i = 1; i + 1 < count; i++)
+		{
+			AddCapturedTriangle(mesh, base, base + i, base + i + 1);
+		}
+		break;
+	}
+}
+
+///////////////////////////////////////////////////
+//	DrawElements()
+//
+//	Draw the first indexed triangles of a mesh, or add
+//  them to the captured triangles
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawElements(const GLMesh& mesh, GLsizei count)
+{
+	if (NULL == m_pCapture)
+	{
+		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)0);
+		CountDraw(GL_TRIANGLES, count);
+		return;
+	}
+
+	for (GLsizei i = 0; (i + 2 < count) && ((size_t)i + 2 < mesh.indexData.size()); i += 3)
+	{
+		AddCapturedTriangle(mesh, mesh.indexData[i], mesh.indexData[i + 1], mesh.indexData[i + 2]);
+	}
+}
+
+///////////////////////////////////////////////////
+//	AddCapturedTriangle()
+//
+//	Add three vertices of a mesh to the captured
+//  triangles.  The vertices past the end of a mesh
+//  are undefined in OpenGL, so a triangle that uses
+//  one of them is left out.
+///////////////////////////////////////////////////
+void ShapeMeshes::AddCapturedTriangle(const GLMesh& mesh, GLuint a, GLuint b, GLuint c)
+{
+	const GLuint floatsPerVertex = g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV;
+	size_t vertexCount = mesh.vertexData.size() / floatsPerVertex;
+	if ((a >= vertexCount) || (b >= vertexCount) || (c >= vertexCount))
+	{
+		return;
+	}
+
+	const GLuint corners[3] = { a, b, c };
+	for (int i = 0; i < 3; i++)
+	{
+		const GLfloat* pData = &mesh.vertexData[corners[i] * floatsPerVertex];
+		MESH_VERTEX vertex;
+		vertex.position = glm::vec3(pData[0], pData[1], pData[2]);
+		vertex.normal = glm::vec3(pData[3], pData[4], pData[5]);
+		vertex.textureCoordinate = glm::vec2(pData[6], pData[7]);
+		m_pCapture->push_back(vertex);
+	}
 }
 
 glm::vec3 ShapeMeshes::CalculateTriangleNormal(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2)
@@ -14,6 +14,10 @@
 
 #include <glm/glm.hpp>
 
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
 /***********************************************************
  *  ShapeMeshes
  *
@@ -26,6 +30,41 @@ public:
 	// constructor
 	ShapeMeshes();
 
+	// number of draw calls and triangles submitted by the
+	// Draw methods since the last reset
+	struct DRAW_STATISTICS
+	{
+		unsigned int drawCalls;
+		unsigned int triangles;
+	};
+
+	// one vertex of the interleaved layout that is set up by
+	// SetShaderMemoryLayout()
+	struct MESH_VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// one vertex of the lightmapped mesh, a mesh vertex followed
+	// by its texture coordinate in the lightmap
+	struct LIGHTMAP_VERTEX
+	{
+		MESH_VERTEX vertex;
+		glm::vec2 lightmapCoordinate;
+	};
+
+	// one vertex of the imported meshes when they are packed,
+	// the normal in 10 bits per axis and the texture coordinate
+	// in half floats - 20 bytes instead of 32
+	struct PACKED_VERTEX
+	{
+		glm::vec3 position;
+		uint32_t normal;
+		uint32_t textureCoordinate;
+	};
+
 private:
 
 	// stores the GL data relative to a given mesh
@@ -35,6 +74,8 @@ private:
 		GLuint vbos[2];     // Handles for the vertex buffer objects
 		GLuint nVertices;	// Number of vertices for the mesh
 		GLuint nIndices;    // Number of indices for the mesh
+		std::vector<GLfloat> vertexData;	// copy of the interleaved vertices
+		std::vector<GLuint> indexData;		// copy of the indices
 	};
 
 	// the available 3D shapes
@@ -48,9 +89,51 @@ private:
 	GLMesh m_SphereMesh;
 	GLMesh m_TaperedCylinderMesh;
 	GLMesh m_TorusMesh;
+	// the triangles of the lightmapped objects, placed in the
+	// world and given their own lightmap coordinates
+	GLMesh m_LightmappedMesh;
+
+	// the place of an imported mesh in the shared buffers
+	struct IMPORTED_RANGE
+	{
+		GLuint firstIndex;
+		GLuint indexCount;
+		GLint baseVertex;
+		// the bytes of the mesh in the pool while it is loaded
+		size_t vertexOffset;
+		size_t vertexBytes;
+		size_t indexOffset;
+		size_t indexBytes;
+	};
+	// a free part of the pool
+	struct POOL_BLOCK
+	{
+		size_t offset;
+		size_t size;
+	};
+	// all of the imported meshes, in one vertex and one index
+	// buffer so that drawing another one binds nothing new
+	GLMesh m_ImportedMesh;
+	std::vector<IMPORTED_RANGE> m_importedRanges;
+	// true to upload the imported meshes as PACKED_VERTEX
+	bool m_bPackImportedMeshes;
+	// the size of the pool that the imported meshes are loaded
+	// into one at a time, or 0, and its free parts by offset
+	size_t m_poolSize;
+	std::vector<POOL_BLOCK> m_poolFree;
 
 	bool m_bMemoryLayoutDone;
 
+	// false when the meshes are only kept in memory, without
+	// any OpenGL buffers
+	bool m_bUploadEnabled;
+	// list that the Draw methods add their triangles to
+	// instead of drawing them, or NULL
+	std::vector<MESH_VERTEX>* m_pCapture;
+
+	// draw calls and triangles submitted since the last reset
+	DRAW_STATISTICS m_drawStatistics;
+
 public:
 	// methods for loading the shape mesh data 
 	// into memory
@@ -87,6 +170,44 @@ public:
 	void DrawTorusMesh();
 	void DrawHalfTorusMesh();
 
+	// load triangles with lightmap coordinates, three vertices
+	// each, replacing the previous ones, and draw a range of them
+	void LoadLightmappedMesh(const std::vector<LIGHTMAP_VERTEX>& vertices);
+	void DrawLightmappedMesh(GLint first, GLsizei count);
+
+	// add an imported mesh to the shared buffers and get its
+	// index, upload all of the added meshes, and draw one
+	int AddImportedMesh(const MESH_VERTEX* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount);
+	void UploadImportedMeshes();
+	void DrawImportedMesh(int index);
+	int GetImportedMeshCount() const { return (int)m_importedRanges.size(); }
+	// upload the imported meshes with packed normals and texture
+	// coordinates, which the shaders read the same way
+	void SetPackedImportedMeshes(bool bPacked);
+	size_t GetImportedVertexSize() const { return m_bPackImportedMeshes ? sizeof(PACKED_VERTEX) : sizeof(MESH_VERTEX); }
+
+	// keep the imported meshes in one buffer of a fixed size
+	// instead, reserve a mesh in it without any data, and load
+	// and unload the data of the reserved meshes - a load that
+	// does not fit in the free parts of the pool returns false
+	bool CreateImportedMeshPool(size_t bytes);
+	int ReserveImportedMesh();
+	bool LoadImportedMesh(int index, const MESH_VERTEX* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount);
+	void UnloadImportedMesh(int index);
+	bool IsImportedMeshLoaded(int index) const;
+
+	// get or clear the draw call and triangle counts
+	const DRAW_STATISTICS& GetDrawStatistics() const { return m_drawStatistics; }
+	void ResetDrawStatistics();
+
+	// load the following meshes into memory only, so that they
+	// can be used without an OpenGL context
+	void SetUploadEnabled(bool bEnabled);
+	// add the triangles of the following Draw calls to a list,
+	// three vertices each, instead of drawing them - NULL goes
+	// back to drawing
+	void CaptureTriangles(std::vector<MESH_VERTEX>* pTriangles);
+
 
 private:
 
@@ -98,4 +219,24 @@ private:
 	// called to set the memory layout 
 	// template for shader data
 	void SetShaderMemoryLayout();
+
+	// add a submitted draw call to the draw statistics
+	void CountDraw(GLenum mode, GLsizei count);
+
+	// keep the mesh data in memory for CaptureTriangles()
+	void KeepMeshData(GLMesh& mesh, const GLfloat* vertices, size_t vertexFloats, const GLuint* indices, size_t indexCount);
+	// bind a mesh for drawing, or unbind it with NULL
+	void BindMesh(const GLMesh* pMesh);
+	// draw a range of the vertices, or of the indices, of a mesh
+	void DrawArrays(const GLMesh& mesh, GLenum mode, GLint first, GLsizei count);
+	void DrawElements(const GLMesh& mesh, GLsizei count);
+	// add a triangle of a mesh to the captured triangles
+	void AddCapturedTriangle(const GLMesh& mesh, GLuint a, GLuint b, GLuint c);
+
+	// set the attributes of the bound imported mesh VAO
+	void SetImportedMemoryLayout();
+	// take a block of the pool that starts at a multiple of the
+	// alignment, or give one back
+	bool AllocatePoolBlock(size_t size, size_t alignment, size_t& offset);
+	void FreePoolBlock(size_t offset, size_t size);
 };
\ No newline at end of file
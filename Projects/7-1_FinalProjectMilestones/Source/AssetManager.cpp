@@ -0,0 +1,601 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetmanager.cpp
+// ============
+// stream the textures and imported meshes of a scene in and out of memory,
+// nearest first, within budgets of CPU and GPU memory
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetManager.h"
+#include "SceneManager.h"
+#include "FrameProfiler.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+
+// declaration of global variables
+namespace
+{
+	const size_t g_Megabyte = 1024 * 1024;
+
+	// the size of a file, which the first load of an asset is
+	// counted with, or 0 when it cannot be read
+	size_t GetFileSize(const char* filename)
+	{
+		FILE* file = fopen(filename, "rb");
+		if (NULL == file)
+		{
+			return 0;
+		}
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fclose(file);
+		return (size > 0) ? (size_t)size : 0;
+	}
+}
+
+/***********************************************************
+ *  GetDefaultBudget()
+ *
+ *  This method is used to get the budget of the streaming
+ *  that is used unless another one is passed.
+ ***********************************************************/
+void AssetManager::GetDefaultBudget(BUDGET& budget)
+{
+	budget.cpuBytes = 256 * g_Megabyte;
+	budget.gpuBytes = 512 * g_Megabyte;
+	budget.evictFrames = 300;
+	budget.uploadsPerFrame = 2;
+}
+
+/***********************************************************
+ *  AssetManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AssetManager::AssetManager(ShapeMeshes* pMeshes, JobSystem* pJobSystem)
+{
+	m_pMeshes = pMeshes;
+	m_pJobSystem = pJobSystem;
+	GetDefaultBudget(m_budget);
+	m_textureBudget = m_budget.gpuBytes;
+	m_poolBytes = 0;
+	// frame 0 is the last use of the assets that were never used
+	m_frame = 1;
+	m_cpuBytes = 0;
+	m_textureBytes = 0;
+	m_meshBytes = 0;
+	m_bResidencyChanged = false;
+	m_statistics = ASSET_STATISTICS();
+}
+
+/***********************************************************
+ *  ~AssetManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AssetManager::~AssetManager()
+{
+	// the loads in flight write into the assets
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->Wait(&m_loadJobs);
+	}
+
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		Evict((int)i);
+		FreeDecodedData(m_assets[i]);
+		delete m_assets[i];
+	}
+	m_assets.clear();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to set the budget and split the GPU
+ *  part of it between the textures and the mesh pool.
+ ***********************************************************/
+bool AssetManager::Initialize(const BUDGET& budget, bool bMeshPool)
+{
+	m_budget = budget;
+	m_budget.evictFrames = std::max(m_budget.evictFrames, 1);
+	m_budget.uploadsPerFrame = std::max(m_budget.uploadsPerFrame, 1);
+
+	m_poolBytes = bMeshPool ? (m_budget.gpuBytes / 4) : 0;
+	m_textureBudget = m_budget.gpuBytes - m_poolBytes;
+	if ((m_poolBytes > 0) && !m_pMeshes->CreateImportedMeshPool(m_poolBytes))
+	{
+		std::cout << "Could not create the mesh pool of " << (m_poolBytes / g_Megabyte) << " MB" << std::endl;
+		return false;
+	}
+
+	// the setting is shared by the decoding jobs, so it is made
+	// before any of them runs
+	stbi_set_flip_vertically_on_load(true);
+	return true;
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used to add a texture that is loaded from
+ *  its image file when a draw uses it.
+ ***********************************************************/
+int AssetManager::AddTexture(const std::string& filename)
+{
+	ASSET* pAsset = new ASSET();
+	pAsset->type = ASSET_TEXTURE;
+	pAsset->filename = filename;
+	pAsset->state = ASSET_UNLOADED;
+	pAsset->references = 0;
+	pAsset->lastUsedFrame = 0;
+	pAsset->distance = 0.0f;
+	pAsset->cpuBytes = GetFileSize(filename.c_str());
+	pAsset->gpuBytes = 0;
+	pAsset->textureID = 0;
+	pAsset->importedMesh = -1;
+	pAsset->pixels = NULL;
+	pAsset->width = 0;
+	pAsset->height = 0;
+	pAsset->colorChannels = 0;
+	pAsset->chargedBytes = 0;
+	pAsset->bDecoded = false;
+	pAsset->bDecodeFailed = false;
+	m_assets.push_back(pAsset);
+	return (int)m_assets.size() - 1;
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used to add an imported mesh, reserved in
+ *  the mesh pool, that is loaded from its file when a draw
+ *  uses it.
+ ***********************************************************/
+int AssetManager::AddMesh(const std::string& filename, int importedMesh)
+{
+	int asset = AddTexture(filename);
+	m_assets[asset]->type = ASSET_MESH;
+	m_assets[asset]->importedMesh = importedMesh;
+	return asset;
+}
+
+/***********************************************************
+ *  AddReference()
+ *
+ *  This method is used to count an object that references
+ *  an asset.
+ ***********************************************************/
+void AssetManager::AddReference(int asset)
+{
+	if ((asset >= 0) && (asset < (int)m_assets.size()))
+	{
+		m_assets[asset]->references++;
+	}
+}
+
+/***********************************************************
+ *  ReleaseReference()
+ *
+ *  This method is used to stop counting an object that
+ *  referenced an asset.  An asset without references is
+ *  freed at the end of the frame.
+ ***********************************************************/
+void AssetManager::ReleaseReference(int asset)
+{
+	if ((asset >= 0) && (asset < (int)m_assets.size()) && (m_assets[asset]->references > 0))
+	{
+		m_assets[asset]->references--;
+	}
+}
+
+/***********************************************************
+ *  UseTexture()
+ *
+ *  This method is used to mark a texture as used by a draw
+ *  of this frame and get its OpenGL texture.
+ ***********************************************************/
+GLuint AssetManager::UseTexture(int asset, float distance)
+{
+	if ((asset < 0) || (asset >= (int)m_assets.size()))
+	{
+		return 0;
+	}
+
+	ASSET* pAsset = m_assets[asset];
+	if (pAsset->lastUsedFrame != m_frame)
+	{
+		pAsset->lastUsedFrame = m_frame;
+		pAsset->distance = distance;
+	}
+	pAsset->distance = std::min(pAsset->distance, distance);
+	return (pAsset->state == ASSET_RESIDENT) ? pAsset->textureID : 0;
+}
+
+/***********************************************************
+ *  UseMesh()
+ *
+ *  This method is used to mark an imported mesh as used by
+ *  a draw of this frame.
+ ***********************************************************/
+bool AssetManager::UseMesh(int asset, float distance)
+{
+	// the mark is the same as the one of a texture
+	UseTexture(asset, distance);
+	return (asset >= 0) && (asset < (int)m_assets.size()) && (m_assets[asset]->state == ASSET_RESIDENT);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to free the assets that are no
+ *  longer used, upload the decoded ones and start the loads
+ *  of the used ones that are not in memory.  The loads are
+ *  ordered by the distance of the nearest draw that used
+ *  them, so the closest objects get their assets first.
+ ***********************************************************/
+void AssetManager::EndFrame()
+{
+	PROFILE_SCOPE("StreamAssets");
+
+	m_bResidencyChanged = false;
+
+	// 1) free the assets that were not used for long enough
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		ASSET* pAsset = m_assets[i];
+		if ((pAsset->state == ASSET_RESIDENT) &&
+			((pAsset->references <= 0) || (m_frame - pAsset->lastUsedFrame >= (unsigned int)m_budget.evictFrames)))
+		{
+			Evict((int)i);
+		}
+	}
+
+	// 2) upload the decoded assets, nearest first
+	std::vector<int> decoded;
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		ASSET* pAsset = m_assets[i];
+		if ((pAsset->state == ASSET_LOADING) && pAsset->bDecoded.load(std::memory_order_acquire))
+		{
+			decoded.push_back((int)i);
+		}
+	}
+	std::stable_sort(decoded.begin(), decoded.end(),
+		[this](int a, int b) { return m_assets[a]->distance < m_assets[b]->distance; });
+
+	int uploads = 0;
+	for (size_t i = 0; i < decoded.size(); i++)
+	{
+		ASSET* pAsset = m_assets[decoded[i]];
+
+		// the load is counted with its real size from here on
+		m_cpuBytes = m_cpuBytes - pAsset->chargedBytes + pAsset->cpuBytes;
+		pAsset->chargedBytes = pAsset->cpuBytes;
+		m_statistics.peakCpuBytes = std::max(m_statistics.peakCpuBytes, m_cpuBytes);
+		if (pAsset->type == ASSET_MESH)
+		{
+			pAsset->gpuBytes = (pAsset->mesh.vertices.size() * m_pMeshes->GetImportedVertexSize()) +
+				(pAsset->mesh.indices.size() * sizeof(GLuint));
+		}
+
+		size_t gpuLimit = (pAsset->type == ASSET_TEXTURE) ? m_textureBudget : m_poolBytes;
+		bool bUsed = (pAsset->references > 0) && (m_frame - pAsset->lastUsedFrame < (unsigned int)m_budget.evictFrames);
+		if (pAsset->bDecodeFailed || (pAsset->gpuBytes > gpuLimit))
+		{
+			std::cout << "Could not stream asset:" << pAsset->filename << ((pAsset->bDecodeFailed) ? "" : ", it is larger than its budget") << std::endl;
+			FreeDecodedData(pAsset);
+			pAsset->state = ASSET_FAILED;
+		}
+		else if (!bUsed)
+		{
+			FreeDecodedData(pAsset);
+			pAsset->state = ASSET_UNLOADED;
+		}
+		else if (uploads < m_budget.uploadsPerFrame)
+		{
+			// an asset that does not fit, because everything in the
+			// way is in use, is loaded again once it fits
+			if (Upload(decoded[i]))
+			{
+				m_statistics.loads++;
+				m_bResidencyChanged = true;
+			}
+			else
+			{
+				pAsset->state = ASSET_UNLOADED;
+			}
+			FreeDecodedData(pAsset);
+			uploads++;
+		}
+	}
+
+	// 3) start loading the used assets, nearest first, while the
+	// loads fit in the CPU budget - one load always runs, so that
+	// an asset larger than the budget is not stuck - an asset
+	// that was decoded before is only loaded again once there is
+	// room for it, so that a frame that uses more than the GPU
+	// budget does not decode the same files every frame
+	std::vector<int> wanted;
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		ASSET* pAsset = m_assets[i];
+		if ((pAsset->state == ASSET_UNLOADED) && (pAsset->references > 0) && (pAsset->lastUsedFrame == m_frame))
+		{
+			wanted.push_back((int)i);
+		}
+	}
+	std::stable_sort(wanted.begin(), wanted.end(),
+		[this](int a, int b) { return m_assets[a]->distance < m_assets[b]->distance; });
+
+	for (size_t i = 0; i < wanted.size(); i++)
+	{
+		ASSET* pAsset = m_assets[wanted[i]];
+		if ((pAsset->gpuBytes > 0) && !HasRoom(pAsset->type, pAsset->gpuBytes))
+		{
+			continue;
+		}
+		if ((m_cpuBytes > 0) && (m_cpuBytes + pAsset->cpuBytes > m_budget.cpuBytes))
+		{
+			break;
+		}
+
+		pAsset->state = ASSET_LOADING;
+		pAsset->bDecoded = false;
+		pAsset->bDecodeFailed = false;
+		pAsset->chargedBytes = pAsset->cpuBytes;
+		m_cpuBytes += pAsset->chargedBytes;
+		if (NULL == m_pJobSystem)
+		{
+			Decode(pAsset);
+		}
+		else
+		{
+			m_pJobSystem->Run([pAsset]() { Decode(pAsset); }, &m_loadJobs);
+		}
+	}
+
+	// 4) the memory in use after the frame
+	m_statistics.residentAssets = 0;
+	m_statistics.loadingAssets = 0;
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		m_statistics.residentAssets += (m_assets[i]->state == ASSET_RESIDENT) ? 1 : 0;
+		m_statistics.loadingAssets += (m_assets[i]->state == ASSET_LOADING) ? 1 : 0;
+	}
+	m_statistics.cpuBytes = m_cpuBytes;
+	m_statistics.gpuBytes = m_textureBytes + m_meshBytes;
+	m_statistics.peakCpuBytes = std::max(m_statistics.peakCpuBytes, m_statistics.cpuBytes);
+	m_statistics.peakGpuBytes = std::max(m_statistics.peakGpuBytes, m_statistics.gpuBytes);
+
+	m_frame++;
+}
+
+/***********************************************************
+ *  IsUpdatePending()
+ *
+ *  This method is used to tell whether the scene has to be
+ *  drawn again for the streaming to go on.  The uploads and
+ *  the next loads only happen at the end of a drawn frame,
+ *  so a frame that is only drawn on changes keeps drawing
+ *  while assets are loading, and once more to show the ones
+ *  that were just uploaded.
+ ***********************************************************/
+bool AssetManager::IsUpdatePending() const
+{
+	if (m_bResidencyChanged)
+	{
+		return true;
+	}
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		if (m_assets[i]->state == ASSET_LOADING)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print the loads and the peak
+ *  memory of the streaming against the budget.
+ ***********************************************************/
+void AssetManager::PrintReport() const
+{
+	printf("INFO: Streamed %d asset loads, %d evictions, %d of %d assets resident, peak CPU %.1f of %.1f MB, peak GPU %.1f of %.1f MB\n",
+		m_statistics.loads, m_statistics.evictions, m_statistics.residentAssets, (int)m_assets.size(),
+		(double)m_statistics.peakCpuBytes / g_Megabyte, (double)m_budget.cpuBytes / g_Megabyte,
+		(double)m_statistics.peakGpuBytes / g_Megabyte, (double)m_budget.gpuBytes / g_Megabyte);
+}
+
+/***********************************************************
+ *  Decode()
+ *
+ *  This method is used to read the file of an asset into
+ *  memory.  It makes no OpenGL calls and touches only the
+ *  asset, so it runs on any thread, and the decoded flag
+ *  hands the data over to the thread of the context.
+ ***********************************************************/
+void AssetManager::Decode(ASSET* pAsset)
+{
+	TRACE_SCOPE("DecodeAsset", pAsset->filename.c_str());
+
+	if (pAsset->type == ASSET_TEXTURE)
+	{
+		pAsset->pixels = stbi_load(pAsset->filename.c_str(), &pAsset->width, &pAsset->height, &pAsset->colorChannels, 0);
+		pAsset->bDecodeFailed = (NULL == pAsset->pixels) || ((pAsset->colorChannels != 3) && (pAsset->colorChannels != 4));
+
+		// the texels are stored in four bytes each, and the mipmaps
+		// add a third
+		size_t texels = (size_t)pAsset->width * (size_t)pAsset->height;
+		pAsset->cpuBytes = texels * (size_t)pAsset->colorChannels;
+		pAsset->gpuBytes = (texels * 4 * 4) / 3;
+	}
+	else
+	{
+		pAsset->bDecodeFailed = !MeshImporter::Load(pAsset->filename.c_str(), pAsset->mesh) || pAsset->mesh.indices.empty();
+		pAsset->cpuBytes = (pAsset->mesh.vertices.size() * sizeof(ShapeMeshes::MESH_VERTEX)) +
+			(pAsset->mesh.indices.size() * sizeof(uint32_t));
+	}
+
+	pAsset->bDecoded.store(true, std::memory_order_release);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used to create the OpenGL texture of a
+ *  decoded image, or to load a decoded mesh into the pool.
+ *  The resident assets of the same type that this frame
+ *  did not use are freed, the least recently used first,
+ *  until the asset fits.
+ ***********************************************************/
+bool AssetManager::Upload(int asset)
+{
+	ASSET* pAsset = m_assets[asset];
+
+	if (pAsset->type == ASSET_TEXTURE)
+	{
+		while (m_textureBytes + pAsset->gpuBytes > m_textureBudget)
+		{
+			int evictable = FindEvictable(ASSET_TEXTURE);
+			if (evictable < 0)
+			{
+				return false;
+			}
+			Evict(evictable);
+		}
+
+		SceneManager::TEXTURE_IMAGE image;
+		image.filename = pAsset->filename;
+		image.pixels = pAsset->pixels;
+		image.width = pAsset->width;
+		image.height = pAsset->height;
+		image.colorChannels = pAsset->colorChannels;
+		pAsset->textureID = SceneManager::CreateTextureObject(&image);
+		if (pAsset->textureID == 0)
+		{
+			return false;
+		}
+		m_textureBytes += pAsset->gpuBytes;
+	}
+	else
+	{
+		const MeshImporter::IMPORTED_MESH& mesh = pAsset->mesh;
+		while (!m_pMeshes->LoadImportedMesh(pAsset->importedMesh, mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size()))
+		{
+			int evictable = FindEvictable(ASSET_MESH);
+			if (evictable < 0)
+			{
+				return false;
+			}
+			Evict(evictable);
+		}
+		m_meshBytes += pAsset->gpuBytes;
+	}
+
+	pAsset->state = ASSET_RESIDENT;
+	return true;
+}
+
+/***********************************************************
+ *  Evict()
+ *
+ *  This method is used to free a resident asset, or the
+ *  decoded data of one that has not been uploaded.  An
+ *  asset that a job is still decoding is left alone.
+ ***********************************************************/
+void AssetManager::Evict(int asset)
+{
+	ASSET* pAsset = m_assets[asset];
+
+	if (pAsset->state == ASSET_RESIDENT)
+	{
+		if (pAsset->type == ASSET_TEXTURE)
+		{
+			glDeleteTextures(1, &pAsset->textureID);
+			pAsset->textureID = 0;
+			m_textureBytes -= pAsset->gpuBytes;
+		}
+		else
+		{
+			m_pMeshes->UnloadImportedMesh(pAsset->importedMesh);
+			m_meshBytes -= pAsset->gpuBytes;
+		}
+		pAsset->state = ASSET_UNLOADED;
+		m_statistics.evictions++;
+	}
+	else if ((pAsset->state == ASSET_LOADING) && pAsset->bDecoded.load(std::memory_order_acquire))
+	{
+		FreeDecodedData(pAsset);
+		pAsset->state = ASSET_UNLOADED;
+	}
+}
+
+/***********************************************************
+ *  FreeDecodedData()
+ *
+ *  This method is used to free the data that a decode read,
+ *  and stop counting it against the CPU budget.
+ ***********************************************************/
+void AssetManager::FreeDecodedData(ASSET* pAsset)
+{
+	stbi_image_free(pAsset->pixels);
+	pAsset->pixels = NULL;
+	std::vector<ShapeMeshes::MESH_VERTEX>().swap(pAsset->mesh.vertices);
+	std::vector<uint32_t>().swap(pAsset->mesh.indices);
+
+	m_cpuBytes -= std::min(m_cpuBytes, pAsset->chargedBytes);
+	pAsset->chargedBytes = 0;
+}
+
+/***********************************************************
+ *  FindEvictable()
+ *
+ *  This method is used to find the resident asset of a type
+ *  that was used the longest time ago, not counting the
+ *  ones that this frame used.
+ ***********************************************************/
+int AssetManager::FindEvictable(ASSET_TYPE type) const
+{
+	int evictable = -1;
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		const ASSET* pAsset = m_assets[i];
+		if ((pAsset->type == type) && (pAsset->state == ASSET_RESIDENT) && (pAsset->lastUsedFrame < m_frame) &&
+			((evictable < 0) || (pAsset->lastUsedFrame < m_assets[evictable]->lastUsedFrame)))
+		{
+			evictable = (int)i;
+		}
+	}
+	return evictable;
+}
+
+/***********************************************************
+ *  HasRoom()
+ *
+ *  This method is used to check whether an asset could be
+ *  uploaded by freeing the resident assets of its type that
+ *  this frame did not use.  The mesh pool may still be too
+ *  fragmented for it, which the upload finds out.
+ ***********************************************************/
+bool AssetManager::HasRoom(ASSET_TYPE type, size_t gpuBytes) const
+{
+	size_t freeBytes = (type == ASSET_TEXTURE) ? (m_textureBudget - m_textureBytes) : (m_poolBytes - m_meshBytes);
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		const ASSET* pAsset = m_assets[i];
+		if ((pAsset->type == type) && (pAsset->state == ASSET_RESIDENT) && (pAsset->lastUsedFrame < m_frame))
+		{
+			freeBytes += pAsset->gpuBytes;
+		}
+	}
+	return (gpuBytes <= freeBytes);
+}
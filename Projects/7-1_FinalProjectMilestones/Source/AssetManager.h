@@ -0,0 +1,193 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetmanager.h
+// ============
+// stream the textures and imported meshes of a scene in and out of memory,
+// nearest first, within budgets of CPU and GPU memory
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+#include "MeshImporter.h"
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  AssetManager
+ *
+ *  This class contains the code for keeping only the assets
+ *  that are drawn in memory.  Every texture and imported
+ *  mesh of the scene is an asset, counted by the objects
+ *  that reference it, and the draws of each frame mark the
+ *  assets they use with their distance from the camera.
+ *
+ *  At the end of the frame:
+ *
+ *  - the assets that no object references, or that were
+ *    not used for the eviction frames, are freed
+ *  - the assets whose files were decoded are uploaded,
+ *    nearest first, up to a number per frame - when they
+ *    do not fit in the GPU budget, the assets that were
+ *    used the longest time ago make room for them
+ *  - the used assets that are not in memory are decoded
+ *    on the job system, nearest first, while the decoded
+ *    data waiting for its upload is within the CPU budget
+ *
+ *  The resident textures are bound by the draws that use
+ *  them, so only the budget limits how many there are, and
+ *  the meshes are loaded into the pool of the ShapeMeshes,
+ *  which takes a quarter of the GPU budget when the scene
+ *  has imported meshes.  The memory stays bounded by the
+ *  budgets however large the scene, and a draw whose
+ *  asset is not resident yet uses the color of its
+ *  object, or draws nothing for a mesh.
+ ***********************************************************/
+class AssetManager
+{
+public:
+	// the limits of the memory that the assets use
+	struct BUDGET
+	{
+		size_t cpuBytes;		// decoded data waiting for its upload
+		size_t gpuBytes;		// the textures and the mesh pool
+		int evictFrames;		// frames without a use before an asset is freed
+		int uploadsPerFrame;
+	};
+
+	// the assets in memory and the loads since the start
+	struct ASSET_STATISTICS
+	{
+		int residentAssets;
+		int loadingAssets;
+		size_t cpuBytes;
+		size_t gpuBytes;
+		size_t peakCpuBytes;
+		size_t peakGpuBytes;
+		int loads;
+		int evictions;
+	};
+
+	// the budget that is used unless another one is passed
+	static void GetDefaultBudget(BUDGET& budget);
+
+	// constructor
+	AssetManager(ShapeMeshes* pMeshes, JobSystem* pJobSystem);
+	// destructor
+	~AssetManager();
+
+	// set the budget, and create the mesh pool from a quarter
+	// of it for a scene with imported meshes - the pool has to
+	// be created before any of them is reserved
+	bool Initialize(const BUDGET& budget, bool bMeshPool);
+
+	// add a texture, or a reserved imported mesh, to be loaded
+	// from a file when it is used - returns the asset index
+	int AddTexture(const std::string& filename);
+	int AddMesh(const std::string& filename, int importedMesh);
+	// count the objects that reference an asset
+	void AddReference(int asset);
+	void ReleaseReference(int asset);
+
+	// use an asset for a draw at a distance from the camera -
+	// returns the OpenGL texture, or whether the mesh is loaded,
+	// and 0 or false while it is not resident
+	GLuint UseTexture(int asset, float distance);
+	bool UseMesh(int asset, float distance);
+
+	// free, upload and start loading the assets as the draws
+	// of the frame used them, on the thread of the context
+	void EndFrame();
+	// whether assets are loading, or the last EndFrame() uploaded
+	// some, so that the scene has to be drawn again to show them
+	bool IsUpdatePending() const;
+
+	const ASSET_STATISTICS& GetStatistics() const { return m_statistics; }
+	void PrintReport() const;
+
+private:
+	enum ASSET_TYPE
+	{
+		ASSET_TEXTURE,
+		ASSET_MESH
+	};
+	enum ASSET_STATE
+	{
+		ASSET_UNLOADED,
+		ASSET_LOADING,			// decoded by a job
+		ASSET_RESIDENT,
+		ASSET_FAILED			// the file cannot be read, or never fits
+	};
+
+	struct ASSET
+	{
+		ASSET_TYPE type;
+		std::string filename;
+		ASSET_STATE state;
+		int references;
+		// the last frame that a draw used it, and the distance of
+		// the nearest draw of that frame
+		unsigned int lastUsedFrame;
+		float distance;
+		// the sizes of the decoded data and of the uploaded asset,
+		// known after the first decode - the CPU size starts as
+		// the size of the file
+		size_t cpuBytes;
+		size_t gpuBytes;
+		// the resident texture, or the imported mesh
+		GLuint textureID;
+		int importedMesh;
+		// the data of a decode, written by the job until the
+		// decoded flag is set
+		unsigned char* pixels;
+		int width;
+		int height;
+		int colorChannels;
+		MeshImporter::IMPORTED_MESH mesh;
+		// the CPU bytes that the load was counted with
+		size_t chargedBytes;
+		std::atomic<bool> bDecoded;
+		bool bDecodeFailed;
+	};
+
+	ShapeMeshes* m_pMeshes;
+	JobSystem* m_pJobSystem;
+	JobSystem::JOB_COUNTER m_loadJobs;
+	BUDGET m_budget;
+	// the GPU bytes of the textures, the rest of the budget is
+	// the mesh pool
+	size_t m_textureBudget;
+	size_t m_poolBytes;
+
+	std::vector<ASSET*> m_assets;
+	// the frame that the draws are marking the assets of
+	unsigned int m_frame;
+	// the CPU bytes of the loads in flight or waiting for their
+	// upload, and the GPU bytes of the resident textures and
+	// meshes
+	size_t m_cpuBytes;
+	size_t m_textureBytes;
+	size_t m_meshBytes;
+	// set when the last EndFrame() made an asset resident
+	bool m_bResidencyChanged;
+	ASSET_STATISTICS m_statistics;
+
+	// read the file of an asset, on any thread
+	static void Decode(ASSET* pAsset);
+	// upload a decoded asset, making room for it - returns false
+	// when it does not fit
+	bool Upload(int asset);
+	// free the uploaded or decoded data of an asset
+	void Evict(int asset);
+	void FreeDecodedData(ASSET* pAsset);
+	// the least recently used resident asset of a type that
+	// this frame has not used, or -1
+	int FindEvictable(ASSET_TYPE type) const;
+	// whether the GPU bytes of an asset fit in the budget that
+	// is free or used by assets this frame has not used
+	bool HasRoom(ASSET_TYPE type, size_t gpuBytes) const;
+};
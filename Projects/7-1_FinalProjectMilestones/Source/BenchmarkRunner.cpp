@@ -0,0 +1,1156 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarkrunner.cpp
+// ============
+// replay a camera path with a fixed timestep through the real scene and
+// generated stress scenes, and compare the frame times with a baseline
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BenchmarkRunner.h"
+#include "FrameProfiler.h"
+#include "ShadowMapper.h"
+#include "TransformBatch.h"
+#include "stb_image.h"
+
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+
+const float BenchmarkRunner::TIMESTEP = 1.0f / 60.0f;
+
+// declaration of global variables
+namespace
+{
+	// a scene that can be selected with --benchmark-scenes
+	struct SCENE_DEFINITION
+	{
+		const char* name;
+		int primitives;			// 0 renders the real scene
+		int lights;
+		int textures;
+	};
+
+	const SCENE_DEFINITION g_SceneDefinitions[] = {
+		{ "scene",      0,      0,  0 },
+		{ "prims1k",    1000,   4,  0 },
+		{ "prims10k",   10000,  4,  0 },
+		{ "prims100k",  100000, 4,  0 },
+		{ "lights16",   1000,   16, 0 },
+		{ "textures64", 1000,   4,  64 }
+	};
+	const int g_SceneCount = sizeof(g_SceneDefinitions) / sizeof(g_SceneDefinitions[0]);
+
+	// the shapes used by the stress scenes
+	enum STRESS_SHAPE
+	{
+		SHAPE_BOX,
+		SHAPE_SPHERE,
+		SHAPE_CYLINDER,
+		SHAPE_CONE,
+		SHAPE_TORUS,
+		SHAPE_PYRAMID,
+		SHAPE_COUNT
+	};
+
+	// size of the generated stress textures
+	const int g_StressTextureSize = 512;
+	// texture unit used by the stress scenes, above the 16 units
+	// that the scene textures are bound to
+	const int g_StressTextureUnit = 16;
+	// half the width of the area the stress objects are placed in
+	const float g_StressAreaSize = 14.0f;
+
+	// objects handled by one job of the stress scene update
+	const int g_StressGrainSize = 1024;
+
+	// the job scaling measurement - the objects of the largest stress
+	// scene, and the images that the scene decodes at startup
+	const int g_ScalingObjects = 100000;
+	const int g_ScalingFrames = 60;
+	const char* const g_ScalingTextures[] = {
+		"../../Utilities/textures/ceramic.jpg",
+		"../../Utilities/textures/porcelain.jpg",
+		"../../Utilities/textures/stainless.jpg",
+		"../../Utilities/textures/paper.jpg",
+		"../../Utilities/textures/plastic.jpg",
+		"../../Utilities/textures/drywall.jpg"
+	};
+	const int g_ScalingTextureCount = sizeof(g_ScalingTextures) / sizeof(g_ScalingTextures[0]);
+
+	// the scripted orbit around the table
+	const float g_OrbitDuration = 10.0f;
+	const float g_OrbitRadius = 18.0f;
+	const int g_OrbitKeyframes = 48;
+
+	// small random number generator, so that every run and every
+	// platform creates the same stress scenes
+	unsigned int g_RandomState = 1;
+
+	void SeedRandom(unsigned int seed)
+	{
+		g_RandomState = seed;
+	}
+
+	float Random(float minValue, float maxValue)
+	{
+		g_RandomState = g_RandomState * 1664525u + 1013904223u;
+		float value = (float)(g_RandomState >> 8) / (float)(1u << 24);
+		return minValue + value * (maxValue - minValue);
+	}
+
+	// get the value at a percentile of sorted frame times
+	double GetPercentile(const std::vector<double>& sortedTimes, int percentile)
+	{
+		size_t index = (sortedTimes.size() * percentile) / 100;
+		if (index >= sortedTimes.size())
+		{
+			index = sortedTimes.size() - 1;
+		}
+		return sortedTimes[index];
+	}
+
+	// find a number value in a JSON object, searching from the
+	// passed in position up to the end of the object
+	bool FindJSONNumber(const std::string& text, size_t start, const char* key, double& value)
+	{
+		size_t end = text.find('}', start);
+		std::string pattern = std::string("\"") + key + "\"";
+		size_t position = text.find(pattern, start);
+		if ((std::string::npos == position) || (position > end))
+		{
+			return false;
+		}
+		position = text.find(':', position + pattern.length());
+		if (std::string::npos == position)
+		{
+			return false;
+		}
+		value = strtod(text.c_str() + position + 1, NULL);
+		return true;
+	}
+}
+
+/***********************************************************
+ *  BenchmarkRunner()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BenchmarkRunner::BenchmarkRunner(
+	ShaderManager* pShaderManager,
+	ViewManager* pViewManager,
+	SceneManager* pSceneManager,
+	GLFWwindow* window)
+{
+	m_pShaderManager = pShaderManager;
+	m_pViewManager = pViewManager;
+	m_pSceneManager = pSceneManager;
+	m_pWindow = window;
+	m_pJobSystem = NULL;
+	m_pStressMeshes = new ShapeMeshes();
+	m_bStressMeshesLoaded = false;
+	m_frameCount = 300;
+
+	for (int i = 0; i < g_SceneCount; i++)
+	{
+		m_scenes.push_back(i);
+	}
+	CreateScriptedPath();
+}
+
+/***********************************************************
+ *  ~BenchmarkRunner()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BenchmarkRunner::~BenchmarkRunner()
+{
+	DestroyStressScene();
+	delete m_pStressMeshes;
+	m_pStressMeshes = NULL;
+}
+
+/***********************************************************
+ *  SetFrameCount()
+ *
+ *  This method is used to set the number of frames that
+ *  are measured for each scene.
+ ***********************************************************/
+void BenchmarkRunner::SetFrameCount(int frames)
+{
+	m_frameCount = (frames > 0) ? frames : 1;
+}
+
+/***********************************************************
+ *  SetScenes()
+ *
+ *  This method is used to select the scenes to run from a
+ *  comma separated list of scene names.
+ ***********************************************************/
+bool BenchmarkRunner::SetScenes(const char* sceneList)
+{
+	std::vector<int> scenes;
+	std::stringstream list(sceneList);
+	std::string name;
+	while (std::getline(list, name, ','))
+	{
+		if (name.empty())
+		{
+			continue;
+		}
+
+		int sceneIndex = -1;
+		for (int i = 0; i < g_SceneCount; i++)
+		{
+			if (name == g_SceneDefinitions[i].name)
+			{
+				sceneIndex = i;
+			}
+		}
+		if (sceneIndex < 0)
+		{
+			std::cout << "Unknown benchmark scene:" << name << ", available scenes:";
+			for (int i = 0; i < g_SceneCount; i++)
+			{
+				std::cout << " " << g_SceneDefinitions[i].name;
+			}
+			std::cout << std::endl;
+			return false;
+		}
+		scenes.push_back(sceneIndex);
+	}
+
+	if (scenes.empty())
+	{
+		return false;
+	}
+	m_scenes = scenes;
+	return true;
+}
+
+/***********************************************************
+ *  LoadCameraPath()
+ *
+ *  This method is used to read a camera path.  Each line
+ *  holds one keyframe as "time x y z targetX targetY
+ *  targetZ zoom", lines starting with # are comments.  The
+ *  keyframes have to be sorted by time.
+ ***********************************************************/
+bool BenchmarkRunner::LoadCameraPath(const char* filename)
+{
+	std::ifstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << "Could not open camera path:" << filename << std::endl;
+		return false;
+	}
+
+	std::vector<CAMERA_KEYFRAME> path;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		size_t first = line.find_first_not_of(" \t\r");
+		if ((std::string::npos == first) || (line[first] == '#'))
+		{
+			continue;
+		}
+
+		CAMERA_KEYFRAME keyframe;
+		std::istringstream values(line);
+		values >> keyframe.time
+			>> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+			>> keyframe.target.x >> keyframe.target.y >> keyframe.target.z
+			>> keyframe.zoom;
+		if (values.fail() || (!path.empty() && (keyframe.time <= path.back().time)))
+		{
+			std::cout << "Invalid camera keyframe in " << filename << " line " << lineNumber << std::endl;
+			return false;
+		}
+		path.push_back(keyframe);
+	}
+
+	if (path.empty())
+	{
+		std::cout << "Camera path has no keyframes:" << filename << std::endl;
+		return false;
+	}
+
+	m_cameraPath = path;
+	m_cameraPathName = filename;
+	return true;
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used to set the job system that builds
+ *  the matrices of the stress objects every frame.
+ ***********************************************************/
+void BenchmarkRunner::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+/***********************************************************
+ *  CreateScriptedPath()
+ *
+ *  This method is used to create the default camera path,
+ *  one orbit around the table that slowly comes down.
+ ***********************************************************/
+void BenchmarkRunner::CreateScriptedPath()
+{
+	m_cameraPath.clear();
+	for (int i = 0; i <= g_OrbitKeyframes; i++)
+	{
+		float t = (float)i / (float)g_OrbitKeyframes;
+		float angle = t * glm::two_pi<float>();
+
+		CAMERA_KEYFRAME keyframe;
+		keyframe.time = t * g_OrbitDuration;
+		keyframe.position = glm::vec3(
+			g_OrbitRadius * sinf(angle),
+			10.0f - 4.0f * t,
+			g_OrbitRadius * cosf(angle));
+		keyframe.target = glm::vec3(0.0f, 2.0f, 0.0f);
+		keyframe.zoom = 45.0f;
+		m_cameraPath.push_back(keyframe);
+	}
+	m_cameraPathName = "scripted";
+}
+
+/***********************************************************
+ *  UpdateCamera()
+ *
+ *  This method is used to move the camera to the place on
+ *  the path at the passed in time.  The path is repeated
+ *  when a scene runs for longer than the path.
+ ***********************************************************/
+void BenchmarkRunner::UpdateCamera(float time)
+{
+	Camera* camera = m_pViewManager->GetCamera();
+	if ((NULL == camera) || m_cameraPath.empty())
+	{
+		return;
+	}
+
+	const CAMERA_KEYFRAME* from = &m_cameraPath[0];
+	const CAMERA_KEYFRAME* to = from;
+	float blend = 0.0f;
+
+	float duration = m_cameraPath.back().time;
+	if (duration > 0.0f)
+	{
+		time = fmodf(time, duration);
+		for (size_t i = 1; i < m_cameraPath.size(); i++)
+		{
+			if (time <= m_cameraPath[i].time)
+			{
+				from = &m_cameraPath[i - 1];
+				to = &m_cameraPath[i];
+				blend = (time - from->time) / (to->time - from->time);
+				break;
+			}
+		}
+	}
+
+	glm::vec3 position = glm::mix(from->position, to->position, blend);
+	glm::vec3 target = glm::mix(from->target, to->target, blend);
+
+	camera->Position = position;
+	camera->Front = glm::normalize(target - position);
+	camera->Right = glm::normalize(glm::cross(camera->Front, camera->WorldUp));
+	camera->Up = glm::normalize(glm::cross(camera->Right, camera->Front));
+	camera->Zoom = from->zoom + (to->zoom - from->zoom) * blend;
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used to measure every selected scene.
+ ***********************************************************/
+bool BenchmarkRunner::Run()
+{
+	// the frames are paced by the GPU alone
+	if (NULL != m_pWindow)
+	{
+		glfwSwapInterval(0);
+	}
+	m_pViewManager->SetFixedTimestep(TIMESTEP);
+
+	std::cout << "INFO: Benchmark camera path: " << m_cameraPathName
+		<< ", frames per scene: " << m_frameCount << std::endl;
+
+	bool bSuccess = true;
+	m_results.clear();
+	for (size_t i = 0; i < m_scenes.size(); i++)
+	{
+		if (!RunScene(m_scenes[i]))
+		{
+			bSuccess = false;
+		}
+		if ((NULL != m_pWindow) && glfwWindowShouldClose(m_pWindow))
+		{
+			break;
+		}
+	}
+
+	// put the scene lights back for the normal frame loop
+	m_pSceneManager->SetupSceneLights();
+	m_pViewManager->SetFixedTimestep(0.0f);
+
+	return bSuccess;
+}
+
+/***********************************************************
+ *  RunScene()
+ *
+ *  This method is used to render one scene along the
+ *  camera path and collect the frame times.  Every frame
+ *  waits for the GPU, so the time covers the full cost of
+ *  the frame.
+ ***********************************************************/
+bool BenchmarkRunner::RunScene(int sceneIndex)
+{
+	const SCENE_DEFINITION& definition = g_SceneDefinitions[sceneIndex];
+	TRACE_SCOPE("RunBenchmarkScene", definition.name);
+
+	bool bStressScene = (definition.primitives > 0);
+	if (bStressScene)
+	{
+		BuildStressScene(definition.primitives, definition.lights, definition.textures);
+	}
+	else
+	{
+		m_pSceneManager->SetupSceneLights();
+	}
+
+	SCENE_RESULT result;
+	result.name = definition.name;
+	result.primitives = definition.primitives;
+	result.lights = bStressScene ? definition.lights : m_pShaderManager->GetFrameUniforms().GetConstants().lightCount;
+	result.textures = definition.textures;
+	result.drawCalls = 0;
+	result.triangles = 0;
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve(m_frameCount);
+
+	for (int frame = -WARMUP_FRAMES; frame < m_frameCount; frame++)
+	{
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		FrameProfiler::BeginFrame();
+
+		glEnable(GL_DEPTH_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// the warmup frames start at the same place as the measured ones
+		UpdateCamera((frame < 0 ? 0 : frame) * TIMESTEP);
+		m_pViewManager->PrepareSceneView();
+
+		m_pShaderManager->ResetUniformStatistics();
+		ShapeMeshes::DRAW_STATISTICS statistics;
+		if (bStressScene)
+		{
+			RenderStressScene(m_pViewManager->GetViewProjection());
+			statistics = m_pStressMeshes->GetDrawStatistics();
+		}
+		else
+		{
+			m_pSceneManager->SetViewProjection(m_pViewManager->GetViewProjection());
+			m_pSceneManager->RenderScene();
+			statistics = m_pSceneManager->GetDrawStatistics();
+		}
+
+		m_pShaderManager->GetFrameUniforms().EndFrame();
+
+		if (NULL != m_pWindow)
+		{
+			glfwSwapBuffers(m_pWindow);
+			glfwPollEvents();
+		}
+		{
+			PROFILE_SCOPE("glFinish");
+			glFinish();
+		}
+		FrameProfiler::EndFrame();
+
+		double frameMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - frameStart).count();
+		if (frame >= 0)
+		{
+			frameTimes.push_back(frameMs);
+			result.drawCalls = statistics.drawCalls;
+			result.triangles = statistics.triangles;
+		}
+
+		if ((NULL != m_pWindow) && glfwWindowShouldClose(m_pWindow))
+		{
+			break;
+		}
+	}
+
+	if (bStressScene)
+	{
+		DestroyStressScene();
+	}
+	if (frameTimes.empty())
+	{
+		return false;
+	}
+
+	if (!bStressScene)
+	{
+		result.primitives = (int)result.drawCalls;
+	}
+
+	double total = 0.0;
+	for (size_t i = 0; i < frameTimes.size(); i++)
+	{
+		total += frameTimes[i];
+	}
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	result.frames = (int)frameTimes.size();
+	result.meanMs = total / frameTimes.size();
+	result.medianMs = GetPercentile(frameTimes, 50);
+	result.p95Ms = GetPercentile(frameTimes, 95);
+	result.p99Ms = GetPercentile(frameTimes, 99);
+	result.maxMs = frameTimes.back();
+	m_results.push_back(result);
+
+	printf("INFO: Benchmark %-10s %6d primitives, %2d lights, %2d textures: mean %.3f ms, median %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+		result.name.c_str(), result.primitives, result.lights, result.textures,
+		result.meanMs, result.medianMs, result.p95Ms, result.p99Ms, result.maxMs);
+
+	return true;
+}
+
+/***********************************************************
+ *  BuildStressScene()
+ *
+ *  This method is used to generate a stress scene.  The
+ *  objects are placed at random on the table area, and
+ *  get smaller the more of them there are, so that the
+ *  camera path sees all of them.
+ ***********************************************************/
+void BenchmarkRunner::BuildStressScene(int primitives, int lights, int textures)
+{
+	TRACE_SCOPE("BuildStressScene");
+
+	DestroyStressScene();
+
+	if (!m_bStressMeshesLoaded)
+	{
+		m_pStressMeshes->LoadBoxMesh();
+		m_pStressMeshes->LoadSphereMesh();
+		m_pStressMeshes->LoadCylinderMesh();
+		m_pStressMeshes->LoadConeMesh();
+		m_pStressMeshes->LoadTorusMesh();
+		m_pStressMeshes->LoadPyramid4Mesh();
+		m_bStressMeshesLoaded = true;
+	}
+
+	GenerateStressObjects(primitives, textures);
+
+	// checkerboard textures with a different color each, so the
+	// driver cannot share their memory
+	std::vector<unsigned char> pixels(g_StressTextureSize * g_StressTextureSize * 4);
+	for (int t = 0; t < textures; t++)
+	{
+		unsigned char red = (unsigned char)Random(64.0f, 255.0f);
+		unsigned char green = (unsigned char)Random(64.0f, 255.0f);
+		unsigned char blue = (unsigned char)Random(64.0f, 255.0f);
+		for (int y = 0; y < g_StressTextureSize; y++)
+		{
+			for (int x = 0; x < g_StressTextureSize; x++)
+			{
+				bool bDark = (((x >> 5) ^ (y >> 5)) & 1) != 0;
+				unsigned char* pixel = &pixels[(y * g_StressTextureSize + x) * 4];
+				pixel[0] = bDark ? red / 4 : red;
+				pixel[1] = bDark ? green / 4 : green;
+				pixel[2] = bDark ? blue / 4 : blue;
+				pixel[3] = 255;
+			}
+		}
+
+		GLuint textureID = 0;
+		glGenTextures(1, &textureID);
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, g_StressTextureSize, g_StressTextureSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		m_stressTextures.push_back(textureID);
+	}
+
+	// the lights are spread evenly on a ring above the objects, and
+	// are dimmer the more of them there are
+	FrameUniformBuffer::FRAME_CONSTANTS& frame = m_pShaderManager->GetFrameUniforms().GetConstants();
+	if (lights > FrameUniformBuffer::TOTAL_LIGHTS)
+	{
+		lights = FrameUniformBuffer::TOTAL_LIGHTS;
+	}
+	frame.lightCount = lights;
+	for (int i = 0; i < lights; i++)
+	{
+		float angle = glm::two_pi<float>() * (float)i / (float)lights;
+		float ambient = 0.2f / (float)lights;
+		float diffuse = 1.6f / (float)lights;
+
+		FrameUniformBuffer::LIGHT_SOURCE& light = frame.lightSources[i];
+		light.position = glm::vec3(12.0f * sinf(angle), 6.0f, 12.0f * cosf(angle));
+		light.ambientColor = glm::vec3(ambient, ambient, ambient);
+		light.diffuseColor = glm::vec3(diffuse, diffuse, diffuse);
+		light.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
+		light.specularIntensity = 0.5f / (float)lights;
+		light.focalStrength = 16.0f;
+	}
+}
+
+/***********************************************************
+ *  GenerateStressObjects()
+ *
+ *  This method is used to place the objects of a stress
+ *  scene.  It makes no OpenGL calls, so the job scaling
+ *  measurement can use the same objects.
+ ***********************************************************/
+void BenchmarkRunner::GenerateStressObjects(int primitives, int textures)
+{
+	// the same seed gives the same scene in every run
+	SeedRandom(12345u + (unsigned int)primitives);
+
+	float objectSize = 1.2f * sqrtf(1000.0f / (float)primitives);
+	m_stressObjects.resize(primitives);
+	// the transformation values of all the objects, one array per
+	// component, which the model matrices are built from at once
+	std::vector<float> values[9];
+	for (int component = 0; component < 9; component++)
+	{
+		values[component].resize(primitives);
+	}
+	for (int i = 0; i < primitives; i++)
+	{
+		STRESS_OBJECT& object = m_stressObjects[i];
+		glm::vec3 position(
+			Random(-g_StressAreaSize, g_StressAreaSize),
+			Random(0.0f, 4.0f),
+			Random(-g_StressAreaSize, g_StressAreaSize));
+		glm::vec3 rotation(Random(0.0f, 360.0f), Random(0.0f, 360.0f), Random(0.0f, 360.0f));
+		glm::vec3 scale = glm::vec3(Random(0.5f, 1.0f), Random(0.5f, 1.0f), Random(0.5f, 1.0f)) * objectSize;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			values[axis][i] = scale[axis];
+			values[3 + axis][i] = rotation[axis];
+			values[6 + axis][i] = position[axis];
+		}
+		object.color = glm::vec4(Random(0.2f, 1.0f), Random(0.2f, 1.0f), Random(0.2f, 1.0f), 1.0f);
+		object.shape = (int)Random(0.0f, (float)SHAPE_COUNT) % SHAPE_COUNT;
+		object.texture = (textures > 0) ? (i % textures) : -1;
+	}
+
+	if (primitives > 0)
+	{
+		std::vector<glm::mat4> models(primitives);
+		TransformBatch::TRANSFORM_ARRAYS transforms = {
+			values[0].data(), values[1].data(), values[2].data(), values[3].data(), values[4].data(),
+			values[5].data(), values[6].data(), values[7].data(), values[8].data() };
+		TransformBatch::ComputeModels(transforms, primitives, models.data());
+		for (int i = 0; i < primitives; i++)
+		{
+			m_stressObjects[i].model = models[i];
+			m_stressObjects[i].normalMatrix = glm::inverseTranspose(glm::mat3(models[i]));
+		}
+	}
+
+	// the objects are drawn sorted by texture and then by shape,
+	// so that the texture and the mesh change as little as possible
+	m_stressOrder.resize(primitives);
+	for (int i = 0; i < primitives; i++)
+	{
+		m_stressOrder[i] = i;
+	}
+	const std::vector<STRESS_OBJECT>& objects = m_stressObjects;
+	std::stable_sort(m_stressOrder.begin(), m_stressOrder.end(), [&objects](int a, int b)
+	{
+		if (objects[a].texture != objects[b].texture)
+		{
+			return objects[a].texture < objects[b].texture;
+		}
+		return objects[a].shape < objects[b].shape;
+	});
+
+	m_stressMVP.resize(primitives);
+	m_stressVisible.resize(primitives);
+}
+
+/***********************************************************
+ *  DestroyStressScene()
+ *
+ *  This method is used to free the objects and textures of
+ *  the stress scene.
+ ***********************************************************/
+void BenchmarkRunner::DestroyStressScene()
+{
+	if (!m_stressTextures.empty())
+	{
+		glDeleteTextures((GLsizei)m_stressTextures.size(), &m_stressTextures[0]);
+		m_stressTextures.clear();
+	}
+	m_stressObjects.clear();
+	m_stressOrder.clear();
+	m_stressMVP.clear();
+	m_stressVisible.clear();
+}
+
+/***********************************************************
+ *  UpdateStressScene()
+ *
+ *  This method is used to build the model-view-projection
+ *  matrix of every stress object and to cull the objects
+ *  outside the view frustum.  The objects are split into
+ *  ranges that run in parallel on the job system.
+ ***********************************************************/
+void BenchmarkRunner::UpdateStressScene(const glm::mat4& viewProjection)
+{
+	PROFILE_SCOPE("UpdateStressScene");
+
+	glm::vec4 planes[6];
+	SceneManager::GetFrustumPlanes(viewProjection, planes);
+
+	std::function<void(int, int)> update = [this, &planes, &viewProjection](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			const STRESS_OBJECT& object = m_stressObjects[i];
+			float radius = SceneManager::MESH_BOUNDING_RADIUS * std::max(glm::length(glm::vec3(object.model[0])),
+				std::max(glm::length(glm::vec3(object.model[1])), glm::length(glm::vec3(object.model[2]))));
+
+			m_stressVisible[i] = SceneManager::IsSphereVisible(planes, glm::vec3(object.model[3]), radius) ? 1 : 0;
+			m_stressMVP[i] = viewProjection * object.model;
+		}
+	};
+
+	int count = (int)m_stressObjects.size();
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(count, g_StressGrainSize, update);
+	}
+	else
+	{
+		update(0, count);
+	}
+}
+
+/***********************************************************
+ *  RenderStressScene()
+ *
+ *  This method is used to draw every object of the stress
+ *  scene with the same shader settings as the real scene.
+ ***********************************************************/
+void BenchmarkRunner::RenderStressScene(const glm::mat4& viewProjection)
+{
+	PROFILE_SCOPE("RenderStressScene");
+
+	UpdateStressScene(viewProjection);
+
+	m_pStressMeshes->ResetDrawStatistics();
+
+	m_pShaderManager->setIntValue("bUseLighting", true);
+	m_pShaderManager->setVec2Value("UVscale", glm::vec2(1.0f, 1.0f));
+	m_pShaderManager->setVec3Value("material.ambientColor", glm::vec3(0.2f, 0.2f, 0.2f));
+	m_pShaderManager->setFloatValue("material.ambientStrength", 0.3f);
+	m_pShaderManager->setVec3Value("material.diffuseColor", glm::vec3(0.8f, 0.8f, 0.8f));
+	m_pShaderManager->setVec3Value("material.specularColor", glm::vec3(0.5f, 0.5f, 0.5f));
+	m_pShaderManager->setFloatValue("material.shininess", 16.0f);
+	m_pShaderManager->setSampler2DValue("objectTexture", g_StressTextureUnit);
+
+	glActiveTexture(GL_TEXTURE0 + g_StressTextureUnit);
+
+	// the floor
+	glm::mat4 floorModel = glm::scale(glm::vec3(g_StressAreaSize + 2.0f, 1.0f, g_StressAreaSize + 2.0f));
+	m_pShaderManager->setMat4Value("model", floorModel);
+	m_pShaderManager->setMat4Value("modelViewProjection", viewProjection * floorModel);
+	m_pShaderManager->setMat3Value("normalMatrix", glm::mat3(1.0f));
+	m_pShaderManager->setIntValue("bUseTexture", false);
+	m_pShaderManager->setVec4Value("objectColor", glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+	m_pStressMeshes->DrawBoxMesh();
+
+	int boundTexture = -1;
+	for (size_t i = 0; i < m_stressOrder.size(); i++)
+	{
+		int index = m_stressOrder[i];
+		if (!m_stressVisible[index])
+		{
+			continue;
+		}
+		const STRESS_OBJECT& object = m_stressObjects[index];
+
+		m_pShaderManager->setMat4Value("model", object.model);
+		m_pShaderManager->setMat4Value("modelViewProjection", m_stressMVP[index]);
+		m_pShaderManager->setMat3Value("normalMatrix", object.normalMatrix);
+		m_pShaderManager->setVec4Value("objectColor", object.color);
+		if (object.texture >= 0)
+		{
+			m_pShaderManager->setIntValue("bUseTexture", true);
+			if (object.texture != boundTexture)
+			{
+				glBindTexture(GL_TEXTURE_2D, m_stressTextures[object.texture]);
+				boundTexture = object.texture;
+			}
+		}
+		else
+		{
+			m_pShaderManager->setIntValue("bUseTexture", false);
+		}
+
+		switch (object.shape)
+		{
+		case SHAPE_BOX:
+			m_pStressMeshes->DrawBoxMesh();
+			break;
+		case SHAPE_SPHERE:
+			m_pStressMeshes->DrawSphereMesh();
+			break;
+		case SHAPE_CYLINDER:
+			m_pStressMeshes->DrawCylinderMesh();
+			break;
+		case SHAPE_CONE:
+			m_pStressMeshes->DrawConeMesh();
+			break;
+		case SHAPE_TORUS:
+			m_pStressMeshes->DrawTorusMesh();
+			break;
+		default:
+			m_pStressMeshes->DrawPyramid4Mesh();
+			break;
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  WriteResults()
+ *
+ *  This method is used to write the results of every scene
+ *  into a JSON file, which can be used as the baseline of
+ *  a later run.
+ ***********************************************************/
+bool BenchmarkRunner::WriteResults(const char* filename) const
+{
+	FILE* file = fopen(filename, "w");
+	if (NULL == file)
+	{
+		printf("Unable to write benchmark results %s\n", filename);
+		return false;
+	}
+
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	std::string rendererName = (NULL != renderer) ? renderer : "";
+	std::replace(rendererName.begin(), rendererName.end(), '"', '\'');
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"renderer\": \"%s\",\n", rendererName.c_str());
+	fprintf(file, "  \"camera_path\": \"%s\",\n", m_cameraPathName == "scripted" ? "scripted" : "file");
+	fprintf(file, "  \"timestep_ms\": %.4f,\n", TIMESTEP * 1000.0f);
+	fprintf(file, "  \"warmup_frames\": %d,\n", WARMUP_FRAMES);
+	fprintf(file, "  \"scenes\": [\n");
+	for (size_t i = 0; i < m_results.size(); i++)
+	{
+		const SCENE_RESULT& result = m_results[i];
+		fprintf(file,
+			"    {\"name\": \"%s\", \"primitives\": %d, \"lights\": %d, \"textures\": %d, \"frames\": %d, "
+			"\"mean_ms\": %.4f, \"median_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, "
+			"\"draw_calls\": %u, \"triangles\": %u}%s\n",
+			result.name.c_str(), result.primitives, result.lights, result.textures, result.frames,
+			result.meanMs, result.medianMs, result.p95Ms, result.p99Ms, result.maxMs,
+			result.drawCalls, result.triangles,
+			(i + 1 < m_results.size()) ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+
+	printf("INFO: Wrote benchmark results to %s\n", filename);
+	return true;
+}
+
+/***********************************************************
+ *  CompareBaseline()
+ *
+ *  This method is used to compare the median and the 95th
+ *  percentile of every scene with a baseline file.  A scene
+ *  regresses when either value is more than the threshold
+ *  percentage slower than the baseline.
+ ***********************************************************/
+bool BenchmarkRunner::CompareBaseline(const char* filename, float thresholdPercent) const
+{
+	std::ifstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << "Could not open benchmark baseline:" << filename << std::endl;
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	std::string baseline = buffer.str();
+
+	double limit = 1.0 + thresholdPercent / 100.0;
+	bool bPassed = true;
+	for (size_t i = 0; i < m_results.size(); i++)
+	{
+		const SCENE_RESULT& result = m_results[i];
+
+		std::string pattern = "\"name\": \"" + result.name + "\"";
+		size_t position = baseline.find(pattern);
+		double baselineMedian = 0.0;
+		double baselineP95 = 0.0;
+		if ((std::string::npos == position) ||
+			!FindJSONNumber(baseline, position, "median_ms", baselineMedian) ||
+			!FindJSONNumber(baseline, position, "p95_ms", baselineP95))
+		{
+			printf("INFO: Benchmark %-10s is not in the baseline\n", result.name.c_str());
+			continue;
+		}
+
+		bool bRegressed = (result.medianMs > baselineMedian * limit) || (result.p95Ms > baselineP95 * limit);
+		printf("%s: Benchmark %-10s median %.3f ms (baseline %.3f ms, %+.1f%%), p95 %.3f ms (baseline %.3f ms, %+.1f%%)\n",
+			bRegressed ? "REGRESSION" : "INFO",
+			result.name.c_str(),
+			result.medianMs, baselineMedian, (baselineMedian > 0.0) ? (result.medianMs / baselineMedian - 1.0) * 100.0 : 0.0,
+			result.p95Ms, baselineP95, (baselineP95 > 0.0) ? (result.p95Ms / baselineP95 - 1.0) * 100.0 : 0.0);
+		if (bRegressed)
+		{
+			bPassed = false;
+		}
+	}
+
+	printf("INFO: Benchmark %s the baseline with a %.1f%% threshold\n", bPassed ? "passed" : "failed", thresholdPercent);
+	return bPassed;
+}
+
+/***********************************************************
+ *  RunJobScaling()
+ *
+ *  This method is used to measure how the work spread over
+ *  the job system scales with the number of workers.  The
+ *  per-frame work is the matrix update and culling of the
+ *  largest stress scene along the camera path, and the
+ *  startup work is decoding the scene textures.  Neither
+ *  waits for the GPU, so the times show the CPU alone.
+ ***********************************************************/
+void BenchmarkRunner::RunJobScaling(int maxWorkers)
+{
+	if (maxWorkers < 1)
+	{
+		maxWorkers = 1;
+	}
+
+	GenerateStressObjects(g_ScalingObjects, 0);
+
+	// one view projection per frame, from the keyframes of the path
+	std::vector<glm::mat4> viewProjections;
+	for (int frame = 0; frame < g_ScalingFrames; frame++)
+	{
+		const CAMERA_KEYFRAME& keyframe = m_cameraPath[frame % m_cameraPath.size()];
+		glm::mat4 view = glm::lookAt(keyframe.position, keyframe.target, glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspective(glm::radians(keyframe.zoom), 16.0f / 9.0f, 0.1f, 100.0f);
+		viewProjections.push_back(projection * view);
+	}
+
+	std::cout << "INFO: Job scaling with " << g_ScalingObjects << " objects over " << g_ScalingFrames
+		<< " frames and " << g_ScalingTextureCount << " texture images, "
+		<< std::thread::hardware_concurrency() << " hardware thread(s)" << std::endl;
+
+	stbi_set_flip_vertically_on_load(true);
+
+	JobSystem* pPreviousJobSystem = m_pJobSystem;
+	double baseFrameMs = 0.0;
+	double baseDecodeMs = 0.0;
+	for (int workers = 1; workers <= maxWorkers; workers++)
+	{
+		JobSystem jobSystem;
+		jobSystem.Initialize(workers);
+		m_pJobSystem = &jobSystem;
+
+		// the first pass warms up the caches and the workers
+		UpdateStressScene(viewProjections[0]);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < g_ScalingFrames; frame++)
+		{
+			UpdateStressScene(viewProjections[frame]);
+		}
+		double frameMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count() / g_ScalingFrames;
+
+		start = std::chrono::steady_clock::now();
+		JobSystem::JOB_COUNTER decodeJobs;
+		for (int i = 0; i < g_ScalingTextureCount; i++)
+		{
+			const char* filename = g_ScalingTextures[i];
+			jobSystem.Run([filename]()
+			{
+				int width = 0;
+				int height = 0;
+				int colorChannels = 0;
+				unsigned char* pixels = stbi_load(filename, &width, &height, &colorChannels, 0);
+				if (NULL != pixels)
+				{
+					stbi_image_free(pixels);
+				}
+			}, &decodeJobs);
+		}
+		jobSystem.Wait(&decodeJobs);
+		double decodeMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+
+		if (workers == 1)
+		{
+			baseFrameMs = frameMs;
+			baseDecodeMs = decodeMs;
+		}
+
+		printf("INFO: Job scaling %2d worker(s): frame work %8.3f ms (%.2fx), texture decode %8.3f ms (%.2fx)\n",
+			workers,
+			frameMs, (frameMs > 0.0) ? baseFrameMs / frameMs : 0.0,
+			decodeMs, (decodeMs > 0.0) ? baseDecodeMs / decodeMs : 0.0);
+	}
+
+	m_pJobSystem = pPreviousJobSystem;
+	DestroyStressScene();
+}
+
+/***********************************************************
+ *  RunShadowBenchmark()
+ *
+ *  This method is used to measure what the shadow maps
+ *  cost per frame of the scene along the camera path,
+ *  first drawn again every frame and then cached.  The
+ *  camera moves but the lights and the objects do not, so
+ *  the cached maps are drawn once in the warmup frames.
+ *  The GPU time of a pass is measured with a timer query
+ *  around the drawn maps.
+ ***********************************************************/
+bool BenchmarkRunner::RunShadowBenchmark()
+{
+	ShadowMapper* pShadowMapper = m_pSceneManager->GetShadowMapper();
+	if (NULL == pShadowMapper)
+	{
+		printf("The shadow benchmark needs the shadow maps\n");
+		return false;
+	}
+
+	if (NULL != m_pWindow)
+	{
+		glfwSwapInterval(0);
+	}
+	m_pViewManager->SetFixedTimestep(TIMESTEP);
+	m_pSceneManager->SetupSceneLights();
+
+	std::cout << "INFO: Shadow benchmark camera path: " << m_cameraPathName
+		<< ", frames per pass: " << m_frameCount
+		<< ", map size: " << pShadowMapper->GetMapSize() << std::endl;
+
+	bool bPreviousCache = pShadowMapper->IsCacheEnabled();
+	double uncachedMs = 0.0;
+	bool bSuccess = true;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		bool bCache = (pass == 1);
+		pShadowMapper->SetCacheEnabled(bCache);
+
+		double totalMs = 0.0;
+		int frames = 0;
+		for (int frame = -WARMUP_FRAMES; frame < m_frameCount; frame++)
+		{
+			// the measured frames start with the maps of the warmup
+			if (frame == 0)
+			{
+				pShadowMapper->ResetStatistics();
+			}
+
+			std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+
+			glEnable(GL_DEPTH_TEST);
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			UpdateCamera((frame < 0 ? 0 : frame) * TIMESTEP);
+			m_pViewManager->PrepareSceneView();
+			m_pSceneManager->SetViewProjection(m_pViewManager->GetViewProjection());
+			m_pSceneManager->RenderScene();
+			m_pShaderManager->GetFrameUniforms().EndFrame();
+
+			if (NULL != m_pWindow)
+			{
+				glfwSwapBuffers(m_pWindow);
+				glfwPollEvents();
+			}
+			glFinish();
+
+			if (frame >= 0)
+			{
+				totalMs += std::chrono::duration<double, std::milli>(
+					std::chrono::steady_clock::now() - frameStart).count();
+				frames++;
+			}
+
+			if ((NULL != m_pWindow) && glfwWindowShouldClose(m_pWindow))
+			{
+				break;
+			}
+		}
+
+		if (frames == 0)
+		{
+			bSuccess = false;
+			break;
+		}
+
+		// the GPU time is known for the timed updates that drew a
+		// map, it is spread over the updates that drew one
+		const ShadowMapper::SHADOW_STATISTICS& statistics = pShadowMapper->GetStatistics();
+		double updates = (statistics.updates > 0) ? (double)statistics.updates : 1.0;
+		double gpuMs = 0.0;
+		if (statistics.gpuSamples > 0)
+		{
+			gpuMs = (statistics.gpuMs / statistics.gpuSamples) * (statistics.drawnUpdates / updates);
+		}
+
+		double frameMs = totalMs / frames;
+		if (!bCache)
+		{
+			uncachedMs = frameMs;
+		}
+
+		printf("INFO: Shadow benchmark %-8s frame %8.3f ms, shadow pass CPU %8.3f ms, GPU %8.3f ms, %6.2f maps drawn and %6.2f cached per frame, %8.1f draw calls per frame\n",
+			bCache ? "cached" : "uncached", frameMs,
+			statistics.cpuMs / updates, gpuMs,
+			statistics.drawnMaps / updates, statistics.cachedMaps / updates,
+			statistics.drawCalls / updates);
+		if (bCache && (frameMs > 0.0))
+		{
+			printf("INFO: Shadow benchmark the cache makes the frames %.2fx as fast\n", uncachedMs / frameMs);
+		}
+	}
+
+	pShadowMapper->SetCacheEnabled(bPreviousCache);
+	m_pViewManager->SetFixedTimestep(0.0f);
+
+	return bSuccess;
+}
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarkrunner.h
+// ============
+// replay a camera path with a fixed timestep through the real scene and
+// generated stress scenes, and compare the frame times with a baseline
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "ViewManager.h"
+#include "SceneManager.h"
+#include "ShapeMeshes.h"
+#include "JobSystem.h"
+
+#include <string>
+#include <vector>
+#include <GLFW/glfw3.h>
+
+/***********************************************************
+ *  BenchmarkRunner
+ *
+ *  This class contains the code for the benchmark mode.
+ *  Every scene is rendered for the same number of frames
+ *  while the camera follows the same path, so two runs of
+ *  the same build draw exactly the same images and only
+ *  the frame times differ.
+ ***********************************************************/
+class BenchmarkRunner
+{
+public:
+	// time between two benchmark frames in seconds
+	static const float TIMESTEP;
+	// frames rendered before the measurement of each scene
+	static const int WARMUP_FRAMES = 10;
+
+	// one point of the camera path
+	struct CAMERA_KEYFRAME
+	{
+		float time;				// seconds from the start of the path
+		glm::vec3 position;
+		glm::vec3 target;		// the point the camera looks at
+		float zoom;				// vertical field of view in degrees
+	};
+
+	// the measurements of one scene
+	struct SCENE_RESULT
+	{
+		std::string name;
+		int primitives;
+		int lights;
+		int textures;
+		int frames;
+		double meanMs;
+		double medianMs;
+		double p95Ms;
+		double p99Ms;
+		double maxMs;
+		unsigned int drawCalls;
+		unsigned int triangles;
+	};
+
+	// constructor
+	BenchmarkRunner(
+		ShaderManager* pShaderManager,
+		ViewManager* pViewManager,
+		SceneManager* pSceneManager,
+		GLFWwindow* window);
+	// destructor
+	~BenchmarkRunner();
+
+	// number of measured frames per scene
+	void SetFrameCount(int frames);
+	// comma separated list of the scenes to run
+	bool SetScenes(const char* sceneList);
+	// replace the scripted orbit with a camera path file
+	bool LoadCameraPath(const char* filename);
+	// spread the per-frame work of the stress scenes over a
+	// job system, or NULL
+	void SetJobSystem(JobSystem* pJobSystem);
+
+	// render every selected scene and measure the frames
+	bool Run();
+	// write the results as JSON
+	bool WriteResults(const char* filename) const;
+	// compare the results with a JSON file written by an
+	// earlier run, false is returned on a regression
+	bool CompareBaseline(const char* filename, float thresholdPercent) const;
+
+	// measure the per-frame scene work and the texture decoding
+	// on job systems of 1 to the passed in number of workers
+	void RunJobScaling(int maxWorkers);
+
+	// measure the shadow pass of the scene along the camera
+	// path, with the maps drawn every frame and with the cache
+	bool RunShadowBenchmark();
+
+private:
+	// one object of a generated stress scene
+	struct STRESS_OBJECT
+	{
+		glm::mat4 model;
+		glm::mat3 normalMatrix;
+		glm::vec4 color;
+		int shape;
+		int texture;			// index into m_stressTextures, or -1
+	};
+
+	// pointers to the objects of the application
+	ShaderManager* m_pShaderManager;
+	ViewManager* m_pViewManager;
+	SceneManager* m_pSceneManager;
+	GLFWwindow* m_pWindow;
+
+	// pool for the per-frame work of the stress scenes
+	JobSystem* m_pJobSystem;
+
+	// meshes used by the stress scenes
+	ShapeMeshes* m_pStressMeshes;
+	bool m_bStressMeshesLoaded;
+	// objects and textures of the current stress scene
+	std::vector<STRESS_OBJECT> m_stressObjects;
+	std::vector<GLuint> m_stressTextures;
+	// the objects sorted by texture and shape, and the matrix and
+	// visibility of every object in the current frame
+	std::vector<int> m_stressOrder;
+	std::vector<glm::mat4> m_stressMVP;
+	std::vector<unsigned char> m_stressVisible;
+
+	int m_frameCount;
+	std::vector<int> m_scenes;
+	std::vector<CAMERA_KEYFRAME> m_cameraPath;
+	std::string m_cameraPathName;
+	std::vector<SCENE_RESULT> m_results;
+
+	// create the default orbit around the table
+	void CreateScriptedPath();
+	// move the camera to its place on the path
+	void UpdateCamera(float time);
+
+	// measure one scene
+	bool RunScene(int sceneIndex);
+	// generate the objects, lights and textures of a stress scene
+	void BuildStressScene(int primitives, int lights, int textures);
+	// generate the objects of a stress scene, without OpenGL
+	void GenerateStressObjects(int primitives, int textures);
+	// build the matrices and cull the objects of the stress scene
+	void UpdateStressScene(const glm::mat4& viewProjection);
+	// free the textures of the stress scene
+	void DestroyStressScene();
+	// draw the objects of the stress scene
+	void RenderStressScene(const glm::mat4& viewProjection);
+};
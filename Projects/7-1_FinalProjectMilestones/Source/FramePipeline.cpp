@@ -0,0 +1,331 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepipeline.cpp
+// ============
+// run the frame loop as a pipeline - the main thread builds the next frame
+// while a render thread submits the current one to OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePipeline.h"
+#include "FrameProfiler.h"
+#include "TraceRecorder.h"
+
+#include <iostream>
+#include <chrono>
+
+/***********************************************************
+ *  FramePipeline()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePipeline::FramePipeline(
+	ShaderManager* pShaderManager,
+	ViewManager* pViewManager,
+	SceneManager* pSceneManager,
+	GLFWwindow* window,
+	HeadlessContext* pHeadlessContext)
+{
+	m_pShaderManager = pShaderManager;
+	m_pViewManager = pViewManager;
+	m_pSceneManager = pSceneManager;
+	m_pWindow = window;
+	m_pHeadlessContext = pHeadlessContext;
+	m_pTelemetryLog = NULL;
+	m_pFramePacer = NULL;
+	m_depth = 2;
+	m_submittedFrames = 0;
+	m_completedFrames = 0;
+	m_bStopping = false;
+	m_pFrameTimes = NULL;
+}
+
+/***********************************************************
+ *  ~FramePipeline()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FramePipeline::~FramePipeline()
+{
+	m_pShaderManager = NULL;
+	m_pViewManager = NULL;
+	m_pSceneManager = NULL;
+	m_pWindow = NULL;
+	m_pHeadlessContext = NULL;
+	m_pTelemetryLog = NULL;
+	m_pFramePacer = NULL;
+}
+
+/***********************************************************
+ *  SetDepth()
+ *
+ *  This method is used to set the number of frame slots.
+ ***********************************************************/
+void FramePipeline::SetDepth(int depth)
+{
+	if (depth < 1)
+	{
+		depth = 1;
+	}
+	if (depth > MAX_DEPTH)
+	{
+		depth = MAX_DEPTH;
+	}
+	m_depth = depth;
+}
+
+/***********************************************************
+ *  SetTelemetryLog()
+ *
+ *  This method is used to log the metrics of every frame.
+ *  The samples are pushed by the render thread only.
+ ***********************************************************/
+void FramePipeline::SetTelemetryLog(TelemetryLog* pTelemetryLog)
+{
+	m_pTelemetryLog = pTelemetryLog;
+}
+
+/***********************************************************
+ *  SetFramePacer()
+ *
+ *  This method is used to pace the frames.  The main thread
+ *  waits after it submitted a frame, so the render thread
+ *  is paced by the frames it is given.
+ ***********************************************************/
+void FramePipeline::SetFramePacer(FramePacer* pFramePacer)
+{
+	m_pFramePacer = pFramePacer;
+}
+
+/***********************************************************
+ *  AcquireContext()
+ *
+ *  This method is used to make the OpenGL context current
+ *  on the calling thread.
+ ***********************************************************/
+bool FramePipeline::AcquireContext()
+{
+	if (NULL != m_pWindow)
+	{
+		glfwMakeContextCurrent(m_pWindow);
+		return true;
+	}
+	if (NULL != m_pHeadlessContext)
+	{
+		return m_pHeadlessContext->MakeCurrent();
+	}
+	return false;
+}
+
+/***********************************************************
+ *  ReleaseContext()
+ *
+ *  This method is used to release the OpenGL context from
+ *  the calling thread.
+ ***********************************************************/
+void FramePipeline::ReleaseContext()
+{
+	if (NULL != m_pWindow)
+	{
+		glfwMakeContextCurrent(NULL);
+	}
+	else if (NULL != m_pHeadlessContext)
+	{
+		m_pHeadlessContext->ReleaseCurrent();
+	}
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used to run the frame loop.  The OpenGL
+ *  context is handed to the render thread for the run, and
+ *  given back to the main thread at the end.
+ ***********************************************************/
+void FramePipeline::Run(int frameCount, std::vector<double>& frameTimes)
+{
+	m_submittedFrames = 0;
+	m_completedFrames = 0;
+	m_bStopping = false;
+	m_pFrameTimes = &frameTimes;
+	m_lastFrameEnd = std::chrono::steady_clock::now();
+
+	std::cout << "INFO: Pipelined frame loop with " << m_depth << " frame(s) in flight" << std::endl;
+
+	// every GL call of the loop is made by the render thread
+	glFlush();
+	ReleaseContext();
+	std::thread renderThread(&FramePipeline::RenderFrames, this);
+
+	unsigned int frame = 0;
+	while ((NULL != m_pWindow) ? !glfwWindowShouldClose(m_pWindow) : ((int)frame < frameCount))
+	{
+		// the replay ends the loop once its input is used up
+		if (m_pViewManager->IsInputReplayFinished())
+		{
+			break;
+		}
+
+		// wait until the render thread is done with the slot that
+		// the frame is built into
+		{
+			TRACE_SCOPE("WaitForFrameSlot");
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (frame - m_completedFrames >= (unsigned int)m_depth)
+			{
+				m_frameCompleted.wait(lock);
+			}
+		}
+
+		// the slot belongs to this thread until it is submitted
+		{
+			TRACE_SCOPE("BuildFrame");
+			FRAME_SLOT& slot = m_slots[frame % m_depth];
+			m_pViewManager->UpdateSceneView();
+			slot.viewState = m_pViewManager->GetViewState();
+			m_pSceneManager->SetViewProjection(slot.viewState.viewProjection);
+			m_pSceneManager->BuildDrawList(slot.drawList);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_submittedFrames = ++frame;
+		}
+		m_frameSubmitted.notify_one();
+
+		// query the latest GLFW events
+		if (NULL != m_pWindow)
+		{
+			glfwPollEvents();
+		}
+
+		if (NULL != m_pFramePacer)
+		{
+			m_pFramePacer->EndFrame(m_pViewManager->HasViewChanged());
+		}
+	}
+
+	// let the render thread draw the submitted frames and stop
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_frameSubmitted.notify_one();
+	renderThread.join();
+
+	AcquireContext();
+	m_pFrameTimes = NULL;
+}
+
+/***********************************************************
+ *  RenderFrames()
+ *
+ *  This method is the body of the render thread.  It draws
+ *  the submitted frames in order until the pipeline stops.
+ ***********************************************************/
+void FramePipeline::RenderFrames()
+{
+	TraceRecorder::SetThreadName("Render");
+
+	if (!AcquireContext())
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_completedFrames = m_submittedFrames;
+		return;
+	}
+
+	while (true)
+	{
+		unsigned int frame = 0;
+		{
+			TRACE_SCOPE("WaitForFrame");
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while ((m_completedFrames == m_submittedFrames) && !m_bStopping)
+			{
+				m_frameSubmitted.wait(lock);
+			}
+			if (m_completedFrames == m_submittedFrames)
+			{
+				break;
+			}
+			frame = m_completedFrames;
+		}
+
+		RenderFrame(m_slots[frame % m_depth], frame);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_completedFrames = frame + 1;
+		}
+		m_frameCompleted.notify_one();
+	}
+
+	ReleaseContext();
+}
+
+/***********************************************************
+ *  RenderFrame()
+ *
+ *  This method is used to submit the draw list of a frame.
+ *  The frame time is measured on this thread, from the end
+ *  of one frame to the end of the next, so it shows the
+ *  throughput of the pipeline.
+ ***********************************************************/
+void FramePipeline::RenderFrame(const FRAME_SLOT& slot, unsigned int frame)
+{
+	FrameProfiler::BeginFrame();
+	TraceRecorder::BeginFrame();
+
+	// Enable z-depth
+	glEnable(GL_DEPTH_TEST);
+
+	// Clear the frame and z buffers
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// swap in any shader programs rebuilt after a GLSL file changed
+	m_pShaderManager->ProcessHotReload();
+
+	m_pShaderManager->ResetUniformStatistics();
+	m_pViewManager->CommitSceneView(slot.viewState);
+	m_pSceneManager->SubmitDrawList(slot.drawList);
+
+	// fence the frame constants copy used by this frame's draws
+	m_pShaderManager->GetFrameUniforms().EndFrame();
+
+	if (NULL != m_pWindow)
+	{
+		PROFILE_SCOPE("glfwSwapBuffers");
+		glfwSwapBuffers(m_pWindow);
+	}
+	else
+	{
+		// there is no buffer swap to pace the frames
+		PROFILE_SCOPE("glFinish");
+		glFinish();
+	}
+
+	FrameProfiler::EndFrame();
+	TraceRecorder::EndFrame();
+
+	std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+	double frameMs = std::chrono::duration<double, std::milli>(frameEnd - m_lastFrameEnd).count();
+	m_lastFrameEnd = frameEnd;
+	if (NULL == m_pWindow)
+	{
+		m_pFrameTimes->push_back(frameMs);
+	}
+
+	if (NULL != m_pTelemetryLog)
+	{
+		TelemetryLog::TELEMETRY_SAMPLE sample;
+		sample.timestampMs = m_pTelemetryLog->GetElapsedMs();
+		sample.frame = frame;
+		sample.frameMs = (float)frameMs;
+		sample.drawCalls = m_pSceneManager->GetDrawStatistics().drawCalls;
+		sample.triangles = m_pSceneManager->GetDrawStatistics().triangles;
+		sample.uniformUploads = m_pShaderManager->GetUniformUploads();
+		sample.uniformSkips = m_pShaderManager->GetUniformSkips();
+		sample.lightRadius = m_pSceneManager->GetLightRadius();
+		sample.lightHeight = m_pSceneManager->GetLightHeight();
+		m_pTelemetryLog->Push(sample);
+	}
+}
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepipeline.h
+// ============
+// run the frame loop as a pipeline - the main thread builds the next frame
+// while a render thread submits the current one to OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "ViewManager.h"
+#include "SceneManager.h"
+#include "HeadlessContext.h"
+#include "TelemetryLog.h"
+#include "FramePacer.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <GLFW/glfw3.h>
+
+/***********************************************************
+ *  FramePipeline
+ *
+ *  This class contains the code for the pipelined frame
+ *  loop.  The main thread handles the window events, moves
+ *  the camera and builds the draw list of frame N+1, while
+ *  the render thread owns the OpenGL context and submits
+ *  frame N.  The frames are passed between the threads in
+ *  a ring of frame slots, guarded by two fences:
+ *
+ *  - the main thread waits until the render thread has
+ *    finished with a slot before building into it again
+ *  - the render thread waits until a slot was submitted
+ *    before drawing it
+ *
+ *  The depth of the ring trades latency for throughput.
+ *  With one slot the threads take turns, like the serial
+ *  loop, two slots let the main thread run one frame ahead,
+ *  and three slots absorb the frames that take longer.
+ ***********************************************************/
+class FramePipeline
+{
+public:
+	// largest number of frames in the ring
+	static const int MAX_DEPTH = 3;
+
+	// constructor
+	FramePipeline(
+		ShaderManager* pShaderManager,
+		ViewManager* pViewManager,
+		SceneManager* pSceneManager,
+		GLFWwindow* window,
+		HeadlessContext* pHeadlessContext);
+	// destructor
+	~FramePipeline();
+
+	// number of frames that can be built ahead of the GPU
+	void SetDepth(int depth);
+	// log the metrics of every frame
+	void SetTelemetryLog(TelemetryLog* pTelemetryLog);
+	// pace the frames built by the main thread
+	void SetFramePacer(FramePacer* pFramePacer);
+
+	// run frames until the window is closed, the input replay
+	// ends or the passed in number of frames is reached - the
+	// frame count is only used without a window, and the time
+	// of each frame is added to the passed in list
+	void Run(int frameCount, std::vector<double>& frameTimes);
+
+private:
+	// one frame travelling from the main to the render thread
+	struct FRAME_SLOT
+	{
+		ViewManager::VIEW_STATE viewState;
+		SceneManager::DRAW_LIST drawList;
+	};
+
+	// pointers to the objects of the application
+	ShaderManager* m_pShaderManager;
+	ViewManager* m_pViewManager;
+	SceneManager* m_pSceneManager;
+	GLFWwindow* m_pWindow;
+	HeadlessContext* m_pHeadlessContext;
+	TelemetryLog* m_pTelemetryLog;
+	FramePacer* m_pFramePacer;
+
+	// the ring of frames and the fences between the threads
+	FRAME_SLOT m_slots[MAX_DEPTH];
+	int m_depth;
+	unsigned int m_submittedFrames;
+	unsigned int m_completedFrames;
+	bool m_bStopping;
+	std::mutex m_mutex;
+	std::condition_variable m_frameSubmitted;
+	std::condition_variable m_frameCompleted;
+
+	// frame times measured by the render thread
+	std::vector<double>* m_pFrameTimes;
+	std::chrono::steady_clock::time_point m_lastFrameEnd;
+
+	// move the OpenGL context to or from the calling thread
+	bool AcquireContext();
+	void ReleaseContext();
+
+	// body of the render thread
+	void RenderFrames();
+	// submit one frame to OpenGL
+	void RenderFrame(const FRAME_SLOT& slot, unsigned int frame);
+};
@@ -0,0 +1,673 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmapbaker.cpp
+// ============
+// bake the diffuse lighting and the ambient occlusion of the static scene
+// lights into a lightmap texture, ray traced on the CPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightmapBaker.h"
+#include "RenderTarget.h"
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+const float LightmapBaker::LIGHTMAP_RANGE = 2.0f;
+
+// declaration of global variables
+namespace
+{
+	const char g_LayoutMagic[4] = { 'L', 'M', 'A', 'P' };
+	const uint32_t g_LayoutVersion = 1;
+
+	// texels left empty around every cell, for the filtering
+	const int g_CellGutter = 1;
+	// legs of the smallest cell of a triangle with area, which
+	// covers three texels
+	const int g_MinCellSize = 2;
+	// each try to pack the cells shrinks them by this much
+	const float g_DensityStep = 0.95f;
+	// rows of a cell that are ray traced by one job
+	const int g_BakeRowsPerJob = 16;
+	// distance that the rays start above the surface, so that
+	// they do not hit the triangle they start from
+	const float g_RayBias = 0.002f;
+	// a triangle below this world area gets no texels
+	const float g_MinTriangleArea = 1e-10f;
+
+	// a material for the commands that are drawn before one is set
+	const SceneManager::OBJECT_MATERIAL g_NoMaterial = { 0.0f, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, "" };
+
+	// the next value of a xorshift random sequence, as a float
+	// in [0, 1)
+	float NextRandom(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return((float)(state >> 8) * (1.0f / 16777216.0f));
+	}
+
+	// a seed that differs for every texel, and never is zero
+	uint32_t TexelSeed(int x, int y)
+	{
+		uint32_t hash = ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u);
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6bu;
+		hash ^= hash >> 13;
+		return(hash | 1u);
+	}
+}
+
+/***********************************************************
+ *  LightmapBaker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightmapBaker::LightmapBaker(SceneManager* pSceneManager)
+{
+	m_pSceneManager = pSceneManager;
+	m_pJobSystem = NULL;
+	m_layout.width = 0;
+	m_layout.height = 0;
+	m_layout.lightRadius = 0.0f;
+	m_layout.lightHeight = 0.0f;
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used to set the pool that the texels are
+ *  ray traced on.  The pool must outlive the baker.
+ ***********************************************************/
+void LightmapBaker::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+/***********************************************************
+ *  GetDefaultSettings()
+ *
+ *  This method is used to get the settings that a bake
+ *  uses unless they are changed on the command line.
+ ***********************************************************/
+void LightmapBaker::GetDefaultSettings(BAKE_SETTINGS& settings)
+{
+	settings.atlasSize = 2048;
+	settings.occlusionRays = 16;
+	settings.occlusionDistance = 1.0f;
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used to bake the lighting of every draw
+ *  command of the scene into the atlas.  The scene has to
+ *  be prepared, its meshes are drawn into a list of world
+ *  space triangles that the rays are traced against.
+ ***********************************************************/
+bool LightmapBaker::Bake(const BAKE_SETTINGS& settings, const FrameUniformBuffer::FRAME_CONSTANTS& frame)
+{
+	TRACE_SCOPE("BakeLightmaps");
+
+	if ((settings.atlasSize < 64) || (settings.atlasSize > 8192))
+	{
+		printf("The lightmap atlas size %d is not between 64 and 8192\n", settings.atlasSize);
+		return false;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	SceneManager::DRAW_LIST drawList;
+	m_pSceneManager->BuildDrawList(drawList);
+
+	m_layout.instances.clear();
+	m_layout.lightRadius = m_pSceneManager->GetLightRadius();
+	m_layout.lightHeight = m_pSceneManager->GetLightHeight();
+	m_triangles.clear();
+	m_lighting.clear();
+
+	// every command is an instance, culled or not, with the
+	// material carried over like the shader uniforms
+	std::vector<std::vector<ShapeMeshes::MESH_VERTEX> > meshTriangles(m_pSceneManager->GetMeshCount());
+	std::vector<bool> bCaptured(m_pSceneManager->GetMeshCount(), false);
+	std::vector<glm::vec3> positions;
+	const SceneManager::OBJECT_MATERIAL* pMaterial = &g_NoMaterial;
+	for (size_t i = 0; i < drawList.commands.size(); i++)
+	{
+		const SceneManager::DRAW_COMMAND& command = drawList.commands[i];
+		if (!bCaptured[command.mesh])
+		{
+			m_pSceneManager->GetMeshTriangles(command.mesh, meshTriangles[command.mesh]);
+			bCaptured[command.mesh] = true;
+		}
+		if (command.material >= 0)
+		{
+			const SceneManager::OBJECT_MATERIAL* pFound = m_pSceneManager->GetMaterial(command.material);
+			pMaterial = (NULL != pFound) ? pFound : &g_NoMaterial;
+		}
+
+		PhongKernel::PHONG_CONSTANTS lighting;
+		PhongKernel::PrepareConstants(frame, *pMaterial, lighting);
+		m_lighting.push_back(lighting);
+
+		LIGHTMAP_INSTANCE instance;
+		instance.mesh = command.mesh;
+		instance.scale = command.scale;
+		instance.rotationDegrees = command.rotationDegrees;
+		instance.position = command.position;
+
+		const std::vector<ShapeMeshes::MESH_VERTEX>& vertices = meshTriangles[command.mesh];
+		for (size_t v = 0; v + 2 < vertices.size(); v += 3)
+		{
+			BAKE_TRIANGLE triangle;
+			for (int k = 0; k < 3; k++)
+			{
+				// the normals are left unnormalized, the shader
+				// interpolates them that way too
+				triangle.positions[k] = glm::vec3(command.model * glm::vec4(vertices[v + k].position, 1.0f));
+				triangle.normals[k] = command.normalMatrix * vertices[v + k].normal;
+				positions.push_back(triangle.positions[k]);
+			}
+			triangle.instance = (int)m_layout.instances.size();
+			triangle.cell = (int)instance.cells.size();
+			m_triangles.push_back(triangle);
+
+			LIGHTMAP_CELL cell = { 0, 0, 0, 0 };
+			instance.cells.push_back(cell);
+		}
+		m_layout.instances.push_back(instance);
+	}
+
+	m_bvh.Build(positions);
+
+	if (PackCells(settings.atlasSize) == false)
+	{
+		printf("The %d lightmap triangles do not fit into a %dx%d atlas\n", (int)m_triangles.size(), settings.atlasSize, settings.atlasSize);
+		return false;
+	}
+
+	m_texels.assign((size_t)m_layout.width * m_layout.height, glm::vec3(0.0f));
+	m_coverage.assign((size_t)m_layout.width * m_layout.height, 0);
+
+	// the cells are split into bands of rows, so the large
+	// triangles of the floor are shared by all the workers
+	std::vector<glm::ivec3> jobs;
+	for (size_t i = 0; i < m_triangles.size(); i++)
+	{
+		const LIGHTMAP_CELL& cell = m_layout.instances[m_triangles[i].instance].cells[m_triangles[i].cell];
+		for (int row = 0; row < cell.size; row += g_BakeRowsPerJob)
+		{
+			jobs.push_back(glm::ivec3((int)i, row, std::min((int)cell.size, row + g_BakeRowsPerJob)));
+		}
+	}
+
+	std::function<void(int, int)> bake = [this, &settings, &jobs](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			BakeTriangle(settings, jobs[i].x, jobs[i].y, jobs[i].z);
+		}
+	};
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor((int)jobs.size(), 4, bake);
+	}
+	else
+	{
+		bake(0, (int)jobs.size());
+	}
+
+	DilateTexels(2);
+
+	size_t coveredTexels = 0;
+	for (size_t i = 0; i < m_coverage.size(); i++)
+	{
+		coveredTexels += (m_coverage[i] == 1) ? 1 : 0;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("INFO: Baked %d instances, %d triangles and %d nodes, into %.0f texels of a %dx%d lightmap\n",
+		(int)m_layout.instances.size(), m_bvh.GetTriangleCount(), m_bvh.GetNodeCount(),
+		(double)coveredTexels, m_layout.width, m_layout.height);
+	printf("INFO:   %d occlusion rays per texel, %.2f s on %d worker(s)\n",
+		settings.occlusionRays, seconds, (NULL != m_pJobSystem) ? m_pJobSystem->GetWorkerCount() : 1);
+
+	return true;
+}
+
+/***********************************************************
+ *  PackCells()
+ *
+ *  This method is used to find the largest texel density
+ *  that the cells of the triangles fit into the atlas with.
+ *  The first try assumes no space is lost to the gutters
+ *  and the rows, and every next try shrinks the cells a
+ *  little.
+ ***********************************************************/
+bool LightmapBaker::PackCells(int atlasSize)
+{
+	double totalArea = 0.0;
+	for (size_t i = 0; i < m_triangles.size(); i++)
+	{
+		const BAKE_TRIANGLE& triangle = m_triangles[i];
+		totalArea += glm::length(glm::cross(triangle.positions[1] - triangle.positions[0], triangle.positions[2] - triangle.positions[0]));
+	}
+	if (totalArea <= 0.0)
+	{
+		return false;
+	}
+
+	// a triangle of area A has a cell of sqrt(2 A) * density
+	// texels, which holds A * density * density texels
+	float density = (float)sqrt((double)atlasSize * atlasSize / totalArea);
+	while (density > 1e-3f)
+	{
+		if (PackCellsAtDensity(atlasSize, density))
+		{
+			return true;
+		}
+		density *= g_DensityStep;
+	}
+	return false;
+}
+
+/***********************************************************
+ *  PackCellsAtDensity()
+ *
+ *  This method is used to size the cells for a texel
+ *  density and pack them into rows, from the largest to
+ *  the smallest.  The largest vertex angle of a triangle
+ *  goes to the right angle of its cell, which keeps the
+ *  texels of the triangle closest to square.
+ ***********************************************************/
+bool LightmapBaker::PackCellsAtDensity(int atlasSize, float density)
+{
+	const int maxCellSize = (atlasSize / 2) - (g_CellGutter * 2);
+
+	std::vector<int> order;
+	order.reserve(m_triangles.size());
+	for (size_t i = 0; i < m_triangles.size(); i++)
+	{
+		const BAKE_TRIANGLE& triangle = m_triangles[i];
+		LIGHTMAP_CELL& cell = m_layout.instances[triangle.instance].cells[triangle.cell];
+
+		float edges[3];
+		for (int k = 0; k < 3; k++)
+		{
+			edges[k] = glm::length(triangle.positions[(k + 2) % 3] - triangle.positions[(k + 1) % 3]);
+		}
+		int corner = 0;
+		if (edges[1] > edges[corner])
+		{
+			corner = 1;
+		}
+		if (edges[2] > edges[corner])
+		{
+			corner = 2;
+		}
+
+		float area = 0.5f * glm::length(glm::cross(triangle.positions[1] - triangle.positions[0], triangle.positions[2] - triangle.positions[0]));
+		cell.x = 0;
+		cell.y = 0;
+		cell.corner = (uint16_t)corner;
+		cell.size = 0;
+		if (area > g_MinTriangleArea)
+		{
+			int size = (int)(sqrtf(2.0f * area) * density + 0.5f);
+			cell.size = (uint16_t)std::min(std::max(size, g_MinCellSize), maxCellSize);
+			order.push_back((int)i);
+		}
+	}
+
+	std::stable_sort(order.begin(), order.end(), [this](int a, int b)
+	{
+		return(m_layout.instances[m_triangles[a].instance].cells[m_triangles[a].cell].size >
+			m_layout.instances[m_triangles[b].instance].cells[m_triangles[b].cell].size);
+	});
+
+	int cursorX = 0;
+	int cursorY = 0;
+	int rowHeight = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const BAKE_TRIANGLE& triangle = m_triangles[order[i]];
+		LIGHTMAP_CELL& cell = m_layout.instances[triangle.instance].cells[triangle.cell];
+
+		int footprint = cell.size + (g_CellGutter * 2);
+		if (cursorX + footprint > atlasSize)
+		{
+			cursorX = 0;
+			cursorY += rowHeight;
+			rowHeight = 0;
+		}
+		if (cursorY + footprint > atlasSize)
+		{
+			return false;
+		}
+
+		cell.x = (uint16_t)(cursorX + g_CellGutter);
+		cell.y = (uint16_t)(cursorY + g_CellGutter);
+		cursorX += footprint;
+		rowHeight = std::max(rowHeight, footprint);
+	}
+
+	m_layout.width = atlasSize;
+	m_layout.height = atlasSize;
+	return true;
+}
+
+/***********************************************************
+ *  BakeTriangle()
+ *
+ *  This method is used to ray trace the texels of a band
+ *  of rows of a cell whose centers are inside its triangle.
+ *  A texel gets the ambient of the lights, darkened by the
+ *  share of its occlusion rays that hit something, and the
+ *  diffuse light of every light that its shadow ray
+ *  reaches.
+ ***********************************************************/
+void LightmapBaker::BakeTriangle(const BAKE_SETTINGS& settings, int triangleIndex, int firstRow, int endRow)
+{
+	const BAKE_TRIANGLE& triangle = m_triangles[triangleIndex];
+	const LIGHTMAP_CELL& cell = m_layout.instances[triangle.instance].cells[triangle.cell];
+	const PhongKernel::PHONG_CONSTANTS& lighting = m_lighting[triangle.instance];
+
+	// the corner vertex and the vertices along the x and y legs
+	int corner = cell.corner;
+	const glm::vec3& p0 = triangle.positions[corner];
+	const glm::vec3& p1 = triangle.positions[(corner + 1) % 3];
+	const glm::vec3& p2 = triangle.positions[(corner + 2) % 3];
+	const glm::vec3& n0 = triangle.normals[corner];
+	const glm::vec3& n1 = triangle.normals[(corner + 1) % 3];
+	const glm::vec3& n2 = triangle.normals[(corner + 2) % 3];
+	glm::vec3 faceNormal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+
+	float size = (float)cell.size;
+	for (int row = firstRow; row < endRow; row++)
+	{
+		for (int column = 0; column + row < cell.size; column++)
+		{
+			float u = ((float)column + 0.5f) / size;
+			float v = ((float)row + 0.5f) / size;
+
+			glm::vec3 position = (p0 * (1.0f - u - v)) + (p1 * u) + (p2 * v);
+			glm::vec3 normal = (n0 * (1.0f - u - v)) + (n1 * u) + (n2 * v);
+			if (glm::dot(normal, normal) <= 0.0f)
+			{
+				normal = faceNormal;
+			}
+			normal = glm::normalize(normal);
+
+			// the rays start on the side of the surface that the
+			// shading normal points to
+			glm::vec3 side = (glm::dot(faceNormal, normal) < 0.0f) ? -faceNormal : faceNormal;
+			glm::vec3 origin = position + (side * g_RayBias);
+
+			glm::vec3 diffuse(0.0f);
+			for (int i = 0; i < lighting.lightCount; i++)
+			{
+				glm::vec3 toLight = glm::vec3(lighting.lightX[i], lighting.lightY[i], lighting.lightZ[i]) - position;
+				float impact = glm::dot(normal, glm::normalize(toLight));
+				if ((impact > 0.0f) && !m_bvh.IsOccluded(origin, toLight, 1.0f))
+				{
+					diffuse += impact * lighting.diffuseColor;
+				}
+			}
+
+			// cosine weighted directions around the normal
+			int x = cell.x + column;
+			int y = cell.y + row;
+			float occlusion = 0.0f;
+			if (settings.occlusionRays > 0)
+			{
+				glm::vec3 tangent = (fabsf(normal.x) > 0.5f) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+				tangent = glm::normalize(glm::cross(tangent, normal));
+				glm::vec3 bitangent = glm::cross(normal, tangent);
+
+				uint32_t seed = TexelSeed(x, y);
+				int hits = 0;
+				for (int i = 0; i < settings.occlusionRays; i++)
+				{
+					float angle = NextRandom(seed) * 6.28318531f;
+					float radiusSquared = NextRandom(seed);
+					float radius = sqrtf(radiusSquared);
+					glm::vec3 direction = (tangent * (radius * cosf(angle))) + (bitangent * (radius * sinf(angle))) +
+						(normal * sqrtf(1.0f - radiusSquared));
+					if (m_bvh.IsOccluded(origin, direction, settings.occlusionDistance))
+					{
+						hits++;
+					}
+				}
+				occlusion = (float)hits / (float)settings.occlusionRays;
+			}
+
+			size_t texel = ((size_t)y * m_layout.width) + x;
+			m_texels[texel] = (lighting.ambient * (1.0f - occlusion)) + diffuse;
+			m_coverage[texel] = 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  DilateTexels()
+ *
+ *  This method is used to give the empty texels next to
+ *  covered ones the average of those neighbours.  Every
+ *  pass grows the covered texels by one, which keeps the
+ *  bilinear filtering of the triangle edges inside the
+ *  lighting of the triangle.
+ ***********************************************************/
+void LightmapBaker::DilateTexels(int passes)
+{
+	int width = m_layout.width;
+	int height = m_layout.height;
+	std::vector<size_t> filled;
+
+	for (int pass = 0; pass < passes; pass++)
+	{
+		filled.clear();
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				size_t texel = ((size_t)y * width) + x;
+				if (m_coverage[texel] != 0)
+				{
+					continue;
+				}
+
+				glm::vec3 sum(0.0f);
+				int count = 0;
+				for (int dy = -1; dy <= 1; dy++)
+				{
+					for (int dx = -1; dx <= 1; dx++)
+					{
+						int nx = x + dx;
+						int ny = y + dy;
+						if ((nx < 0) || (ny < 0) || (nx >= width) || (ny >= height))
+						{
+							continue;
+						}
+						size_t neighbour = ((size_t)ny * width) + nx;
+						if ((m_coverage[neighbour] != 0) && (m_coverage[neighbour] <= pass + 1))
+						{
+							sum += m_texels[neighbour];
+							count++;
+						}
+					}
+				}
+				if (count > 0)
+				{
+					m_texels[texel] = sum / (float)count;
+					filled.push_back(texel);
+				}
+			}
+		}
+
+		// the texels filled by this pass are only read by the next
+		for (size_t i = 0; i < filled.size(); i++)
+		{
+			m_coverage[filled[i]] = (unsigned char)(pass + 2);
+		}
+	}
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used to save the atlas as a PNG image,
+ *  with the first row at the bottom like the other scene
+ *  textures, and the layout as a binary file next to it.
+ ***********************************************************/
+bool LightmapBaker::Save(const char* name) const
+{
+	if (m_texels.empty())
+	{
+		printf("No lightmap was baked\n");
+		return false;
+	}
+
+	std::vector<unsigned char> pixels((size_t)m_layout.width * m_layout.height * 4);
+	for (size_t i = 0; i < m_texels.size(); i++)
+	{
+		glm::vec3 value = glm::clamp(m_texels[i] / LIGHTMAP_RANGE, glm::vec3(0.0f), glm::vec3(1.0f));
+		pixels[i * 4] = (unsigned char)(value.r * 255.0f + 0.5f);
+		pixels[i * 4 + 1] = (unsigned char)(value.g * 255.0f + 0.5f);
+		pixels[i * 4 + 2] = (unsigned char)(value.b * 255.0f + 0.5f);
+		pixels[i * 4 + 3] = 255;
+	}
+
+	std::string imageFilename = std::string(name) + ".png";
+	if (RenderTarget::WritePNG(imageFilename.c_str(), m_layout.width, m_layout.height, pixels) == false)
+	{
+		return false;
+	}
+
+	std::string layoutFilename = std::string(name) + ".layout";
+	FILE* file = fopen(layoutFilename.c_str(), "wb");
+	if (NULL == file)
+	{
+		printf("Unable to write lightmap layout %s\n", layoutFilename.c_str());
+		return false;
+	}
+
+	int32_t header[3] = { m_layout.width, m_layout.height, (int32_t)m_layout.instances.size() };
+	float lights[2] = { m_layout.lightRadius, m_layout.lightHeight };
+	fwrite(g_LayoutMagic, sizeof(g_LayoutMagic), 1, file);
+	fwrite(&g_LayoutVersion, sizeof(g_LayoutVersion), 1, file);
+	fwrite(header, sizeof(header), 1, file);
+	fwrite(lights, sizeof(lights), 1, file);
+	for (size_t i = 0; i < m_layout.instances.size(); i++)
+	{
+		const LIGHTMAP_INSTANCE& instance = m_layout.instances[i];
+		int32_t counts[2] = { (int32_t)instance.mesh, (int32_t)instance.cells.size() };
+		fwrite(counts, sizeof(counts), 1, file);
+		fwrite(&instance.scale, sizeof(instance.scale), 1, file);
+		fwrite(&instance.rotationDegrees, sizeof(instance.rotationDegrees), 1, file);
+		fwrite(&instance.position, sizeof(instance.position), 1, file);
+		if (!instance.cells.empty())
+		{
+			fwrite(&instance.cells[0], sizeof(LIGHTMAP_CELL), instance.cells.size(), file);
+		}
+	}
+	bool bWritten = (ferror(file) == 0);
+	fclose(file);
+
+	if (!bWritten)
+	{
+		printf("Unable to write lightmap layout %s\n", layoutFilename.c_str());
+		return false;
+	}
+	printf("INFO: Saved the lightmap to %s and %s\n", imageFilename.c_str(), layoutFilename.c_str());
+	return true;
+}
+
+/***********************************************************
+ *  LoadLayout()
+ *
+ *  This method is used to read a layout saved by Save().
+ ***********************************************************/
+bool LightmapBaker::LoadLayout(const char* filename, LIGHTMAP_LAYOUT& layout)
+{
+	FILE* file = fopen(filename, "rb");
+	if (NULL == file)
+	{
+		printf("Unable to read lightmap layout %s\n", filename);
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	int32_t header[3] = { 0, 0, 0 };
+	float lights[2] = { 0.0f, 0.0f };
+	bool bValid = (fread(magic, sizeof(magic), 1, file) == 1) &&
+		(fread(&version, sizeof(version), 1, file) == 1) &&
+		(fread(header, sizeof(header), 1, file) == 1) &&
+		(fread(lights, sizeof(lights), 1, file) == 1) &&
+		(memcmp(magic, g_LayoutMagic, sizeof(magic)) == 0) &&
+		(version == g_LayoutVersion) &&
+		(header[0] > 0) && (header[1] > 0) && (header[2] >= 0);
+
+	layout.width = header[0];
+	layout.height = header[1];
+	layout.lightRadius = lights[0];
+	layout.lightHeight = lights[1];
+	layout.instances.clear();
+	for (int i = 0; bValid && (i < header[2]); i++)
+	{
+		LIGHTMAP_INSTANCE instance;
+		int32_t counts[2] = { 0, 0 };
+		bValid = (fread(counts, sizeof(counts), 1, file) == 1) &&
+			(fread(&instance.scale, sizeof(instance.scale), 1, file) == 1) &&
+			(fread(&instance.rotationDegrees, sizeof(instance.rotationDegrees), 1, file) == 1) &&
+			(fread(&instance.position, sizeof(instance.position), 1, file) == 1) &&
+			// the imported meshes of the scene follow the basic ones,
+			// so the mesh is only matched against the commands
+			(counts[0] >= SceneManager::MESH_BOX) &&
+			(counts[1] >= 0);
+		if (bValid)
+		{
+			instance.mesh = (SceneManager::MESH_TYPE)counts[0];
+			instance.cells.resize(counts[1]);
+			bValid = (counts[1] == 0) || (fread(&instance.cells[0], sizeof(LIGHTMAP_CELL), counts[1], file) == (size_t)counts[1]);
+			layout.instances.push_back(instance);
+		}
+	}
+	fclose(file);
+
+	if (!bValid)
+	{
+		printf("%s is not a lightmap layout\n", filename);
+		layout.instances.clear();
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  GetLightmapCoordinates()
+ *
+ *  This method is used to get the texture coordinates in
+ *  the atlas of every corner of the triangles of an
+ *  instance, in the order the mesh draws them.
+ ***********************************************************/
+void LightmapBaker::GetLightmapCoordinates(const LIGHTMAP_LAYOUT& layout, const LIGHTMAP_INSTANCE& instance, std::vector<glm::vec2>& coordinates)
+{
+	coordinates.resize(instance.cells.size() * 3);
+
+	glm::vec2 texelSize(1.0f / (float)layout.width, 1.0f / (float)layout.height);
+	for (size_t i = 0; i < instance.cells.size(); i++)
+	{
+		const LIGHTMAP_CELL& cell = instance.cells[i];
+		int corner = cell.corner % 3;
+		glm::vec2 origin((float)cell.x, (float)cell.y);
+		coordinates[i * 3 + corner] = origin * texelSize;
+		coordinates[i * 3 + ((corner + 1) % 3)] = (origin + glm::vec2((float)cell.size, 0.0f)) * texelSize;
+		coordinates[i * 3 + ((corner + 2) % 3)] = (origin + glm::vec2(0.0f, (float)cell.size)) * texelSize;
+	}
+}
@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmapbaker.h
+// ============
+// bake the diffuse lighting and the ambient occlusion of the static scene
+// lights into a lightmap texture, ray traced on the CPU
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "FrameUniformBuffer.h"
+#include "JobSystem.h"
+#include "TriangleBVH.h"
+#include "PhongKernel.h"
+
+#include <stdint.h>
+#include <vector>
+
+/***********************************************************
+ *  LightmapBaker
+ *
+ *  This class contains the code for the offline lightmap
+ *  baker.  Every draw command of the scene is an instance
+ *  with its own part of one lightmap atlas:
+ *
+ *  - every triangle of an instance gets a square cell in
+ *    the atlas, sized by its world area, and is mapped to
+ *    the lower left half of it, so that no two triangles
+ *    share a texel
+ *  - the cells are packed into rows of the atlas, with a
+ *    gutter around every cell for the texture filtering
+ *  - every covered texel is ray traced through a bounding
+ *    volume hierarchy of the whole scene, with a shadow ray
+ *    to every light and a hemisphere of occlusion rays
+ *  - the empty texels next to the cells are filled from
+ *    their neighbours, so bilinear filtering at a triangle
+ *    edge does not bleed in black
+ *
+ *  The lighting is the ambient and diffuse part of the
+ *  fragment shader, stored divided by LIGHTMAP_RANGE so
+ *  that the 8 bit texture can hold values above one.  The
+ *  specular part depends on the camera, it is left to the
+ *  shader.
+ ***********************************************************/
+class LightmapBaker
+{
+public:
+	// the baked lighting is stored divided by this, the shader
+	// multiplies it back
+	static const float LIGHTMAP_RANGE;
+
+	// the settings of a bake
+	struct BAKE_SETTINGS
+	{
+		int atlasSize;			// width and height of the atlas in texels
+		int occlusionRays;		// hemisphere rays per texel
+		float occlusionDistance;	// hits further away than this do not occlude
+	};
+
+	// the square of the atlas a triangle is mapped to - the
+	// corner vertex goes to x and y, the next two vertices are
+	// size texels to the right of it and above it, and the size
+	// is zero for triangles without area
+	struct LIGHTMAP_CELL
+	{
+		uint16_t x;
+		uint16_t y;
+		uint16_t size;
+		uint16_t corner;
+	};
+
+	// the cells of one draw command, and the transformation it
+	// was baked with
+	struct LIGHTMAP_INSTANCE
+	{
+		SceneManager::MESH_TYPE mesh;
+		glm::vec3 scale;
+		glm::vec3 rotationDegrees;
+		glm::vec3 position;
+		std::vector<LIGHTMAP_CELL> cells;
+	};
+
+	// where the instances are in the atlas, and the light
+	// placement the atlas is valid for
+	struct LIGHTMAP_LAYOUT
+	{
+		int width;
+		int height;
+		float lightRadius;
+		float lightHeight;
+		std::vector<LIGHTMAP_INSTANCE> instances;
+	};
+
+	// constructor
+	LightmapBaker(SceneManager* pSceneManager);
+
+	// spread the ray tracing over a job system, or NULL
+	void SetJobSystem(JobSystem* pJobSystem);
+
+	// the default settings of a bake
+	static void GetDefaultSettings(BAKE_SETTINGS& settings);
+
+	// bake the draw list of the prepared scene with the lights
+	// of the frame constants
+	bool Bake(const BAKE_SETTINGS& settings, const FrameUniformBuffer::FRAME_CONSTANTS& frame);
+
+	// save the atlas as <name>.png and the layout as <name>.layout
+	bool Save(const char* name) const;
+	// load the layout saved with an atlas
+	static bool LoadLayout(const char* filename, LIGHTMAP_LAYOUT& layout);
+
+	// the atlas coordinates of the corners of the triangles of
+	// an instance, three per triangle
+	static void GetLightmapCoordinates(const LIGHTMAP_LAYOUT& layout, const LIGHTMAP_INSTANCE& instance, std::vector<glm::vec2>& coordinates);
+
+	const LIGHTMAP_LAYOUT& GetLayout() const { return m_layout; }
+
+private:
+	// a triangle of an instance in world space
+	struct BAKE_TRIANGLE
+	{
+		glm::vec3 positions[3];
+		glm::vec3 normals[3];
+		int instance;
+		int cell;
+	};
+
+	SceneManager* m_pSceneManager;
+	JobSystem* m_pJobSystem;
+
+	LIGHTMAP_LAYOUT m_layout;
+	std::vector<BAKE_TRIANGLE> m_triangles;
+	// the lights combined with the material of every instance
+	std::vector<PhongKernel::PHONG_CONSTANTS> m_lighting;
+	TriangleBVH m_bvh;
+
+	// the baked lighting of every texel, and which texels are
+	// covered by a triangle
+	std::vector<glm::vec3> m_texels;
+	std::vector<unsigned char> m_coverage;
+
+	// size the cells of the triangles to fill the atlas and pack
+	// them into its rows, false when they do not fit
+	bool PackCells(int atlasSize);
+	bool PackCellsAtDensity(int atlasSize, float density);
+	// ray trace the texels of a band of rows of a triangle
+	void BakeTriangle(const BAKE_SETTINGS& settings, int triangleIndex, int firstRow, int endRow);
+	// fill the empty texels next to the covered ones
+	void DilateTexels(int passes);
+};
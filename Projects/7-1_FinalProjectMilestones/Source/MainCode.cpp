@@ -1,5 +1,12 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <climits>          // INT_MAX
+#include <chrono>           // headless frame timing
+#include <vector>
+#include <algorithm>        // sort
+#include <fstream>
+#include <thread>           // hardware_concurrency
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -13,6 +20,23 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "HeadlessContext.h"
+#include "RenderTarget.h"
+#include "FrameProfiler.h"
+#include "TraceRecorder.h"
+#include "TelemetryLog.h"
+#include "BenchmarkRunner.h"
+#include "FramePipeline.h"
+#include "JobSystem.h"
+#include "FramePacer.h"
+#include "SoftwareRenderer.h"
+#include "PhongKernel.h"
+#include "LightmapBaker.h"
+#include "ShadowMapper.h"
+#include "TransformBatch.h"
+#include "SceneFile.h"
+#include "MeshImporter.h"
+#include "AssetManager.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,12 +53,45 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+
+	// per-frame metrics log, only created when --telemetry is passed
+	TelemetryLog* g_TelemetryLog = nullptr;
+
+	// OpenGL context used instead of the GLFW window in headless mode
+	HeadlessContext g_HeadlessContext;
+	// worker threads for the per-frame scene work and the loading
+	JobSystem g_JobSystem;
+	// number of frames rendered in headless mode unless --frames is passed
+	const int DEFAULT_HEADLESS_FRAMES = 300;
+	// number of frames recorded in the trace unless --trace-frames is passed
+	const int DEFAULT_TRACE_FRAMES = 120;
+	// measured frames per benchmark scene unless --benchmark-frames is passed
+	const int DEFAULT_BENCHMARK_FRAMES = 300;
+	// allowed slowdown against the baseline unless --threshold is passed
+	const float DEFAULT_BENCHMARK_THRESHOLD = 10.0f;
+	// frame rate of an unchanged scene unless --idle-fps is passed
+	const float DEFAULT_IDLE_FPS = 4.0f;
+	// scene description that is drawn unless --scene is passed
+	const char* const DEFAULT_SCENE_FILE = "../../Utilities/scenes/desk.toml";
+	// longest wait for events while rendering on demand, so that a
+	// rebuilt shader is still picked up without any input
+	const double ON_DEMAND_WAIT_SECONDS = 0.25;
+
+	// set when the window has to be drawn again without a change,
+	// such as after it was uncovered
+	bool g_bWindowDamaged = false;
+	// set when the size of the window framebuffer changed, so
+	// that the kept frame is made again at the new size
+	bool g_bFramebufferResized = false;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
-bool InitializeGLEW();
+bool InitializeGLEW(bool bHeadless);
+void WriteFrameTimes(std::vector<double> frameTimes, const char* filename);
+void Window_Refresh_Callback(GLFWwindow* window);
+void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
 
 
 /***********************************************************
@@ -45,63 +102,932 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// shader hot reload is always on for debug builds
+#ifdef _DEBUG
+	bool bHotReload = true;
+#else
+	bool bHotReload = false;
+#endif
+	bool bSerialShaders = false;
+	bool bHeadless = false;
+	int headlessFrames = DEFAULT_HEADLESS_FRAMES;
+	const char* frameTimesFile = NULL;
+	const char* screenshotFile = NULL;
+	bool bProfile = false;
+	const char* profileFile = NULL;
+	const char* traceFile = NULL;
+	int traceFrames = DEFAULT_TRACE_FRAMES;
+	const char* telemetryFile = NULL;
+	bool bBenchmark = false;
+	const char* benchmarkScenes = NULL;
+	int benchmarkFrames = DEFAULT_BENCHMARK_FRAMES;
+	const char* cameraPathFile = NULL;
+	const char* benchmarkFile = NULL;
+	const char* baselineFile = NULL;
+	float benchmarkThreshold = DEFAULT_BENCHMARK_THRESHOLD;
+	bool bFrameCountSet = false;
+	const char* recordInputFile = NULL;
+	const char* replayInputFile = NULL;
+	int pipelineDepth = 0;
+	int jobWorkers = 0;
+	bool bJobScaling = false;
+	bool bVSync = true;
+	float targetFPS = 0.0f;
+	bool bAdaptivePacing = false;
+	float idleFPS = DEFAULT_IDLE_FPS;
+	bool bOnDemand = false;
+	bool bSoftware = false;
+	bool bPhongBenchmark = false;
+	bool bTransformBenchmark = false;
+	const char* phongKernelName = NULL;
+	const char* bakeLightmapsName = NULL;
+	const char* lightmapsName = NULL;
+	LightmapBaker::BAKE_SETTINGS bakeSettings;
+	LightmapBaker::GetDefaultSettings(bakeSettings);
+	bool bShadows = false;
+	int shadowMapSize = ShadowMapper::DEFAULT_MAP_SIZE;
+	bool bShadowCache = true;
+	bool bShadowBenchmark = false;
+	const char* sceneFile = DEFAULT_SCENE_FILE;
+	const char* compileSceneInput = NULL;
+	const char* compileSceneOutput = NULL;
+	const char* compileMeshInput = NULL;
+	const char* compileMeshOutput = NULL;
+	bool bPackedMeshes = false;
+	bool bStreamAssets = false;
+	AssetManager::BUDGET streamingBudget;
+	AssetManager::GetDefaultBudget(streamingBudget);
+
+	// process the command line options
+	for (int i = 1; i < argc; i++)
+	{
+		// recompile the shaders whenever the GLSL files are saved
+		if (strcmp(argv[i], "--hot-reload") == 0)
+		{
+			bHotReload = true;
+		}
+
+		// compile the shaders one after another, even when the driver
+		// supports compiling them in the background - used to compare
+		// the startup time with and without parallel compilation
+		if (strcmp(argv[i], "--serial-shaders") == 0)
+		{
+			bSerialShaders = true;
+		}
+
+		// render a fixed number of frames into an offscreen framebuffer
+		// without a window, for automated performance runs
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			bHeadless = true;
+		}
+		if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc))
+		{
+			headlessFrames = atoi(argv[++i]);
+			bFrameCountSet = true;
+		}
+		if ((strcmp(argv[i], "--frame-times") == 0) && (i + 1 < argc))
+		{
+			frameTimesFile = argv[++i];
+		}
+		if ((strcmp(argv[i], "--screenshot") == 0) && (i + 1 < argc))
+		{
+			screenshotFile = argv[++i];
+		}
+
+		// measure the CPU and GPU time of the frame stages, the
+		// percentiles are printed on exit and optionally saved
+		if (strcmp(argv[i], "--profile") == 0)
+		{
+			bProfile = true;
+		}
+		if ((strcmp(argv[i], "--profile-out") == 0) && (i + 1 < argc))
+		{
+			bProfile = true;
+			profileFile = argv[++i];
+		}
+
+		// record the startup and the first frames as a timeline that
+		// can be opened in chrome://tracing or ui.perfetto.dev
+		if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc))
+		{
+			traceFile = argv[++i];
+		}
+		if ((strcmp(argv[i], "--trace-frames") == 0) && (i + 1 < argc))
+		{
+			traceFrames = atoi(argv[++i]);
+		}
+
+		// log the metrics of every frame, as CSV or as a binary
+		// columnar file when the name ends in .bin
+		if ((strcmp(argv[i], "--telemetry") == 0) && (i + 1 < argc))
+		{
+			telemetryFile = argv[++i];
+		}
+
+		// replay a camera path through the scene and the generated
+		// stress scenes, and fail when the frame times regressed
+		// against a baseline from an earlier run
+		if (strcmp(argv[i], "--benchmark") == 0)
+		{
+			bBenchmark = true;
+		}
+		if ((strcmp(argv[i], "--benchmark-scenes") == 0) && (i + 1 < argc))
+		{
+			benchmarkScenes = argv[++i];
+		}
+		if ((strcmp(argv[i], "--benchmark-frames") == 0) && (i + 1 < argc))
+		{
+			benchmarkFrames = atoi(argv[++i]);
+		}
+		if ((strcmp(argv[i], "--camera-path") == 0) && (i + 1 < argc))
+		{
+			cameraPathFile = argv[++i];
+		}
+		if ((strcmp(argv[i], "--benchmark-out") == 0) && (i + 1 < argc))
+		{
+			benchmarkFile = argv[++i];
+		}
+		if ((strcmp(argv[i], "--baseline") == 0) && (i + 1 < argc))
+		{
+			baselineFile = argv[++i];
+		}
+		if ((strcmp(argv[i], "--threshold") == 0) && (i + 1 < argc))
+		{
+			benchmarkThreshold = (float)atof(argv[++i]);
+		}
+
+		// save the keyboard and mouse input of the session, or play
+		// a saved session back in place of the live input - a slow
+		// camera path can then be reproduced and profiled offline
+		if ((strcmp(argv[i], "--record-input") == 0) && (i + 1 < argc))
+		{
+			recordInputFile = argv[++i];
+		}
+		if ((strcmp(argv[i], "--replay-input") == 0) && (i + 1 < argc))
+		{
+			replayInputFile = argv[++i];
+		}
+
+		// build the next frame on the main thread while a render
+		// thread draws the current one - the depth is the number of
+		// frames in flight, 1 adds no latency and 3 the most
+		if (strcmp(argv[i], "--pipelined") == 0)
+		{
+			pipelineDepth = 2;
+		}
+		if ((strcmp(argv[i], "--pipeline-depth") == 0) && (i + 1 < argc))
+		{
+			pipelineDepth = atoi(argv[++i]);
+		}
+
+		// number of threads for the job system, one per core unless
+		// passed, and a measurement of how the jobs scale from one
+		// worker up to that number
+		if ((strcmp(argv[i], "--workers") == 0) && (i + 1 < argc))
+		{
+			jobWorkers = atoi(argv[++i]);
+		}
+		if (strcmp(argv[i], "--job-scaling") == 0)
+		{
+			bJobScaling = true;
+		}
+
+		// frame pacing - vsync is on unless turned off, the frame rate
+		// can be capped, and the adaptive mode drops to the idle rate
+		// while the camera stands still
+		if ((strcmp(argv[i], "--vsync") == 0) && (i + 1 < argc))
+		{
+			bVSync = (strcmp(argv[++i], "off") != 0);
+		}
+		if ((strcmp(argv[i], "--fps-cap") == 0) && (i + 1 < argc))
+		{
+			targetFPS = (float)atof(argv[++i]);
+		}
+		if (strcmp(argv[i], "--adaptive") == 0)
+		{
+			bAdaptivePacing = true;
+		}
+		if ((strcmp(argv[i], "--idle-fps") == 0) && (i + 1 < argc))
+		{
+			idleFPS = (float)atof(argv[++i]);
+		}
+
+		// only draw a frame when the camera, the lights, the scene
+		// or the shaders changed, and wait for input in between -
+		// used by the serial frame loop only
+		if (strcmp(argv[i], "--on-demand") == 0)
+		{
+			bOnDemand = true;
+		}
+
+		// draw the headless frames with the tiled software renderer,
+		// without any OpenGL context
+		if (strcmp(argv[i], "--software") == 0)
+		{
+			bSoftware = true;
+			bHeadless = true;
+		}
+
+		// measure the pixels per second of the Phong kernels of the
+		// software renderer, or pick the kernel it shades with -
+		// scalar, sse2, neon, avx2 or avx512
+		if (strcmp(argv[i], "--phong-benchmark") == 0)
+		{
+			bPhongBenchmark = true;
+		}
+		if ((strcmp(argv[i], "--phong-kernel") == 0) && (i + 1 < argc))
+		{
+			phongKernelName = argv[++i];
+		}
+
+		// measure the model matrices per second of the transform
+		// batch kernels, which follow the --phong-kernel selection
+		if (strcmp(argv[i], "--transform-benchmark") == 0)
+		{
+			bTransformBenchmark = true;
+		}
+
+		// ray trace the lighting of the static lights into the
+		// lightmap <name>.png and <name>.layout on the CPU, or draw
+		// the frames with a baked lightmap
+		if ((strcmp(argv[i], "--bake-lightmaps") == 0) && (i + 1 < argc))
+		{
+			bakeLightmapsName = argv[++i];
+			bHeadless = true;
+		}
+		if ((strcmp(argv[i], "--lightmaps") == 0) && (i + 1 < argc))
+		{
+			lightmapsName = argv[++i];
+		}
+		if ((strcmp(argv[i], "--lightmap-size") == 0) && (i + 1 < argc))
+		{
+			bakeSettings.atlasSize = atoi(argv[++i]);
+		}
+		if ((strcmp(argv[i], "--occlusion-rays") == 0) && (i + 1 < argc))
+		{
+			bakeSettings.occlusionRays = std::max(atoi(argv[++i]), 0);
+		}
+
+		// draw the shadows of the lights from cube maps of <size>
+		// texels per face, which are kept until their light or an
+		// object near it moves unless the cache is turned off, or
+		// measure the shadow pass with and without the cache
+		if (strcmp(argv[i], "--shadows") == 0)
+		{
+			bShadows = true;
+		}
+		if ((strcmp(argv[i], "--shadow-size") == 0) && (i + 1 < argc))
+		{
+			shadowMapSize = atoi(argv[++i]);
+		}
+		if (strcmp(argv[i], "--no-shadow-cache") == 0)
+		{
+			bShadowCache = false;
+		}
+		if (strcmp(argv[i], "--shadow-benchmark") == 0)
+		{
+			bShadowBenchmark = true;
+			bShadows = true;
+		}
+
+		// draw another scene description, text or compiled, or
+		// compile a text scene into the binary form that is mapped
+		// into memory when it is loaded
+		if ((strcmp(argv[i], "--scene") == 0) && (i + 1 < argc))
+		{
+			sceneFile = argv[++i];
+		}
+		if ((strcmp(argv[i], "--compile-scene") == 0) && (i + 2 < argc))
+		{
+			compileSceneInput = argv[++i];
+			compileSceneOutput = argv[++i];
+		}
+
+		// compile an OBJ or glTF mesh into the binary form that the
+		// scenes load with one read, and upload the imported meshes
+		// with packed normals and texture coordinates
+		if ((strcmp(argv[i], "--compile-mesh") == 0) && (i + 2 < argc))
+		{
+			compileMeshInput = argv[++i];
+			compileMeshOutput = argv[++i];
+		}
+		if (strcmp(argv[i], "--packed-meshes") == 0)
+		{
+			bPackedMeshes = true;
+		}
+
+		// load the scene textures and meshes as they are drawn, within
+		// budgets of GPU and CPU memory in megabytes, and free the
+		// ones that were not drawn for a number of frames
+		if (strcmp(argv[i], "--stream-assets") == 0)
+		{
+			bStreamAssets = true;
+		}
+		if ((strcmp(argv[i], "--gpu-budget") == 0) && (i + 1 < argc))
+		{
+			streamingBudget.gpuBytes = (size_t)std::max(atoi(argv[++i]), 1) * 1024 * 1024;
+		}
+		if ((strcmp(argv[i], "--cpu-budget") == 0) && (i + 1 < argc))
+		{
+			streamingBudget.cpuBytes = (size_t)std::max(atoi(argv[++i]), 1) * 1024 * 1024;
+		}
+		if ((strcmp(argv[i], "--evict-frames") == 0) && (i + 1 < argc))
+		{
+			streamingBudget.evictFrames = std::max(atoi(argv[++i]), 1);
+		}
+	}
+
+	if (NULL != phongKernelName)
+	{
+		PhongKernel::INSTRUCTION_SET instructionSet;
+		if (!PhongKernel::FindInstructionSet(phongKernelName, instructionSet) ||
+			!PhongKernel::SetInstructionSet(instructionSet))
+		{
+			return(EXIT_FAILURE);
+		}
+	}
+
+	// the kernel benchmarks and the scene and mesh compilers need
+	// no window or scene
+	if (bPhongBenchmark)
+	{
+		return(PhongKernel::RunBenchmark() ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	if (bTransformBenchmark)
+	{
+		return(TransformBatch::RunBenchmark() ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	if (NULL != compileSceneInput)
+	{
+		SceneFile scene;
+		return((scene.Load(compileSceneInput) && scene.SaveCompiled(compileSceneOutput)) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	if (NULL != compileMeshInput)
+	{
+		MeshImporter::IMPORTED_MESH mesh;
+		return((MeshImporter::Load(compileMeshInput, mesh) && MeshImporter::SaveCompiled(compileMeshOutput, mesh)) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	if (NULL != traceFile)
+	{
+		TraceRecorder::Start(traceFile, traceFrames);
+		TraceRecorder::SetThreadName("Main");
+	}
+
+	// the software renderer and the lightmap baker work without
+	// OpenGL, so the modes that measure the OpenGL frames are left out
+	bool bOpenGL = !bSoftware && (NULL == bakeLightmapsName);
+	if (!bOpenGL && (bBenchmark || bJobScaling || bShadowBenchmark || (pipelineDepth > 0)))
+	{
+		std::cout << "INFO: The benchmark, job scaling and pipelined modes are not used with --software or --bake-lightmaps" << std::endl;
+		bBenchmark = false;
+		bJobScaling = false;
+		bShadowBenchmark = false;
+		pipelineDepth = 0;
+	}
+	if (!bOpenGL && bStreamAssets)
+	{
+		std::cout << "INFO: The scene assets are only streamed with OpenGL" << std::endl;
+		bStreamAssets = false;
+	}
+
+	if (bHeadless)
+	{
+		// there are no files to watch on a build host
+		bHotReload = false;
+
+		// create the OpenGL context without a display server, the
+		// software renderer and the lightmap baker need none
+		if (bOpenGL && (g_HeadlessContext.Create() == false))
+		{
+			return(EXIT_FAILURE);
+		}
+	}
 	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
+	else if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
+	if (bSerialShaders)
+	{
+		g_ShaderManager->SetParallelCompile(false);
+	}
+
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
 
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	if (!bHeadless)
+	{
+		// try to create the main display window
+		g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	}
 
 	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
+	if (bOpenGL && (InitializeGLEW(bHeadless) == false))
 	{
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
+	// the offscreen framebuffer needs the OpenGL functions from GLEW
+	RenderTarget* pOffscreenTarget = NULL;
+	if (bHeadless && bOpenGL)
+	{
+		pOffscreenTarget = g_ViewManager->CreateOffscreenTarget();
+		if (NULL == pOffscreenTarget)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
+
+	// when rendering on demand, the window frames are drawn into a
+	// framebuffer that keeps the last frame, and copied from there
+	// to the window - the offscreen framebuffer keeps it already
+	RenderTarget* pFrameCache = NULL;
+	if (bOnDemand && !bHeadless)
+	{
+		int width = 0;
+		int height = 0;
+		glfwGetFramebufferSize(g_Window, &width, &height);
+
+		pFrameCache = new RenderTarget();
+		if (pFrameCache->Create(width, height) == false)
+		{
+			std::cout << "Failed to create the frame cache" << std::endl;
+			return(EXIT_FAILURE);
+		}
+		glfwSetWindowRefreshCallback(g_Window, &Window_Refresh_Callback);
+		glfwSetFramebufferSizeCallback(g_Window, &Framebuffer_Size_Callback);
+	}
+
+	// submit the shader code from the external GLSL files - the
+	// driver can compile it while the scene textures and meshes
+	// are being loaded, PrepareScene() waits for it to finish
+	int shadowProgram = -1;
+	if (bOpenGL)
+	{
+		g_ShaderManager->QueueShaders(
+			"../../Utilities/shaders/vertexShader.glsl",
+			"../../Utilities/shaders/fragmentShader.glsl");
+		// the shadow maps are drawn with the same files, where the
+		// fragment shader writes the distance from the light
+		if (bShadows)
+		{
+			shadowProgram = g_ShaderManager->QueueShaders(
+				"../../Utilities/shaders/vertexShader.glsl",
+				"../../Utilities/shaders/fragmentShader.glsl",
+				ShadowMapper::DEPTH_PROGRAM_DEFINES);
+		}
+		g_ShaderManager->EnableHotReload(bHotReload);
+	}
+
+	// the textures are decoded on the workers while the meshes load
+	g_JobSystem.Initialize(jobWorkers);
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetJobSystem(&g_JobSystem);
+	// without OpenGL the textures are kept in memory for the
+	// software renderer instead of being uploaded
+	g_SceneManager->SetOpenGLEnabled(bOpenGL);
+	g_SceneManager->SetPackedMeshes(bPackedMeshes);
+	if (bStreamAssets)
+	{
+		g_SceneManager->EnableStreaming(streamingBudget);
+	}
+	if (g_SceneManager->LoadSceneFile(sceneFile) == false)
+	{
+		return(EXIT_FAILURE);
+	}
 	g_SceneManager->PrepareScene();
 
+	if (NULL != lightmapsName)
+	{
+		if (!bOpenGL)
+		{
+			std::cout << "INFO: The lightmaps are only drawn with OpenGL" << std::endl;
+		}
+		else if (g_SceneManager->LoadLightmaps(lightmapsName) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
+
+	if (bShadows)
+	{
+		if (!bOpenGL)
+		{
+			std::cout << "INFO: The shadows are only drawn with OpenGL" << std::endl;
+		}
+		else if (g_SceneManager->EnableShadows(shadowProgram, shadowMapSize) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		else
+		{
+			g_SceneManager->GetShadowMapper()->SetCacheEnabled(bShadowCache);
+		}
+	}
+
+	if (NULL != replayInputFile)
+	{
+		if (g_ViewManager->StartInputReplay(replayInputFile) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+
+		// a headless replay runs until the recorded input ends,
+		// unless a number of frames is passed
+		if (bHeadless && !bFrameCountSet)
+		{
+			headlessFrames = INT_MAX;
+		}
+	}
+	else if (NULL != recordInputFile)
+	{
+		g_ViewManager->StartInputRecording(recordInputFile);
+	}
+
+	// the profiler issues timer queries, so it needs the OpenGL context
+	FrameProfiler::SetEnabled(bProfile && bOpenGL);
+
+	// the swap interval is set on the context of the window
+	FramePacer framePacer;
+	framePacer.SetWindow(g_Window);
+	framePacer.SetVSync(bVSync);
+	framePacer.SetTargetFPS(targetFPS);
+	framePacer.SetAdaptive(bAdaptivePacing, idleFPS);
+
+	if (NULL != telemetryFile)
+	{
+		g_TelemetryLog = new TelemetryLog();
+		g_TelemetryLog->Open(telemetryFile);
+	}
+	unsigned int frameCount = 0;
+	unsigned int drawnFrames = 0;
+	int exitCode = EXIT_SUCCESS;
+	bool bFrameLoop = true;
+
+	// the time taken by each headless frame in milliseconds
+	std::vector<double> frameTimes;
+	if (bHeadless && (headlessFrames < INT_MAX))
+	{
+		frameTimes.reserve(headlessFrames);
+	}
+
+	// the job scaling measurement replaces the frame loop too
+	if (bJobScaling)
+	{
+		bFrameLoop = false;
+
+		BenchmarkRunner benchmark(g_ShaderManager, g_ViewManager, g_SceneManager, g_Window);
+		benchmark.RunJobScaling(std::max(g_JobSystem.GetWorkerCount(), (int)std::thread::hardware_concurrency()));
+	}
+
+	// the benchmark renders its own frames instead of the frame loop
+	if (bBenchmark)
+	{
+		bFrameLoop = false;
+
+		BenchmarkRunner benchmark(g_ShaderManager, g_ViewManager, g_SceneManager, g_Window);
+		benchmark.SetJobSystem(&g_JobSystem);
+		benchmark.SetFrameCount(benchmarkFrames);
+		bool bReady = true;
+		if (NULL != benchmarkScenes)
+		{
+			bReady = benchmark.SetScenes(benchmarkScenes);
+		}
+		if (bReady && (NULL != cameraPathFile))
+		{
+			bReady = benchmark.LoadCameraPath(cameraPathFile);
+		}
+
+		if (!bReady || !benchmark.Run())
+		{
+			exitCode = EXIT_FAILURE;
+		}
+		else
+		{
+			if (NULL != benchmarkFile)
+			{
+				benchmark.WriteResults(benchmarkFile);
+			}
+			if ((NULL != baselineFile) && !benchmark.CompareBaseline(baselineFile, benchmarkThreshold))
+			{
+				exitCode = EXIT_FAILURE;
+			}
+		}
+	}
+
+	// the shadow benchmark renders its own frames too
+	if (bShadowBenchmark)
+	{
+		bFrameLoop = false;
+
+		BenchmarkRunner benchmark(g_ShaderManager, g_ViewManager, g_SceneManager, g_Window);
+		benchmark.SetFrameCount(benchmarkFrames);
+		if (((NULL != cameraPathFile) && !benchmark.LoadCameraPath(cameraPathFile)) ||
+			!benchmark.RunShadowBenchmark())
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
+
+	// the lightmap baker ray traces the scene instead of the loop
+	if (NULL != bakeLightmapsName)
+	{
+		bFrameLoop = false;
+
+		LightmapBaker baker(g_SceneManager);
+		baker.SetJobSystem(&g_JobSystem);
+		if (!baker.Bake(bakeSettings, g_ShaderManager->GetFrameUniforms().GetConstants()) ||
+			!baker.Save(bakeLightmapsName))
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
+
+	// the software renderer draws the headless frames on the CPU
+	// instead of the loop
+	SoftwareRenderer* pSoftwareRenderer = NULL;
+	if (bSoftware)
+	{
+		bFrameLoop = false;
+
+		int width = 0;
+		int height = 0;
+		g_ViewManager->GetViewportSize(width, height);
+		pSoftwareRenderer = new SoftwareRenderer(g_SceneManager);
+		pSoftwareRenderer->SetJobSystem(&g_JobSystem);
+		if (pSoftwareRenderer->Create(width, height) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+
+		SceneManager::DRAW_LIST drawList;
+		while (!g_ViewManager->IsInputReplayFinished() && ((int)frameTimes.size() < headlessFrames))
+		{
+			std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+			TraceRecorder::BeginFrame();
+
+			// the camera goes into a copy of the frame constants, which
+			// already hold the lights of the scene
+			g_ViewManager->UpdateSceneView();
+			const ViewManager::VIEW_STATE& viewState = g_ViewManager->GetViewState();
+			FrameUniformBuffer::FRAME_CONSTANTS frame = g_ShaderManager->GetFrameUniforms().GetConstants();
+			frame.view = viewState.view;
+			frame.projection = viewState.projection;
+			frame.viewProjection = viewState.viewProjection;
+			frame.viewPosition = viewState.viewPosition;
+
+			g_SceneManager->SetViewProjection(viewState.viewProjection);
+			g_SceneManager->BuildDrawList(drawList);
+			pSoftwareRenderer->Render(drawList, frame);
+
+			TraceRecorder::EndFrame();
+
+			frameTimes.push_back(std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - frameStart).count());
+			frameCount++;
+		}
+
+		pSoftwareRenderer->PrintReport();
+	}
+
+	// the pipeline runs the frames on two threads instead of the loop
+	if (bFrameLoop && (pipelineDepth > 0))
+	{
+		bFrameLoop = false;
+
+		FramePipeline pipeline(g_ShaderManager, g_ViewManager, g_SceneManager, g_Window,
+			bHeadless ? &g_HeadlessContext : NULL);
+		pipeline.SetDepth(pipelineDepth);
+		pipeline.SetTelemetryLog(g_TelemetryLog);
+		pipeline.SetFramePacer(&framePacer);
+		pipeline.Run(headlessFrames, frameTimes);
+	}
+
+	// the scene version of the frame that was drawn last, the
+	// first frame is always drawn
+	unsigned int drawnSceneVersion = g_SceneManager->GetSceneVersion() - 1;
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
+	while (bFrameLoop && !g_ViewManager->IsInputReplayFinished() && (bHeadless ? ((int)frameTimes.size() < headlessFrames) : !glfwWindowShouldClose(g_Window)))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		FrameProfiler::BeginFrame();
+		TraceRecorder::BeginFrame();
 
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// swap in any shader programs rebuilt after a GLSL file changed
+		bool bShadersReloaded = g_ShaderManager->ProcessHotReload();
 
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+		// the kept frame follows the size of the window, and is
+		// drawn again at the new size - a minimized window has no
+		// size, so the frame is kept until it is shown again
+		bool bFrameCacheResized = false;
+		if ((NULL != pFrameCache) && g_bFramebufferResized)
+		{
+			int width = 0;
+			int height = 0;
+			glfwGetFramebufferSize(g_Window, &width, &height);
+			if ((width > 0) && (height > 0))
+			{
+				if (pFrameCache->Create(width, height) == false)
+				{
+					std::cout << "Failed to resize the frame cache" << std::endl;
+					break;
+				}
+				bFrameCacheResized = true;
+			}
+			g_bFramebufferResized = false;
+		}
+
+		// the frame is drawn again only when something in it changed,
+		// or streamed assets wait for the end of a frame to upload
+		bool bDrawFrame = !bOnDemand || bShadersReloaded || bFrameCacheResized ||
+			g_ViewManager->HasViewChanged() || g_SceneManager->HasPendingAssets() ||
+			(g_SceneManager->GetSceneVersion() != drawnSceneVersion);
+
+		if (bDrawFrame)
+		{
+			if (NULL != pFrameCache)
+			{
+				pFrameCache->Bind();
+			}
+
+			// Enable z-depth
+			glEnable(GL_DEPTH_TEST);
+
+			// Clear the frame and z buffers
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// refresh the 3D scene
+			g_ShaderManager->ResetUniformStatistics();
+			g_SceneManager->SetViewProjection(g_ViewManager->GetViewProjection());
+			g_SceneManager->RenderScene();
+
+			// fence the frame constants copy used by this frame's draws
+			g_ShaderManager->GetFrameUniforms().EndFrame();
+
+			drawnSceneVersion = g_SceneManager->GetSceneVersion();
+			drawnFrames++;
+		}
+
+		if (bHeadless)
+		{
+			// there is no buffer swap to pace the frames, so wait for the
+			// GPU to finish to measure the full cost of the frame
+			if (bDrawFrame)
+			{
+				PROFILE_SCOPE("glFinish");
+				glFinish();
+			}
+		}
+		else
+		{
+			// copy the kept frame to the window when it was drawn, or
+			// when the window lost its contents
+			if ((NULL != pFrameCache) && (bDrawFrame || g_bWindowDamaged))
+			{
+				PROFILE_SCOPE("BlitFrameCache");
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, pFrameCache->GetFramebuffer());
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+				glBlitFramebuffer(
+					0, 0, pFrameCache->GetWidth(), pFrameCache->GetHeight(),
+					0, 0, pFrameCache->GetWidth(), pFrameCache->GetHeight(),
+					GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			}
 
+			// Flips the the back buffer with the front buffer every frame.
+			if (bDrawFrame || g_bWindowDamaged)
+			{
+				PROFILE_SCOPE("glfwSwapBuffers");
+				glfwSwapBuffers(g_Window);
+			}
+			g_bWindowDamaged = false;
 
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+			if (bDrawFrame || (NULL != replayInputFile))
+			{
+				// query the latest GLFW events
+				glfwPollEvents();
+			}
+			else
+			{
+				// nothing changed, so sleep until there is input, the
+				// replayed input is read without waiting
+				{
+					TRACE_SCOPE("WaitEvents");
+					glfwWaitEventsTimeout(ON_DEMAND_WAIT_SECONDS);
+				}
+				g_ViewManager->RestartFrameTime();
+			}
+		}
 
-		// query the latest GLFW events
-		glfwPollEvents();
+		FrameProfiler::EndFrame();
+		TraceRecorder::EndFrame();
+
+		double frameMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - frameStart).count();
+		if (bHeadless)
+		{
+			frameTimes.push_back(frameMs);
+		}
+
+		// the sample is only copied here, the log is written by
+		// the telemetry thread
+		if (NULL != g_TelemetryLog)
+		{
+			TelemetryLog::TELEMETRY_SAMPLE sample;
+			sample.timestampMs = g_TelemetryLog->GetElapsedMs();
+			sample.frame = frameCount;
+			sample.frameMs = (float)frameMs;
+			sample.drawCalls = bDrawFrame ? g_SceneManager->GetDrawStatistics().drawCalls : 0;
+			sample.triangles = bDrawFrame ? g_SceneManager->GetDrawStatistics().triangles : 0;
+			sample.uniformUploads = bDrawFrame ? g_ShaderManager->GetUniformUploads() : 0;
+			sample.uniformSkips = bDrawFrame ? g_ShaderManager->GetUniformSkips() : 0;
+			sample.lightRadius = g_SceneManager->GetLightRadius();
+			sample.lightHeight = g_SceneManager->GetLightHeight();
+			g_TelemetryLog->Push(sample);
+		}
+		frameCount++;
+
+		// wait for the next frame, outside of the measured frame time,
+		// a frame that was not drawn has waited for events already
+		if (bDrawFrame)
+		{
+			framePacer.EndFrame(g_ViewManager->HasViewChanged());
+		}
+	}
+
+	if (bOnDemand && bFrameLoop)
+	{
+		std::cout << "INFO: Render on demand: " << drawnFrames << " of " << frameCount << " frames drawn" << std::endl;
+	}
+
+	if (bHeadless)
+	{
+		WriteFrameTimes(frameTimes, frameTimesFile);
+		if ((NULL != screenshotFile) && (NULL != pSoftwareRenderer))
+		{
+			pSoftwareRenderer->SavePNG(screenshotFile);
+		}
+		else if ((NULL != screenshotFile) && (NULL != pOffscreenTarget))
+		{
+			pOffscreenTarget->SavePNG(screenshotFile);
+		}
+	}
+
+	if (bProfile)
+	{
+		FrameProfiler::PrintReport();
+		if (NULL != profileFile)
+		{
+			FrameProfiler::WriteReport(profileFile);
+		}
+	}
+	FrameProfiler::Shutdown();
+	if (framePacer.IsPacing())
+	{
+		framePacer.PrintReport();
+	}
+	if ((NULL != g_SceneManager) && (NULL != g_SceneManager->GetAssetManager()))
+	{
+		g_SceneManager->GetAssetManager()->PrintReport();
+	}
+	if (NULL != traceFile)
+	{
+		TraceRecorder::Write();
+	}
+
+	// stop the worker threads before the objects they work on
+	g_JobSystem.Shutdown();
+
+	if (NULL != pFrameCache)
+	{
+		delete pFrameCache;
+		pFrameCache = NULL;
+	}
+	if (NULL != pSoftwareRenderer)
+	{
+		delete pSoftwareRenderer;
+		pSoftwareRenderer = NULL;
 	}
 
 	// clear the allocated manager objects from memory
+	if (NULL != g_TelemetryLog)
+	{
+		delete g_TelemetryLog;
+		g_TelemetryLog = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -117,9 +1043,11 @@ int main(int argc, char* argv[])
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
+	g_HeadlessContext.Destroy();
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// Terminates the program, a failed benchmark is reported
+	// through the exit code
+	exit(exitCode); 
 }
 
 /***********************************************************
@@ -154,14 +1082,28 @@ bool InitializeGLFW()
  *
  *  This function is used to initialize the GLEW library.
  ***********************************************************/
-bool InitializeGLEW()
+bool InitializeGLEW(bool bHeadless)
 {
+	TRACE_SCOPE("InitializeGLEW");
+
 	// GLEW: initialize
 	// -----------------------------------------
 	GLenum GLEWInitResult = GLEW_OK;
 
+	// core profile entry points are not listed in the extension
+	// string, so GLEW has to load them without checking it
+	glewExperimental = GL_TRUE;
+
 	// try to initialize the GLEW library
 	GLEWInitResult = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// a GLX build of GLEW has already loaded the OpenGL functions when
+	// it finds out that an EGL context has no X display behind it
+	if (bHeadless && (GLEW_ERROR_NO_GLX_DISPLAY == GLEWInitResult))
+	{
+		GLEWInitResult = GLEW_OK;
+	}
+#endif
 	if (GLEW_OK != GLEWInitResult)
 	{
 		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
@@ -174,4 +1116,75 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *	WriteFrameTimes()
+ *
+ *  This function is used to print a summary of the headless
+ *  frame times, and to write every frame time to a CSV file
+ *  when a file name is passed.
+ ***********************************************************/
+void WriteFrameTimes(std::vector<double> frameTimes, const char* filename)
+{
+	if (frameTimes.empty())
+	{
+		return;
+	}
+
+	if (NULL != filename)
+	{
+		std::ofstream file(filename, std::ios::out | std::ios::trunc);
+		if (file.is_open())
+		{
+			file << "frame,ms\n";
+			for (size_t i = 0; i < frameTimes.size(); i++)
+			{
+				file << i << "," << frameTimes[i] << "\n";
+			}
+			file.close();
+		}
+		else
+		{
+			std::cout << "Could not write frame times:" << filename << std::endl;
+		}
+	}
+
+	// the first frames include the driver warm up, so the
+	// percentiles tell more about a regression than the mean
+	double total = 0.0;
+	for (size_t i = 0; i < frameTimes.size(); i++)
+	{
+		total += frameTimes[i];
+	}
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	std::cout << "INFO: Headless frames: " << frameTimes.size()
+		<< ", mean: " << total / frameTimes.size() << " ms"
+		<< ", median: " << frameTimes[frameTimes.size() / 2] << " ms"
+		<< ", p95: " << frameTimes[(frameTimes.size() * 95) / 100] << " ms"
+		<< ", max: " << frameTimes.back() << " ms" << std::endl;
+}
+
+/***********************************************************
+ *	Window_Refresh_Callback()
+ *
+ *  This function is called when the contents of the window
+ *  were lost, so that the kept frame is shown again.
+ ***********************************************************/
+void Window_Refresh_Callback(GLFWwindow*)
+{
+	g_bWindowDamaged = true;
+}
+
+/***********************************************************
+ *	Framebuffer_Size_Callback()
+ *
+ *  This function is called when the size of the window
+ *  framebuffer changed, so that the kept frame is made
+ *  again at the new size.
+ ***********************************************************/
+void Framebuffer_Size_Callback(GLFWwindow*, int, int)
+{
+	g_bFramebufferResized = true;
+}
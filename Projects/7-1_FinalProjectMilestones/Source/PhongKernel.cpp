@@ -0,0 +1,897 @@
+///////////////////////////////////////////////////////////////////////////////
+// phongkernel.cpp
+// ============
+// shade batches of pixels with the Phong lighting of the fragment shader,
+// using the widest SIMD instructions the processor supports
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PhongKernel.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// the x86 kernels are all built, and picked at runtime - the AVX2 and
+// AVX-512 functions are marked for their instruction set, so the rest
+// of the program does not need the compiler flags for them
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define PHONG_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PHONG_KERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(PHONG_KERNEL_X86) && !defined(_MSC_VER)
+#define PHONG_TARGET_SSE2 __attribute__((target("sse2")))
+#define PHONG_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define PHONG_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define PHONG_TARGET_SSE2
+#define PHONG_TARGET_AVX2
+#define PHONG_TARGET_AVX512
+#endif
+
+// declaration of global variables
+namespace
+{
+	// log2(1 + t) for t in [0, 1), a least squares fit of degree
+	// five that is off by less than 2e-5
+	const float LOG2_C1 = 1.44187987f;
+	const float LOG2_C2 = -0.70886457f;
+	const float LOG2_C3 = 0.41524327f;
+	const float LOG2_C4 = -0.19351345f;
+	const float LOG2_C5 = 0.04526690f;
+	// 2^f for f in [0, 1), a fit of degree four that is off by
+	// less than 4e-6 of the result
+	const float EXP2_C0 = 1.00000358f;
+	const float EXP2_C1 = 0.69296956f;
+	const float EXP2_C2 = 0.24162124f;
+	const float EXP2_C3 = 0.05171778f;
+	const float EXP2_C4 = 0.01368399f;
+
+	// pixels shaded by every kernel in the benchmark, few enough
+	// to stay in the cache so the arithmetic is measured
+	const int g_BenchmarkBatches = 16;
+	// time each kernel of the benchmark runs for
+	const double g_BenchmarkSeconds = 0.25;
+	// largest difference to the reference, relative to the color
+	// or to 1 for the darker colors
+	const float g_ErrorTolerance = 1e-3f;
+
+	typedef void (*SHADE_FUNCTION)(const PhongKernel::PHONG_CONSTANTS&, PhongKernel::SHADE_BATCH&);
+
+	const char* const g_InstructionSetNames[PhongKernel::INSTRUCTION_SET_COUNT] = {
+		"scalar", "sse2", "neon", "avx2", "avx512" };
+
+#ifdef PHONG_KERNEL_X86
+	/***********************************************************
+	 *  SSE2 kernel, 4 pixels at a time
+	 ***********************************************************/
+	PHONG_TARGET_SSE2 inline __m128 ReciprocalSqrtSSE2(__m128 x)
+	{
+		// one Newton-Raphson step on the 12 bit estimate
+		__m128 estimate = _mm_rsqrt_ps(x);
+		__m128 halfX = _mm_mul_ps(_mm_set1_ps(0.5f), x);
+		return _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(halfX, _mm_mul_ps(estimate, estimate))));
+	}
+
+	PHONG_TARGET_SSE2 inline __m128 FastPowSSE2(__m128 x, __m128 exponent)
+	{
+		// x = 2^e * (1 + t), read from the bits of the float
+		__m128i bits = _mm_castps_si128(x);
+		__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+		__m128 t = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(
+			_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000))), _mm_set1_ps(1.0f));
+		__m128 p = _mm_set1_ps(LOG2_C5);
+		p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(LOG2_C4));
+		p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(LOG2_C3));
+		p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(LOG2_C2));
+		p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(LOG2_C1));
+		__m128 y = _mm_mul_ps(exponent, _mm_add_ps(e, _mm_mul_ps(p, t)));
+		y = _mm_max_ps(_mm_min_ps(y, _mm_set1_ps(127.0f)), _mm_set1_ps(-126.0f));
+
+		// 2^y = 2^i * 2^f, the truncation is moved down to the floor
+		__m128i i = _mm_cvttps_epi32(y);
+		i = _mm_add_epi32(i, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(i), y)));
+		__m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(i));
+		p = _mm_set1_ps(EXP2_C4);
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_C3));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_C2));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_C1));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_C0));
+		__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23));
+
+		// pow(0, exponent) is 0
+		return _mm_and_ps(_mm_mul_ps(p, scale), _mm_cmpgt_ps(x, _mm_setzero_ps()));
+	}
+
+	PHONG_TARGET_SSE2 void ShadeSSE2(const PhongKernel::PHONG_CONSTANTS& constants, PhongKernel::SHADE_BATCH& batch)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 viewX = _mm_set1_ps(constants.viewPosition.x);
+		const __m128 viewY = _mm_set1_ps(constants.viewPosition.y);
+		const __m128 viewZ = _mm_set1_ps(constants.viewPosition.z);
+
+		for (int i = 0; i < batch.count; i += 4)
+		{
+			__m128 px = _mm_loadu_ps(&batch.positionX[i]);
+			__m128 py = _mm_loadu_ps(&batch.positionY[i]);
+			__m128 pz = _mm_loadu_ps(&batch.positionZ[i]);
+
+			__m128 nx = _mm_loadu_ps(&batch.normalX[i]);
+			__m128 ny = _mm_loadu_ps(&batch.normalY[i]);
+			__m128 nz = _mm_loadu_ps(&batch.normalZ[i]);
+			__m128 scale = ReciprocalSqrtSSE2(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+			nx = _mm_mul_ps(nx, scale);
+			ny = _mm_mul_ps(ny, scale);
+			nz = _mm_mul_ps(nz, scale);
+
+			__m128 vx = _mm_sub_ps(viewX, px);
+			__m128 vy = _mm_sub_ps(viewY, py);
+			__m128 vz = _mm_sub_ps(viewZ, pz);
+			scale = ReciprocalSqrtSSE2(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+			vx = _mm_mul_ps(vx, scale);
+			vy = _mm_mul_ps(vy, scale);
+			vz = _mm_mul_ps(vz, scale);
+
+			__m128 diffuse = zero;
+			__m128 specular = zero;
+			for (int light = 0; light < constants.lightCount; light++)
+			{
+				__m128 lx = _mm_sub_ps(_mm_set1_ps(constants.lightX[light]), px);
+				__m128 ly = _mm_sub_ps(_mm_set1_ps(constants.lightY[light]), py);
+				__m128 lz = _mm_sub_ps(_mm_set1_ps(constants.lightZ[light]), pz);
+				scale = ReciprocalSqrtSSE2(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz)));
+				lx = _mm_mul_ps(lx, scale);
+				ly = _mm_mul_ps(ly, scale);
+				lz = _mm_mul_ps(lz, scale);
+
+				__m128 impact = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, lx), _mm_mul_ps(ny, ly)), _mm_mul_ps(nz, lz));
+				diffuse = _mm_add_ps(diffuse, _mm_max_ps(impact, zero));
+
+				if (constants.specularScale[light] != 0.0f)
+				{
+					// reflect(-l, n) = 2 * dot(n, l) * n - l
+					__m128 twice = _mm_add_ps(impact, impact);
+					__m128 rx = _mm_sub_ps(_mm_mul_ps(twice, nx), lx);
+					__m128 ry = _mm_sub_ps(_mm_mul_ps(twice, ny), ly);
+					__m128 rz = _mm_sub_ps(_mm_mul_ps(twice, nz), lz);
+					__m128 alignment = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, rx), _mm_mul_ps(vy, ry)), _mm_mul_ps(vz, rz));
+					__m128 highlight = FastPowSSE2(_mm_max_ps(alignment, zero), _mm_set1_ps(constants.focalStrength[light]));
+					specular = _mm_add_ps(specular, _mm_mul_ps(_mm_set1_ps(constants.specularScale[light]), highlight));
+				}
+			}
+
+			_mm_storeu_ps(&batch.red[i], _mm_add_ps(_mm_set1_ps(constants.ambient.r), _mm_add_ps(
+				_mm_mul_ps(diffuse, _mm_set1_ps(constants.diffuseColor.r)), _mm_mul_ps(specular, _mm_set1_ps(constants.specularColor.r)))));
+			_mm_storeu_ps(&batch.green[i], _mm_add_ps(_mm_set1_ps(constants.ambient.g), _mm_add_ps(
+				_mm_mul_ps(diffuse, _mm_set1_ps(constants.diffuseColor.g)), _mm_mul_ps(specular, _mm_set1_ps(constants.specularColor.g)))));
+			_mm_storeu_ps(&batch.blue[i], _mm_add_ps(_mm_set1_ps(constants.ambient.b), _mm_add_ps(
+				_mm_mul_ps(diffuse, _mm_set1_ps(constants.diffuseColor.b)), _mm_mul_ps(specular, _mm_set1_ps(constants.specularColor.b)))));
+		}
+	}
+
+	/***********************************************************
+	 *  AVX2 kernel, 8 pixels at a time
+	 ***********************************************************/
+	PHONG_TARGET_AVX2 inline __m256 ReciprocalSqrtAVX2(__m256 x)
+	{
+		__m256 estimate = _mm256_rsqrt_ps(x);
+		__m256 halfX = _mm256_mul_ps(_mm256_set1_ps(0.5f), x);
+		return _mm256_mul_ps(estimate, _mm256_fnmadd_ps(halfX, _mm256_mul_ps(estimate, estimate), _mm256_set1_ps(1.5f)));
+	}
+
+	PHONG_TARGET_AVX2 inline __m256 FastPowAVX2(__m256 x, __m256 exponent)
+	{
+		__m256i bits = _mm256_castps_si256(x);
+		__m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+		__m256 t = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_or_si256(
+			_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000))), _mm256_set1_ps(1.0f));
+		__m256 p = _mm256_set1_ps(LOG2_C5);
+		p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(LOG2_C4));
+		p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(LOG2_C3));
+		p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(LOG2_C2));
+		p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(LOG2_C1));
+		__m256 y = _mm256_mul_ps(exponent, _mm256_fmadd_ps(p, t, e));
+		y = _mm256_max_ps(_mm256_min_ps(y, _mm256_set1_ps(127.0f)), _mm256_set1_ps(-126.0f));
+
+		__m256 floor = _mm256_floor_ps(y);
+		__m256 f = _mm256_sub_ps(y, floor);
+		p = _mm256_set1_ps(EXP2_C4);
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(EXP2_C3));
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(EXP2_C2));
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(EXP2_C1));
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(EXP2_C0));
+		__m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(floor), _mm256_set1_epi32(127)), 23));
+
+		return _mm256_and_ps(_mm256_mul_ps(p, scale), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ));
+	}
+
+	PHONG_TARGET_AVX2 void ShadeAVX2(const PhongKernel::PHONG_CONSTANTS& constants, PhongKernel::SHADE_BATCH& batch)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 viewX = _mm256_set1_ps(constants.viewPosition.x);
+		const __m256 viewY = _mm256_set1_ps(constants.viewPosition.y);
+		const __m256 viewZ = _mm256_set1_ps(constants.viewPosition.z);
+
+		for (int i = 0; i < batch.count; i += 8)
+		{
+			__m256 px = _mm256_loadu_ps(&batch.positionX[i]);
+			__m256 py = _mm256_loadu_ps(&batch.positionY[i]);
+			__m256 pz = _mm256_loadu_ps(&batch.positionZ[i]);
+
+			__m256 nx = _mm256_loadu_ps(&batch.normalX[i]);
+			__m256 ny = _mm256_loadu_ps(&batch.normalY[i]);
+			__m256 nz = _mm256_loadu_ps(&batch.normalZ[i]);
+			__m256 scale = ReciprocalSqrtAVX2(_mm256_fmadd_ps(nx, nx, _mm256_fmadd_ps(ny, ny, _mm256_mul_ps(nz, nz))));
+			nx = _mm256_mul_ps(nx, scale);
+			ny = _mm256_mul_ps(ny, scale);
+			nz = _mm256_mul_ps(nz, scale);
+
+			__m256 vx = _mm256_sub_ps(viewX, px);
+			__m256 vy = _mm256_sub_ps(viewY, py);
+			__m256 vz = _mm256_sub_ps(viewZ, pz);
+			scale = ReciprocalSqrtAVX2(_mm256_fmadd_ps(vx, vx, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vz, vz))));
+			vx = _mm256_mul_ps(vx, scale);
+			vy = _mm256_mul_ps(vy, scale);
+			vz = _mm256_mul_ps(vz, scale);
+
+			__m256 diffuse = zero;
+			__m256 specular = zero;
+			for (int light = 0; light < constants.lightCount; light++)
+			{
+				__m256 lx = _mm256_sub_ps(_mm256_set1_ps(constants.lightX[light]), px);
+				__m256 ly = _mm256_sub_ps(_mm256_set1_ps(constants.lightY[light]), py);
+				__m256 lz = _mm256_sub_ps(_mm256_set1_ps(constants.lightZ[light]), pz);
+				scale = ReciprocalSqrtAVX2(_mm256_fmadd_ps(lx, lx, _mm256_fmadd_ps(ly, ly, _mm256_mul_ps(lz, lz))));
+				lx = _mm256_mul_ps(lx, scale);
+				ly = _mm256_mul_ps(ly, scale);
+				lz = _mm256_mul_ps(lz, scale);
+
+				__m256 impact = _mm256_fmadd_ps(nx, lx, _mm256_fmadd_ps(ny, ly, _mm256_mul_ps(nz, lz)));
+				diffuse = _mm256_add_ps(diffuse, _mm256_max_ps(impact, zero));
+
+				if (constants.specularScale[light] != 0.0f)
+				{
+					__m256 twice = _mm256_add_ps(impact, impact);
+					__m256 rx = _mm256_fmsub_ps(twice, nx, lx);
+					__m256 ry = _mm256_fmsub_ps(twice, ny, ly);
+					__m256 rz = _mm256_fmsub_ps(twice, nz, lz);
+					__m256 alignment = _mm256_fmadd_ps(vx, rx, _mm256_fmadd_ps(vy, ry, _mm256_mul_ps(vz, rz)));
+					__m256 highlight = FastPowAVX2(_mm256_max_ps(alignment, zero), _mm256_set1_ps(constants.focalStrength[light]));
+					specular = _mm256_fmadd_ps(_mm256_set1_ps(constants.specularScale[light]), highlight, specular);
+				}
+			}
+
+			_mm256_storeu_ps(&batch.red[i], _mm256_fmadd_ps(diffuse, _mm256_set1_ps(constants.diffuseColor.r),
+				_mm256_fmadd_ps(specular, _mm256_set1_ps(constants.specularColor.r), _mm256_set1_ps(constants.ambient.r))));
+			_mm256_storeu_ps(&batch.green[i], _mm256_fmadd_ps(diffuse, _mm256_set1_ps(constants.diffuseColor.g),
+				_mm256_fmadd_ps(specular, _mm256_set1_ps(constants.specularColor.g), _mm256_set1_ps(constants.ambient.g))));
+			_mm256_storeu_ps(&batch.blue[i], _mm256_fmadd_ps(diffuse, _mm256_set1_ps(constants.diffuseColor.b),
+				_mm256_fmadd_ps(specular, _mm256_set1_ps(constants.specularColor.b), _mm256_set1_ps(constants.ambient.b))));
+		}
+	}
+
+	/***********************************************************
+	 *  AVX-512 kernel, 16 pixels at a time
+	 ***********************************************************/
+	PHONG_TARGET_AVX512 inline __m512 ReciprocalSqrtAVX512(__m512 x)
+	{
+		// the 14 bit estimate needs one step as well
+		__m512 estimate = _mm512_rsqrt14_ps(x);
+		__m512 halfX = _mm512_mul_ps(_mm512_set1_ps(0.5f), x);
+		return _mm512_mul_ps(estimate, _mm512_fnmadd_ps(halfX, _mm512_mul_ps(estimate, estimate), _mm512_set1_ps(1.5f)));
+	}
+
+	PHONG_TARGET_AVX512 inline __m512 FastPowAVX512(__m512 x, __m512 exponent)
+	{
+		__m512i bits = _mm512_castps_si512(x);
+		__m512 e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(127)));
+		__m512 t = _mm512_sub_ps(_mm512_castsi512_ps(_mm512_or_si512(
+			_mm512_and_si512(bits, _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3F800000))), _mm512_set1_ps(1.0f));
+		__m512 p = _mm512_set1_ps(LOG2_C5);
+		p = _mm512_fmadd_ps(p, t, _mm512_set1_ps(LOG2_C4));
+		p = _mm512_fmadd_ps(p, t, _mm512_set1_ps(LOG2_C3));
+		p = _mm512_fmadd_ps(p, t, _mm512_set1_ps(LOG2_C2));
+		p = _mm512_fmadd_ps(p, t, _mm512_set1_ps(LOG2_C1));
+		__m512 y = _mm512_mul_ps(exponent, _mm512_fmadd_ps(p, t, e));
+		y = _mm512_max_ps(_mm512_min_ps(y, _mm512_set1_ps(127.0f)), _mm512_set1_ps(-126.0f));
+
+		__m512 floor = _mm512_roundscale_ps(y, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+		__m512 f = _mm512_sub_ps(y, floor);
+		p = _mm512_set1_ps(EXP2_C4);
+		p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(EXP2_C3));
+		p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(EXP2_C2));
+		p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(EXP2_C1));
+		p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(EXP2_C0));
+		__m512 scale = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(floor), _mm512_set1_epi32(127)), 23));
+
+		return _mm512_maskz_mul_ps(_mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ), p, scale);
+	}
+
+	PHONG_TARGET_AVX512 void ShadeAVX512(const PhongKernel::PHONG_CONSTANTS& constants, PhongKernel::SHADE_BATCH& batch)
+	{
+		const __m512 zero = _mm512_setzero_ps();
+		const __m512 viewX = _mm512_set1_ps(constants.viewPosition.x);
+		const __m512 viewY = _mm512_set1_ps(constants.viewPosition.y);
+		const __m512 viewZ = _mm512_set1_ps(constants.viewPosition.z);
+
+		for (int i = 0; i < batch.count; i += 16)
+		{
+			__m512 px = _mm512_loadu_ps(&batch.positionX[i]);
+			__m512 py = _mm512_loadu_ps(&batch.positionY[i]);
+			__m512 pz = _mm512_loadu_ps(&batch.positionZ[i]);
+
+			__m512 nx = _mm512_loadu_ps(&batch.normalX[i]);
+			__m512 ny = _mm512_loadu_ps(&batch.normalY[i]);
+			__m512 nz = _mm512_loadu_ps(&batch.normalZ[i]);
+			__m512 scale = ReciprocalSqrtAVX512(_mm512_fmadd_ps(nx, nx, _mm512_fmadd_ps(ny, ny, _mm512_mul_ps(nz, nz))));
+			nx = _mm512_mul_ps(nx, scale);
+			ny = _mm512_mul_ps(ny, scale);
+			nz = _mm512_mul_ps(nz, scale);
+
+			__m512 vx = _mm512_sub_ps(viewX, px);
+			__m512 vy = _mm512_sub_ps(viewY, py);
+			__m512 vz = _mm512_sub_ps(viewZ, pz);
+			scale = ReciprocalSqrtAVX512(_mm512_fmadd_ps(vx, vx, _mm512_fmadd_ps(vy, vy, _mm512_mul_ps(vz, vz))));
+			vx = _mm512_mul_ps(vx, scale);
+			vy = _mm512_mul_ps(vy, scale);
+			vz = _mm512_mul_ps(vz, scale);
+
+			__m512 diffuse = zero;
+			__m512 specular = zero;
+			for (int light = 0; light < constants.lightCount; light++)
+			{
+				__m512 lx = _mm512_sub_ps(_mm512_set1_ps(constants.lightX[light]), px);
+				__m512 ly = _mm512_sub_ps(_mm512_set1_ps(constants.lightY[light]), py);
+				__m512 lz = _mm512_sub_ps(_mm512_set1_ps(constants.lightZ[light]), pz);
+				scale = ReciprocalSqrtAVX512(_mm512_fmadd_ps(lx, lx, _mm512_fmadd_ps(ly, ly, _mm512_mul_ps(lz, lz))));
+				lx = _mm512_mul_ps(lx, scale);
+				ly = _mm512_mul_ps(ly, scale);
+				lz = _mm512_mul_ps(lz, scale);
+
+				__m512 impact = _mm512_fmadd_ps(nx, lx, _mm512_fmadd_ps(ny, ly, _mm512_mul_ps(nz, lz)));
+				diffuse = _mm512_add_ps(diffuse, _mm512_max_ps(impact, zero));
+
+				if (constants.specularScale[light] != 0.0f)
+				{
+					__m512 twice = _mm512_add_ps(impact, impact);
+					__m512 rx = _mm512_fmsub_ps(twice, nx, lx);
+					__m512 ry = _mm512_fmsub_ps(twice, ny, ly);
+					__m512 rz = _mm512_fmsub_ps(twice, nz, lz);
+					__m512 alignment = _mm512_fmadd_ps(vx, rx, _mm512_fmadd_ps(vy, ry, _mm512_mul_ps(vz, rz)));
+					__m512 highlight = FastPowAVX512(_mm512_max_ps(alignment, zero), _mm512_set1_ps(constants.focalStrength[light]));
+					specular = _mm512_fmadd_ps(_mm512_set1_ps(constants.specularScale[light]), highlight, specular);
+				}
+			}
+
+			_mm512_storeu_ps(&batch.red[i], _mm512_fmadd_ps(diffuse, _mm512_set1_ps(constants.diffuseColor.r),
+				_mm512_fmadd_ps(specular, _mm512_set1_ps(constants.specularColor.r), _mm512_set1_ps(constants.ambient.r))));
+			_mm512_storeu_ps(&batch.green[i], _mm512_fmadd_ps(diffuse, _mm512_set1_ps(constants.diffuseColor.g),
+				_mm512_fmadd_ps(specular, _mm512_set1_ps(constants.specularColor.g), _mm512_set1_ps(constants.ambient.g))));
+			_mm512_storeu_ps(&batch.blue[i], _mm512_fmadd_ps(diffuse, _mm512_set1_ps(constants.diffuseColor.b),
+				_mm512_fmadd_ps(specular, _mm512_set1_ps(constants.specularColor.b), _mm512_set1_ps(constants.ambient.b))));
+		}
+	}
+
+	// read a leaf of the processor information
+	void ReadCpuId(int leaf, int subleaf, int registers[4])
+	{
+#ifdef _MSC_VER
+		__cpuidex(registers, leaf, subleaf);
+#else
+		unsigned int eax = 0;
+		unsigned int ebx = 0;
+		unsigned int ecx = 0;
+		unsigned int edx = 0;
+		__cpuid_count(leaf, subleaf, eax, ebx, ecx, edx);
+		registers[0] = (int)eax;
+		registers[1] = (int)ebx;
+		registers[2] = (int)ecx;
+		registers[3] = (int)edx;
+#endif
+	}
+
+	// read the register states that the system saves on a
+	// thread switch, the wide registers are only usable then
+	unsigned long long ReadEnabledStates()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int eax = 0;
+		unsigned int edx = 0;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return ((unsigned long long)edx << 32) | eax;
+#endif
+	}
+#endif
+
+#ifdef PHONG_KERNEL_NEON
+	/***********************************************************
+	 *  NEON kernel, 4 pixels at a time
+	 ***********************************************************/
+	inline float32x4_t ReciprocalSqrtNEON(float32x4_t x)
+	{
+		// the 8 bit estimate needs two steps
+		float32x4_t estimate = vrsqrteq_f32(x);
+		estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(x, estimate), estimate));
+		estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(x, estimate), estimate));
+		return estimate;
+	}
+
+	inline float32x4_t FastPowNEON(float32x4_t x, float32x4_t exponent)
+	{
+		uint32x4_t bits = vreinterpretq_u32_f32(x);
+		float32x4_t e = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+		float32x4_t t = vsubq_f32(vreinterpretq_f32_u32(vorrq_u32(
+			vandq_u32(bits, vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3F800000))), vdupq_n_f32(1.0f));
+		float32x4_t p = vdupq_n_f32(LOG2_C5);
+		p = vfmaq_f32(vdupq_n_f32(LOG2_C4), p, t);
+		p = vfmaq_f32(vdupq_n_f32(LOG2_C3), p, t);
+		p = vfmaq_f32(vdupq_n_f32(LOG2_C2), p, t);
+		p = vfmaq_f32(vdupq_n_f32(LOG2_C1), p, t);
+		float32x4_t y = vmulq_f32(exponent, vfmaq_f32(e, p, t));
+		y = vmaxq_f32(vminq_f32(y, vdupq_n_f32(127.0f)), vdupq_n_f32(-126.0f));
+
+		float32x4_t floor = vrndmq_f32(y);
+		float32x4_t f = vsubq_f32(y, floor);
+		p = vdupq_n_f32(EXP2_C4);
+		p = vfmaq_f32(vdupq_n_f32(EXP2_C3), p, f);
+		p = vfmaq_f32(vdupq_n_f32(EXP2_C2), p, f);
+		p = vfmaq_f32(vdupq_n_f32(EXP2_C1), p, f);
+		p = vfmaq_f32(vdupq_n_f32(EXP2_C0), p, f);
+		float32x4_t scale = vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(floor), vdupq_n_s32(127)), 23));
+
+		uint32x4_t positive = vcgtq_f32(x, vdupq_n_f32(0.0f));
+		return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(p, scale)), positive));
+	}
+
+	void ShadeNEON(const PhongKernel::PHONG_CONSTANTS& constants, PhongKernel::SHADE_BATCH& batch)
+	{
+		const float32x4_t zero = vdupq_n_f32(0.0f);
+		const float32x4_t viewX = vdupq_n_f32(constants.viewPosition.x);
+		const float32x4_t viewY = vdupq_n_f32(constants.viewPosition.y);
+		const float32x4_t viewZ = vdupq_n_f32(constants.viewPosition.z);
+
+		for (int i = 0; i < batch.count; i += 4)
+		{
+			float32x4_t px = vld1q_f32(&batch.positionX[i]);
+			float32x4_t py = vld1q_f32(&batch.positionY[i]);
+			float32x4_t pz = vld1q_f32(&batch.positionZ[i]);
+
+			float32x4_t nx = vld1q_f32(&batch.normalX[i]);
+			float32x4_t ny = vld1q_f32(&batch.normalY[i]);
+			float32x4_t nz = vld1q_f32(&batch.normalZ[i]);
+			float32x4_t scale = ReciprocalSqrtNEON(vfmaq_f32(vfmaq_f32(vmulq_f32(nz, nz), ny, ny), nx, nx));
+			nx = vmulq_f32(nx, scale);
+			ny = vmulq_f32(ny, scale);
+			nz = vmulq_f32(nz, scale);
+
+			float32x4_t vx = vsubq_f32(viewX, px);
+			float32x4_t vy = vsubq_f32(viewY, py);
+			float32x4_t vz = vsubq_f32(viewZ, pz);
+			scale = ReciprocalSqrtNEON(vfmaq_f32(vfmaq_f32(vmulq_f32(vz, vz), vy, vy), vx, vx));
+			vx = vmulq_f32(vx, scale);
+			vy = vmulq_f32(vy, scale);
+			vz = vmulq_f32(vz, scale);
+
+			float32x4_t diffuse = zero;
+			float32x4_t specular = zero;
+			for (int light = 0; light < constants.lightCount; light++)
+			{
+				float32x4_t lx = vsubq_f32(vdupq_n_f32(constants.lightX[light]), px);
+				float32x4_t ly = vsubq_f32(vdupq_n_f32(constants.lightY[light]), py);
+				float32x4_t lz = vsubq_f32(vdupq_n_f32(constants.lightZ[light]), pz);
+				scale = ReciprocalSqrtNEON(vfmaq_f32(vfmaq_f32(vmulq_f32(lz, lz), ly, ly), lx, lx));
+				lx = vmulq_f32(lx, scale);
+				ly = vmulq_f32(ly, scale);
+				lz = vmulq_f32(lz, scale);
+
+				float32x4_t impact = vfmaq_f32(vfmaq_f32(vmulq_f32(nz, lz), ny, ly), nx, lx);
+				diffuse = vaddq_f32(diffuse, vmaxq_f32(impact, zero));
+
+				if (constants.specularScale[light] != 0.0f)
+				{
+					float32x4_t twice = vaddq_f32(impact, impact);
+					float32x4_t rx = vsubq_f32(vmulq_f32(twice, nx), lx);
+					float32x4_t ry = vsubq_f32(vmulq_f32(twice, ny), ly);
+					float32x4_t rz = vsubq_f32(vmulq_f32(twice, nz), lz);
+					float32x4_t alignment = vfmaq_f32(vfmaq_f32(vmulq_f32(vz, rz), vy, ry), vx, rx);
+					float32x4_t highlight = FastPowNEON(vmaxq_f32(alignment, zero), vdupq_n_f32(constants.focalStrength[light]));
+					specular = vfmaq_f32(specular, vdupq_n_f32(constants.specularScale[light]), highlight);
+				}
+			}
+
+			vst1q_f32(&batch.red[i], vfmaq_f32(vfmaq_f32(vdupq_n_f32(constants.ambient.r), specular, vdupq_n_f32(constants.specularColor.r)),
+				diffuse, vdupq_n_f32(constants.diffuseColor.r)));
+			vst1q_f32(&batch.green[i], vfmaq_f32(vfmaq_f32(vdupq_n_f32(constants.ambient.g), specular, vdupq_n_f32(constants.specularColor.g)),
+				diffuse, vdupq_n_f32(constants.diffuseColor.g)));
+			vst1q_f32(&batch.blue[i], vfmaq_f32(vfmaq_f32(vdupq_n_f32(constants.ambient.b), specular, vdupq_n_f32(constants.specularColor.b)),
+				diffuse, vdupq_n_f32(constants.diffuseColor.b)));
+		}
+	}
+#endif
+
+	// the kernels that were built, by instruction set
+	const SHADE_FUNCTION g_ShadeFunctions[PhongKernel::INSTRUCTION_SET_COUNT] = {
+		&PhongKernel::ShadeReference,
+#ifdef PHONG_KERNEL_X86
+		&ShadeSSE2,
+#else
+		NULL,
+#endif
+#ifdef PHONG_KERNEL_NEON
+		&ShadeNEON,
+#else
+		NULL,
+#endif
+#ifdef PHONG_KERNEL_X86
+		&ShadeAVX2,
+		&ShadeAVX512,
+#else
+		NULL,
+		NULL,
+#endif
+	};
+
+	// the kernels the processor runs, and the one in use
+	struct KERNEL_SELECTION
+	{
+		bool bSupported[PhongKernel::INSTRUCTION_SET_COUNT];
+		PhongKernel::INSTRUCTION_SET active;
+	};
+
+	// check the instruction sets of the processor once, and
+	// start with the widest kernel it runs
+	KERNEL_SELECTION DetectKernels()
+	{
+		KERNEL_SELECTION selection;
+		for (int i = 0; i < PhongKernel::INSTRUCTION_SET_COUNT; i++)
+		{
+			selection.bSupported[i] = false;
+		}
+		selection.bSupported[PhongKernel::INSTRUCTIONS_SCALAR] = true;
+
+#ifdef PHONG_KERNEL_X86
+		int leaf0[4];
+		int leaf1[4];
+		int leaf7[4] = { 0, 0, 0, 0 };
+		ReadCpuId(0, 0, leaf0);
+		ReadCpuId(1, 0, leaf1);
+		if (leaf0[0] >= 7)
+		{
+			ReadCpuId(7, 0, leaf7);
+		}
+
+		bool bOSXSave = (leaf1[2] & (1 << 27)) != 0;
+		unsigned long long states = bOSXSave ? ReadEnabledStates() : 0;
+		// the SSE and AVX registers, and the AVX-512 masks and upper halves
+		bool bAVXStates = (states & 0x06) == 0x06;
+		bool bAVX512States = (states & 0xE6) == 0xE6;
+
+		selection.bSupported[PhongKernel::INSTRUCTIONS_SSE2] = (leaf1[3] & (1 << 26)) != 0;
+		selection.bSupported[PhongKernel::INSTRUCTIONS_AVX2] = bAVXStates &&
+			((leaf1[2] & (1 << 28)) != 0) &&	// AVX
+			((leaf1[2] & (1 << 12)) != 0) &&	// FMA
+			((leaf7[1] & (1 << 5)) != 0);		// AVX2
+		selection.bSupported[PhongKernel::INSTRUCTIONS_AVX512] = bAVX512States &&
+			((leaf7[1] & (1 << 16)) != 0);		// AVX-512F
+#endif
+#ifdef PHONG_KERNEL_NEON
+		// every ARM64 processor has NEON
+		selection.bSupported[PhongKernel::INSTRUCTIONS_NEON] = true;
+#endif
+
+		selection.active = PhongKernel::INSTRUCTIONS_SCALAR;
+		for (int i = 0; i < PhongKernel::INSTRUCTION_SET_COUNT; i++)
+		{
+			if (selection.bSupported[i] && (NULL != g_ShadeFunctions[i]))
+			{
+				selection.active = (PhongKernel::INSTRUCTION_SET)i;
+			}
+		}
+		return selection;
+	}
+
+	KERNEL_SELECTION& GetKernelSelection()
+	{
+		static KERNEL_SELECTION selection = DetectKernels();
+		return selection;
+	}
+}
+
+/***********************************************************
+ *  PrepareConstants()
+ *
+ *  This method is used to combine the lights of a frame
+ *  with a material.  The ambient term is the same for every
+ *  pixel, and the diffuse and specular colors are taken out
+ *  of the sum over the lights, so the kernels only add up
+ *  two numbers per light.
+ ***********************************************************/
+void PhongKernel::PrepareConstants(
+	const FrameUniformBuffer::FRAME_CONSTANTS& frame,
+	const SceneManager::OBJECT_MATERIAL& material,
+	PHONG_CONSTANTS& constants)
+{
+	constants.lightCount = std::min(std::max(frame.lightCount, 0), (int)FrameUniformBuffer::TOTAL_LIGHTS);
+	constants.ambient = glm::vec3(0.0f);
+	constants.diffuseColor = material.diffuseColor;
+	constants.specularColor = material.specularColor;
+	constants.viewPosition = frame.viewPosition;
+
+	for (int i = 0; i < constants.lightCount; i++)
+	{
+		const FrameUniformBuffer::LIGHT_SOURCE& light = frame.lightSources[i];
+		constants.ambient += light.ambientColor + (material.ambientColor * material.ambientStrength);
+		constants.lightX[i] = light.position.x;
+		constants.lightY[i] = light.position.y;
+		constants.lightZ[i] = light.position.z;
+		constants.focalStrength[i] = light.focalStrength;
+		constants.specularScale[i] = light.specularIntensity * material.shininess;
+	}
+}
+
+/***********************************************************
+ *  Shade()
+ *
+ *  This method is used to shade a batch with the selected
+ *  kernel.  The kernels work on whole groups of lanes, the
+ *  lanes past the count are shaded too and left unused.
+ ***********************************************************/
+void PhongKernel::Shade(const PHONG_CONSTANTS& constants, SHADE_BATCH& batch)
+{
+	g_ShadeFunctions[GetKernelSelection().active](constants, batch);
+}
+
+/***********************************************************
+ *  ShadeReference()
+ *
+ *  This method is used to shade a batch one pixel at a time
+ *  with the exact square roots and pow() of the shader.  It
+ *  is the kernel for processors without SIMD instructions,
+ *  and the reference the other kernels are checked against.
+ ***********************************************************/
+void PhongKernel::ShadeReference(const PHONG_CONSTANTS& constants, SHADE_BATCH& batch)
+{
+	for (int i = 0; i < batch.count; i++)
+	{
+		glm::vec3 position(batch.positionX[i], batch.positionY[i], batch.positionZ[i]);
+		glm::vec3 lightNormal = glm::normalize(glm::vec3(batch.normalX[i], batch.normalY[i], batch.normalZ[i]));
+		glm::vec3 viewDirection = glm::normalize(constants.viewPosition - position);
+
+		float diffuse = 0.0f;
+		float specular = 0.0f;
+		for (int light = 0; light < constants.lightCount; light++)
+		{
+			glm::vec3 lightPosition(constants.lightX[light], constants.lightY[light], constants.lightZ[light]);
+			glm::vec3 lightDirection = glm::normalize(lightPosition - position);
+			diffuse += std::max(glm::dot(lightNormal, lightDirection), 0.0f);
+
+			glm::vec3 reflectDirection = glm::reflect(-lightDirection, lightNormal);
+			float specularComponent = powf(std::max(glm::dot(viewDirection, reflectDirection), 0.0f), constants.focalStrength[light]);
+			specular += constants.specularScale[light] * specularComponent;
+		}
+
+		glm::vec3 color = constants.ambient + diffuse * constants.diffuseColor + specular * constants.specularColor;
+		batch.red[i] = color.r;
+		batch.green[i] = color.g;
+		batch.blue[i] = color.b;
+	}
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used to get the kernel used by Shade().
+ ***********************************************************/
+PhongKernel::INSTRUCTION_SET PhongKernel::GetInstructionSet()
+{
+	return GetKernelSelection().active;
+}
+
+/***********************************************************
+ *  SetInstructionSet()
+ *
+ *  This method is used to select the kernel used by Shade()
+ *  instead of the widest one.  It has to be called before
+ *  any worker threads shade.
+ ***********************************************************/
+bool PhongKernel::SetInstructionSet(INSTRUCTION_SET instructionSet)
+{
+	if (!IsSupported(instructionSet))
+	{
+		printf("The %s shading kernel is not supported on this processor\n", GetInstructionSetName(instructionSet));
+		return false;
+	}
+
+	GetKernelSelection().active = instructionSet;
+	return true;
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used to check that a kernel was built for
+ *  this processor architecture, and that the processor and
+ *  the system support its instructions.
+ ***********************************************************/
+bool PhongKernel::IsSupported(INSTRUCTION_SET instructionSet)
+{
+	if ((instructionSet < 0) || (instructionSet >= INSTRUCTION_SET_COUNT))
+	{
+		return false;
+	}
+	return (NULL != g_ShadeFunctions[instructionSet]) && GetKernelSelection().bSupported[instructionSet];
+}
+
+/***********************************************************
+ *  GetInstructionSetName()
+ *
+ *  This method is used to get the name of a kernel, as it
+ *  is passed on the command line.
+ ***********************************************************/
+const char* PhongKernel::GetInstructionSetName(INSTRUCTION_SET instructionSet)
+{
+	if ((instructionSet < 0) || (instructionSet >= INSTRUCTION_SET_COUNT))
+	{
+		return "unknown";
+	}
+	return g_InstructionSetNames[instructionSet];
+}
+
+/***********************************************************
+ *  FindInstructionSet()
+ *
+ *  This method is used to get the kernel of a name.
+ ***********************************************************/
+bool PhongKernel::FindInstructionSet(const char* name, INSTRUCTION_SET& instructionSet)
+{
+	for (int i = 0; i < INSTRUCTION_SET_COUNT; i++)
+	{
+		if (strcmp(name, g_InstructionSetNames[i]) == 0)
+		{
+			instructionSet = (INSTRUCTION_SET)i;
+			return true;
+		}
+	}
+
+	printf("Unknown shading kernel %s\n", name);
+	return false;
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used to measure how many pixels per
+ *  second every supported kernel shades on one core.  The
+ *  pixels have random positions and normals, and all four
+ *  lights have a specular term, so pow() runs four times a
+ *  pixel - the scene only uses it for one of its lights.
+ *  Every kernel is also checked against the reference, and
+ *  the benchmark fails when one is off by too much.
+ ***********************************************************/
+bool PhongKernel::RunBenchmark()
+{
+	// the lights of the scene at its corners, with the material
+	// of a glossy object
+	FrameUniformBuffer::FRAME_CONSTANTS frame;
+	memset(&frame, 0, sizeof(frame));
+	frame.viewPosition = glm::vec3(0.0f, 6.0f, 12.0f);
+	frame.lightCount = 4;
+	const glm::vec3 corners[4] = {
+		{ 10.0f, 12.0f, -10.0f }, { 10.0f, 12.0f, 10.0f }, { -10.0f, 12.0f, 10.0f }, { -10.0f, 12.0f, -10.0f }
+	};
+	for (int i = 0; i < frame.lightCount; i++)
+	{
+		frame.lightSources[i].position = corners[i];
+		frame.lightSources[i].ambientColor = glm::vec3(0.05f);
+		frame.lightSources[i].specularIntensity = 0.15f;
+		frame.lightSources[i].focalStrength = 3.0f + 22.0f * i / 3.0f;
+	}
+
+	SceneManager::OBJECT_MATERIAL material;
+	material.ambientStrength = 0.2f;
+	material.ambientColor = glm::vec3(0.5f);
+	material.diffuseColor = glm::vec3(0.8f, 0.7f, 0.6f);
+	material.specularColor = glm::vec3(0.3f);
+	material.shininess = 0.5f;
+
+	PHONG_CONSTANTS constants;
+	PrepareConstants(frame, material, constants);
+
+	// pixels on a table, with the normals of a curved surface
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<float> spread(-1.0f, 1.0f);
+	std::vector<SHADE_BATCH> batches(g_BenchmarkBatches);
+	for (int b = 0; b < g_BenchmarkBatches; b++)
+	{
+		SHADE_BATCH& batch = batches[b];
+		batch.count = BATCH_SIZE;
+		for (int i = 0; i < BATCH_SIZE; i++)
+		{
+			batch.positionX[i] = 10.0f * spread(generator);
+			batch.positionY[i] = 2.0f + 2.0f * spread(generator);
+			batch.positionZ[i] = 10.0f * spread(generator);
+			batch.normalX[i] = 0.5f * spread(generator);
+			batch.normalY[i] = 1.0f + 0.5f * spread(generator);
+			batch.normalZ[i] = 0.5f * spread(generator);
+		}
+	}
+	std::vector<SHADE_BATCH> reference = batches;
+	for (int b = 0; b < g_BenchmarkBatches; b++)
+	{
+		ShadeReference(constants, reference[b]);
+	}
+
+	printf("INFO: Phong kernel benchmark, %d pixels with %d lights on one core\n",
+		g_BenchmarkBatches * BATCH_SIZE, frame.lightCount);
+
+	bool bPassed = true;
+	double scalarRate = 0.0;
+	for (int set = 0; set < INSTRUCTION_SET_COUNT; set++)
+	{
+		if (!IsSupported((INSTRUCTION_SET)set))
+		{
+			continue;
+		}
+		SHADE_FUNCTION shade = g_ShadeFunctions[set];
+
+		// the first pass is checked, and warms up the caches
+		float largestError = 0.0f;
+		for (int b = 0; b < g_BenchmarkBatches; b++)
+		{
+			shade(constants, batches[b]);
+			for (int i = 0; i < BATCH_SIZE; i++)
+			{
+				const float shaded[3] = { batches[b].red[i], batches[b].green[i], batches[b].blue[i] };
+				const float expected[3] = { reference[b].red[i], reference[b].green[i], reference[b].blue[i] };
+				for (int channel = 0; channel < 3; channel++)
+				{
+					float error = fabsf(shaded[channel] - expected[channel]) / std::max(fabsf(expected[channel]), 1.0f);
+					largestError = std::max(largestError, error);
+				}
+			}
+		}
+
+		long long iterations = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double seconds = 0.0;
+		do
+		{
+			for (int b = 0; b < g_BenchmarkBatches; b++)
+			{
+				shade(constants, batches[b]);
+			}
+			iterations++;
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (seconds < g_BenchmarkSeconds);
+
+		double rate = (double)iterations * g_BenchmarkBatches * BATCH_SIZE / seconds;
+		if (set == INSTRUCTIONS_SCALAR)
+		{
+			scalarRate = rate;
+		}
+
+		bool bAccurate = largestError <= g_ErrorTolerance;
+		printf("INFO: Phong kernel %-7s %9.2f Mpixels/s per core (%5.2fx scalar), largest error %.2e%s\n",
+			GetInstructionSetName((INSTRUCTION_SET)set), rate * 1e-6,
+			(scalarRate > 0.0) ? rate / scalarRate : 0.0,
+			largestError, bAccurate ? "" : " - too large");
+		bPassed = bPassed && bAccurate;
+	}
+
+	printf("INFO: Phong kernel in use: %s\n", GetInstructionSetName(GetInstructionSet()));
+	return bPassed;
+}
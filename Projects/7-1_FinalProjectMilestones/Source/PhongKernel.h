@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// phongkernel.h
+// ============
+// shade batches of pixels with the Phong lighting of the fragment shader,
+// using the widest SIMD instructions the processor supports
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "FrameUniformBuffer.h"
+
+/***********************************************************
+ *  PhongKernel
+ *
+ *  This class contains the code for a CPU port of the
+ *  lighting in fragmentShader.glsl.  The pixels are passed
+ *  as a structure of arrays, so that one instruction works
+ *  on 4, 8 or 16 pixels, and the kernel is picked once at
+ *  runtime from the instruction sets of the processor:
+ *
+ *  - AVX-512 shades 16 pixels at a time
+ *  - AVX2 with FMA shades 8 pixels at a time
+ *  - SSE2 on x86 and NEON on ARM64 shade 4 pixels at a time
+ *  - the scalar reference shades one pixel at a time
+ *
+ *  The SIMD kernels replace the square roots with reciprocal
+ *  square root estimates and the pow() of the specular term
+ *  with a polynomial log2 and exp2, which stay well inside
+ *  one step of an 8 bit color channel.
+ ***********************************************************/
+class PhongKernel
+{
+public:
+	// most pixels in a batch, a multiple of the widest kernel
+	static const int BATCH_SIZE = 256;
+
+	// the kernels, from the narrowest to the widest
+	enum INSTRUCTION_SET
+	{
+		INSTRUCTIONS_SCALAR,
+		INSTRUCTIONS_SSE2,
+		INSTRUCTIONS_NEON,
+		INSTRUCTIONS_AVX2,
+		INSTRUCTIONS_AVX512,
+		INSTRUCTION_SET_COUNT
+	};
+
+	// the lights and the material of a draw, with the terms
+	// that are the same for every pixel already added up
+	struct PHONG_CONSTANTS
+	{
+		glm::vec3 ambient;			// ambient of every light plus the material
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		glm::vec3 viewPosition;
+		int lightCount;
+		float lightX[FrameUniformBuffer::TOTAL_LIGHTS];
+		float lightY[FrameUniformBuffer::TOTAL_LIGHTS];
+		float lightZ[FrameUniformBuffer::TOTAL_LIGHTS];
+		float focalStrength[FrameUniformBuffer::TOTAL_LIGHTS];
+		float specularScale[FrameUniformBuffer::TOTAL_LIGHTS];	// light intensity times shininess
+	};
+
+	// the pixels of a batch as a structure of arrays - the world
+	// position and the interpolated normal go in, the lighting
+	// comes out before it is multiplied by the object color
+	struct SHADE_BATCH
+	{
+		float positionX[BATCH_SIZE];
+		float positionY[BATCH_SIZE];
+		float positionZ[BATCH_SIZE];
+		float normalX[BATCH_SIZE];
+		float normalY[BATCH_SIZE];
+		float normalZ[BATCH_SIZE];
+		float red[BATCH_SIZE];
+		float green[BATCH_SIZE];
+		float blue[BATCH_SIZE];
+		int count;
+	};
+
+	// combine the frame lights with a material
+	static void PrepareConstants(
+		const FrameUniformBuffer::FRAME_CONSTANTS& frame,
+		const SceneManager::OBJECT_MATERIAL& material,
+		PHONG_CONSTANTS& constants);
+
+	// shade a batch with the selected kernel
+	static void Shade(const PHONG_CONSTANTS& constants, SHADE_BATCH& batch);
+	// shade a batch one pixel at a time, with the exact math
+	static void ShadeReference(const PHONG_CONSTANTS& constants, SHADE_BATCH& batch);
+
+	// the kernel used by Shade(), the widest supported one
+	// unless another one was selected
+	static INSTRUCTION_SET GetInstructionSet();
+	// select a kernel, false when the processor lacks it
+	static bool SetInstructionSet(INSTRUCTION_SET instructionSet);
+	// true when the kernel was built and the processor runs it
+	static bool IsSupported(INSTRUCTION_SET instructionSet);
+	// the name of a kernel, and the kernel of a name
+	static const char* GetInstructionSetName(INSTRUCTION_SET instructionSet);
+	static bool FindInstructionSet(const char* name, INSTRUCTION_SET& instructionSet);
+
+	// measure the pixels per second of every supported kernel on
+	// one core, and check them against the scalar reference
+	static bool RunBenchmark();
+};
@@ -0,0 +1,1124 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// load the textures, materials, lights and objects of a scene from a text
+// scene description, or from its compiled form mapped into memory
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "SceneManager.h"
+#include "TraceRecorder.h"
+
+#include <map>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const char g_SceneMagic[4] = { 'S', 'C', 'N', 'B' };
+
+	// arrays nested deeper than this are not read
+	const int g_MaxArrayDepth = 4;
+
+	// the names of the meshes in the text form
+	struct MESH_NAME
+	{
+		const char* name;
+		int32_t mesh;
+	};
+	const MESH_NAME g_MeshNames[] = {
+		{ "group", SceneFile::MESH_GROUP },
+		{ "box", SceneManager::MESH_BOX },
+		{ "cone", SceneManager::MESH_CONE },
+		{ "cylinder", SceneManager::MESH_CYLINDER },
+		{ "plane", SceneManager::MESH_PLANE },
+		{ "prism", SceneManager::MESH_PRISM },
+		{ "pyramid3", SceneManager::MESH_PYRAMID3 },
+		{ "pyramid4", SceneManager::MESH_PYRAMID4 },
+		{ "sphere", SceneManager::MESH_SPHERE },
+		{ "half_sphere", SceneManager::MESH_HALF_SPHERE },
+		{ "tapered_cylinder", SceneManager::MESH_TAPERED_CYLINDER },
+		{ "torus", SceneManager::MESH_TORUS },
+		{ "half_torus", SceneManager::MESH_HALF_TORUS }
+	};
+
+	// a value of the text form
+	struct TEXT_VALUE
+	{
+		enum VALUE_TYPE
+		{
+			VALUE_STRING,
+			VALUE_NUMBER,
+			VALUE_ARRAY
+		};
+
+		VALUE_TYPE type;
+		int line;
+		std::string text;
+		float number;
+		std::vector<TEXT_VALUE> items;
+	};
+
+	struct TEXT_KEY
+	{
+		std::string name;
+		TEXT_VALUE value;
+		bool bUsed;
+	};
+
+	// a [table] or an entry of an [[array]] of tables
+	struct TEXT_TABLE
+	{
+		std::string name;
+		bool bArray;
+		int line;
+		std::vector<TEXT_KEY> keys;
+	};
+
+	// the position of the parser in the text
+	struct TEXT_READER
+	{
+		const char* filename;
+		const std::string& text;
+		size_t position;
+		int line;
+	};
+
+	// print an error at a line of a scene file
+	void ReportError(const char* filename, int line, const char* format, ...)
+	{
+		printf("%s(%d): ", filename, line);
+		va_list arguments;
+		va_start(arguments, format);
+		vprintf(format, arguments);
+		va_end(arguments);
+		printf("\n");
+	}
+
+	// skip the spaces and the comments, and the line ends
+	// when they are allowed
+	void SkipSpace(TEXT_READER& reader, bool bLineEnds)
+	{
+		const std::string& text = reader.text;
+		while (reader.position < text.size())
+		{
+			char c = text[reader.position];
+			if ((c == ' ') || (c == '\t') || (c == '\r'))
+			{
+				reader.position++;
+			}
+			else if (c == '#')
+			{
+				while ((reader.position < text.size()) && (text[reader.position] != '\n'))
+				{
+					reader.position++;
+				}
+			}
+			else if ((c == '\n') && bLineEnds)
+			{
+				reader.position++;
+				reader.line++;
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	// true when the next character is the passed in one
+	bool IsNext(const TEXT_READER& reader, char c)
+	{
+		return (reader.position < reader.text.size()) && (reader.text[reader.position] == c);
+	}
+
+	// read a bare key or table name
+	bool ReadKey(TEXT_READER& reader, std::string& key)
+	{
+		size_t start = reader.position;
+		while (reader.position < reader.text.size())
+		{
+			char c = reader.text[reader.position];
+			if (!(((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+				((c >= '0') && (c <= '9')) || (c == '_') || (c == '-')))
+			{
+				break;
+			}
+			reader.position++;
+		}
+
+		if (reader.position == start)
+		{
+			ReportError(reader.filename, reader.line, "expected a key");
+			return false;
+		}
+		key = reader.text.substr(start, reader.position - start);
+		return true;
+	}
+
+	// read a string, a number or an array of values
+	bool ReadValue(TEXT_READER& reader, TEXT_VALUE& value, int depth)
+	{
+		const std::string& text = reader.text;
+		value.line = reader.line;
+		value.number = 0.0f;
+
+		if (IsNext(reader, '"'))
+		{
+			value.type = TEXT_VALUE::VALUE_STRING;
+			reader.position++;
+			while (!IsNext(reader, '"'))
+			{
+				if ((reader.position >= text.size()) || (text[reader.position] == '\n'))
+				{
+					ReportError(reader.filename, reader.line, "the string is not closed");
+					return false;
+				}
+
+				char c = text[reader.position++];
+				if ((c == '\\') && (reader.position < text.size()))
+				{
+					c = text[reader.position++];
+					c = (c == 'n') ? '\n' : ((c == 't') ? '\t' : c);
+				}
+				value.text += c;
+			}
+			reader.position++;
+			return true;
+		}
+
+		if (IsNext(reader, '['))
+		{
+			if (depth >= g_MaxArrayDepth)
+			{
+				ReportError(reader.filename, reader.line, "the arrays are nested too deep");
+				return false;
+			}
+
+			value.type = TEXT_VALUE::VALUE_ARRAY;
+			reader.position++;
+			for (;;)
+			{
+				// a comma may follow the last value
+				SkipSpace(reader, true);
+				if (IsNext(reader, ']'))
+				{
+					break;
+				}
+
+				value.items.push_back(TEXT_VALUE());
+				if (!ReadValue(reader, value.items.back(), depth + 1))
+				{
+					return false;
+				}
+
+				SkipSpace(reader, true);
+				if (IsNext(reader, ','))
+				{
+					reader.position++;
+				}
+				else if (!IsNext(reader, ']'))
+				{
+					ReportError(reader.filename, reader.line, "expected , or ] in the array");
+					return false;
+				}
+			}
+			reader.position++;
+			return true;
+		}
+
+		// a number, where underscores can separate the digits
+		value.type = TEXT_VALUE::VALUE_NUMBER;
+		std::string digits;
+		while ((reader.position < text.size()) && (strchr("+-.0123456789eE_", text[reader.position]) != NULL))
+		{
+			if (text[reader.position] != '_')
+			{
+				digits += text[reader.position];
+			}
+			reader.position++;
+		}
+
+		char* pEnd = NULL;
+		value.number = strtof(digits.c_str(), &pEnd);
+		if (digits.empty() || (*pEnd != '\0'))
+		{
+			ReportError(reader.filename, reader.line, "expected a string, a number or an array");
+			return false;
+		}
+		return true;
+	}
+
+	// read the tables of a text scene
+	bool ParseText(TEXT_READER& reader, std::vector<TEXT_TABLE>& tables)
+	{
+		for (;;)
+		{
+			SkipSpace(reader, true);
+			if (reader.position >= reader.text.size())
+			{
+				break;
+			}
+
+			if (IsNext(reader, '['))
+			{
+				reader.position++;
+				TEXT_TABLE table;
+				table.bArray = IsNext(reader, '[');
+				table.line = reader.line;
+				if (table.bArray)
+				{
+					reader.position++;
+				}
+
+				SkipSpace(reader, false);
+				if (!ReadKey(reader, table.name))
+				{
+					return false;
+				}
+				SkipSpace(reader, false);
+				for (int i = 0; i < (table.bArray ? 2 : 1); i++)
+				{
+					if (!IsNext(reader, ']'))
+					{
+						ReportError(reader.filename, reader.line, "expected ] after the table name");
+						return false;
+					}
+					reader.position++;
+				}
+
+				for (size_t i = 0; i < tables.size(); i++)
+				{
+					if ((tables[i].name == table.name) && (!table.bArray || !tables[i].bArray))
+					{
+						ReportError(reader.filename, reader.line, "the table %s is defined twice", table.name.c_str());
+						return false;
+					}
+				}
+				tables.push_back(table);
+			}
+			else
+			{
+				TEXT_KEY key;
+				key.bUsed = false;
+				if (!ReadKey(reader, key.name))
+				{
+					return false;
+				}
+				if (tables.empty())
+				{
+					ReportError(reader.filename, reader.line, "the key %s is not in a table", key.name.c_str());
+					return false;
+				}
+
+				SkipSpace(reader, false);
+				if (!IsNext(reader, '='))
+				{
+					ReportError(reader.filename, reader.line, "expected = after the key %s", key.name.c_str());
+					return false;
+				}
+				reader.position++;
+				SkipSpace(reader, false);
+				if (!ReadValue(reader, key.value, 0))
+				{
+					return false;
+				}
+
+				std::vector<TEXT_KEY>& keys = tables.back().keys;
+				for (size_t i = 0; i < keys.size(); i++)
+				{
+					if (keys[i].name == key.name)
+					{
+						ReportError(reader.filename, key.value.line, "the key %s is set twice", key.name.c_str());
+						return false;
+					}
+				}
+				keys.push_back(key);
+			}
+
+			SkipSpace(reader, false);
+			if ((reader.position < reader.text.size()) && !IsNext(reader, '\n'))
+			{
+				ReportError(reader.filename, reader.line, "expected the end of the line");
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// find a key of a table and mark it as used
+	const TEXT_VALUE* FindKey(TEXT_TABLE& table, const char* name)
+	{
+		for (size_t i = 0; i < table.keys.size(); i++)
+		{
+			if (table.keys[i].name == name)
+			{
+				table.keys[i].bUsed = true;
+				return &table.keys[i].value;
+			}
+		}
+		return NULL;
+	}
+
+	// read a string key, which is left as it is when the key
+	// is not there and not required
+	bool GetStringKey(const char* filename, TEXT_TABLE& table, const char* name, bool bRequired, std::string& text)
+	{
+		const TEXT_VALUE* pValue = FindKey(table, name);
+		if (NULL == pValue)
+		{
+			if (bRequired)
+			{
+				ReportError(filename, table.line, "the key %s is missing from [[%s]]", name, table.name.c_str());
+			}
+			return !bRequired;
+		}
+		if (pValue->type != TEXT_VALUE::VALUE_STRING)
+		{
+			ReportError(filename, pValue->line, "the key %s is not a string", name);
+			return false;
+		}
+
+		text = pValue->text;
+		return true;
+	}
+
+	// read one number, or an array of the passed in count
+	bool ReadFloats(const char* filename, const TEXT_VALUE& value, const char* name, float* values, int count)
+	{
+		if ((count == 1) && (value.type == TEXT_VALUE::VALUE_NUMBER))
+		{
+			values[0] = value.number;
+			return true;
+		}
+
+		bool bValid = (count > 1) && (value.type == TEXT_VALUE::VALUE_ARRAY) && ((int)value.items.size() == count);
+		for (int i = 0; bValid && (i < count); i++)
+		{
+			bValid = (value.items[i].type == TEXT_VALUE::VALUE_NUMBER);
+		}
+		if (!bValid)
+		{
+			if (count == 1)
+			{
+				ReportError(filename, value.line, "the key %s is not a number", name);
+			}
+			else
+			{
+				ReportError(filename, value.line, "the key %s is not an array of %d numbers", name, count);
+			}
+			return false;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			values[i] = value.items[i].number;
+		}
+		return true;
+	}
+
+	// read a number key, which is left as it is when the key
+	// is not there
+	bool GetNumberKey(const char* filename, TEXT_TABLE& table, const char* name, float* values, int count)
+	{
+		const TEXT_VALUE* pValue = FindKey(table, name);
+		return (NULL == pValue) || ReadFloats(filename, *pValue, name, values, count);
+	}
+
+	// report the keys of a table that were not read
+	bool CheckKeys(const char* filename, const TEXT_TABLE& table)
+	{
+		for (size_t i = 0; i < table.keys.size(); i++)
+		{
+			if (!table.keys[i].bUsed)
+			{
+				ReportError(filename, table.keys[i].value.line, "unknown key %s in %s", table.keys[i].name.c_str(), table.name.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// find a tag defined before, or give NO_INDEX for none
+	bool FindIndex(const char* filename, int line, const std::map<std::string, int32_t>& indices, const std::string& name, const char* kind, int32_t& index)
+	{
+		index = SceneFile::NO_INDEX;
+		if (name.empty())
+		{
+			return true;
+		}
+
+		std::map<std::string, int32_t>::const_iterator found = indices.find(name);
+		if (found == indices.end())
+		{
+			ReportError(filename, line, "unknown %s %s", kind, name.c_str());
+			return false;
+		}
+		index = found->second;
+		return true;
+	}
+
+	// the strings of a compiled scene, each one stored once
+	struct STRING_TABLE
+	{
+		std::string bytes;
+		std::map<std::string, uint32_t> offsets;
+
+		uint32_t Add(const std::string& text)
+		{
+			std::map<std::string, uint32_t>::const_iterator found = offsets.find(text);
+			if (found != offsets.end())
+			{
+				return found->second;
+			}
+
+			uint32_t offset = (uint32_t)bytes.size();
+			bytes.append(text.c_str(), text.size() + 1);
+			offsets[text] = offset;
+			return offset;
+		}
+	};
+
+	// add the records of a section to a compiled scene
+	template <typename RECORD>
+	void AddSection(std::vector<uint8_t>& image, SceneFile::SECTION& section, const std::vector<RECORD>& records)
+	{
+		section.offset = (uint32_t)image.size();
+		section.count = (uint32_t)records.size();
+		if (!records.empty())
+		{
+			const uint8_t* pBytes = (const uint8_t*)records.data();
+			image.insert(image.end(), pBytes, pBytes + (records.size() * sizeof(RECORD)));
+		}
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pHeader = NULL;
+	m_pMapping = NULL;
+	m_mappingSize = 0;
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used to load a scene file.  A compiled
+ *  scene is mapped into memory, and a text scene is read
+ *  and compiled.
+ ***********************************************************/
+bool SceneFile::Load(const char* filename)
+{
+	TRACE_SCOPE("LoadSceneFile", filename);
+
+	Close();
+
+	FILE* file = fopen(filename, "rb");
+	if (NULL == file)
+	{
+		printf("Unable to read scene %s\n", filename);
+		return false;
+	}
+
+	char magic[sizeof(g_SceneMagic)];
+	bool bCompiled = (fread(magic, 1, sizeof(magic), file) == sizeof(magic)) &&
+		(memcmp(magic, g_SceneMagic, sizeof(magic)) == 0);
+
+	bool bLoaded = false;
+	if (bCompiled)
+	{
+		fclose(file);
+		bLoaded = MapCompiled(filename);
+	}
+	else
+	{
+		std::string text;
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		if (size > 0)
+		{
+			text.resize((size_t)size);
+			text.resize(fread(&text[0], 1, text.size(), file));
+		}
+		fclose(file);
+		bLoaded = CompileText(filename, text);
+	}
+
+	if (!bLoaded)
+	{
+		Close();
+		return false;
+	}
+
+	// the files named in the scene are relative to it
+	std::string path(filename);
+	size_t separator = path.find_last_of("/\\");
+	m_directory = (separator != std::string::npos) ? path.substr(0, separator + 1) : std::string();
+
+	return true;
+}
+
+/***********************************************************
+ *  MapCompiled()
+ *
+ *  This method is used to map a compiled scene into memory
+ *  for reading.  The pages are only read from the disk as
+ *  the records are used.
+ ***********************************************************/
+bool SceneFile::MapCompiled(const char* filename)
+{
+	void* pMapping = NULL;
+	size_t size = 0;
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(hFile, &fileSize) && (fileSize.QuadPart > 0))
+		{
+			// the view keeps the file open after the handles are closed
+			HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (NULL != hMapping)
+			{
+				pMapping = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+				size = (size_t)fileSize.QuadPart;
+				CloseHandle(hMapping);
+			}
+		}
+		CloseHandle(hFile);
+	}
+#else
+	int file = open(filename, O_RDONLY);
+	if (file >= 0)
+	{
+		struct stat status;
+		if ((fstat(file, &status) == 0) && (status.st_size > 0))
+		{
+			// the mapping keeps the file open after it is closed
+			pMapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			size = (size_t)status.st_size;
+			if (pMapping == MAP_FAILED)
+			{
+				pMapping = NULL;
+			}
+		}
+		close(file);
+	}
+#endif
+
+	if (NULL == pMapping)
+	{
+		printf("Unable to map scene %s\n", filename);
+		return false;
+	}
+
+	m_pMapping = pMapping;
+	m_mappingSize = size;
+	if (!Validate(pMapping, size, filename))
+	{
+		return false;
+	}
+
+	m_pHeader = (const SCENE_HEADER*)pMapping;
+	return true;
+}
+
+/***********************************************************
+ *  CompileText()
+ *
+ *  This method is used to compile a text scene into the
+ *  records of a compiled one, in memory.  The textures,
+ *  meshes, materials and objects are named by their tags, which
+ *  become indices, and the parents have to come before
+ *  the objects that name them.
+ ***********************************************************/
+bool SceneFile::CompileText(const char* filename, const std::string& text)
+{
+	std::vector<TEXT_TABLE> tables;
+	TEXT_READER reader = { filename, text, 0, 1 };
+	if (!ParseText(reader, tables))
+	{
+		return false;
+	}
+
+	SCENE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, g_SceneMagic, sizeof(header.magic));
+	header.version = VERSION;
+
+	std::vector<TEXTURE_RECORD> textures;
+	std::vector<MESH_RECORD> meshes;
+	std::vector<MATERIAL_RECORD> materials;
+	std::vector<LIGHT_RECORD> lights;
+	std::vector<OBJECT_RECORD> objects;
+	STRING_TABLE strings;
+	strings.Add("");
+
+	std::map<std::string, int32_t> textureIndices;
+	std::map<std::string, int32_t> meshIndices;
+	std::map<std::string, int32_t> materialIndices;
+	std::map<std::string, int32_t> objectIndices;
+
+	// the objects are compiled after everything they can name
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (size_t i = 0; i < tables.size(); i++)
+		{
+			TEXT_TABLE& table = tables[i];
+			bool bObject = table.bArray && (table.name == "object");
+			if (bObject != (pass == 1))
+			{
+				continue;
+			}
+
+			if (!table.bArray && (table.name == "lights"))
+			{
+				if (!GetNumberKey(filename, table, "radius", &header.lightRadius, 1) ||
+					!GetNumberKey(filename, table, "height", &header.lightHeight, 1))
+				{
+					return false;
+				}
+			}
+			else if (table.bArray && (table.name == "texture"))
+			{
+				std::string tag;
+				std::string file;
+				if (!GetStringKey(filename, table, "tag", true, tag) ||
+					!GetStringKey(filename, table, "file", true, file))
+				{
+					return false;
+				}
+
+				TEXTURE_RECORD texture;
+				texture.tag = strings.Add(tag);
+				texture.filename = strings.Add(file);
+				textureIndices[tag] = (int32_t)textures.size();
+				textures.push_back(texture);
+			}
+			else if (table.bArray && (table.name == "mesh"))
+			{
+				std::string tag;
+				std::string file;
+				if (!GetStringKey(filename, table, "tag", true, tag) ||
+					!GetStringKey(filename, table, "file", true, file))
+				{
+					return false;
+				}
+				for (size_t j = 0; j < sizeof(g_MeshNames) / sizeof(g_MeshNames[0]); j++)
+				{
+					if (tag == g_MeshNames[j].name)
+					{
+						ReportError(filename, table.line, "the mesh tag %s is the name of a basic mesh", tag.c_str());
+						return false;
+					}
+				}
+
+				MESH_RECORD mesh;
+				mesh.tag = strings.Add(tag);
+				mesh.filename = strings.Add(file);
+				meshIndices[tag] = (int32_t)meshes.size();
+				meshes.push_back(mesh);
+			}
+			else if (table.bArray && (table.name == "material"))
+			{
+				MATERIAL_RECORD material;
+				memset(&material, 0, sizeof(material));
+				std::string tag;
+				if (!GetStringKey(filename, table, "tag", true, tag) ||
+					!GetNumberKey(filename, table, "ambient_strength", &material.ambientStrength, 1) ||
+					!GetNumberKey(filename, table, "ambient_color", material.ambientColor, 3) ||
+					!GetNumberKey(filename, table, "diffuse_color", material.diffuseColor, 3) ||
+					!GetNumberKey(filename, table, "specular_color", material.specularColor, 3) ||
+					!GetNumberKey(filename, table, "shininess", &material.shininess, 1))
+				{
+					return false;
+				}
+
+				material.tag = strings.Add(tag);
+				materialIndices[tag] = (int32_t)materials.size();
+				materials.push_back(material);
+			}
+			else if (table.bArray && (table.name == "light"))
+			{
+				LIGHT_RECORD light;
+				memset(&light, 0, sizeof(light));
+				if (!GetNumberKey(filename, table, "placement", light.placement, 3) ||
+					!GetNumberKey(filename, table, "ambient_color", light.ambientColor, 3) ||
+					!GetNumberKey(filename, table, "diffuse_color", light.diffuseColor, 3) ||
+					!GetNumberKey(filename, table, "specular_color", light.specularColor, 3) ||
+					!GetNumberKey(filename, table, "specular_intensity", &light.specularIntensity, 1) ||
+					!GetNumberKey(filename, table, "focal_strength", &light.focalStrength, 1))
+				{
+					return false;
+				}
+				lights.push_back(light);
+			}
+			else if (bObject)
+			{
+				OBJECT_RECORD object;
+				memset(&object, 0, sizeof(object));
+				for (int axis = 0; axis < 3; axis++)
+				{
+					object.scale[axis] = 1.0f;
+				}
+				for (int channel = 0; channel < 4; channel++)
+				{
+					object.color[channel] = 1.0f;
+				}
+				object.UVscale[0] = 1.0f;
+				object.UVscale[1] = 1.0f;
+
+				std::string name;
+				std::string mesh;
+				std::string parent;
+				std::string texture;
+				std::string material;
+				if (!GetStringKey(filename, table, "name", false, name) ||
+					!GetStringKey(filename, table, "mesh", true, mesh) ||
+					!GetStringKey(filename, table, "parent", false, parent) ||
+					!GetStringKey(filename, table, "texture", false, texture) ||
+					!GetStringKey(filename, table, "material", false, material) ||
+					!FindIndex(filename, table.line, objectIndices, parent, "parent", object.parent) ||
+					!FindIndex(filename, table.line, textureIndices, texture, "texture", object.texture) ||
+					!FindIndex(filename, table.line, materialIndices, material, "material", object.material) ||
+					!GetNumberKey(filename, table, "scale", object.scale, 3) ||
+					!GetNumberKey(filename, table, "rotation", object.rotationDegrees, 3) ||
+					!GetNumberKey(filename, table, "position", object.position, 3) ||
+					!GetNumberKey(filename, table, "color", object.color, 4) ||
+					!GetNumberKey(filename, table, "uv_scale", object.UVscale, 2))
+				{
+					return false;
+				}
+
+				object.name = strings.Add(name);
+				bool bKnownMesh = false;
+				for (size_t j = 0; j < sizeof(g_MeshNames) / sizeof(g_MeshNames[0]); j++)
+				{
+					if (mesh == g_MeshNames[j].name)
+					{
+						object.mesh = g_MeshNames[j].mesh;
+						bKnownMesh = true;
+					}
+				}
+				std::map<std::string, int32_t>::const_iterator imported = meshIndices.find(mesh);
+				if (imported != meshIndices.end())
+				{
+					object.mesh = SceneManager::MESH_IMPORTED + imported->second;
+					bKnownMesh = true;
+				}
+				if (!bKnownMesh)
+				{
+					ReportError(filename, table.line, "unknown mesh %s", mesh.c_str());
+					return false;
+				}
+
+				// an object with a list of positions is drawn at each
+				// one, and its name is the last of them
+				const TEXT_VALUE* pPositions = FindKey(table, "positions");
+				if (NULL == pPositions)
+				{
+					objects.push_back(object);
+				}
+				else if (pPositions->type != TEXT_VALUE::VALUE_ARRAY)
+				{
+					ReportError(filename, pPositions->line, "the key positions is not an array");
+					return false;
+				}
+				else
+				{
+					for (size_t j = 0; j < pPositions->items.size(); j++)
+					{
+						if (!ReadFloats(filename, pPositions->items[j], "positions", object.position, 3))
+						{
+							return false;
+						}
+						objects.push_back(object);
+					}
+				}
+
+				if (!name.empty() && !objects.empty())
+				{
+					objectIndices[name] = (int32_t)objects.size() - 1;
+				}
+			}
+			else
+			{
+				ReportError(filename, table.line, "unknown table %s", table.name.c_str());
+				return false;
+			}
+
+			if (!CheckKeys(filename, table))
+			{
+				return false;
+			}
+		}
+	}
+
+	// the records are followed by the strings, padded to a
+	// whole number of words
+	std::vector<uint8_t> image(sizeof(SCENE_HEADER));
+	AddSection(image, header.textures, textures);
+	AddSection(image, header.meshes, meshes);
+	AddSection(image, header.materials, materials);
+	AddSection(image, header.lights, lights);
+	AddSection(image, header.objects, objects);
+	strings.bytes.resize((strings.bytes.size() + 3) & ~(size_t)3, '\0');
+	header.strings.offset = (uint32_t)image.size();
+	header.strings.count = (uint32_t)strings.bytes.size();
+	image.insert(image.end(), strings.bytes.begin(), strings.bytes.end());
+	header.fileSize = (uint32_t)image.size();
+	memcpy(image.data(), &header, sizeof(header));
+
+	// the words keep the records aligned
+	m_compiled.resize(image.size() / sizeof(uint32_t));
+	memcpy(m_compiled.data(), image.data(), image.size());
+	if (!Validate(m_compiled.data(), image.size(), filename))
+	{
+		return false;
+	}
+
+	m_pHeader = (const SCENE_HEADER*)m_compiled.data();
+	return true;
+}
+
+/***********************************************************
+ *  Validate()
+ *
+ *  This method is used to check a compiled scene before it
+ *  is used, so that a damaged file or one of another version
+ *  cannot make the records point outside of it.
+ ***********************************************************/
+bool SceneFile::Validate(const void* pData, size_t size, const char* filename)
+{
+	const SCENE_HEADER* pHeader = (const SCENE_HEADER*)pData;
+	bool bValid = (size >= sizeof(SCENE_HEADER)) &&
+		(memcmp(pHeader->magic, g_SceneMagic, sizeof(g_SceneMagic)) == 0) &&
+		(pHeader->version == VERSION) &&
+		(pHeader->fileSize == size);
+	if (!bValid)
+	{
+		printf("%s is not a compiled scene of version %u\n", filename, VERSION);
+		return false;
+	}
+
+	// every section is word aligned and inside the file
+	const SECTION* sections[] = { &pHeader->textures, &pHeader->meshes, &pHeader->materials, &pHeader->lights, &pHeader->objects, &pHeader->strings };
+	const size_t recordSizes[] = { sizeof(TEXTURE_RECORD), sizeof(MESH_RECORD), sizeof(MATERIAL_RECORD), sizeof(LIGHT_RECORD), sizeof(OBJECT_RECORD), 1 };
+	for (int i = 0; bValid && (i < 6); i++)
+	{
+		bValid = ((sections[i]->offset % sizeof(uint32_t)) == 0) &&
+			(sections[i]->offset <= size) &&
+			(sections[i]->count <= (size - sections[i]->offset) / recordSizes[i]);
+	}
+
+	// the string table ends with the end of a string, so every
+	// offset into it is the start of a terminated one
+	const char* pStrings = (const char*)pData + pHeader->strings.offset;
+	uint32_t stringBytes = pHeader->strings.count;
+	bValid = bValid && (stringBytes > 0) && (pStrings[stringBytes - 1] == '\0');
+
+	const TEXTURE_RECORD* pTextures = (const TEXTURE_RECORD*)((const char*)pData + pHeader->textures.offset);
+	for (uint32_t i = 0; bValid && (i < pHeader->textures.count); i++)
+	{
+		bValid = (pTextures[i].tag < stringBytes) && (pTextures[i].filename < stringBytes);
+	}
+
+	const MESH_RECORD* pMeshes = (const MESH_RECORD*)((const char*)pData + pHeader->meshes.offset);
+	for (uint32_t i = 0; bValid && (i < pHeader->meshes.count); i++)
+	{
+		bValid = (pMeshes[i].tag < stringBytes) && (pMeshes[i].filename < stringBytes);
+	}
+
+	const MATERIAL_RECORD* pMaterials = (const MATERIAL_RECORD*)((const char*)pData + pHeader->materials.offset);
+	for (uint32_t i = 0; bValid && (i < pHeader->materials.count); i++)
+	{
+		bValid = (pMaterials[i].tag < stringBytes);
+	}
+
+	const OBJECT_RECORD* pObjects = (const OBJECT_RECORD*)((const char*)pData + pHeader->objects.offset);
+	for (uint32_t i = 0; bValid && (i < pHeader->objects.count); i++)
+	{
+		const OBJECT_RECORD& object = pObjects[i];
+		bValid = (object.name < stringBytes) &&
+			(object.mesh >= MESH_GROUP) && (object.mesh < SceneManager::MESH_IMPORTED + (int32_t)pHeader->meshes.count) &&
+			(object.parent >= NO_INDEX) && (object.parent < (int32_t)i) &&
+			(object.texture >= NO_INDEX) && (object.texture < (int32_t)pHeader->textures.count) &&
+			(object.material >= NO_INDEX) && (object.material < (int32_t)pHeader->materials.count);
+	}
+
+	if (!bValid)
+	{
+		printf("The compiled scene %s is damaged\n", filename);
+	}
+	return bValid;
+}
+
+/***********************************************************
+ *  SaveCompiled()
+ *
+ *  This method is used to write the loaded scene as it is
+ *  in memory, which is its compiled form.
+ ***********************************************************/
+bool SceneFile::SaveCompiled(const char* filename) const
+{
+	if (NULL == m_pHeader)
+	{
+		printf("No scene was loaded\n");
+		return false;
+	}
+
+	FILE* file = fopen(filename, "wb");
+	bool bWritten = (NULL != file) && (fwrite(m_pHeader, 1, m_pHeader->fileSize, file) == m_pHeader->fileSize);
+	if (NULL != file)
+	{
+		bWritten = (fclose(file) == 0) && bWritten;
+	}
+	if (!bWritten)
+	{
+		printf("Unable to write scene %s\n", filename);
+		return false;
+	}
+
+	printf("INFO: Compiled %u objects, %u textures, %u meshes, %u materials and %u lights into %s, %u bytes\n",
+		GetObjectCount(), GetTextureCount(), GetMeshCount(), GetMaterialCount(), GetLightCount(), filename, m_pHeader->fileSize);
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to free the loaded scene, after
+ *  which none of its records can be used.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	if (NULL != m_pMapping)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_pMapping);
+#else
+		munmap(m_pMapping, m_mappingSize);
+#endif
+	}
+	m_pMapping = NULL;
+	m_mappingSize = 0;
+	m_compiled.clear();
+	m_pHeader = NULL;
+	m_directory.clear();
+}
+
+/***********************************************************
+ *  GetTextures()
+ *
+ *  This method is used to get the texture records, which
+ *  are read in place.
+ ***********************************************************/
+const SceneFile::TEXTURE_RECORD* SceneFile::GetTextures() const
+{
+	return (NULL != m_pHeader) ? (const TEXTURE_RECORD*)((const char*)m_pHeader + m_pHeader->textures.offset) : NULL;
+}
+
+/***********************************************************
+ *  GetMeshes()
+ *
+ *  This method is used to get the mesh records, which are
+ *  read in place.
+ ***********************************************************/
+const SceneFile::MESH_RECORD* SceneFile::GetMeshes() const
+{
+	return (NULL != m_pHeader) ? (const MESH_RECORD*)((const char*)m_pHeader + m_pHeader->meshes.offset) : NULL;
+}
+
+/***********************************************************
+ *  GetMaterials()
+ *
+ *  This method is used to get the material records, which
+ *  are read in place.
+ ***********************************************************/
+const SceneFile::MATERIAL_RECORD* SceneFile::GetMaterials() const
+{
+	return (NULL != m_pHeader) ? (const MATERIAL_RECORD*)((const char*)m_pHeader + m_pHeader->materials.offset) : NULL;
+}
+
+/***********************************************************
+ *  GetLights()
+ *
+ *  This method is used to get the light records, which are
+ *  read in place.
+ ***********************************************************/
+const SceneFile::LIGHT_RECORD* SceneFile::GetLights() const
+{
+	return (NULL != m_pHeader) ? (const LIGHT_RECORD*)((const char*)m_pHeader + m_pHeader->lights.offset) : NULL;
+}
+
+/***********************************************************
+ *  GetObjects()
+ *
+ *  This method is used to get the object records, which
+ *  are read in place.
+ ***********************************************************/
+const SceneFile::OBJECT_RECORD* SceneFile::GetObjects() const
+{
+	return (NULL != m_pHeader) ? (const OBJECT_RECORD*)((const char*)m_pHeader + m_pHeader->objects.offset) : NULL;
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used to get a string of a record from
+ *  the string table.
+ ***********************************************************/
+const char* SceneFile::GetString(uint32_t offset) const
+{
+	return (NULL != m_pHeader) ? ((const char*)m_pHeader + m_pHeader->strings.offset + offset) : "";
+}
+
+/***********************************************************
+ *  GetFilePath()
+ *
+ *  This method is used to get the path of a file named in
+ *  the scene.  A relative path is relative to the scene
+ *  file, so the scene can be moved with its files.
+ ***********************************************************/
+std::string SceneFile::GetFilePath(uint32_t offset) const
+{
+	std::string path(GetString(offset));
+	bool bAbsolute = !path.empty() && ((path[0] == '/') || (path[0] == '\\') || ((path.size() > 1) && (path[1] == ':')));
+	return bAbsolute ? path : (m_directory + path);
+}
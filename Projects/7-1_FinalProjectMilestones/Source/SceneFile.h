@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// load the textures, materials, lights and objects of a scene from a text
+// scene description, or from its compiled form mapped into memory
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class contains the code for the scene files.  A
+ *  scene is written as text, in a subset of TOML:
+ *
+ *  - [lights] sets the radius and height of the lights
+ *  - every [[texture]] gives an image file and its tag
+ *  - every [[mesh]] gives an OBJ, glTF or compiled mesh
+ *    file and its tag, which objects draw like the names
+ *    of the basic meshes
+ *  - every [[material]] gives the lighting of a surface
+ *  - every [[light]] is placed in units of the radius and
+ *    the height, so the lights move with SetLightPlacement
+ *  - every [[object]] draws a mesh, or is a "group" that
+ *    the objects after it can name as their parent, and an
+ *    object with a list of positions is drawn at each one
+ *
+ *  Values that are left out are zero, except the scale,
+ *  color and UV scale of an object, which are one.
+ *
+ *  The text is compiled into the binary form, which is the
+ *  same records in fixed size arrays and a string table,
+ *  all found by their offsets from the start of the file.
+ *  A compiled file holds no pointers, so it is mapped into
+ *  memory as it is and read in place, and a text file is
+ *  compiled into memory when it is loaded.  Either way the
+ *  records are checked once, and used without copying.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// the version of the record layout of a compiled scene
+	static const uint32_t VERSION = 2;
+	// the mesh of a group object, which draws nothing
+	static const int32_t MESH_GROUP = -1;
+	// the parent, texture or material of an object without one
+	static const int32_t NO_INDEX = -1;
+
+	// a part of the file, counted in records or bytes
+	struct SECTION
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	// the start of a compiled scene
+	struct SCENE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t fileSize;
+		float lightRadius;
+		float lightHeight;
+		SECTION textures;
+		SECTION meshes;
+		SECTION materials;
+		SECTION lights;
+		SECTION objects;
+		SECTION strings;
+	};
+
+	// the strings are offsets into the string table
+	struct TEXTURE_RECORD
+	{
+		uint32_t tag;
+		uint32_t filename;		// relative to the scene file
+	};
+
+	struct MESH_RECORD
+	{
+		uint32_t tag;
+		uint32_t filename;		// relative to the scene file
+	};
+
+	struct MATERIAL_RECORD
+	{
+		uint32_t tag;
+		float ambientStrength;
+		float ambientColor[3];
+		float diffuseColor[3];
+		float specularColor[3];
+		float shininess;
+	};
+
+	struct LIGHT_RECORD
+	{
+		// multiplied by the light radius for X and Z, and by
+		// the light height for Y
+		float placement[3];
+		float ambientColor[3];
+		float diffuseColor[3];
+		float specularColor[3];
+		float specularIntensity;
+		float focalStrength;
+	};
+
+	// the objects come after their parents
+	struct OBJECT_RECORD
+	{
+		uint32_t name;
+		int32_t mesh;			// SceneManager::MESH_TYPE, MESH_IMPORTED and up for
+								// the meshes of the scene, or MESH_GROUP
+		int32_t parent;			// object index, or NO_INDEX
+		int32_t texture;		// texture index, or NO_INDEX for the color
+		int32_t material;		// material index, or NO_INDEX
+		float scale[3];
+		float rotationDegrees[3];
+		float position[3];
+		float color[4];
+		float UVscale[2];
+	};
+
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+	// load a text or a compiled scene, told apart by the
+	// first bytes of the file
+	bool Load(const char* filename);
+	// write the loaded scene in its compiled form
+	bool SaveCompiled(const char* filename) const;
+	// free the loaded scene
+	void Close();
+
+	// the records of the loaded scene
+	const SCENE_HEADER* GetHeader() const { return m_pHeader; }
+	const TEXTURE_RECORD* GetTextures() const;
+	const MESH_RECORD* GetMeshes() const;
+	const MATERIAL_RECORD* GetMaterials() const;
+	const LIGHT_RECORD* GetLights() const;
+	const OBJECT_RECORD* GetObjects() const;
+	uint32_t GetTextureCount() const { return (NULL != m_pHeader) ? m_pHeader->textures.count : 0; }
+	uint32_t GetMeshCount() const { return (NULL != m_pHeader) ? m_pHeader->meshes.count : 0; }
+	uint32_t GetMaterialCount() const { return (NULL != m_pHeader) ? m_pHeader->materials.count : 0; }
+	uint32_t GetLightCount() const { return (NULL != m_pHeader) ? m_pHeader->lights.count : 0; }
+	uint32_t GetObjectCount() const { return (NULL != m_pHeader) ? m_pHeader->objects.count : 0; }
+	// a string of a record
+	const char* GetString(uint32_t offset) const;
+	// a file named in the scene, as a path from the working
+	// directory instead of from the scene file
+	std::string GetFilePath(uint32_t offset) const;
+
+private:
+	// the loaded scene, either mapped from a compiled file or
+	// compiled into m_compiled from a text file
+	const SCENE_HEADER* m_pHeader;
+	std::vector<uint32_t> m_compiled;
+	// the mapping of a compiled file, or NULL
+	void* m_pMapping;
+	size_t m_mappingSize;
+	// the directory of the scene file, with the separator
+	std::string m_directory;
+
+	// map a compiled scene into memory
+	bool MapCompiled(const char* filename);
+	// compile a text scene into m_compiled
+	bool CompileText(const char* filename, const std::string& text);
+	// check that the sections, strings and indices of a scene
+	// are inside the file, before anything reads them
+	static bool Validate(const void* pData, size_t size, const char* filename);
+};
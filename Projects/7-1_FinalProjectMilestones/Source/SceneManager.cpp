@@ -8,22 +8,42 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "FrameProfiler.h"
+#include "LightmapBaker.h"
+#include "ShadowMapper.h"
+#include "SceneFile.h"
+#include "MeshImporter.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #endif
 
-#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+// the cylinders and the plane reach furthest from the origin, at the
+// square root of two
+const float SceneManager::MESH_BOUNDING_RADIUS = 1.5f;
+const int SceneManager::LIGHTMAP_TEXTURE_UNIT;
 
 // declaration of global variables
 namespace
 {
 	const char* g_ModelName = "model";
+	const char* g_ModelViewProjectionName = "modelViewProjection";
+	const char* g_NormalMatrixName = "normalMatrix";
 	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_UseLightmapName = "bUseLightmap";
+	const char* g_LightmapTextureName = "lightmapTexture";
+
+	// draw commands handled by one job of the draw list update
+	const int g_DrawListGrainSize = 64;
 }
 
 /***********************************************************
@@ -35,6 +55,42 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
 	m_basicMeshes = new ShapeMeshes();
+	m_pJobSystem = NULL;
+	m_bOpenGLEnabled = true;
+	m_loadedTextures = 0;
+	m_viewProjection = glm::mat4(1.0f);
+	m_lightRadius = 12.0f;
+	m_lightHeight = 6.0f;
+	m_sceneVersion = 0;
+	m_pRecordingList = NULL;
+	m_lightmapTexture = 0;
+	m_lightmapRadius = 0.0f;
+	m_lightmapHeight = 0.0f;
+	m_pShadowMapper = NULL;
+	m_pSceneFile = NULL;
+	m_pAssetManager = NULL;
+	AssetManager::GetDefaultBudget(m_streamingBudget);
+	m_bStreamingEnabled = false;
+	m_nextTransform = 0;
+
+	// the shader defaults for the first draw command
+	m_nextCommand.mesh = MESH_BOX;
+	m_nextCommand.scale = glm::vec3(1.0f);
+	m_nextCommand.rotationDegrees = glm::vec3(0.0f);
+	m_nextCommand.position = glm::vec3(0.0f);
+	m_nextCommand.transform = -1;
+	m_nextCommand.model = glm::mat4(1.0f);
+	m_nextCommand.modelViewProjection = glm::mat4(1.0f);
+	m_nextCommand.normalMatrix = glm::mat3(1.0f);
+	m_nextCommand.radius = MESH_BOUNDING_RADIUS;
+	m_nextCommand.bUseTexture = false;
+	m_nextCommand.textureSlot = 0;
+	m_nextCommand.color = glm::vec4(1.0f);
+	m_nextCommand.UVscale = glm::vec2(1.0f, 1.0f);
+	m_nextCommand.material = -1;
+	m_nextCommand.bVisible = true;
+	m_nextCommand.lightmap = -1;
+	m_nextCommand.sortKey = 0;
 }
 
 /***********************************************************
@@ -44,9 +100,31 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
  ***********************************************************/
 SceneManager::~SceneManager()
 {
+	delete m_pShadowMapper;
+	m_pShadowMapper = NULL;
+	// the objects release their streamed assets before the
+	// scene file that lists them goes
+	ReferenceSceneAssets(false);
+	delete m_pSceneFile;
+	m_pSceneFile = NULL;
 	m_pShaderManager = NULL;
+	// the streamed meshes are unloaded from the pool of the
+	// basic meshes, so it goes first
+	delete m_pAssetManager;
+	m_pAssetManager = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	if (m_bOpenGLEnabled)
+	{
+		DestroyGLTextures();
+	}
+
+	for (size_t i = 0; i < m_textureImages.size(); i++)
+	{
+		stbi_image_free(m_textureImages[i]->pixels);
+		delete m_textureImages[i];
+	}
+	m_textureImages.clear();
 }
 
 /***********************************************************
@@ -59,59 +137,165 @@ SceneManager::~SceneManager()
  ***********************************************************/
 bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
+	TRACE_SCOPE("CreateGLTexture", filename);
+
+	TEXTURE_IMAGE image;
+	image.filename = filename;
+	image.tag = tag;
 
 	// indicate to always flip images vertically when loaded
 	stbi_set_flip_vertically_on_load(true);
 
+	DecodeTextureImage(&image);
+	return(UploadGLTexture(&image));
+}
+
+/***********************************************************
+ *  QueueGLTexture()
+ *
+ *  This method is used for decoding a texture image file
+ *  on the job system.  The OpenGL texture is created by
+ *  FinishGLTextures(), on the thread of the context.
+ ***********************************************************/
+void SceneManager::QueueGLTexture(const char* filename, std::string tag)
+{
+	TEXTURE_IMAGE* image = new TEXTURE_IMAGE();
+	image->filename = filename;
+	image->tag = tag;
+	image->pixels = NULL;
+	m_pendingTextures.push_back(image);
+
+	// indicate to always flip images vertically when loaded - the
+	// setting is shared by the decoding jobs, so it is made here
+	stbi_set_flip_vertically_on_load(true);
+
+	if (NULL == m_pJobSystem)
+	{
+		DecodeTextureImage(image);
+		return;
+	}
+	m_pJobSystem->Run([image]() { DecodeTextureImage(image); }, &m_textureJobs);
+}
+
+/***********************************************************
+ *  FinishGLTextures()
+ *
+ *  This method is used for waiting for the queued texture
+ *  images and creating their OpenGL textures, in the order
+ *  they were queued so that every run gets the same slots.
+ ***********************************************************/
+void SceneManager::FinishGLTextures()
+{
+	TRACE_SCOPE("FinishGLTextures");
+
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->Wait(&m_textureJobs);
+	}
+
+	for (size_t i = 0; i < m_pendingTextures.size(); i++)
+	{
+		if (m_bOpenGLEnabled)
+		{
+			UploadGLTexture(m_pendingTextures[i]);
+			delete m_pendingTextures[i];
+		}
+		else if (KeepTextureImage(m_pendingTextures[i]) == false)
+		{
+			delete m_pendingTextures[i];
+		}
+	}
+	m_pendingTextures.clear();
+}
+
+/***********************************************************
+ *  KeepTextureImage()
+ *
+ *  This method is used for keeping a decoded image in
+ *  memory, in place of an OpenGL texture, and registering
+ *  it in the next available texture slot.  The image is
+ *  owned by the scene manager once this returns true.
+ ***********************************************************/
+bool SceneManager::KeepTextureImage(TEXTURE_IMAGE* image)
+{
+	if ((NULL == image->pixels) || ((image->colorChannels != 3) && (image->colorChannels != 4)))
+	{
+		std::cout << "Could not load image:" << image->filename << std::endl;
+		stbi_image_free(image->pixels);
+		image->pixels = NULL;
+		return false;
+	}
+
+	std::cout << "Successfully loaded image:" << image->filename << ", width:" << image->width << ", height:" << image->height << ", channels:" << image->colorChannels << std::endl;
+
+	m_textureIDs[m_loadedTextures].ID = 0;
+	m_textureIDs[m_loadedTextures].tag = image->tag;
+	m_loadedTextures++;
+	m_textureImages.push_back(image);
+
+	return true;
+}
+
+/***********************************************************
+ *  DecodeTextureImage()
+ *
+ *  This method is used for reading the pixels of a texture
+ *  image file.  It makes no OpenGL calls, so it can run on
+ *  any thread.
+ ***********************************************************/
+void SceneManager::DecodeTextureImage(TEXTURE_IMAGE* image)
+{
+	TRACE_SCOPE("DecodeTextureImage", image->filename.c_str());
+
+	image->width = 0;
+	image->height = 0;
+	image->colorChannels = 0;
+
 	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
+	image->pixels = stbi_load(
+		image->filename.c_str(),
+		&image->width,
+		&image->height,
+		&image->colorChannels,
 		0);
+}
+
+/***********************************************************
+ *  UploadGLTexture()
+ *
+ *  This method is used for configuring the texture mapping
+ *  parameters in OpenGL, generating the mipmaps, and loading
+ *  a decoded image into the next available texture slot in
+ *  memory.
+ ***********************************************************/
+bool SceneManager::UploadGLTexture(TEXTURE_IMAGE* image)
+{
+	TRACE_SCOPE("UploadGLTexture", image->filename.c_str());
+
+	const char* filename = image->filename.c_str();
+	int width = image->width;
+	int height = image->height;
+	int colorChannels = image->colorChannels;
+	GLuint textureID = 0;
 
 	// if the image was successfully read from the image file
-	if (image)
+	if (image->pixels)
 	{
 		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
 
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
+		textureID = CreateTextureObject(image);
+
+		// free the image data from local memory
+		stbi_image_free(image->pixels);
+		image->pixels = NULL;
+		if (textureID == 0)
 		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
 			return false;
 		}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-
 		// register the loaded texture and associate it with the special tag string
 		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
+		m_textureIDs[m_loadedTextures].tag = image->tag;
 		m_loadedTextures++;
 
 		return true;
@@ -123,6 +307,46 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	return false;
 }
 
+/***********************************************************
+ *  CreateTextureObject()
+ *
+ *  This method is used for creating the OpenGL texture of a
+ *  decoded image, with its mipmaps, or 0 for an image with
+ *  a number of channels that is not handled.
+ ***********************************************************/
+GLuint SceneManager::CreateTextureObject(const TEXTURE_IMAGE* image)
+{
+	if ((image->colorChannels != 3) && (image->colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << image->colorChannels << " channels" << std::endl;
+		return 0;
+	}
+
+	GLuint textureID = 0;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// if the loaded image is in RGB format
+	if (image->colorChannels == 3)
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, image->width, image->height, 0, GL_RGB, GL_UNSIGNED_BYTE, image->pixels);
+	// if the loaded image is in RGBA format - it supports transparency
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image->width, image->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image->pixels);
+
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+
+	return textureID;
+}
+
 /***********************************************************
  *  BindGLTextures()
  *
@@ -131,6 +355,11 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
+	if (!m_bOpenGLEnabled)
+	{
+		return;
+	}
+
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
 		// bind textures on corresponding texture units
@@ -149,8 +378,10 @@ void SceneManager::DestroyGLTextures()
 {
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		glDeleteTextures(1, &m_textureIDs[i].ID);
+		m_textureIDs[i].ID = 0;
 	}
+	m_loadedTextures = 0;
 }
 
 /***********************************************************
@@ -241,6 +472,25 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 	return(true); // this was return true not return bFound
 }
 
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of a defined
+ *  material that is associated with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(std::string tag)
+{
+	for (int index = 0; index < (int)m_objectMaterials.size(); index++)
+	{
+		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		{
+			return(index);
+		}
+	}
+
+	return(-1);
+}
+
 /***********************************************************
  *  SetTransformations()
  *
@@ -254,29 +504,594 @@ void SceneManager::SetTransformations(
 	float ZrotationDegrees,
 	glm::vec3 positionXYZ)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
+	// the values go into the transform node of the next command
+	// when it is recorded, and the matrices are built after the
+	// whole scene is recorded
+	m_nextCommand.scale = scaleXYZ;
+	m_nextCommand.rotationDegrees = glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+	m_nextCommand.position = positionXYZ;
+}
+
+/***********************************************************
+ *  BeginTransformGroup()
+ *
+ *  This method is used for starting a group of commands
+ *  that move together, like the parts of one object.  The
+ *  transformation values set before it place the group,
+ *  and the ones of the commands in the group place them
+ *  relative to it.  Groups can be nested.
+ ***********************************************************/
+void SceneManager::BeginTransformGroup()
+{
+	if (NULL != m_pRecordingList)
+	{
+		int parent = m_transformGroups.empty() ? TransformHierarchy::NO_PARENT : m_transformGroups.back();
+		m_transformGroups.push_back(RecordTransform(parent));
+	}
+}
+
+/***********************************************************
+ *  EndTransformGroup()
+ *
+ *  This method is used for ending the last group that was
+ *  started, the following commands are placed relative to
+ *  the group around it again.
+ ***********************************************************/
+void SceneManager::EndTransformGroup()
+{
+	if (!m_transformGroups.empty())
+	{
+		m_transformGroups.pop_back();
+	}
+}
+
+/***********************************************************
+ *  RecordTransform()
+ *
+ *  This method is used for getting the transform node of
+ *  the next command or group, with the transformation
+ *  values set last.  The scene records the same nodes in
+ *  every frame, so a node is only added the first time,
+ *  and the angles are only converted when they change.
+ ***********************************************************/
+int SceneManager::RecordTransform(int parent)
+{
+	int node = m_nextTransform++;
+	if (node == m_transforms.GetNodeCount())
+	{
+		m_transforms.AddNode(parent);
+	}
+	else
+	{
+		m_transforms.SetParent(node, parent);
+	}
+
+	m_transforms.SetEulerTransform(node, m_nextCommand.scale, m_nextCommand.rotationDegrees, m_nextCommand.position);
+	return(node);
+}
+
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for setting the combined view and
+ *  projection matrix of the current frame, which is used
+ *  for calculating the model-view-projection matrices.
+ ***********************************************************/
+void SceneManager::SetViewProjection(const glm::mat4& viewProjection)
+{
+	m_viewProjection = viewProjection;
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used for setting the job system that the
+ *  draw list update and the texture decoding are spread
+ *  over.  The pool must outlive the scene manager.
+ ***********************************************************/
+void SceneManager::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+/***********************************************************
+ *  SetOpenGLEnabled()
+ *
+ *  This method is used to prepare the scene without any
+ *  OpenGL calls.  The meshes and the texture images are
+ *  kept in memory for the software renderer instead.
+ ***********************************************************/
+void SceneManager::SetOpenGLEnabled(bool bEnabled)
+{
+	m_bOpenGLEnabled = bEnabled;
+	m_basicMeshes->SetUploadEnabled(bEnabled);
+}
+
+/***********************************************************
+ *  EnableStreaming()
+ *
+ *  This method is used to have the textures and imported
+ *  meshes of the scene loaded by an asset manager as the
+ *  draws use them, within a memory budget, instead of all
+ *  of them being loaded by PrepareScene().
+ ***********************************************************/
+void SceneManager::EnableStreaming(const AssetManager::BUDGET& budget)
+{
+	m_streamingBudget = budget;
+	m_bStreamingEnabled = true;
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used to load the scene description that
+ *  PrepareScene() and BuildDrawList() use.  The records are
+ *  kept where the file was loaded or mapped, and are read
+ *  from there for every frame.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(const char* filename)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	SceneFile* pSceneFile = new SceneFile();
+	if (pSceneFile->Load(filename) == false)
+	{
+		delete pSceneFile;
+		return false;
+	}
+
+	// the scene textures have to stay below the lightmap unit,
+	// unless they are streamed and bound by the draws
+	if ((!m_bStreamingEnabled && (pSceneFile->GetTextureCount() > (uint32_t)LIGHTMAP_TEXTURE_UNIT)) ||
+		(pSceneFile->GetLightCount() > (uint32_t)FrameUniformBuffer::TOTAL_LIGHTS))
+	{
+		std::cout << "The scene " << filename << " has more than " << LIGHTMAP_TEXTURE_UNIT << " textures or "
+			<< FrameUniformBuffer::TOTAL_LIGHTS << " lights" << std::endl;
+		delete pSceneFile;
+		return false;
+	}
+
+	// the objects of a replaced scene no longer hold their
+	// streamed assets, which are freed at the end of the frame
+	ReferenceSceneAssets(false);
+	m_textureAssets.clear();
+	m_meshAssets.clear();
+	delete m_pSceneFile;
+	m_pSceneFile = pSceneFile;
+	m_lightRadius = m_pSceneFile->GetHeader()->lightRadius;
+	m_lightHeight = m_pSceneFile->GetHeader()->lightHeight;
+
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Successfully loaded scene:" << filename << ", objects:" << m_pSceneFile->GetObjectCount()
+		<< ", time:" << milliseconds << " ms" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  GetMeshTriangles()
+ *
+ *  This method is used to get the triangles that drawing
+ *  a mesh type submits, in the order they are drawn.
+ ***********************************************************/
+void SceneManager::GetMeshTriangles(MESH_TYPE mesh, std::vector<ShapeMeshes::MESH_VERTEX>& triangles)
+{
+	triangles.clear();
+	m_basicMeshes->CaptureTriangles(&triangles);
+	DrawMeshType(mesh);
+	m_basicMeshes->CaptureTriangles(NULL);
+}
+
+/***********************************************************
+ *  GetMeshBoundingRadius()
+ *
+ *  This method is used to get the radius of a sphere around
+ *  the origin that holds a mesh at a scale of one.
+ ***********************************************************/
+float SceneManager::GetMeshBoundingRadius(MESH_TYPE mesh) const
+{
+	int imported = mesh - MESH_IMPORTED;
+	if ((imported >= 0) && (imported < (int)m_importedRadii.size()))
+	{
+		return m_importedRadii[imported];
+	}
+	return MESH_BOUNDING_RADIUS;
+}
+
+/***********************************************************
+ *  LoadBasicMeshes()
+ *
+ *  This method is used to load the basic meshes that the
+ *  objects of the scene file draw, so that every mesh name
+ *  the scene file accepts has its mesh in memory.  The half
+ *  sphere and half torus draw part of the full meshes.
+ ***********************************************************/
+void SceneManager::LoadBasicMeshes()
+{
+	bool bMeshUsed[MESH_IMPORTED];
+	for (int mesh = 0; mesh < MESH_IMPORTED; mesh++)
+	{
+		bMeshUsed[mesh] = (NULL == m_pSceneFile);
+	}
+	const SceneFile::OBJECT_RECORD* objects = (NULL != m_pSceneFile) ? m_pSceneFile->GetObjects() : NULL;
+	for (uint32_t i = 0; (NULL != m_pSceneFile) && (i < m_pSceneFile->GetObjectCount()); i++)
+	{
+		if ((objects[i].mesh >= 0) && (objects[i].mesh < MESH_IMPORTED))
+		{
+			bMeshUsed[objects[i].mesh] = true;
+		}
+	}
+
+	if (bMeshUsed[MESH_BOX])
+	{
+		m_basicMeshes->LoadBoxMesh();
+	}
+	if (bMeshUsed[MESH_PLANE])
+	{
+		m_basicMeshes->LoadPlaneMesh();
+	}
+	if (bMeshUsed[MESH_CYLINDER])
+	{
+		m_basicMeshes->LoadCylinderMesh();
+	}
+	if (bMeshUsed[MESH_CONE])
+	{
+		m_basicMeshes->LoadConeMesh();
+	}
+	if (bMeshUsed[MESH_PRISM])
+	{
+		m_basicMeshes->LoadPrismMesh();
+	}
+	if (bMeshUsed[MESH_PYRAMID3])
+	{
+		m_basicMeshes->LoadPyramid3Mesh();
+	}
+	if (bMeshUsed[MESH_PYRAMID4])
+	{
+		m_basicMeshes->LoadPyramid4Mesh();
+	}
+	if (bMeshUsed[MESH_SPHERE] || bMeshUsed[MESH_HALF_SPHERE])
+	{
+		m_basicMeshes->LoadSphereMesh();
+	}
+	if (bMeshUsed[MESH_TAPERED_CYLINDER])
+	{
+		m_basicMeshes->LoadTaperedCylinderMesh();
+	}
+	if (bMeshUsed[MESH_TORUS] || bMeshUsed[MESH_HALF_TORUS])
+	{
+		m_basicMeshes->LoadTorusMesh();
+	}
+}
+
+/***********************************************************
+ *  ReferenceSceneAssets()
+ *
+ *  This method is used to count the objects of the scene
+ *  file as references to the streamed textures and meshes
+ *  they draw with, or to release those references when the
+ *  objects go away.  An asset that no object references is
+ *  freed at the end of the frame.
+ ***********************************************************/
+void SceneManager::ReferenceSceneAssets(bool bReference)
+{
+	if ((NULL == m_pAssetManager) || (NULL == m_pSceneFile))
+	{
+		return;
+	}
+
+	const SceneFile::OBJECT_RECORD* objects = m_pSceneFile->GetObjects();
+	for (uint32_t i = 0; i < m_pSceneFile->GetObjectCount(); i++)
+	{
+		if (objects[i].mesh == SceneFile::MESH_GROUP)
+		{
+			continue;
+		}
+
+		// an object references its texture and its imported mesh
+		int assets[2] = { -1, -1 };
+		if ((objects[i].texture >= 0) && (objects[i].texture < (int)m_textureAssets.size()))
+		{
+			assets[0] = m_textureAssets[objects[i].texture];
+		}
+		int imported = objects[i].mesh - MESH_IMPORTED;
+		if ((imported >= 0) && (imported < (int)m_meshAssets.size()))
+		{
+			assets[1] = m_meshAssets[imported];
+		}
+
+		for (int j = 0; j < 2; j++)
+		{
+			if (bReference)
+			{
+				m_pAssetManager->AddReference(assets[j]);
+			}
+			else
+			{
+				m_pAssetManager->ReleaseReference(assets[j]);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  LoadSceneMeshes()
+ *
+ *  This method is used to import the meshes named by the
+ *  scene file.  Each file is read by its own job, and the
+ *  meshes are added in the order of the scene so that the
+ *  objects find them by index.  A mesh that cannot be read
+ *  is added empty, and its objects draw nothing.  While
+ *  streaming, only the boxes around the meshes are read and
+ *  the meshes are reserved in the pool, to be loaded by the
+ *  asset manager when they are drawn.
+ ***********************************************************/
+void SceneManager::LoadSceneMeshes()
+{
+	TRACE_SCOPE("LoadSceneMeshes");
+
+	uint32_t meshCount = (NULL != m_pSceneFile) ? m_pSceneFile->GetMeshCount() : 0;
+	std::vector<MeshImporter::IMPORTED_MESH> meshes(meshCount);
+	std::vector<std::string> filenames(meshCount);
+	bool bStreaming = (NULL != m_pAssetManager);
+	for (uint32_t i = 0; i < meshCount; i++)
+	{
+		filenames[i] = m_pSceneFile->GetFilePath(m_pSceneFile->GetMeshes()[i].filename);
+	}
+
+	JobSystem::JOB_COUNTER meshJobs;
+	for (uint32_t i = 0; i < meshCount; i++)
+	{
+		MeshImporter::IMPORTED_MESH* pMesh = &meshes[i];
+		const char* filename = filenames[i].c_str();
+		std::function<void()> load = [pMesh, filename, bStreaming]()
+		{
+			pMesh->boundsMin = glm::vec3(0.0f);
+			pMesh->boundsMax = glm::vec3(0.0f);
+			if (bStreaming)
+			{
+				MeshImporter::ReadBounds(filename, pMesh->boundsMin, pMesh->boundsMax);
+			}
+			else
+			{
+				MeshImporter::Load(filename, *pMesh);
+			}
+		};
+		if (NULL == m_pJobSystem)
+		{
+			load();
+		}
+		else
+		{
+			m_pJobSystem->Run(load, &meshJobs);
+		}
+	}
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->Wait(&meshJobs);
+	}
+
+	// the radius reaches the farthest corner of the box, so a
+	// streamed mesh is culled the same as a loaded one
+	m_importedRadii.clear();
+	m_meshAssets.clear();
+	for (uint32_t i = 0; i < meshCount; i++)
+	{
+		const MeshImporter::IMPORTED_MESH& mesh = meshes[i];
+		if (bStreaming)
+		{
+			m_meshAssets.push_back(m_pAssetManager->AddMesh(filenames[i], m_basicMeshes->ReserveImportedMesh()));
+		}
+		else
+		{
+			m_basicMeshes->AddImportedMesh(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+		}
+		m_importedRadii.push_back(glm::length(glm::max(glm::abs(mesh.boundsMin), glm::abs(mesh.boundsMax))));
+	}
+	if ((meshCount > 0) && !bStreaming)
+	{
+		m_basicMeshes->UploadImportedMeshes();
+	}
+}
+
+/***********************************************************
+ *  GetTextureImage()
+ *
+ *  This method is used to get the image of a texture slot,
+ *  which is only kept without OpenGL.
+ ***********************************************************/
+const SceneManager::TEXTURE_IMAGE* SceneManager::GetTextureImage(int slot) const
+{
+	if ((slot < 0) || (slot >= (int)m_textureImages.size()))
+	{
+		return NULL;
+	}
+	return m_textureImages[slot];
+}
+
+/***********************************************************
+ *  GetMaterial()
+ *
+ *  This method is used to get a defined material by the
+ *  index that the draw commands store.
+ ***********************************************************/
+const SceneManager::OBJECT_MATERIAL* SceneManager::GetMaterial(int index) const
+{
+	if ((index < 0) || (index >= (int)m_objectMaterials.size()))
+	{
+		return NULL;
+	}
+	return &m_objectMaterials[index];
+}
+
+/***********************************************************
+ *  LoadLightmaps()
+ *
+ *  This method is used to load a baked lightmap and build
+ *  the lightmapped mesh from it.  Every command of the
+ *  scene is matched to the instance baked in its place,
+ *  and one that moved or changed its mesh since the bake
+ *  keeps the dynamic lighting.
+ ***********************************************************/
+bool SceneManager::LoadLightmaps(const char* name)
+{
+	TRACE_SCOPE("LoadLightmaps", name);
+
+	if (!m_bOpenGLEnabled)
+	{
+		return false;
+	}
+
+	LightmapBaker::LIGHTMAP_LAYOUT layout;
+	std::string layoutFilename = std::string(name) + ".layout";
+	if (LightmapBaker::LoadLayout(layoutFilename.c_str(), layout) == false)
+	{
+		return false;
+	}
+
+	TEXTURE_IMAGE image;
+	image.filename = std::string(name) + ".png";
+	stbi_set_flip_vertically_on_load(true);
+	DecodeTextureImage(&image);
+	if ((NULL == image.pixels) || (image.width != layout.width) || (image.height != layout.height) ||
+		((image.colorChannels != 3) && (image.colorChannels != 4)))
+	{
+		std::cout << "Could not load lightmap:" << image.filename << std::endl;
+		stbi_image_free(image.pixels);
+		return false;
+	}
+
+	// the ranges are cleared first, so the list is built without them
+	m_lightmapRanges.clear();
+	DRAW_LIST drawList;
+	BuildDrawList(drawList);
+
+	std::vector<std::vector<ShapeMeshes::MESH_VERTEX> > meshTriangles(GetMeshCount());
+	std::vector<ShapeMeshes::LIGHTMAP_VERTEX> vertices;
+	std::vector<glm::vec2> coordinates;
+	int matchedCount = 0;
+	for (size_t i = 0; i < drawList.commands.size(); i++)
+	{
+		const DRAW_COMMAND& command = drawList.commands[i];
+		LIGHTMAP_RANGE range = { 0, 0 };
+		if (i < layout.instances.size())
+		{
+			const LightmapBaker::LIGHTMAP_INSTANCE& instance = layout.instances[i];
+			if (meshTriangles[command.mesh].empty())
+			{
+				GetMeshTriangles(command.mesh, meshTriangles[command.mesh]);
+			}
+			const std::vector<ShapeMeshes::MESH_VERTEX>& triangles = meshTriangles[command.mesh];
+
+			if ((instance.mesh == command.mesh) && (instance.cells.size() * 3 == triangles.size()) &&
+				(instance.scale == command.scale) && (instance.rotationDegrees == command.rotationDegrees) &&
+				(instance.position == command.position))
+			{
+				LightmapBaker::GetLightmapCoordinates(layout, instance, coordinates);
+				range.first = (GLint)vertices.size();
+				range.count = (GLsizei)triangles.size();
+				for (size_t v = 0; v < triangles.size(); v++)
+				{
+					ShapeMeshes::LIGHTMAP_VERTEX vertex;
+					vertex.vertex = triangles[v];
+					vertex.lightmapCoordinate = coordinates[v];
+					vertices.push_back(vertex);
+				}
+				matchedCount++;
+			}
+		}
+		m_lightmapRanges.push_back(range);
+	}
+	m_basicMeshes->LoadLightmappedMesh(vertices);
+
+	if (m_lightmapTexture == 0)
+	{
+		glGenTextures(1, &m_lightmapTexture);
+	}
+	glActiveTexture(GL_TEXTURE0 + LIGHTMAP_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_lightmapTexture);
+
+	// the cells are packed next to each other, so the lightmap
+	// is neither repeated nor mipmapped
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (image.colorChannels == 3)
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.pixels);
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glActiveTexture(GL_TEXTURE0);
+	stbi_image_free(image.pixels);
+
+	m_lightmapRadius = layout.lightRadius;
+	m_lightmapHeight = layout.lightHeight;
+	MarkSceneChanged();
+
+	std::cout << "Successfully loaded lightmap:" << image.filename << ", width:" << image.width << ", height:" << image.height
+		<< ", objects:" << matchedCount << " of " << drawList.commands.size() << std::endl;
+	if (!IsLightmapActive())
+	{
+		std::cout << "INFO: The lights have moved since the lightmap was baked, it is not used" << std::endl;
+	}
+
+	return true;
+}
 
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
+/***********************************************************
+ *  IsLightmapActive()
+ *
+ *  This method is used to find out whether the lightmap is
+ *  used, which needs the lights where it was baked.
+ ***********************************************************/
+bool SceneManager::IsLightmapActive() const
+{
+	return(!m_lightmapRanges.empty() && (m_lightmapRadius == m_lightRadius) && (m_lightmapHeight == m_lightHeight));
+}
 
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+/***********************************************************
+ *  EnableShadows()
+ *
+ *  This method is used to create the shadow maps of the
+ *  lights.  The maps are drawn at the start of every
+ *  submitted draw list, when their light or the objects
+ *  around it changed.
+ ***********************************************************/
+bool SceneManager::EnableShadows(int depthProgram, int mapSize)
+{
+	if (!m_bOpenGLEnabled)
+	{
+		return false;
+	}
 
-	if (NULL != m_pShaderManager)
+	if (NULL == m_pShadowMapper)
+	{
+		m_pShadowMapper = new ShadowMapper(m_pShaderManager);
+	}
+	if (m_pShadowMapper->Create(depthProgram, mapSize) == false)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		delete m_pShadowMapper;
+		m_pShadowMapper = NULL;
+		return false;
 	}
+
+	return true;
+}
+
+/***********************************************************
+ *  SetLightPlacement()
+ *
+ *  This method is used to move the corner lights, which
+ *  takes effect with the next frame.
+ ***********************************************************/
+void SceneManager::SetLightPlacement(float radius, float height)
+{
+	m_lightRadius = radius;
+	m_lightHeight = height;
+	SetupSceneLights();
+	MarkSceneChanged();
 }
 
 /***********************************************************
@@ -299,11 +1114,8 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
+	m_nextCommand.bUseTexture = false;
+	m_nextCommand.color = currentColor;
 }
 
 /***********************************************************
@@ -315,14 +1127,8 @@ void SceneManager::SetShaderColor(
 void SceneManager::SetShaderTexture(
 	std::string textureTag)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
-	}
+	m_nextCommand.bUseTexture = true;
+	m_nextCommand.textureSlot = FindTextureSlot(textureTag);
 }
 
 /***********************************************************
@@ -333,10 +1139,7 @@ void SceneManager::SetShaderTexture(
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
+	m_nextCommand.UVscale = glm::vec2(u, v);
 }
 
 /***********************************************************
@@ -348,20 +1151,304 @@ void SceneManager::SetTextureUVScale(float u, float v)
 void SceneManager::SetShaderMaterial(
 	std::string materialTag)
 {
-	if (m_objectMaterials.size() > 0)
+	// an unknown tag keeps the previous material
+	int material = FindMaterialIndex(materialTag);
+	if (material >= 0)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		m_nextCommand.material = material;
+	}
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for adding a draw command for the
+ *  passed in mesh to the draw list being built, with the
+ *  transformations and shader settings set before it.
+ ***********************************************************/
+void SceneManager::DrawMesh(MESH_TYPE mesh)
+{
+	if (NULL != m_pRecordingList)
+	{
+		m_nextCommand.mesh = mesh;
+		m_nextCommand.transform = RecordTransform(m_transformGroups.empty() ? TransformHierarchy::NO_PARENT : m_transformGroups.back());
+		m_pRecordingList->commands.push_back(m_nextCommand);
+	}
+}
+
+/***********************************************************
+ *  GetFrustumPlanes()
+ *
+ *  This method is used for getting the six planes of the
+ *  view frustum from the rows of a view projection matrix.
+ *  The planes are normalized, so the distance of a point
+ *  to a plane is in world units.
+ ***********************************************************/
+void SceneManager::GetFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		planes[i * 2] = w + row;
+		planes[i * 2 + 1] = w - row;
+	}
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+/***********************************************************
+ *  IsSphereVisible()
+ *
+ *  This method is used for testing a bounding sphere
+ *  against the frustum planes.  A sphere that is fully
+ *  behind one of the planes cannot be seen.
+ ***********************************************************/
+bool SceneManager::IsSphereVisible(const glm::vec4 planes[6], const glm::vec3& center, float radius)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/***********************************************************
+ *  UpdateDrawList()
+ *
+ *  This method is used for getting the matrices of every
+ *  command of a recorded draw list from its transform node,
+ *  culling the commands outside the view frustum and
+ *  ordering the rest by their shader state.  The commands
+ *  are independent, so they are updated in parallel ranges
+ *  on the job system.
+ ***********************************************************/
+void SceneManager::UpdateDrawList(DRAW_LIST& drawList)
+{
+	PROFILE_SCOPE("UpdateDrawList");
+
+	glm::vec4 planes[6];
+	GetFrustumPlanes(m_viewProjection, planes);
+
+	const glm::mat4 viewProjection = m_viewProjection;
+	std::vector<DRAW_COMMAND>& commands = drawList.commands;
+	const TransformHierarchy& transforms = m_transforms;
+	std::function<void(int, int)> update = [this, &commands, &planes, &viewProjection, &transforms](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			DRAW_COMMAND& command = commands[i];
+
+			// the model and normal matrices are cached by the transform
+			// node, only the combined matrix changes with the camera
+			command.model = transforms.GetWorldMatrix(command.transform);
+			command.modelViewProjection = viewProjection * command.model;
+			command.normalMatrix = transforms.GetNormalMatrix(command.transform);
+
+			command.radius = GetMeshBoundingRadius(command.mesh) * transforms.GetWorldScale(command.transform);
+			command.bVisible = IsSphereVisible(planes, glm::vec3(command.model[3]), command.radius);
+
+			// the texture changes the most shader state, then the
+			// material, then the mesh
+			uint32_t texture = command.bUseTexture ? (uint32_t)command.textureSlot : 0xFFu;
+			command.sortKey = ((texture & 0xFFu) << 16) | (((uint32_t)(command.material + 1) & 0xFFu) << 8) | ((uint32_t)command.mesh & 0xFFu);
+		}
+	};
+
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor((int)commands.size(), g_DrawListGrainSize, update);
+	}
+	else
+	{
+		update(0, (int)commands.size());
+	}
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+	// equal keys keep the order they were recorded in
+	drawList.order.clear();
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		if (commands[i].bVisible)
+		{
+			drawList.order.push_back((int)i);
+		}
+	}
+	std::stable_sort(drawList.order.begin(), drawList.order.end(),
+		[&commands](int a, int b) { return commands[a].sortKey < commands[b].sortKey; });
+}
+
+/***********************************************************
+ *  SubmitDrawList()
+ *
+ *  This method is used for setting the shader values of
+ *  each command of a draw list and drawing its mesh.  This
+ *  is the only part of the scene rendering that calls
+ *  OpenGL, so it has to run on the thread of the context.
+ ***********************************************************/
+void SceneManager::SubmitDrawList(const DRAW_LIST& drawList)
+{
+	PROFILE_SCOPE("SubmitDrawList");
+
+	m_basicMeshes->ResetDrawStatistics();
+
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	// the shadow maps that changed are drawn first, their draws
+	// are not counted with the ones of the scene
+	if (NULL != m_pShadowMapper)
+	{
+		m_pShadowMapper->Update(drawList, m_pShaderManager->GetFrameUniforms().GetConstants(),
+			[this](MESH_TYPE mesh) { DrawMeshType(mesh); });
+		m_basicMeshes->ResetDrawStatistics();
+		m_pShadowMapper->SetShaderValues(true);
+	}
+
+	// the streamed texture bound to its unit, the uploads after
+	// the last frame may have changed the binding
+	GLuint streamedTexture = 0;
+
+	for (size_t i = 0; i < drawList.order.size(); i++)
+	{
+		const DRAW_COMMAND& command = drawList.commands[drawList.order[i]];
+
+		// the streamed assets are marked as used by the distance of
+		// the command, and their textures are bound as the commands
+		// use them, sorted so that each is bound once - a texture
+		// that is not loaded yet is left out for the object color
+		int textureUnit = command.textureSlot;
+		if (NULL != m_pAssetManager)
+		{
+			float distance = std::max(command.modelViewProjection[3][3] - command.radius, 0.0f);
+			int imported = command.mesh - MESH_IMPORTED;
+			if ((imported >= 0) && (imported < (int)m_meshAssets.size()))
+			{
+				m_pAssetManager->UseMesh(m_meshAssets[imported], distance);
+			}
+			if (command.bUseTexture)
+			{
+				GLuint textureID = ((command.textureSlot >= 0) && (command.textureSlot < (int)m_textureAssets.size())) ?
+					m_pAssetManager->UseTexture(m_textureAssets[command.textureSlot], distance) : 0;
+				if ((textureID != 0) && (textureID != streamedTexture))
+				{
+					glActiveTexture(GL_TEXTURE0 + STREAMED_TEXTURE_UNIT);
+					glBindTexture(GL_TEXTURE_2D, textureID);
+					glActiveTexture(GL_TEXTURE0);
+					streamedTexture = textureID;
+				}
+				textureUnit = (textureID != 0) ? STREAMED_TEXTURE_UNIT : -1;
+			}
+		}
+
+		// the shader manager filters out the values that did not
+		// change since the previous command
+		m_pShaderManager->setMat4Value(g_ModelName, command.model);
+		m_pShaderManager->setMat4Value(g_ModelViewProjectionName, command.modelViewProjection);
+		m_pShaderManager->setMat3Value(g_NormalMatrixName, command.normalMatrix);
+		m_pShaderManager->setIntValue(g_UseTextureName, command.bUseTexture && (textureUnit >= 0));
+		m_pShaderManager->setBoolValue(g_UseLightmapName, command.lightmap >= 0);
+		if (command.bUseTexture && (textureUnit >= 0))
+		{
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, textureUnit);
+		}
+		else
+		{
+			m_pShaderManager->setVec4Value(g_ColorValueName, command.color);
+		}
+		m_pShaderManager->setVec2Value("UVscale", command.UVscale);
+
+		if (command.material >= 0)
 		{
+			const OBJECT_MATERIAL& material = m_objectMaterials[command.material];
 			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
 			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
 			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
 			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
 			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
 		}
+
+		if (command.lightmap >= 0)
+		{
+			const LIGHTMAP_RANGE& range = m_lightmapRanges[command.lightmap];
+			m_pShaderManager->setSampler2DValue(g_LightmapTextureName, LIGHTMAP_TEXTURE_UNIT);
+			m_basicMeshes->DrawLightmappedMesh(range.first, range.count);
+		}
+		else
+		{
+			DrawMeshType(command.mesh);
+		}
+	}
+
+	// other draws with the program, like the benchmark stress
+	// scenes, have lights without shadow maps or lightmaps
+	if (NULL != m_pShadowMapper)
+	{
+		m_pShadowMapper->SetShaderValues(false);
+	}
+	m_pShaderManager->setBoolValue(g_UseLightmapName, false);
+
+	if (NULL != m_pAssetManager)
+	{
+		m_pAssetManager->EndFrame();
+	}
+}
+
+/***********************************************************
+ *  DrawMeshType()
+ *
+ *  This method is used for drawing the mesh of a draw
+ *  command with the current shader settings.
+ ***********************************************************/
+void SceneManager::DrawMeshType(MESH_TYPE mesh)
+{
+	switch (mesh)
+	{
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CONE:
+		m_basicMeshes->DrawConeMesh();
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_PRISM:
+		m_basicMeshes->DrawPrismMesh();
+		break;
+	case MESH_PYRAMID3:
+		m_basicMeshes->DrawPyramid3Mesh();
+		break;
+	case MESH_PYRAMID4:
+		m_basicMeshes->DrawPyramid4Mesh();
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	case MESH_HALF_SPHERE:
+		m_basicMeshes->DrawHalfSphereMesh();
+		break;
+	case MESH_TAPERED_CYLINDER:
+		m_basicMeshes->DrawTaperedCylinderMesh();
+		break;
+	case MESH_TORUS:
+		m_basicMeshes->DrawTorusMesh();
+		break;
+	case MESH_HALF_TORUS:
+		m_basicMeshes->DrawHalfTorusMesh();
+		break;
+	default:
+		m_basicMeshes->DrawImportedMesh(mesh - MESH_IMPORTED);
+		break;
 	}
 }
 
@@ -382,31 +1469,29 @@ void SceneManager::SetShaderMaterial(
 
 void SceneManager::LoadSceneTextures()
 {
-	bool bReturn = false;
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/ceramic.jpg",
-		"ceramic");
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/porcelain.jpg",
-		"porcelain");
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/stainless.jpg",
-		"metal");
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/paper.jpg",
-		"paper");
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/plastic.jpg",
-		"plastic");
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/drywall.jpg",
-		"drywall");
+	TRACE_SCOPE("LoadSceneTextures");
 
-	// after the texture image data is loaded into memory, the
-	// loaded textures need to be bound to texture slots - there
-	// are a total of 16 available slots for scene textures
-	BindGLTextures();
+	if (NULL == m_pSceneFile)
+	{
+		return;
+	}
+
+	// the images are decoded in parallel on the job system, and
+	// the textures are created once FinishGLTextures() is called -
+	// while streaming, they are loaded when they are drawn
+	const SceneFile::TEXTURE_RECORD* textures = m_pSceneFile->GetTextures();
+	m_textureAssets.clear();
+	for (uint32_t i = 0; i < m_pSceneFile->GetTextureCount(); i++)
+	{
+		if (NULL != m_pAssetManager)
+		{
+			m_textureAssets.push_back(m_pAssetManager->AddTexture(m_pSceneFile->GetFilePath(textures[i].filename)));
+			continue;
+		}
+		QueueGLTexture(
+			m_pSceneFile->GetFilePath(textures[i].filename).c_str(),
+			m_pSceneFile->GetString(textures[i].tag));
+	}
 }
 
 /***********************************************************
@@ -417,67 +1502,25 @@ void SceneManager::LoadSceneTextures()
  ***********************************************************/
 void SceneManager::DefineObjectMaterials()
 {
-	// easier tuning
-
-	float ambC = .1;
-	float ambS = .75;
-	float difC = .25;
-	float specC = .75;
-	float shin = 16.0;
-
-	OBJECT_MATERIAL ceramic;
-	ceramic.tag = "ceramic";
-	ceramic.ambientColor = glm::vec3(ambC); 
-	ceramic.ambientStrength = ambS;          
-	ceramic.diffuseColor = glm::vec3(difC);
-	ceramic.specularColor = glm::vec3(specC); 
-	ceramic.shininess = shin;           
-	m_objectMaterials.push_back(ceramic);
-
-	OBJECT_MATERIAL porcelain;
-	porcelain.tag = "porcelain";
-	porcelain.ambientColor = glm::vec3(ambC);
-	porcelain.ambientStrength = ambS;
-	porcelain.diffuseColor = glm::vec3(difC);
-	porcelain.specularColor = glm::vec3(specC);
-	porcelain.shininess = shin;
-	m_objectMaterials.push_back(porcelain);
-
-	OBJECT_MATERIAL metal;
-	metal.tag = "metal";
-	metal.ambientColor = glm::vec3(ambC);
-	metal.ambientStrength = ambS;
-	metal.diffuseColor = glm::vec3(difC);
-	metal.specularColor = glm::vec3(specC);
-	metal.shininess = shin;
-	m_objectMaterials.push_back(metal);
-
-	OBJECT_MATERIAL paper;
-	paper.tag = "paper";
-	paper.ambientColor = glm::vec3(ambC);
-	paper.ambientStrength = ambS;
-	paper.diffuseColor = glm::vec3(difC);
-	paper.specularColor = glm::vec3(specC);
-	paper.shininess = shin;
-	m_objectMaterials.push_back(paper);
-
-	OBJECT_MATERIAL plastic;
-	plastic.tag = "plastic";
-	plastic.ambientColor = glm::vec3(ambC);
-	plastic.ambientStrength = ambS;
-	plastic.diffuseColor = glm::vec3(difC);
-	plastic.specularColor = glm::vec3(specC);
-	plastic.shininess = shin;
-	m_objectMaterials.push_back(plastic);
-
-	OBJECT_MATERIAL drywall;
-	drywall.tag = "drywall";
-	drywall.ambientColor = glm::vec3(ambC);
-	drywall.ambientStrength = ambS;
-	drywall.diffuseColor = glm::vec3(difC);
-	drywall.specularColor = glm::vec3(specC);
-	drywall.shininess = shin;
-	m_objectMaterials.push_back(drywall);
+	if (NULL == m_pSceneFile)
+	{
+		return;
+	}
+
+	// the materials are defined in the order of the scene, so the
+	// index of a record is the index of its material
+	const SceneFile::MATERIAL_RECORD* materials = m_pSceneFile->GetMaterials();
+	for (uint32_t i = 0; i < m_pSceneFile->GetMaterialCount(); i++)
+	{
+		OBJECT_MATERIAL material;
+		material.tag = m_pSceneFile->GetString(materials[i].tag);
+		material.ambientColor = glm::make_vec3(materials[i].ambientColor);
+		material.ambientStrength = materials[i].ambientStrength;
+		material.diffuseColor = glm::make_vec3(materials[i].diffuseColor);
+		material.specularColor = glm::make_vec3(materials[i].specularColor);
+		material.shininess = materials[i].shininess;
+		m_objectMaterials.push_back(material);
+	}
 }
 
 /***********************************************************
@@ -488,38 +1531,30 @@ void SceneManager::DefineObjectMaterials()
  ***********************************************************/
 void SceneManager::SetupSceneLights()
 {
-	//easier tuning
-	const float amb = 0.1f;   
-	const float dif = 0.12f;   
-	const float H = 6.0f;    
-	const float R = 12.0f;   
-
-	//makes lights in the corners of the scene.
-	//which ever is last in the array gets the glare
-	const glm::vec3 corners[4] = {
-		{ R, H, -R}, { R, H,  R}, {-R, H,  R}, {-R, H, -R}
-	};
-
-	for (int i = 0; i < 3; ++i) {
-		std::string base = "lightSources[" + std::to_string(i) + "]";
-		m_pShaderManager->setVec3Value((base + ".position").c_str(), corners[i]);
-		m_pShaderManager->setVec3Value((base + ".ambientColor").c_str(), amb, amb, amb);
-		m_pShaderManager->setVec3Value((base + ".diffuseColor").c_str(), dif, dif, dif);
-		m_pShaderManager->setVec3Value((base + ".specularColor").c_str(), 0.0f, 0.0f, 0.0f);
-		m_pShaderManager->setFloatValue((base + ".specularIntensity").c_str(), 0.0f);
-		m_pShaderManager->setFloatValue((base + ".focalStrength").c_str(), 3.0f);
+	// the lights live in the frame constants uniform buffer, so
+	// they are shared by every shader program and survive program
+	// changes - they are uploaded together with the camera each frame
+	FrameUniformBuffer::FRAME_CONSTANTS& frame = m_pShaderManager->GetFrameUniforms().GetConstants();
+	frame.lightCount = (NULL != m_pSceneFile) ? (int)m_pSceneFile->GetLightCount() : 0;
+
+	// the lights are placed in units of the light radius and
+	// height, so they move with SetLightPlacement()
+	for (int i = 0; i < frame.lightCount; ++i) {
+		const SceneFile::LIGHT_RECORD& record = m_pSceneFile->GetLights()[i];
+		FrameUniformBuffer::LIGHT_SOURCE& light = frame.lightSources[i];
+		light.position = glm::make_vec3(record.placement) * glm::vec3(m_lightRadius, m_lightHeight, m_lightRadius);
+		light.ambientColor = glm::make_vec3(record.ambientColor);
+		light.diffuseColor = glm::make_vec3(record.diffuseColor);
+		light.specularColor = glm::make_vec3(record.specularColor);
+		light.specularIntensity = record.specularIntensity;
+		light.focalStrength = record.focalStrength;
 	}
 
-	//only light that makes glare aka specular effect
-	std::string base = "lightSources[3]";
-	m_pShaderManager->setVec3Value((base + ".position").c_str(), corners[3]);
-	m_pShaderManager->setVec3Value((base + ".ambientColor").c_str(), amb, amb, amb);
-	m_pShaderManager->setVec3Value((base + ".diffuseColor").c_str(), dif, dif, dif);
-	m_pShaderManager->setVec3Value((base + ".specularColor").c_str(), 0.25f, 0.25f, 0.25f);
-	m_pShaderManager->setFloatValue((base + ".specularIntensity").c_str(), 0.15f);
-	m_pShaderManager->setFloatValue((base + ".focalStrength").c_str(), 25.0f);
-
-	m_pShaderManager->setBoolValue("bUseLighting", true);
+	// the software renderer always lights the scene
+	if (m_bOpenGLEnabled)
+	{
+		m_pShaderManager->setBoolValue("bUseLighting", true);
+	}
 }
 
 
@@ -532,28 +1567,78 @@ void SceneManager::SetupSceneLights()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
-	// 1) load and bind textures
+	TRACE_SCOPE("PrepareScene");
+
+	// the shader programs may still be compiling in the driver,
+	// so the work that does not need them is done first
+
+	// the streamed assets are only loaded once they are drawn,
+	// and the mesh pool is left out of a scene without meshes
+	if (m_bStreamingEnabled && m_bOpenGLEnabled && (NULL == m_pAssetManager))
+	{
+		m_pAssetManager = new AssetManager(m_basicMeshes, m_pJobSystem);
+		bool bMeshPool = (NULL != m_pSceneFile) && (m_pSceneFile->GetMeshCount() > 0);
+		if (m_pAssetManager->Initialize(m_streamingBudget, bMeshPool) == false)
+		{
+			std::cout << "Failed to start streaming, the scene assets are all loaded" << std::endl;
+			delete m_pAssetManager;
+			m_pAssetManager = NULL;
+		}
+	}
+
+	// 1) start decoding the textures
 	LoadSceneTextures();
 
 	// 2) define materials (even for textured objects)
 	DefineObjectMaterials();
 
-	// 3) set up lights and enable lighting
-	SetupSceneLights();
+	// 3) load the meshes - only one instance of a particular mesh
+	// needs to be loaded in memory no matter how many times it is
+	// drawn in the rendered 3D scene - the meshes need the OpenGL
+	// context, so they are loaded here while the workers decode
+	LoadBasicMeshes();
+	LoadSceneMeshes();
+
+	// after the texture image data is loaded into memory, the
+	// loaded textures need to be bound to texture slots - there
+	// are a total of 16 available slots for scene textures
+	FinishGLTextures();
+	BindGLTextures();
+
+	// the objects find their texture slots by index from here on,
+	// an object whose texture did not load is drawn with its color
+	m_sceneTextureSlots.clear();
+	for (uint32_t i = 0; (NULL != m_pSceneFile) && (i < m_pSceneFile->GetTextureCount()); i++)
+	{
+		m_sceneTextureSlots.push_back(FindTextureSlot(m_pSceneFile->GetString(m_pSceneFile->GetTextures()[i].tag)));
+	}
+
+	// the streamed textures are kept by their index, and bound
+	// by the draws that use them - the objects hold the
+	// references to the assets they draw with
+	if (NULL != m_pAssetManager)
+	{
+		for (size_t i = 0; i < m_sceneTextureSlots.size(); i++)
+		{
+			m_sceneTextureSlots[i] = (int)i;
+		}
 
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+		ReferenceSceneAssets(true);
+	}
 
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadConeMesh();
-	m_basicMeshes->LoadPrismMesh();
-	m_basicMeshes->LoadPyramid4Mesh();
-	m_basicMeshes->LoadSphereMesh();
-	m_basicMeshes->LoadTaperedCylinderMesh();
-	m_basicMeshes->LoadTorusMesh();
+	// 4) wait for the queued shader programs and activate them
+	if (m_bOpenGLEnabled)
+	{
+		if (m_pShaderManager->WaitForShaders() == false)
+		{
+			std::cout << "Failed to build the shader programs" << std::endl;
+		}
+		m_pShaderManager->use();
+	}
+
+	// 5) set up lights and enable lighting
+	SetupSceneLights();
+	MarkSceneChanged();
 }
 
 /***********************************************************
@@ -564,216 +1649,95 @@ void SceneManager::PrepareScene()
  ***********************************************************/
 void SceneManager::RenderScene()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/******************************************************************/
-
-	// plane / floor / ground 
-
-	/******************************************************************/
-	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 20.0f, 20.0f);
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-
-	//SetShaderColor(0.8f, 0.8f, 0.8f, 1.0f);
-	SetShaderTexture( "porcelain");
-	SetShaderMaterial("porcelain");
-	SetTextureUVScale(8, 8);
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	/****************************************************************/
-	/******************************************************************/
-
-	// plate / tappered cylinder 
-
-	/******************************************************************/
-	/******************************************************************/
-	scaleXYZ = glm::vec3(4.0f, 1.0f, 4.0f);
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-5.0f, 1.0f, 2.0f);
-
-	SetTransformations( scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-
-	//SetShaderColor(0.5, 0.5, 0.5, 1);
-	SetShaderTexture("ceramic");
-	SetShaderMaterial("ceramic");
-	m_basicMeshes->DrawTaperedCylinderMesh();
-	/****************************************************************/
-	/******************************************************************/
-
-	// cup / tappered cylinder / torus / plane 
-
-	/******************************************************************/
-	// tappered cylinder
-	/******************************************************************/
-	scaleXYZ = glm::vec3(3.0f, 3.0f, 3.0f);
-	/* same rotation as above minor computational savings // keep in for readability */
-	//XrotationDegrees = 180.0f;
-	//YrotationDegrees = 0.0f;
-	//ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-5.0f, 4.10f, 2.5f);
-
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-
-	//SetShaderColor(0.6, 0.6, 0.6, 1);
-	SetShaderTexture("ceramic");
-	SetShaderMaterial("ceramic");
-	m_basicMeshes->DrawTaperedCylinderMesh();
-	/****************************************************************/
-	// torus
-	/******************************************************************/
-	scaleXYZ = glm::vec3(1.0f, 1.0f, 1.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 10.0f;
-	ZrotationDegrees = 120.0f;
-	positionXYZ = glm::vec3(-6.5f, 3.0f, 3.75f);
-
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-
-	//SetShaderColor(0.6, 0.6, 0.6, 1);
-	SetShaderTexture("ceramic");
-	SetShaderMaterial("ceramic");
-	m_basicMeshes->DrawHalfTorusMesh();
-	/****************************************************************/
-	/******************************************************************/
-
-	// book / box / torus
-
-	/******************************************************************/
-	// Box
-	/******************************************************************/
-	scaleXYZ = glm::vec3(6.0f, 0.5f, 11.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = -30.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(5.5f, 0.25f, 3.0f);
-
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-
-	//SetShaderColor(0.4, 0.4, 0.4, 1);
-	SetShaderTexture("paper");
-	SetShaderMaterial("paper");
-	SetTextureUVScale(2, 2);
-	m_basicMeshes->DrawBoxMesh();
-	/******************************************************************/
-	// torus'
-	/******************************************************************/
-	scaleXYZ = glm::vec3(0.25f, 0.25f, 0.25f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = -30.0f;
-	ZrotationDegrees = 0.0f;
-
-	// I used a formula to find the concrete values instead of coding in the trig 
-	// 24 x 3 matrix of positions
-	float positions[24][3] = { 
-		{5.537341f, 0.250000f, -3.064676f}, 
-		{5.308174f, 0.250000f, -2.667747f}, 
-		{5.079008f, 0.250000f, -2.270819f}, 
-		{4.849841f, 0.250000f, -1.873891f}, 
-		{4.620674f, 0.250000f, -1.476962f}, 
-		{4.391508f, 0.250000f, -1.080034f}, 
-		{4.162341f, 0.250000f, -0.683105f}, 
-		{3.933174f, 0.250000f, -0.286177f}, 
-		{3.704008f, 0.250000f, 0.110752f}, 
-		{3.474841f, 0.250000f, 0.507680f}, 
-		{3.245674f, 0.250000f, 0.904609f}, 
-		{3.016508f, 0.250000f, 1.301537f}, 
-		{2.787341f, 0.250000f, 1.698465f}, 
-		{2.558174f, 0.250000f, 2.095394f}, 
-		{2.329008f, 0.250000f, 2.492322f}, 
-		{2.099841f, 0.250000f, 2.889251f}, 
-		{1.870674f, 0.250000f, 3.286179f}, 
-		{1.641508f, 0.250000f, 3.683108f}, 
-		{1.412341f, 0.250000f, 4.080036f}, 
-		{1.183174f, 0.250000f, 4.476964f}, 
-		{0.954008f, 0.250000f, 4.873893f}, 
-		{0.724841f, 0.250000f, 5.270821f}, 
-		{0.495674f, 0.250000f, 5.667750f}, 
-		{0.266508f, 0.250000f, 6.064678f}, 
-	};
+	PROFILE_SCOPE("RenderScene");
 
-	for (int i = 0; i < 24; ++i) {
-		glm::vec3 positionXYZ(
-			positions[i][0],
-			positions[i][1],
-			positions[i][2]
-		);
+	BuildDrawList(m_drawList);
+	SubmitDrawList(m_drawList);
+}
 
-		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+/***********************************************************
+ *  BuildDrawList()
+ *
+ *  This method is used for recording the transformations
+ *  and the shader settings of every shape of the 3D scene
+ *  into a draw list.  It makes no OpenGL calls, so it can
+ *  run on another thread while the previous frame is
+ *  being drawn.
+ ***********************************************************/
+void SceneManager::BuildDrawList(DRAW_LIST& drawList)
+{
+	PROFILE_SCOPE("BuildDrawList");
+
+	drawList.commands.clear();
+	m_pRecordingList = &drawList;
+	m_nextTransform = 0;
+	m_transformGroups.clear();
+
+	// the objects are read where the scene was loaded, and every
+	// one of them, groups too, is the transform node of its index
+	const SceneFile::OBJECT_RECORD* objects = (NULL != m_pSceneFile) ? m_pSceneFile->GetObjects() : NULL;
+	uint32_t objectCount = (NULL != m_pSceneFile) ? m_pSceneFile->GetObjectCount() : 0;
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		const SceneFile::OBJECT_RECORD& object = objects[i];
+		SetTransformations(
+			glm::make_vec3(object.scale),
+			object.rotationDegrees[0],
+			object.rotationDegrees[1],
+			object.rotationDegrees[2],
+			glm::make_vec3(object.position));
+
+		int node = RecordTransform(object.parent);
+		if (object.mesh == SceneFile::MESH_GROUP)
+		{
+			continue;
+		}
 
-		//SetShaderColor(0.0, 0.0, 0.0, 1);
-		SetShaderTexture("plastic");
-		SetShaderMaterial("plastic");
-		m_basicMeshes->DrawTorusMesh();
+		int textureSlot = ((object.texture >= 0) && (object.texture < (int)m_sceneTextureSlots.size())) ? m_sceneTextureSlots[object.texture] : -1;
+		if (NULL != m_pAssetManager)
+		{
+			// the color is drawn until the streamed texture is loaded
+			SetShaderColor(object.color[0], object.color[1], object.color[2], object.color[3]);
+		}
+		if (textureSlot >= 0)
+		{
+			m_nextCommand.bUseTexture = true;
+			m_nextCommand.textureSlot = textureSlot;
+		}
+		else
+		{
+			SetShaderColor(object.color[0], object.color[1], object.color[2], object.color[3]);
+		}
+		m_nextCommand.material = object.material;
+		SetTextureUVScale(object.UVscale[0], object.UVscale[1]);
+
+		m_nextCommand.mesh = (MESH_TYPE)object.mesh;
+		m_nextCommand.transform = node;
+		drawList.commands.push_back(m_nextCommand);
+	}
+
+	m_pRecordingList = NULL;
+
+	// only the nodes that changed since the last list are built,
+	// which is none for a scene where nothing moves
+	if (m_transforms.UpdateWorldMatrices() > 0)
+	{
+		MarkSceneChanged();
+	}
+
+	// the objects are drawn with the lightmap in the order it
+	// was baked in
+	if (IsLightmapActive())
+	{
+		for (size_t i = 0; (i < drawList.commands.size()) && (i < m_lightmapRanges.size()); i++)
+		{
+			if (m_lightmapRanges[i].count > 0)
+			{
+				drawList.commands[i].lightmap = (int)i;
+			}
+		}
 	}
 
-	/******************************************************************/
-	/******************************************************************/
-
-	// pencil / cylinder / cone
-
-	/******************************************************************/
-	// pen cylinder metal
-	/******************************************************************/
-	scaleXYZ = glm::vec3(0.25f, 2.0f, 0.25f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 35.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(5.0f, 1.0f, 5.0f);
-
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-
-	//SetShaderColor(1, 1, 1, 1);
-	SetShaderTexture("metal");
-	SetShaderMaterial("metal");
-	m_basicMeshes->DrawCylinderMesh();
-	/****************************************************************/
-	// pen cylinder plastic
-	/******************************************************************/
-	scaleXYZ = glm::vec3(0.25f, 2.0f, 0.25f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 35.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(5.0f, 1.0f, 3.0f);
-
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-
-	//SetShaderColor(0.0, 0.0, 0.0, 1);
-	SetShaderTexture("plastic");
-	SetShaderMaterial("plastic");
-
-	m_basicMeshes->DrawCylinderMesh();
-	/****************************************************************/
-	// pen cone plastic tip
-	/******************************************************************/
-	scaleXYZ = glm::vec3(0.25f, 1.0f, 0.25f);
-	XrotationDegrees = 270.0f;
-	YrotationDegrees = 35.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(5.0f, 1.0f, 3.0f);
-
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-
-	//SetShaderColor(0.0, 0.0, 0.0, 1);
-	SetShaderTexture("plastic");
-	SetShaderMaterial("plastic");
-	m_basicMeshes->DrawConeMesh();
-	/****************************************************************/
+	UpdateDrawList(drawList);
 }
 
@@ -11,11 +11,17 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "JobSystem.h"
+#include "TransformHierarchy.h"
+#include "AssetManager.h"
 
 #include <string>
 #include <vector>
 #include <GLFW/glfw3.h>
 
+class ShadowMapper;
+class SceneFile;
+
 /***********************************************************
  *  SceneManager
  *
@@ -36,6 +42,17 @@ public:
 		uint32_t ID;
 	};
 
+	// a decoded texture image - the rows start at the bottom
+	struct TEXTURE_IMAGE
+	{
+		std::string filename;
+		std::string tag;
+		unsigned char* pixels;
+		int width;
+		int height;
+		int colorChannels;
+	};
+
 	struct OBJECT_MATERIAL
 	{
 		float ambientStrength;
@@ -46,21 +63,146 @@ public:
 		std::string tag;
 	};
 
+	// the meshes that a draw command can draw, the meshes
+	// imported by the scene file follow the basic ones
+	enum MESH_TYPE : int
+	{
+		MESH_BOX,
+		MESH_CONE,
+		MESH_CYLINDER,
+		MESH_PLANE,
+		MESH_PRISM,
+		MESH_PYRAMID3,
+		MESH_PYRAMID4,
+		MESH_SPHERE,
+		MESH_HALF_SPHERE,
+		MESH_TAPERED_CYLINDER,
+		MESH_TORUS,
+		MESH_HALF_TORUS,
+		MESH_IMPORTED
+	};
+
+	// everything the shader needs to draw one object
+	struct DRAW_COMMAND
+	{
+		MESH_TYPE mesh;
+		// the authored transformation values, relative to the
+		// transform group the command was recorded in
+		glm::vec3 scale;
+		glm::vec3 rotationDegrees;
+		glm::vec3 position;
+		int transform;			// node in the transform hierarchy
+		glm::mat4 model;
+		glm::mat4 modelViewProjection;
+		glm::mat3 normalMatrix;
+		float radius;			// of the bounding sphere in the world
+		bool bUseTexture;
+		int textureSlot;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		int material;			// index into the defined materials, or -1
+		bool bVisible;			// inside the view frustum
+		int lightmap;			// range of the lightmapped mesh, or -1
+		uint32_t sortKey;		// equal for commands with the same state
+	};
+
+	// the draw commands of one frame, built without any OpenGL
+	// calls so that it can be done on another thread
+	struct DRAW_LIST
+	{
+		std::vector<DRAW_COMMAND> commands;
+		// the visible commands in the order they are drawn
+		std::vector<int> order;
+	};
+
 
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
+	// pool that the per-frame and loading work is spread over,
+	// everything runs on the calling thread without it
+	JobSystem* m_pJobSystem;
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
+	// radius of a sphere around the origin that holds each of
+	// the imported meshes
+	std::vector<float> m_importedRadii;
+	// the texture images decoded by jobs, waiting to be uploaded
+	std::vector<TEXTURE_IMAGE*> m_pendingTextures;
+	// false when the scene is prepared without an OpenGL context,
+	// the textures are then kept in memory by slot
+	bool m_bOpenGLEnabled;
+	std::vector<TEXTURE_IMAGE*> m_textureImages;
+	JobSystem::JOB_COUNTER m_textureJobs;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// the textures, materials, lights and objects of the scene,
+	// read in place, and the slots of its textures by index
+	SceneFile* m_pSceneFile;
+	std::vector<int> m_sceneTextureSlots;
+	// streams the textures and imported meshes of the scene
+	// within a memory budget, NULL when they are all loaded -
+	// the assets of the scene textures and meshes by index
+	AssetManager* m_pAssetManager;
+	AssetManager::BUDGET m_streamingBudget;
+	bool m_bStreamingEnabled;
+	std::vector<int> m_textureAssets;
+	std::vector<int> m_meshAssets;
+	// combined view and projection matrix of the current frame
+	glm::mat4 m_viewProjection;
+	// distance of the corner lights from the scene center, and
+	// their height above the table
+	float m_lightRadius;
+	float m_lightHeight;
+	// counts the changes to the lights and the objects
+	unsigned int m_sceneVersion;
+	// the triangles of every command in the lightmapped mesh,
+	// empty for the commands that have no lightmap
+	struct LIGHTMAP_RANGE
+	{
+		GLint first;
+		GLsizei count;
+	};
+	std::vector<LIGHTMAP_RANGE> m_lightmapRanges;
+	GLuint m_lightmapTexture;
+	// the light placement the lightmap was baked with, it is only
+	// used while the lights are there
+	float m_lightmapRadius;
+	float m_lightmapHeight;
+	// draws the shadow maps of the lights, NULL without shadows
+	ShadowMapper* m_pShadowMapper;
+	// the draw list used by RenderScene()
+	DRAW_LIST m_drawList;
+	// list that the draw commands are added to, and the shader
+	// settings for the next one - the settings carry over from
+	// one command to the next like the shader uniforms do
+	DRAW_LIST* m_pRecordingList;
+	DRAW_COMMAND m_nextCommand;
+	// the transformations of the recorded commands and groups, one
+	// node each in the order they are recorded - the matrices are
+	// only built again for the nodes whose values changed
+	TransformHierarchy m_transforms;
+	int m_nextTransform;
+	// the open transform groups, the last one is the parent of the
+	// following commands
+	std::vector<int> m_transformGroups;
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
+	// decode a texture image on the job system, and upload the
+	// decoded images in the order they were queued
+	void QueueGLTexture(const char* filename, std::string tag);
+	void FinishGLTextures();
+	// read the pixels of a texture image file
+	static void DecodeTextureImage(TEXTURE_IMAGE* image);
+	// register the OpenGL texture of a decoded image
+	bool UploadGLTexture(TEXTURE_IMAGE* image);
+	// keep a decoded image in memory in the next texture slot
+	bool KeepTextureImage(TEXTURE_IMAGE* image);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
@@ -70,6 +212,7 @@ private:
 	int FindTextureSlot(std::string tag);
 	// find a defined material by tag
 	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(std::string tag);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -80,6 +223,16 @@ private:
 		float ZrotationDegrees,
 		glm::vec3 positionXYZ);
 
+	// start a group whose transformation, from the values set
+	// with SetTransformations(), moves the commands recorded
+	// until the group is ended - the values of those commands are
+	// relative to the group
+	void BeginTransformGroup();
+	void EndTransformGroup();
+	// the transform node of the next command or group, below
+	// the passed in parent node
+	int RecordTransform(int parent);
+
 	// set the color values into the shader
 	void SetShaderColor(
 		float redColorValue,
@@ -99,13 +252,116 @@ private:
 	void SetShaderMaterial(
 		std::string materialTag);
 
+	// add a draw command for a mesh with the current settings
+	void DrawMesh(MESH_TYPE mesh);
+	// build the matrices, cull and sort the commands of a list
+	void UpdateDrawList(DRAW_LIST& drawList);
+	// draw a mesh with the current shader settings
+	void DrawMeshType(MESH_TYPE mesh);
+	// load the basic meshes that the objects of the scene file
+	// draw, or all of them without a scene file
+	void LoadBasicMeshes();
+	// import the meshes of the scene file on the job system
+	// and add them to the shared imported meshes
+	void LoadSceneMeshes();
+	// count, or stop counting, the objects of the scene file as
+	// references to the streamed assets they draw with
+	void ReferenceSceneAssets(bool bReference);
+
 public:
 
+	// load the scene description, a text scene or a compiled
+	// one - set before PrepareScene()
+	bool LoadSceneFile(const char* filename);
+
 	// The following methods are for the students to 
 	// customize for their own 3D scene
 	void PrepareScene();
 	void RenderScene();
 
+	// record the draw commands of the scene without drawing, and
+	// draw a recorded list - RenderScene() does both in turn
+	void BuildDrawList(DRAW_LIST& drawList);
+	void SubmitDrawList(const DRAW_LIST& drawList);
+
+	// texture unit of the lightmap, above the scene textures
+	static const int LIGHTMAP_TEXTURE_UNIT = 15;
+	// texture unit that the streamed textures are bound to by
+	// the draws that use them
+	static const int STREAMED_TEXTURE_UNIT = 0;
+	// load a lightmap baked by the LightmapBaker, <name>.png and
+	// <name>.layout, for the following frames - the objects that
+	// match the baked ones get their diffuse lighting from it
+	bool LoadLightmaps(const char* name);
+	// true while a lightmap is loaded and the lights are where
+	// it was baked
+	bool IsLightmapActive() const;
+
+	// draw the shadows of the lights from cube shadow maps of the
+	// passed in size, with a program queued with the defines of
+	// ShadowMapper::DEPTH_PROGRAM_DEFINES
+	bool EnableShadows(int depthProgram, int mapSize);
+	ShadowMapper* GetShadowMapper() { return m_pShadowMapper; }
+
+	// spread the scene work over a job system, or NULL
+	void SetJobSystem(JobSystem* pJobSystem);
+	// prepare the scene without an OpenGL context, for the
+	// software renderer - set before PrepareScene()
+	void SetOpenGLEnabled(bool bEnabled);
+	// stream the scene textures and imported meshes within a
+	// memory budget instead of loading them all - set before
+	// PrepareScene(), and only with OpenGL
+	void EnableStreaming(const AssetManager::BUDGET& budget);
+	AssetManager* GetAssetManager() { return m_pAssetManager; }
+	// whether streamed assets are still loading, or were just
+	// uploaded, so that the scene has to be drawn again
+	bool HasPendingAssets() const { return (NULL != m_pAssetManager) && m_pAssetManager->IsUpdatePending(); }
+
+	// create the OpenGL texture of a decoded image, with its
+	// mipmaps, or 0 when its channels are not handled
+	static GLuint CreateTextureObject(const TEXTURE_IMAGE* image);
+
+	// the data the software renderer draws a list with - the
+	// triangles of a mesh, three vertices each, a texture image
+	// by slot and a material by index
+	void GetMeshTriangles(MESH_TYPE mesh, std::vector<ShapeMeshes::MESH_VERTEX>& triangles);
+	const TEXTURE_IMAGE* GetTextureImage(int slot) const;
+	const OBJECT_MATERIAL* GetMaterial(int index) const;
+
+	// radius of a sphere around the origin that holds every
+	// basic mesh at a scale of one
+	static const float MESH_BOUNDING_RADIUS;
+	// the number of mesh types, the basic and imported meshes,
+	// and the radius of a sphere around the origin that holds
+	// one of them at a scale of one
+	int GetMeshCount() const { return MESH_IMPORTED + m_basicMeshes->GetImportedMeshCount(); }
+	float GetMeshBoundingRadius(MESH_TYPE mesh) const;
+	// upload the imported meshes with packed vertices - set
+	// before PrepareScene()
+	void SetPackedMeshes(bool bPacked) { m_basicMeshes->SetPackedImportedMeshes(bPacked); }
+
+	// get the planes of the view frustum, with the normals
+	// pointing inwards, and test a bounding sphere against them
+	static void GetFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+	static bool IsSphereVisible(const glm::vec4 planes[6], const glm::vec3& center, float radius);
+
+	// set the view and projection of the current frame
+	void SetViewProjection(const glm::mat4& viewProjection);
+
+	// move the corner lights and update the light constants
+	void SetLightPlacement(float radius, float height);
+	float GetLightRadius() const { return m_lightRadius; }
+	float GetLightHeight() const { return m_lightHeight; }
+
+	// the version changes whenever the lights or the objects of the
+	// scene change, a frame drawn at the same version and with the
+	// same camera can be shown again without drawing it
+	unsigned int GetSceneVersion() const { return m_sceneVersion; }
+	void MarkSceneChanged() { m_sceneVersion++; }
+
+	// draw calls and triangles submitted by the last RenderScene()
+	const ShapeMeshes::DRAW_STATISTICS& GetDrawStatistics() const { return m_basicMeshes->GetDrawStatistics(); }
+
 	// loads textures from image files
 	void LoadSceneTextures();
 	void DefineObjectMaterials();
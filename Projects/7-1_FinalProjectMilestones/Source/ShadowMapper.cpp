@@ -0,0 +1,462 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmapper.cpp
+// ============
+// draw and cache the cube shadow maps of the scene lights
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowMapper.h"
+#include "FrameProfiler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+const float ShadowMapper::SHADOW_RANGE = 50.0f;
+const char* const ShadowMapper::DEPTH_PROGRAM_DEFINES = "#define SHADOW_DEPTH\n";
+
+// declaration of global variables
+namespace
+{
+	const char* g_UseShadowsName = "bUseShadows";
+	const char* g_ShadowLightCountName = "shadowLightCount";
+	const char* g_ShadowParametersName = "shadowParameters";
+
+	// the parts of the objects closer than this to a light are clipped
+	const float g_NearPlane = 0.05f;
+
+	// the direction and the up vector of every face of a cube map,
+	// in the order of the layers, +X, -X, +Y, -Y, +Z and -Z
+	const glm::vec3 g_FaceDirections[6] =
+	{
+		glm::vec3(1.0f, 0.0f, 0.0f),
+		glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	const glm::vec3 g_FaceUps[6] =
+	{
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+
+	// 64 bit FNV-1a over a block of memory
+	const uint64_t g_HashBasis = 14695981039346656037ULL;
+	const uint64_t g_HashPrime = 1099511628211ULL;
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * g_HashPrime;
+		}
+		return hash;
+	}
+
+	// radius of the bounding sphere of a command, set with its
+	// matrices by the draw list update
+	float GetCommandRadius(const SceneManager::DRAW_COMMAND& command)
+	{
+		return command.radius;
+	}
+}
+
+/***********************************************************
+ *  ShadowMapper()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowMapper::ShadowMapper(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_depthProgram = -1;
+	m_mapSize = 0;
+	m_texture = 0;
+	m_framebuffer = 0;
+	m_locationProgram = 0;
+	m_modelLocation = -1;
+	m_modelViewProjectionLocation = -1;
+	m_shadowLightLocation = -1;
+	m_bCacheEnabled = true;
+	m_lightCount = 0;
+	m_timerQuery = 0;
+	m_bQueryPending = false;
+
+	Invalidate();
+	ResetStatistics();
+}
+
+/***********************************************************
+ *  ~ShadowMapper()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowMapper::~ShadowMapper()
+{
+	Destroy();
+	m_pShaderManager = NULL;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create the cube map array of
+ *  the shadow maps, six layers per light, and the
+ *  framebuffer that the layers are drawn through.  The
+ *  maps compare the distance passed in by the shader with
+ *  the stored one, with bilinear filtering between the
+ *  results of the four closest texels.
+ ***********************************************************/
+bool ShadowMapper::Create(int depthProgram, int mapSize)
+{
+	Destroy();
+
+	if ((NULL == m_pShaderManager) || (0 == m_pShaderManager->GetProgram(depthProgram)))
+	{
+		printf("The shadow depth program is not linked\n");
+		return false;
+	}
+
+	m_depthProgram = depthProgram;
+	m_mapSize = std::max(mapSize, 16);
+
+	glGenTextures(1, &m_texture);
+	glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, m_texture);
+	glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, GL_DEPTH_COMPONENT24, m_mapSize, m_mapSize,
+		MAX_SHADOW_LIGHTS * 6, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glActiveTexture(GL_TEXTURE0);
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		printf("The shadow map framebuffer is incomplete, status 0x%x\n", status);
+		Destroy();
+		return false;
+	}
+
+	glGenQueries(1, &m_timerQuery);
+
+	Invalidate();
+	printf("INFO: Shadow maps of %d lights, %d x %d texels per face\n", MAX_SHADOW_LIGHTS, m_mapSize, m_mapSize);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to free the shadow maps.
+ ***********************************************************/
+void ShadowMapper::Destroy()
+{
+	if (m_timerQuery != 0)
+	{
+		glDeleteQueries(1, &m_timerQuery);
+		m_timerQuery = 0;
+	}
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_texture != 0)
+	{
+		glDeleteTextures(1, &m_texture);
+		m_texture = 0;
+	}
+	m_bQueryPending = false;
+	m_lightCount = 0;
+	Invalidate();
+}
+
+/***********************************************************
+ *  SetCacheEnabled()
+ *
+ *  This method is used to turn the cache of the maps on
+ *  or off.
+ ***********************************************************/
+void ShadowMapper::SetCacheEnabled(bool bEnabled)
+{
+	m_bCacheEnabled = bEnabled;
+	Invalidate();
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used to throw away the cached maps.
+ ***********************************************************/
+void ShadowMapper::Invalidate()
+{
+	for (int i = 0; i < MAX_SHADOW_LIGHTS; i++)
+	{
+		m_cache[i].bValid = false;
+		m_cache[i].position = glm::vec3(0.0f);
+		m_cache[i].casterHash = 0;
+	}
+}
+
+/***********************************************************
+ *  ResetStatistics()
+ *
+ *  This method is used to start counting the work of the
+ *  maps again.
+ ***********************************************************/
+void ShadowMapper::ResetStatistics()
+{
+	m_statistics.updates = 0;
+	m_statistics.drawnUpdates = 0;
+	m_statistics.drawnMaps = 0;
+	m_statistics.cachedMaps = 0;
+	m_statistics.drawCalls = 0;
+	m_statistics.cpuMs = 0.0;
+	m_statistics.gpuMs = 0.0;
+	m_statistics.gpuSamples = 0;
+}
+
+/***********************************************************
+ *  HashCasters()
+ *
+ *  This method is used to hash the mesh and the model
+ *  matrix of every command whose bounding sphere reaches
+ *  into the range of a light, in the order of the list.
+ *  The objects out of range cannot change the map, so
+ *  they can move without the map being drawn again.
+ ***********************************************************/
+uint64_t ShadowMapper::HashCasters(const SceneManager::DRAW_LIST& drawList, const glm::vec3& lightPosition)
+{
+	uint64_t hash = g_HashBasis;
+	for (size_t i = 0; i < drawList.commands.size(); i++)
+	{
+		const SceneManager::DRAW_COMMAND& command = drawList.commands[i];
+		float reach = SHADOW_RANGE + GetCommandRadius(command);
+		glm::vec3 offset = glm::vec3(command.model[3]) - lightPosition;
+		if (glm::dot(offset, offset) > reach * reach)
+		{
+			continue;
+		}
+
+		int mesh = (int)command.mesh;
+		hash = HashBytes(hash, &mesh, sizeof(mesh));
+		hash = HashBytes(hash, &command.model[0][0], sizeof(command.model));
+	}
+
+	return hash;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to bring the maps up to date with
+ *  the lights and the objects of a draw list.  The maps
+ *  whose light and casters are the same as when they were
+ *  drawn are kept, unless the cache is off.
+ ***********************************************************/
+void ShadowMapper::Update(
+	const SceneManager::DRAW_LIST& drawList,
+	const FrameUniformBuffer::FRAME_CONSTANTS& frame,
+	const std::function<void(SceneManager::MESH_TYPE)>& drawMesh)
+{
+	PROFILE_SCOPE("ShadowMaps");
+
+	if ((m_texture == 0) || (NULL == m_pShaderManager))
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	m_statistics.updates++;
+
+	// the time of the maps drawn in an earlier update
+	if (m_bQueryPending)
+	{
+		GLint bAvailable = 0;
+		glGetQueryObjectiv(m_timerQuery, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (bAvailable)
+		{
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(m_timerQuery, GL_QUERY_RESULT, &elapsed);
+			m_statistics.gpuMs += (double)elapsed / 1000000.0;
+			m_statistics.gpuSamples++;
+			m_bQueryPending = false;
+		}
+	}
+
+	m_lightCount = std::min(frame.lightCount, (int)MAX_SHADOW_LIGHTS);
+
+	// find the maps that have to be drawn before changing any state
+	bool bDrawLight[MAX_SHADOW_LIGHTS];
+	bool bAnyDrawn = false;
+	for (int i = 0; i < m_lightCount; i++)
+	{
+		const glm::vec3& position = frame.lightSources[i].position;
+		uint64_t hash = HashCasters(drawList, position);
+
+		LIGHT_CACHE& cache = m_cache[i];
+		bDrawLight[i] = !m_bCacheEnabled || !cache.bValid ||
+			(cache.position != position) || (cache.casterHash != hash);
+		cache.bValid = true;
+		cache.position = position;
+		cache.casterHash = hash;
+
+		if (bDrawLight[i])
+		{
+			bAnyDrawn = true;
+			m_statistics.drawnMaps++;
+		}
+		else
+		{
+			m_statistics.cachedMaps++;
+		}
+	}
+
+	// the program can be swapped by hot reload
+	GLuint program = m_pShaderManager->GetProgram(m_depthProgram);
+	if (bAnyDrawn && (program != 0))
+	{
+		m_statistics.drawnUpdates++;
+
+		if (program != m_locationProgram)
+		{
+			m_modelLocation = glGetUniformLocation(program, "model");
+			m_modelViewProjectionLocation = glGetUniformLocation(program, "modelViewProjection");
+			m_shadowLightLocation = glGetUniformLocation(program, "shadowLight");
+			m_locationProgram = program;
+		}
+
+		GLint previousFramebuffer = 0;
+		GLint previousViewport[4];
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+		glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+		// only one query can be running, the time is left out
+		// while the previous one is still pending
+		bool bTimed = !m_bQueryPending;
+		if (bTimed)
+		{
+			glBeginQuery(GL_TIME_ELAPSED, m_timerQuery);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		glViewport(0, 0, m_mapSize, m_mapSize);
+		glEnable(GL_DEPTH_TEST);
+		glDepthMask(GL_TRUE);
+		glUseProgram(program);
+
+		for (int i = 0; i < m_lightCount; i++)
+		{
+			if (bDrawLight[i])
+			{
+				DrawLightMap(i, frame.lightSources[i].position, drawList, drawMesh);
+			}
+		}
+
+		if (bTimed)
+		{
+			glEndQuery(GL_TIME_ELAPSED);
+			m_bQueryPending = true;
+		}
+
+		glUseProgram(m_pShaderManager->m_programID);
+		glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+		glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+	}
+
+	m_statistics.cpuMs += std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  DrawLightMap()
+ *
+ *  This method is used to draw the six faces of the map
+ *  of a light, each with the commands inside the view of
+ *  the face.  The depth program stores the distance from
+ *  the light over the range, the same for every face.
+ ***********************************************************/
+void ShadowMapper::DrawLightMap(
+	int light,
+	const glm::vec3& lightPosition,
+	const SceneManager::DRAW_LIST& drawList,
+	const std::function<void(SceneManager::MESH_TYPE)>& drawMesh)
+{
+	glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, g_NearPlane, SHADOW_RANGE);
+	glUniform4f(m_shadowLightLocation, lightPosition.x, lightPosition.y, lightPosition.z, 1.0f / SHADOW_RANGE);
+
+	for (int face = 0; face < 6; face++)
+	{
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0, (light * 6) + face);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		glm::mat4 viewProjection = projection *
+			glm::lookAt(lightPosition, lightPosition + g_FaceDirections[face], g_FaceUps[face]);
+		glm::vec4 planes[6];
+		SceneManager::GetFrustumPlanes(viewProjection, planes);
+
+		for (size_t i = 0; i < drawList.commands.size(); i++)
+		{
+			const SceneManager::DRAW_COMMAND& command = drawList.commands[i];
+			if (!SceneManager::IsSphereVisible(planes, glm::vec3(command.model[3]), GetCommandRadius(command)))
+			{
+				continue;
+			}
+
+			glm::mat4 modelViewProjection = viewProjection * command.model;
+			glUniformMatrix4fv(m_modelLocation, 1, GL_FALSE, &command.model[0][0]);
+			glUniformMatrix4fv(m_modelViewProjectionLocation, 1, GL_FALSE, &modelViewProjection[0][0]);
+			drawMesh(command.mesh);
+			m_statistics.drawCalls++;
+		}
+	}
+}
+
+/***********************************************************
+ *  SetShaderValues()
+ *
+ *  This method is used to point the scene program at the
+ *  maps, or to turn the shadows off for the draws that
+ *  follow, such as the benchmark stress scenes whose
+ *  lights have no maps.
+ ***********************************************************/
+void ShadowMapper::SetShaderValues(bool bEnabled) const
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	bool bUseShadows = bEnabled && (m_texture != 0) && (m_lightCount > 0);
+	m_pShaderManager->setBoolValue(g_UseShadowsName, bUseShadows);
+	if (bUseShadows)
+	{
+		m_pShaderManager->setIntValue(g_ShadowLightCountName, m_lightCount);
+		// a face is two units wide at a distance of one
+		m_pShaderManager->setVec2Value(g_ShadowParametersName,
+			glm::vec2(1.0f / SHADOW_RANGE, 2.0f / (float)m_mapSize));
+	}
+}
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmapper.h
+// ============
+// draw and cache the cube shadow maps of the scene lights
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "ShaderManager.h"
+#include "FrameUniformBuffer.h"
+
+#include <functional>
+#include <stdint.h>
+
+/***********************************************************
+ *  ShadowMapper
+ *
+ *  This class contains the code for the shadows of the
+ *  point lights.  Every light has a cube map in one cube
+ *  map array, holding the distance from the light to the
+ *  closest object in each direction, which the fragment
+ *  shader compares with the distance of the fragment.
+ *
+ *  Drawing a map takes six passes over the objects near
+ *  the light, so the maps are cached: a map is only drawn
+ *  again when its light moved, or when an object within
+ *  the range of the light was added, removed or moved.  A
+ *  scene where nothing moves draws its shadow maps once.
+ ***********************************************************/
+class ShadowMapper
+{
+public:
+	// texture unit of the shadow maps, below the lightmap - the
+	// fragment shader binds its sampler to it
+	static const int SHADOW_TEXTURE_UNIT = 14;
+	// the lights with a shadow map, the first ones of the frame
+	// constants
+	static const int MAX_SHADOW_LIGHTS = 4;
+	// width and height of every face of a map
+	static const int DEFAULT_MAP_SIZE = 512;
+	// objects further away from a light than this cast no shadow
+	static const float SHADOW_RANGE;
+	// the defines of the depth program, queued from the same GLSL
+	// files as the scene program
+	static const char* const DEPTH_PROGRAM_DEFINES;
+
+	// the work of the shadow maps since the last reset
+	struct SHADOW_STATISTICS
+	{
+		unsigned int updates;		// calls of Update()
+		unsigned int drawnUpdates;	// updates that drew a map
+		unsigned int drawnMaps;		// maps drawn again
+		unsigned int cachedMaps;	// maps kept from the cache
+		unsigned int drawCalls;
+		double cpuMs;				// time spent in Update()
+		double gpuMs;				// GPU time of the drawn maps
+		unsigned int gpuSamples;	// updates that gpuMs covers
+	};
+
+	// constructor
+	ShadowMapper(ShaderManager* pShaderManager);
+	// destructor
+	~ShadowMapper();
+
+	// create the maps, drawn with a program queued with the
+	// DEPTH_PROGRAM_DEFINES - needs a current OpenGL context
+	bool Create(int depthProgram, int mapSize);
+	// free the maps
+	void Destroy();
+
+	// with the cache off, every map is drawn in every update
+	void SetCacheEnabled(bool bEnabled);
+	bool IsCacheEnabled() const { return m_bCacheEnabled; }
+	// draw every map again in the next update
+	void Invalidate();
+
+	// draw the maps of the lights that changed, with a function
+	// that draws the mesh of a command - the framebuffer, the
+	// viewport and the program are restored afterwards
+	void Update(
+		const SceneManager::DRAW_LIST& drawList,
+		const FrameUniformBuffer::FRAME_CONSTANTS& frame,
+		const std::function<void(SceneManager::MESH_TYPE)>& drawMesh);
+
+	// set the uniforms that the scene program samples the maps
+	// with, or turn the shadows off for the following draws
+	void SetShaderValues(bool bEnabled) const;
+
+	int GetMapSize() const { return m_mapSize; }
+	const SHADOW_STATISTICS& GetStatistics() const { return m_statistics; }
+	void ResetStatistics();
+
+private:
+	// what a map was drawn with
+	struct LIGHT_CACHE
+	{
+		bool bValid;
+		glm::vec3 position;
+		uint64_t casterHash;
+	};
+
+	ShaderManager* m_pShaderManager;
+	int m_depthProgram;
+	int m_mapSize;
+	GLuint m_texture;
+	GLuint m_framebuffer;
+	// the uniforms of the depth program, found again when hot
+	// reload swaps the program
+	GLuint m_locationProgram;
+	GLint m_modelLocation;
+	GLint m_modelViewProjectionLocation;
+	GLint m_shadowLightLocation;
+
+	bool m_bCacheEnabled;
+	LIGHT_CACHE m_cache[MAX_SHADOW_LIGHTS];
+	int m_lightCount;
+
+	// the GPU time of the maps is read one update later, so that
+	// the query never waits for the GPU
+	GLuint m_timerQuery;
+	bool m_bQueryPending;
+
+	SHADOW_STATISTICS m_statistics;
+
+	// hash the objects within the range of a light
+	static uint64_t HashCasters(const SceneManager::DRAW_LIST& drawList, const glm::vec3& lightPosition);
+	// draw the six faces of the map of a light
+	void DrawLightMap(
+		int light,
+		const glm::vec3& lightPosition,
+		const SceneManager::DRAW_LIST& drawList,
+		const std::function<void(SceneManager::MESH_TYPE)>& drawMesh);
+};
@@ -0,0 +1,711 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerenderer.cpp
+// ============
+// draw the draw lists of the scene on the CPU, binned into screen tiles that
+// are rasterized and shaded in parallel
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRenderer.h"
+#include "RenderTarget.h"
+#include "TraceRecorder.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+
+// the edge functions are tested four pixels at a time where SSE2 is
+// available, which every x64 processor has
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SOFTWARE_RENDERER_SSE2
+#include <emmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// draw commands handled by one job of the vertex stage
+	const int g_CommandGrainSize = 4;
+	// the vertices are snapped to 1/16 of a pixel, like the GPU does,
+	// so that the edges shared by two triangles are tested exactly
+	const float g_SubpixelSteps = 16.0f;
+
+	// the material uniforms before any material was set
+	const SceneManager::OBJECT_MATERIAL g_NoMaterial = {
+		0.0f, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, "" };
+
+	// round a color channel to 8 bits, like the fixed point color
+	// buffer of the GPU
+	unsigned char ToColorByte(float value)
+	{
+		value = std::min(std::max(value, 0.0f), 1.0f);
+		return (unsigned char)(value * 255.0f + 0.5f);
+	}
+}
+
+/***********************************************************
+ *  SoftwareRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoftwareRenderer::SoftwareRenderer(SceneManager* pSceneManager)
+{
+	m_pSceneManager = pSceneManager;
+	m_pJobSystem = NULL;
+	m_bMeshesCaptured = false;
+	m_width = 0;
+	m_height = 0;
+	m_tilesX = 0;
+	m_tilesY = 0;
+
+	m_statistics.frames = 0;
+	m_statistics.triangles = 0;
+	m_statistics.binnedTriangles = 0;
+	m_statistics.shadedPixels = 0;
+	m_statistics.seconds = 0.0;
+}
+
+/***********************************************************
+ *  ~SoftwareRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SoftwareRenderer::~SoftwareRenderer()
+{
+	m_pSceneManager = NULL;
+	m_pJobSystem = NULL;
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used to set the pool that the vertex
+ *  stage and the tiles are spread over.
+ ***********************************************************/
+void SoftwareRenderer::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create the color and depth
+ *  buffers and the bins of the screen tiles.
+ ***********************************************************/
+bool SoftwareRenderer::Create(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		printf("Failed to create the software render target %dx%d\n", width, height);
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_color.assign((size_t)width * height * 4, 0);
+	m_depth.assign((size_t)width * height, 1.0f);
+
+	m_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	m_tileBins.assign(m_tilesX * m_tilesY, std::vector<int>());
+	m_tilePixels.assign(m_tilesX * m_tilesY, 0);
+
+	return true;
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used to draw the visible commands of a
+ *  draw list, in the order of the list, into the color
+ *  and depth buffers.
+ ***********************************************************/
+void SoftwareRenderer::Render(const SceneManager::DRAW_LIST& drawList, const FrameUniformBuffer::FRAME_CONSTANTS& frame)
+{
+	TRACE_SCOPE("SoftwareRender");
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	// the triangles are captured from the same draw calls that
+	// the OpenGL path submits
+	if (!m_bMeshesCaptured)
+	{
+		m_meshTriangles.resize(m_pSceneManager->GetMeshCount());
+		for (int mesh = 0; mesh < (int)m_meshTriangles.size(); mesh++)
+		{
+			m_pSceneManager->GetMeshTriangles((SceneManager::MESH_TYPE)mesh, m_meshTriangles[mesh]);
+		}
+		m_bMeshesCaptured = true;
+	}
+
+	// a command without a material draws with the material of the
+	// command before it, like the shader uniforms carry over, and
+	// the lights of the frame are combined with it once per command
+	int commandCount = (int)drawList.order.size();
+	m_states.resize(commandCount);
+	const SceneManager::OBJECT_MATERIAL* pMaterial = &g_NoMaterial;
+	for (int i = 0; i < commandCount; i++)
+	{
+		const SceneManager::DRAW_COMMAND& command = drawList.commands[drawList.order[i]];
+		if (command.material >= 0)
+		{
+			const SceneManager::OBJECT_MATERIAL* pFound = m_pSceneManager->GetMaterial(command.material);
+			pMaterial = (NULL != pFound) ? pFound : &g_NoMaterial;
+		}
+
+		SHADE_STATE& state = m_states[i];
+		PhongKernel::PrepareConstants(frame, *pMaterial, state.lighting);
+		state.bUseTexture = command.bUseTexture;
+		state.pTexture = command.bUseTexture ? m_pSceneManager->GetTextureImage(command.textureSlot) : NULL;
+		state.color = command.color;
+		state.UVscale = command.UVscale;
+	}
+
+	// vertex stage
+	{
+		TRACE_SCOPE("SoftwareVertices");
+
+		if ((int)m_commandTriangles.size() < commandCount)
+		{
+			m_commandTriangles.resize(commandCount);
+		}
+		std::function<void(int, int)> process = [this, &drawList](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				ProcessCommand(drawList.commands[drawList.order[i]], i, m_commandTriangles[i]);
+			}
+		};
+		if (NULL != m_pJobSystem)
+		{
+			m_pJobSystem->ParallelFor(commandCount, g_CommandGrainSize, process);
+		}
+		else
+		{
+			process(0, commandCount);
+		}
+	}
+
+	// binning, in the order of the draw list
+	unsigned long long binnedTriangles = 0;
+	{
+		TRACE_SCOPE("SoftwareBinning");
+
+		for (size_t i = 0; i < m_tileBins.size(); i++)
+		{
+			m_tileBins[i].clear();
+		}
+		m_triangles.clear();
+
+		for (int i = 0; i < commandCount; i++)
+		{
+			const std::vector<SETUP_TRIANGLE>& triangles = m_commandTriangles[i];
+			for (size_t j = 0; j < triangles.size(); j++)
+			{
+				const SETUP_TRIANGLE& triangle = triangles[j];
+				int index = (int)m_triangles.size();
+				m_triangles.push_back(triangle);
+
+				int tileMinX = triangle.minX / TILE_SIZE;
+				int tileMaxX = triangle.maxX / TILE_SIZE;
+				int tileMinY = triangle.minY / TILE_SIZE;
+				int tileMaxY = triangle.maxY / TILE_SIZE;
+				for (int tileY = tileMinY; tileY <= tileMaxY; tileY++)
+				{
+					for (int tileX = tileMinX; tileX <= tileMaxX; tileX++)
+					{
+						m_tileBins[tileY * m_tilesX + tileX].push_back(index);
+						binnedTriangles++;
+					}
+				}
+			}
+		}
+	}
+
+	// raster stage, every tile clears and draws its own pixels
+	{
+		TRACE_SCOPE("SoftwareTiles");
+
+		int tileCount = m_tilesX * m_tilesY;
+		std::function<void(int, int)> render = [this](int begin, int end)
+		{
+			for (int tile = begin; tile < end; tile++)
+			{
+				RenderTile(tile);
+			}
+		};
+		if (NULL != m_pJobSystem)
+		{
+			m_pJobSystem->ParallelFor(tileCount, 1, render);
+		}
+		else
+		{
+			render(0, tileCount);
+		}
+	}
+
+	m_statistics.frames++;
+	m_statistics.triangles += m_triangles.size();
+	m_statistics.binnedTriangles += binnedTriangles;
+	for (size_t i = 0; i < m_tilePixels.size(); i++)
+	{
+		m_statistics.shadedPixels += m_tilePixels[i];
+	}
+	m_statistics.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+/***********************************************************
+ *  ProcessCommand()
+ *
+ *  This method is used to run the vertex shader on the
+ *  triangles of a command, to drop the triangles that are
+ *  outside of the view, and to clip the rest against the
+ *  near plane.  The other planes need no clipping, the
+ *  rasterizer only visits the pixels on the screen.
+ ***********************************************************/
+void SoftwareRenderer::ProcessCommand(const SceneManager::DRAW_COMMAND& command, int state, std::vector<SETUP_TRIANGLE>& triangles) const
+{
+	triangles.clear();
+
+	const std::vector<ShapeMeshes::MESH_VERTEX>& meshTriangles = m_meshTriangles[command.mesh];
+	for (size_t i = 0; i + 2 < meshTriangles.size(); i += 3)
+	{
+		CLIP_VERTEX vertices[3];
+		int outsideAll = 0x3F;
+		int outsideAny = 0;
+		for (int j = 0; j < 3; j++)
+		{
+			const ShapeMeshes::MESH_VERTEX& vertex = meshTriangles[i + j];
+			glm::vec4 position(vertex.position, 1.0f);
+			vertices[j].clipPosition = command.modelViewProjection * position;
+			vertices[j].worldPosition = glm::vec3(command.model * position);
+			vertices[j].normal = command.normalMatrix * vertex.normal;
+			vertices[j].textureCoordinate = vertex.textureCoordinate;
+
+			const glm::vec4& clip = vertices[j].clipPosition;
+			int outside = 0;
+			if (clip.x < -clip.w) outside |= 0x01;
+			if (clip.x > clip.w) outside |= 0x02;
+			if (clip.y < -clip.w) outside |= 0x04;
+			if (clip.y > clip.w) outside |= 0x08;
+			if (clip.z < -clip.w) outside |= 0x10;
+			if (clip.z > clip.w) outside |= 0x20;
+			outsideAll &= outside;
+			outsideAny |= outside;
+		}
+
+		// every vertex is outside of the same plane
+		if (outsideAll != 0)
+		{
+			continue;
+		}
+
+		SETUP_TRIANGLE triangle;
+		if ((outsideAny & 0x10) == 0)
+		{
+			if (SetupTriangle(vertices[0], vertices[1], vertices[2], state, triangle))
+			{
+				triangles.push_back(triangle);
+			}
+			continue;
+		}
+
+		// clip the polygon against z >= -w, which keeps up to four
+		// of the corners, and draw it as a fan
+		CLIP_VERTEX polygon[4];
+		int corners = 0;
+		for (int j = 0; j < 3; j++)
+		{
+			const CLIP_VERTEX& current = vertices[j];
+			const CLIP_VERTEX& next = vertices[(j + 1) % 3];
+			float currentDistance = current.clipPosition.z + current.clipPosition.w;
+			float nextDistance = next.clipPosition.z + next.clipPosition.w;
+
+			if (currentDistance >= 0.0f)
+			{
+				polygon[corners++] = current;
+			}
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+			{
+				float t = currentDistance / (currentDistance - nextDistance);
+				CLIP_VERTEX& cut = polygon[corners++];
+				cut.clipPosition = glm::mix(current.clipPosition, next.clipPosition, t);
+				cut.worldPosition = glm::mix(current.worldPosition, next.worldPosition, t);
+				cut.normal = glm::mix(current.normal, next.normal, t);
+				cut.textureCoordinate = glm::mix(current.textureCoordinate, next.textureCoordinate, t);
+			}
+		}
+
+		for (int j = 1; j + 1 < corners; j++)
+		{
+			if (SetupTriangle(polygon[0], polygon[j], polygon[j + 1], state, triangle))
+			{
+				triangles.push_back(triangle);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  SetupTriangle()
+ *
+ *  This method is used to project a triangle onto the
+ *  screen and to calculate its edge functions and the
+ *  planes of its depth and attributes.  Both windings are
+ *  drawn, like the scene does without face culling.
+ ***********************************************************/
+bool SoftwareRenderer::SetupTriangle(const CLIP_VERTEX& v0, const CLIP_VERTEX& v1, const CLIP_VERTEX& v2, int state, SETUP_TRIANGLE& triangle) const
+{
+	const CLIP_VERTEX* vertices[3] = { &v0, &v1, &v2 };
+	float x[3];
+	float y[3];
+	float values[PLANE_COUNT][3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		const CLIP_VERTEX& vertex = *vertices[i];
+		float inverseW = 1.0f / vertex.clipPosition.w;
+
+		// viewport transform, snapped to the subpixel grid
+		x[i] = (vertex.clipPosition.x * inverseW * 0.5f + 0.5f) * (float)m_width;
+		y[i] = (vertex.clipPosition.y * inverseW * 0.5f + 0.5f) * (float)m_height;
+		x[i] = floorf(x[i] * g_SubpixelSteps + 0.5f) / g_SubpixelSteps;
+		y[i] = floorf(y[i] * g_SubpixelSteps + 0.5f) / g_SubpixelSteps;
+
+		values[PLANE_DEPTH][i] = vertex.clipPosition.z * inverseW * 0.5f + 0.5f;
+		values[PLANE_INVERSE_W][i] = inverseW;
+		values[PLANE_POSITION_X][i] = vertex.worldPosition.x * inverseW;
+		values[PLANE_POSITION_Y][i] = vertex.worldPosition.y * inverseW;
+		values[PLANE_POSITION_Z][i] = vertex.worldPosition.z * inverseW;
+		values[PLANE_NORMAL_X][i] = vertex.normal.x * inverseW;
+		values[PLANE_NORMAL_Y][i] = vertex.normal.y * inverseW;
+		values[PLANE_NORMAL_Z][i] = vertex.normal.z * inverseW;
+		values[PLANE_TEXTURE_U][i] = vertex.textureCoordinate.x * inverseW;
+		values[PLANE_TEXTURE_V][i] = vertex.textureCoordinate.y * inverseW;
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (area == 0.0f)
+	{
+		return false;
+	}
+
+	// turn clockwise triangles around, so the inside is positive
+	if (area < 0.0f)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		for (int plane = 0; plane < PLANE_COUNT; plane++)
+		{
+			std::swap(values[plane][1], values[plane][2]);
+		}
+		area = -area;
+	}
+
+	// pixel bounds on the screen, the pixel centers are at +0.5
+	float minX = std::min(x[0], std::min(x[1], x[2]));
+	float maxX = std::max(x[0], std::max(x[1], x[2]));
+	float minY = std::min(y[0], std::min(y[1], y[2]));
+	float maxY = std::max(y[0], std::max(y[1], y[2]));
+	triangle.minX = std::max((int)ceilf(minX - 0.5f), 0);
+	triangle.maxX = std::min((int)floorf(maxX - 0.5f), m_width - 1);
+	triangle.minY = std::max((int)ceilf(minY - 0.5f), 0);
+	triangle.maxY = std::min((int)floorf(maxY - 0.5f), m_height - 1);
+	if ((triangle.minX > triangle.maxX) || (triangle.minY > triangle.maxY))
+	{
+		return false;
+	}
+
+	// edge i runs from corner i to the next corner - a top edge is
+	// horizontal and runs to the left, a left edge runs down
+	for (int i = 0; i < 3; i++)
+	{
+		int next = (i + 1) % 3;
+		triangle.edgeA[i] = y[i] - y[next];
+		triangle.edgeB[i] = x[next] - x[i];
+		triangle.edgeC[i] = x[i] * y[next] - y[i] * x[next];
+		triangle.bTopLeft[i] = ((y[i] == y[next]) && (x[next] < x[i])) || (y[next] < y[i]);
+	}
+
+	// the weight of a corner is the edge function of the opposite
+	// edge divided by the area
+	float inverseArea = 1.0f / area;
+	for (int plane = 0; plane < PLANE_COUNT; plane++)
+	{
+		const float* v = values[plane];
+		triangle.planes[plane][0] = (v[0] * triangle.edgeA[1] + v[1] * triangle.edgeA[2] + v[2] * triangle.edgeA[0]) * inverseArea;
+		triangle.planes[plane][1] = (v[0] * triangle.edgeB[1] + v[1] * triangle.edgeB[2] + v[2] * triangle.edgeB[0]) * inverseArea;
+		triangle.planes[plane][2] = (v[0] * triangle.edgeC[1] + v[1] * triangle.edgeC[2] + v[2] * triangle.edgeC[0]) * inverseArea;
+	}
+
+	triangle.state = state;
+	return true;
+}
+
+/***********************************************************
+ *  RenderTile()
+ *
+ *  This method is used to clear a tile and to draw the
+ *  triangles of its bin into it.  The edge functions are
+ *  tested for four pixels of a row at once, and only the
+ *  covered pixels are depth tested.  The pixels of a
+ *  triangle cover each other only once, so their depth is
+ *  written right away, and they are shaded and blended in
+ *  batches.
+ ***********************************************************/
+void SoftwareRenderer::RenderTile(int tile)
+{
+	int tileX0 = (tile % m_tilesX) * TILE_SIZE;
+	int tileY0 = (tile / m_tilesX) * TILE_SIZE;
+	int tileX1 = std::min(tileX0 + TILE_SIZE, m_width) - 1;
+	int tileY1 = std::min(tileY0 + TILE_SIZE, m_height) - 1;
+
+	for (int y = tileY0; y <= tileY1; y++)
+	{
+		size_t row = (size_t)y * m_width;
+		for (int x = tileX0; x <= tileX1; x++)
+		{
+			unsigned char* pColor = &m_color[(row + x) * 4];
+			pColor[0] = 0;
+			pColor[1] = 0;
+			pColor[2] = 0;
+			pColor[3] = 255;
+			m_depth[row + x] = 1.0f;
+		}
+	}
+
+	unsigned long long shadedPixels = 0;
+	PIXEL_BATCH batch;
+	batch.lighting.count = 0;
+	const std::vector<int>& bin = m_tileBins[tile];
+	for (size_t i = 0; i < bin.size(); i++)
+	{
+		const SETUP_TRIANGLE& triangle = m_triangles[bin[i]];
+		const SHADE_STATE& state = m_states[triangle.state];
+
+		int minX = std::max(triangle.minX, tileX0);
+		int maxX = std::min(triangle.maxX, tileX1);
+		int minY = std::max(triangle.minY, tileY0);
+		int maxY = std::min(triangle.maxY, tileY1);
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float pixelY = (float)y + 0.5f;
+			float rowC[3];
+			for (int edge = 0; edge < 3; edge++)
+			{
+				rowC[edge] = triangle.edgeB[edge] * pixelY + triangle.edgeC[edge];
+			}
+
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				// lanes past the end of the span are masked off
+				int mask = (maxX - x >= 3) ? 0xF : ((1 << (maxX - x + 1)) - 1);
+
+#ifdef SOFTWARE_RENDERER_SSE2
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+				for (int edge = 0; (edge < 3) && (mask != 0); edge++)
+				{
+					__m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[edge]), pixelX), _mm_set1_ps(rowC[edge]));
+					__m128 inside = triangle.bTopLeft[edge] ?
+						_mm_cmpge_ps(value, _mm_setzero_ps()) :
+						_mm_cmpgt_ps(value, _mm_setzero_ps());
+					mask &= _mm_movemask_ps(inside);
+				}
+#else
+				for (int lane = 0; lane < 4; lane++)
+				{
+					float pixelX = (float)(x + lane) + 0.5f;
+					for (int edge = 0; edge < 3; edge++)
+					{
+						float value = triangle.edgeA[edge] * pixelX + rowC[edge];
+						bool bInside = triangle.bTopLeft[edge] ? (value >= 0.0f) : (value > 0.0f);
+						if (!bInside)
+						{
+							mask &= ~(1 << lane);
+						}
+					}
+				}
+#endif
+
+				while (mask != 0)
+				{
+					int lane = 0;
+					while ((mask & (1 << lane)) == 0)
+					{
+						lane++;
+					}
+					mask &= ~(1 << lane);
+
+					float pixelX = (float)(x + lane) + 0.5f;
+					const float (*planes)[3] = triangle.planes;
+#define PLANE_AT(plane) (planes[plane][0] * pixelX + planes[plane][1] * pixelY + planes[plane][2])
+
+					// the far plane is not clipped, so it is tested here
+					float depth = PLANE_AT(PLANE_DEPTH);
+					size_t pixel = (size_t)y * m_width + (x + lane);
+					if ((depth > 1.0f) || !(depth < m_depth[pixel]))
+					{
+						continue;
+					}
+
+					float w = 1.0f / PLANE_AT(PLANE_INVERSE_W);
+					int index = batch.lighting.count++;
+					batch.lighting.positionX[index] = PLANE_AT(PLANE_POSITION_X) * w;
+					batch.lighting.positionY[index] = PLANE_AT(PLANE_POSITION_Y) * w;
+					batch.lighting.positionZ[index] = PLANE_AT(PLANE_POSITION_Z) * w;
+					batch.lighting.normalX[index] = PLANE_AT(PLANE_NORMAL_X) * w;
+					batch.lighting.normalY[index] = PLANE_AT(PLANE_NORMAL_Y) * w;
+					batch.lighting.normalZ[index] = PLANE_AT(PLANE_NORMAL_Z) * w;
+					batch.textureCoordinates[index] = glm::vec2(PLANE_AT(PLANE_TEXTURE_U) * w, PLANE_AT(PLANE_TEXTURE_V) * w);
+					batch.pixels[index] = (int)pixel;
+#undef PLANE_AT
+
+					m_depth[pixel] = depth;
+					shadedPixels++;
+
+					if (batch.lighting.count == PhongKernel::BATCH_SIZE)
+					{
+						ShadeBatch(state, batch);
+					}
+				}
+			}
+		}
+
+		if (batch.lighting.count > 0)
+		{
+			ShadeBatch(state, batch);
+		}
+	}
+
+	m_tilePixels[tile] = shadedPixels;
+}
+
+/***********************************************************
+ *  ShadeBatch()
+ *
+ *  This method is used to light the pixels of a batch with
+ *  the Phong kernel, to multiply the light with the texture
+ *  or the object color like the fragment shader does, and
+ *  to blend the pixels into the color buffer.  The batch is
+ *  empty again afterwards.
+ ***********************************************************/
+void SoftwareRenderer::ShadeBatch(const SHADE_STATE& state, PIXEL_BATCH& batch)
+{
+	PhongKernel::Shade(state.lighting, batch.lighting);
+
+	for (int i = 0; i < batch.lighting.count; i++)
+	{
+		glm::vec3 phongResult(batch.lighting.red[i], batch.lighting.green[i], batch.lighting.blue[i]);
+		glm::vec4 source;
+		if (state.bUseTexture)
+		{
+			glm::vec4 textureColor = SampleTexture(state.pTexture, batch.textureCoordinates[i] * state.UVscale);
+			source = glm::vec4(phongResult * glm::vec3(textureColor), 1.0f);
+		}
+		else
+		{
+			source = glm::vec4(phongResult * glm::vec3(state.color), state.color.a);
+		}
+		source = glm::clamp(source, 0.0f, 1.0f);
+
+		// blend with the source alpha, like the OpenGL path
+		unsigned char* pColor = &m_color[(size_t)batch.pixels[i] * 4];
+		for (int channel = 0; channel < 4; channel++)
+		{
+			float destination = pColor[channel] / 255.0f;
+			pColor[channel] = ToColorByte(source[channel] * source.a + destination * (1.0f - source.a));
+		}
+	}
+
+	batch.lighting.count = 0;
+}
+
+/***********************************************************
+ *  SampleTexture()
+ *
+ *  This method is used to read a texture image with the
+ *  settings of the OpenGL textures - bilinear filtering
+ *  and repeated texture coordinates.  A slot without an
+ *  image reads black, like an unbound texture.
+ ***********************************************************/
+glm::vec4 SoftwareRenderer::SampleTexture(const SceneManager::TEXTURE_IMAGE* pTexture, const glm::vec2& textureCoordinate)
+{
+	if ((NULL == pTexture) || (NULL == pTexture->pixels))
+	{
+		return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	int width = pTexture->width;
+	int height = pTexture->height;
+	float u = textureCoordinate.x * width - 0.5f;
+	float v = textureCoordinate.y * height - 0.5f;
+	float u0 = floorf(u);
+	float v0 = floorf(v);
+	float fractionU = u - u0;
+	float fractionV = v - v0;
+
+	// wrap the texel coordinates into the image
+	int x0 = (int)fmodf(u0, (float)width);
+	int y0 = (int)fmodf(v0, (float)height);
+	if (x0 < 0) x0 += width;
+	if (y0 < 0) y0 += height;
+	int x1 = (x0 + 1 < width) ? x0 + 1 : 0;
+	int y1 = (y0 + 1 < height) ? y0 + 1 : 0;
+
+	const int channels = pTexture->colorChannels;
+	const unsigned char* pixels = pTexture->pixels;
+	const int texels[4][2] = { { x0, y0 }, { x1, y0 }, { x0, y1 }, { x1, y1 } };
+	const float weights[4] = {
+		(1.0f - fractionU) * (1.0f - fractionV),
+		fractionU * (1.0f - fractionV),
+		(1.0f - fractionU) * fractionV,
+		fractionU * fractionV };
+
+	glm::vec4 color(0.0f);
+	for (int i = 0; i < 4; i++)
+	{
+		const unsigned char* texel = &pixels[((size_t)texels[i][1] * width + texels[i][0]) * channels];
+		glm::vec4 value(texel[0], texel[1], texel[2], (channels == 4) ? texel[3] : 255);
+		color += value * weights[i];
+	}
+	return color / 255.0f;
+}
+
+/***********************************************************
+ *  SavePNG()
+ *
+ *  This method is used to save the color buffer as a PNG
+ *  image file.
+ ***********************************************************/
+bool SoftwareRenderer::SavePNG(const char* filename) const
+{
+	return(RenderTarget::WritePNG(filename, m_width, m_height, m_color));
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print how many triangles and
+ *  pixels the frames went through, and how fast.
+ ***********************************************************/
+void SoftwareRenderer::PrintReport() const
+{
+	if ((m_statistics.frames == 0) || (m_statistics.seconds <= 0.0))
+	{
+		return;
+	}
+
+	double frames = (double)m_statistics.frames;
+	printf("INFO: Software renderer: %u frames of %dx%d in %d tiles, %d worker(s), %s shading\n",
+		m_statistics.frames, m_width, m_height, m_tilesX * m_tilesY,
+		(NULL != m_pJobSystem) ? m_pJobSystem->GetWorkerCount() : 1,
+		PhongKernel::GetInstructionSetName(PhongKernel::GetInstructionSet()));
+	printf("INFO:   %.0f triangles and %.0f tile bins per frame, %.0f pixels shaded per frame\n",
+		m_statistics.triangles / frames, m_statistics.binnedTriangles / frames, m_statistics.shadedPixels / frames);
+	printf("INFO:   %.2f ms per frame, %.2f Mtriangles/s, %.2f Mpixels/s\n",
+		1000.0 * m_statistics.seconds / frames,
+		m_statistics.triangles / m_statistics.seconds * 1e-6,
+		m_statistics.shadedPixels / m_statistics.seconds * 1e-6);
+}
@@ -0,0 +1,182 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerenderer.h
+// ============
+// draw the draw lists of the scene on the CPU, binned into screen tiles that
+// are rasterized and shaded in parallel
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "ShapeMeshes.h"
+#include "FrameUniformBuffer.h"
+#include "JobSystem.h"
+#include "PhongKernel.h"
+
+#include <vector>
+
+/***********************************************************
+ *  SoftwareRenderer
+ *
+ *  This class contains the code for a CPU rendering backend
+ *  that needs no OpenGL context.  It draws the same draw
+ *  lists, meshes, materials and lights as the shaders, and
+ *  the frames are made in three steps:
+ *
+ *  - the triangles of every command are transformed,
+ *    clipped against the near plane and set up as edge
+ *    functions, spread over the job system by command
+ *  - the set up triangles are added to the bins of the
+ *    screen tiles they touch, in the order of the draw list
+ *  - every tile is rasterized and shaded by its own job,
+ *    testing four pixels at a time against the edges and
+ *    lighting the covered pixels in batches with the SIMD
+ *    Phong kernel
+ *
+ *  A tile draws its triangles in the order of the draw
+ *  list, so the blending matches the GPU.
+ ***********************************************************/
+class SoftwareRenderer
+{
+public:
+	// width and height of a screen tile in pixels
+	static const int TILE_SIZE = 64;
+
+	// work done by the frames since the renderer was created
+	struct RENDER_STATISTICS
+	{
+		unsigned int frames;
+		unsigned long long triangles;		// triangles that reached the set up
+		unsigned long long binnedTriangles;	// triangle and tile pairs
+		unsigned long long shadedPixels;	// pixels that passed the depth test
+		double seconds;
+	};
+
+	// constructor
+	SoftwareRenderer(SceneManager* pSceneManager);
+	// destructor
+	~SoftwareRenderer();
+
+	// spread the frame work over a job system, or NULL
+	void SetJobSystem(JobSystem* pJobSystem);
+
+	// create the color and depth buffers with the passed in size
+	bool Create(int width, int height);
+
+	// draw a list with the camera and the lights of the frame
+	// constants, the list has to be updated for the same camera
+	void Render(const SceneManager::DRAW_LIST& drawList, const FrameUniformBuffer::FRAME_CONSTANTS& frame);
+
+	// the color buffer as RGBA rows, the first row at the bottom
+	const std::vector<unsigned char>& GetPixels() const { return m_color; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	// save the color buffer as a PNG image file
+	bool SavePNG(const char* filename) const;
+
+	// print the triangle and pixel throughput of the frames
+	const RENDER_STATISTICS& GetStatistics() const { return m_statistics; }
+	void PrintReport() const;
+
+private:
+	// a vertex after the vertex stage
+	struct CLIP_VERTEX
+	{
+		glm::vec4 clipPosition;
+		glm::vec3 worldPosition;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// the shader settings of a command, with the carried over
+	// material resolved and combined with the lights
+	struct SHADE_STATE
+	{
+		PhongKernel::PHONG_CONSTANTS lighting;
+		const SceneManager::TEXTURE_IMAGE* pTexture;
+		bool bUseTexture;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+	};
+
+	// the values of a triangle, as planes a * x + b * y + c over
+	// the screen - the attributes are divided by w, so that they
+	// can be corrected for the perspective per pixel
+	enum PLANE
+	{
+		PLANE_DEPTH,
+		PLANE_INVERSE_W,
+		PLANE_POSITION_X,
+		PLANE_POSITION_Y,
+		PLANE_POSITION_Z,
+		PLANE_NORMAL_X,
+		PLANE_NORMAL_Y,
+		PLANE_NORMAL_Z,
+		PLANE_TEXTURE_U,
+		PLANE_TEXTURE_V,
+		PLANE_COUNT
+	};
+
+	// a triangle ready for the rasterizer
+	struct SETUP_TRIANGLE
+	{
+		// the edge functions a * x + b * y + c are positive inside
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		// pixels exactly on a top or left edge belong to the triangle
+		bool bTopLeft[3];
+		float planes[PLANE_COUNT][3];
+		// pixel bounds, inclusive
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		int state;
+	};
+
+	// the pixels of a triangle that passed the depth test, lit
+	// together once the batch is full or the triangle is done
+	struct PIXEL_BATCH
+	{
+		PhongKernel::SHADE_BATCH lighting;
+		int pixels[PhongKernel::BATCH_SIZE];
+		glm::vec2 textureCoordinates[PhongKernel::BATCH_SIZE];
+	};
+
+	SceneManager* m_pSceneManager;
+	JobSystem* m_pJobSystem;
+
+	// the triangles of every mesh type, three vertices each
+	std::vector<std::vector<ShapeMeshes::MESH_VERTEX> > m_meshTriangles;
+	bool m_bMeshesCaptured;
+
+	// the buffers, RGBA bytes and window depth per pixel
+	int m_width;
+	int m_height;
+	std::vector<unsigned char> m_color;
+	std::vector<float> m_depth;
+
+	// the work of the current frame
+	std::vector<SHADE_STATE> m_states;
+	std::vector<std::vector<SETUP_TRIANGLE> > m_commandTriangles;
+	std::vector<SETUP_TRIANGLE> m_triangles;
+	int m_tilesX;
+	int m_tilesY;
+	std::vector<std::vector<int> > m_tileBins;
+	std::vector<unsigned long long> m_tilePixels;
+
+	RENDER_STATISTICS m_statistics;
+
+	// transform, clip and set up the triangles of one command
+	void ProcessCommand(const SceneManager::DRAW_COMMAND& command, int state, std::vector<SETUP_TRIANGLE>& triangles) const;
+	// set up a triangle in clip space, false when it covers no pixel
+	bool SetupTriangle(const CLIP_VERTEX& v0, const CLIP_VERTEX& v1, const CLIP_VERTEX& v2, int state, SETUP_TRIANGLE& triangle) const;
+	// rasterize and shade the binned triangles of a tile
+	void RenderTile(int tile);
+	// light a batch of pixels, color them like the fragment
+	// shader and blend them into the color buffer
+	void ShadeBatch(const SHADE_STATE& state, PIXEL_BATCH& batch);
+	// sample a texture image with bilinear filtering and wrapping
+	static glm::vec4 SampleTexture(const SceneManager::TEXTURE_IMAGE* pTexture, const glm::vec2& textureCoordinate);
+};
@@ -0,0 +1,573 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.cpp
+// ============
+// build the model matrices of many objects at once from their scale,
+// rotation and position, using the widest SIMD instructions available
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+// the x86 kernels are all built, and picked at runtime like the ones of
+// the PhongKernel
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define TRANSFORM_BATCH_X86
+#include <immintrin.h>
+#endif
+
+#if defined(TRANSFORM_BATCH_X86) && !defined(_MSC_VER)
+#define TRANSFORM_TARGET_SSE2 __attribute__((target("sse2")))
+#define TRANSFORM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TRANSFORM_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TRANSFORM_TARGET_SSE2
+#define TRANSFORM_TARGET_AVX2
+#define TRANSFORM_TARGET_AVX512
+#endif
+
+// declaration of global variables
+namespace
+{
+	const float g_RadiansPerDegree = 0.0174532925f;
+
+	// sin(x) and cos(x) for x in [-pi/4, pi/4], the polynomials of
+	// the Cephes library, off by less than one float step
+	const float SIN_C1 = -1.6666654611e-1f;
+	const float SIN_C2 = 8.3321608736e-3f;
+	const float SIN_C3 = -1.9515295891e-4f;
+	const float COS_C1 = 4.166664568298827e-2f;
+	const float COS_C2 = -1.388731625493765e-3f;
+	const float COS_C3 = 2.443315711809948e-5f;
+
+	// objects of each size in the benchmark
+	const int g_BenchmarkCounts[2] = { 10000, 1000000 };
+	// time each kernel of the benchmark runs for
+	const double g_BenchmarkSeconds = 0.25;
+	// largest difference to the glm matrices, relative to the
+	// element or to 1 for the smaller elements
+	const float g_ErrorTolerance = 1e-5f;
+
+	typedef void (*TRANSFORM_FUNCTION)(const TransformBatch::TRANSFORM_ARRAYS&, int, int, glm::mat4*);
+
+	/***********************************************************
+	 *  scalar kernel, one object at a time
+	 ***********************************************************/
+	inline void SinCosDegrees(float degrees, float& sine, float& cosine)
+	{
+		// the angle is split into quarter turns and the rest, which is
+		// exact, so only the rest has to be converted to radians
+		int quadrant = (int)lrintf(degrees * (1.0f / 90.0f));
+		float x = (degrees - ((float)quadrant * 90.0f)) * g_RadiansPerDegree;
+		float z = x * x;
+		float sinPoly = x + (x * z * (SIN_C1 + z * (SIN_C2 + z * SIN_C3)));
+		float cosPoly = 1.0f - (0.5f * z) + (z * z * (COS_C1 + z * (COS_C2 + z * COS_C3)));
+
+		sine = (quadrant & 1) ? cosPoly : sinPoly;
+		cosine = (quadrant & 1) ? sinPoly : cosPoly;
+		if (quadrant & 2)
+		{
+			sine = -sine;
+		}
+		if ((quadrant + 1) & 2)
+		{
+			cosine = -cosine;
+		}
+	}
+
+	void ComputeModelsScalar(const TransformBatch::TRANSFORM_ARRAYS& transforms, int begin, int end, glm::mat4* models)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			float sx, cx, sy, cy, sz, cz;
+			SinCosDegrees(transforms.rotationX[i], sx, cx);
+			SinCosDegrees(transforms.rotationY[i], sy, cy);
+			SinCosDegrees(transforms.rotationZ[i], sz, cz);
+
+			float cxsy = cx * sy;
+			float sxsy = sx * sy;
+			float scaleX = transforms.scaleX[i];
+			float scaleY = transforms.scaleY[i];
+			float scaleZ = transforms.scaleZ[i];
+
+			glm::mat4& model = models[i];
+			model[0] = glm::vec4(cy * cz * scaleX, (cx * sz + sxsy * cz) * scaleX, (sx * sz - cxsy * cz) * scaleX, 0.0f);
+			model[1] = glm::vec4(-cy * sz * scaleY, (cx * cz - sxsy * sz) * scaleY, (sx * cz + cxsy * sz) * scaleY, 0.0f);
+			model[2] = glm::vec4(sy * scaleZ, -sx * cy * scaleZ, cx * cy * scaleZ, 0.0f);
+			model[3] = glm::vec4(transforms.positionX[i], transforms.positionY[i], transforms.positionZ[i], 1.0f);
+		}
+	}
+
+#ifdef TRANSFORM_BATCH_X86
+	/***********************************************************
+	 *  SSE2 kernel, 4 objects at a time
+	 ***********************************************************/
+	TRANSFORM_TARGET_SSE2 inline void SinCosSSE2(__m128 degrees, __m128& sine, __m128& cosine)
+	{
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(degrees, _mm_set1_ps(1.0f / 90.0f)));
+		__m128 x = _mm_mul_ps(_mm_sub_ps(degrees, _mm_mul_ps(_mm_cvtepi32_ps(quadrant), _mm_set1_ps(90.0f))),
+			_mm_set1_ps(g_RadiansPerDegree));
+		__m128 z = _mm_mul_ps(x, x);
+		__m128 sinPoly = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x, z),
+			_mm_add_ps(_mm_set1_ps(SIN_C1), _mm_mul_ps(z, _mm_add_ps(_mm_set1_ps(SIN_C2), _mm_mul_ps(z, _mm_set1_ps(SIN_C3)))))));
+		__m128 cosPoly = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z),
+			_mm_add_ps(_mm_set1_ps(COS_C1), _mm_mul_ps(z, _mm_add_ps(_mm_set1_ps(COS_C2), _mm_mul_ps(z, _mm_set1_ps(COS_C3)))))));
+
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+		sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cosPoly), _mm_andnot_ps(swap, sinPoly)), sinSign);
+		cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sinPoly), _mm_andnot_ps(swap, cosPoly)), cosSign);
+	}
+
+	// the values are one row of a column for 4 objects, transposed
+	// into the column of every object
+	TRANSFORM_TARGET_SSE2 inline void StoreColumnsSSE2(__m128 x, __m128 y, __m128 z, __m128 w, int column, glm::mat4* models)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&models[0][column][0], x);
+		_mm_storeu_ps(&models[1][column][0], y);
+		_mm_storeu_ps(&models[2][column][0], z);
+		_mm_storeu_ps(&models[3][column][0], w);
+	}
+
+	TRANSFORM_TARGET_SSE2 void ComputeModelsSSE2(const TransformBatch::TRANSFORM_ARRAYS& transforms, int begin, int end, glm::mat4* models)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		int i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 sx, cx, sy, cy, sz, cz;
+			SinCosSSE2(_mm_loadu_ps(&transforms.rotationX[i]), sx, cx);
+			SinCosSSE2(_mm_loadu_ps(&transforms.rotationY[i]), sy, cy);
+			SinCosSSE2(_mm_loadu_ps(&transforms.rotationZ[i]), sz, cz);
+
+			__m128 cxsy = _mm_mul_ps(cx, sy);
+			__m128 sxsy = _mm_mul_ps(sx, sy);
+			__m128 scaleX = _mm_loadu_ps(&transforms.scaleX[i]);
+			__m128 scaleY = _mm_loadu_ps(&transforms.scaleY[i]);
+			__m128 scaleZ = _mm_loadu_ps(&transforms.scaleZ[i]);
+
+			StoreColumnsSSE2(
+				_mm_mul_ps(_mm_mul_ps(cy, cz), scaleX),
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(cx, sz), _mm_mul_ps(sxsy, cz)), scaleX),
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sx, sz), _mm_mul_ps(cxsy, cz)), scaleX),
+				zero, 0, &models[i]);
+			StoreColumnsSSE2(
+				_mm_sub_ps(zero, _mm_mul_ps(_mm_mul_ps(cy, sz), scaleY)),
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cx, cz), _mm_mul_ps(sxsy, sz)), scaleY),
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(sx, cz), _mm_mul_ps(cxsy, sz)), scaleY),
+				zero, 1, &models[i]);
+			StoreColumnsSSE2(
+				_mm_mul_ps(sy, scaleZ),
+				_mm_sub_ps(zero, _mm_mul_ps(_mm_mul_ps(sx, cy), scaleZ)),
+				_mm_mul_ps(_mm_mul_ps(cx, cy), scaleZ),
+				zero, 2, &models[i]);
+			StoreColumnsSSE2(
+				_mm_loadu_ps(&transforms.positionX[i]),
+				_mm_loadu_ps(&transforms.positionY[i]),
+				_mm_loadu_ps(&transforms.positionZ[i]),
+				one, 3, &models[i]);
+		}
+		ComputeModelsScalar(transforms, i, end, models);
+	}
+
+	/***********************************************************
+	 *  AVX2 kernel, 8 objects at a time
+	 ***********************************************************/
+	TRANSFORM_TARGET_AVX2 inline void SinCosAVX2(__m256 degrees, __m256& sine, __m256& cosine)
+	{
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i two = _mm256_set1_epi32(2);
+
+		__m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(degrees, _mm256_set1_ps(1.0f / 90.0f)));
+		__m256 x = _mm256_mul_ps(_mm256_fnmadd_ps(_mm256_cvtepi32_ps(quadrant), _mm256_set1_ps(90.0f), degrees),
+			_mm256_set1_ps(g_RadiansPerDegree));
+		__m256 z = _mm256_mul_ps(x, x);
+		__m256 sinPoly = _mm256_fmadd_ps(_mm256_mul_ps(x, z),
+			_mm256_fmadd_ps(z, _mm256_fmadd_ps(z, _mm256_set1_ps(SIN_C3), _mm256_set1_ps(SIN_C2)), _mm256_set1_ps(SIN_C1)), x);
+		__m256 cosPoly = _mm256_fmadd_ps(_mm256_mul_ps(z, z),
+			_mm256_fmadd_ps(z, _mm256_fmadd_ps(z, _mm256_set1_ps(COS_C3), _mm256_set1_ps(COS_C2)), _mm256_set1_ps(COS_C1)),
+			_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, _mm256_set1_ps(1.0f)));
+
+		__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+		__m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+		__m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+		sine = _mm256_xor_ps(_mm256_blendv_ps(sinPoly, cosPoly, swap), sinSign);
+		cosine = _mm256_xor_ps(_mm256_blendv_ps(cosPoly, sinPoly, swap), cosSign);
+	}
+
+	// the transpose works within the 128 bit halves, so the low
+	// halves are the objects 0 to 3 and the high ones 4 to 7
+	TRANSFORM_TARGET_AVX2 inline void StoreColumnsAVX2(__m256 x, __m256 y, __m256 z, __m256 w, int column, glm::mat4* models)
+	{
+		__m256 xy0 = _mm256_unpacklo_ps(x, y);
+		__m256 xy1 = _mm256_unpackhi_ps(x, y);
+		__m256 zw0 = _mm256_unpacklo_ps(z, w);
+		__m256 zw1 = _mm256_unpackhi_ps(z, w);
+		__m256 object0 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 object1 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 object2 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 object3 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2));
+
+		_mm_storeu_ps(&models[0][column][0], _mm256_castps256_ps128(object0));
+		_mm_storeu_ps(&models[1][column][0], _mm256_castps256_ps128(object1));
+		_mm_storeu_ps(&models[2][column][0], _mm256_castps256_ps128(object2));
+		_mm_storeu_ps(&models[3][column][0], _mm256_castps256_ps128(object3));
+		_mm_storeu_ps(&models[4][column][0], _mm256_extractf128_ps(object0, 1));
+		_mm_storeu_ps(&models[5][column][0], _mm256_extractf128_ps(object1, 1));
+		_mm_storeu_ps(&models[6][column][0], _mm256_extractf128_ps(object2, 1));
+		_mm_storeu_ps(&models[7][column][0], _mm256_extractf128_ps(object3, 1));
+	}
+
+	TRANSFORM_TARGET_AVX2 void ComputeModelsAVX2(const TransformBatch::TRANSFORM_ARRAYS& transforms, int begin, int end, glm::mat4* models)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+
+		int i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 sx, cx, sy, cy, sz, cz;
+			SinCosAVX2(_mm256_loadu_ps(&transforms.rotationX[i]), sx, cx);
+			SinCosAVX2(_mm256_loadu_ps(&transforms.rotationY[i]), sy, cy);
+			SinCosAVX2(_mm256_loadu_ps(&transforms.rotationZ[i]), sz, cz);
+
+			__m256 cxsy = _mm256_mul_ps(cx, sy);
+			__m256 sxsy = _mm256_mul_ps(sx, sy);
+			__m256 scaleX = _mm256_loadu_ps(&transforms.scaleX[i]);
+			__m256 scaleY = _mm256_loadu_ps(&transforms.scaleY[i]);
+			__m256 scaleZ = _mm256_loadu_ps(&transforms.scaleZ[i]);
+
+			StoreColumnsAVX2(
+				_mm256_mul_ps(_mm256_mul_ps(cy, cz), scaleX),
+				_mm256_mul_ps(_mm256_fmadd_ps(cx, sz, _mm256_mul_ps(sxsy, cz)), scaleX),
+				_mm256_mul_ps(_mm256_fmsub_ps(sx, sz, _mm256_mul_ps(cxsy, cz)), scaleX),
+				zero, 0, &models[i]);
+			StoreColumnsAVX2(
+				_mm256_sub_ps(zero, _mm256_mul_ps(_mm256_mul_ps(cy, sz), scaleY)),
+				_mm256_mul_ps(_mm256_fmsub_ps(cx, cz, _mm256_mul_ps(sxsy, sz)), scaleY),
+				_mm256_mul_ps(_mm256_fmadd_ps(sx, cz, _mm256_mul_ps(cxsy, sz)), scaleY),
+				zero, 1, &models[i]);
+			StoreColumnsAVX2(
+				_mm256_mul_ps(sy, scaleZ),
+				_mm256_sub_ps(zero, _mm256_mul_ps(_mm256_mul_ps(sx, cy), scaleZ)),
+				_mm256_mul_ps(_mm256_mul_ps(cx, cy), scaleZ),
+				zero, 2, &models[i]);
+			StoreColumnsAVX2(
+				_mm256_loadu_ps(&transforms.positionX[i]),
+				_mm256_loadu_ps(&transforms.positionY[i]),
+				_mm256_loadu_ps(&transforms.positionZ[i]),
+				one, 3, &models[i]);
+		}
+		ComputeModelsScalar(transforms, i, end, models);
+	}
+
+	/***********************************************************
+	 *  AVX-512 kernel, 16 objects at a time
+	 ***********************************************************/
+	TRANSFORM_TARGET_AVX512 inline void SinCosAVX512(__m512 degrees, __m512& sine, __m512& cosine)
+	{
+		const __m512i one = _mm512_set1_epi32(1);
+		const __m512i two = _mm512_set1_epi32(2);
+
+		__m512i quadrant = _mm512_cvtps_epi32(_mm512_mul_ps(degrees, _mm512_set1_ps(1.0f / 90.0f)));
+		__m512 x = _mm512_mul_ps(_mm512_fnmadd_ps(_mm512_cvtepi32_ps(quadrant), _mm512_set1_ps(90.0f), degrees),
+			_mm512_set1_ps(g_RadiansPerDegree));
+		__m512 z = _mm512_mul_ps(x, x);
+		__m512 sinPoly = _mm512_fmadd_ps(_mm512_mul_ps(x, z),
+			_mm512_fmadd_ps(z, _mm512_fmadd_ps(z, _mm512_set1_ps(SIN_C3), _mm512_set1_ps(SIN_C2)), _mm512_set1_ps(SIN_C1)), x);
+		__m512 cosPoly = _mm512_fmadd_ps(_mm512_mul_ps(z, z),
+			_mm512_fmadd_ps(z, _mm512_fmadd_ps(z, _mm512_set1_ps(COS_C3), _mm512_set1_ps(COS_C2)), _mm512_set1_ps(COS_C1)),
+			_mm512_fnmadd_ps(_mm512_set1_ps(0.5f), z, _mm512_set1_ps(1.0f)));
+
+		__mmask16 swap = _mm512_test_epi32_mask(quadrant, one);
+		__m512i sinSign = _mm512_slli_epi32(_mm512_and_si512(quadrant, two), 30);
+		__m512i cosSign = _mm512_slli_epi32(_mm512_and_si512(_mm512_add_epi32(quadrant, one), two), 30);
+		sine = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_mask_blend_ps(swap, sinPoly, cosPoly)), sinSign));
+		cosine = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_mask_blend_ps(swap, cosPoly, sinPoly)), cosSign));
+	}
+
+	// the transpose works within the 128 bit quarters, so quarter
+	// n holds the objects 4n to 4n + 3
+	TRANSFORM_TARGET_AVX512 inline void StoreColumnsAVX512(__m512 x, __m512 y, __m512 z, __m512 w, int column, glm::mat4* models)
+	{
+		__m512 xy0 = _mm512_unpacklo_ps(x, y);
+		__m512 xy1 = _mm512_unpackhi_ps(x, y);
+		__m512 zw0 = _mm512_unpacklo_ps(z, w);
+		__m512 zw1 = _mm512_unpackhi_ps(z, w);
+		__m512 object0 = _mm512_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0));
+		__m512 object1 = _mm512_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2));
+		__m512 object2 = _mm512_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0));
+		__m512 object3 = _mm512_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2));
+
+		_mm_storeu_ps(&models[0][column][0], _mm512_castps512_ps128(object0));
+		_mm_storeu_ps(&models[1][column][0], _mm512_castps512_ps128(object1));
+		_mm_storeu_ps(&models[2][column][0], _mm512_castps512_ps128(object2));
+		_mm_storeu_ps(&models[3][column][0], _mm512_castps512_ps128(object3));
+		_mm_storeu_ps(&models[4][column][0], _mm512_extractf32x4_ps(object0, 1));
+		_mm_storeu_ps(&models[5][column][0], _mm512_extractf32x4_ps(object1, 1));
+		_mm_storeu_ps(&models[6][column][0], _mm512_extractf32x4_ps(object2, 1));
+		_mm_storeu_ps(&models[7][column][0], _mm512_extractf32x4_ps(object3, 1));
+		_mm_storeu_ps(&models[8][column][0], _mm512_extractf32x4_ps(object0, 2));
+		_mm_storeu_ps(&models[9][column][0], _mm512_extractf32x4_ps(object1, 2));
+		_mm_storeu_ps(&models[10][column][0], _mm512_extractf32x4_ps(object2, 2));
+		_mm_storeu_ps(&models[11][column][0], _mm512_extractf32x4_ps(object3, 2));
+		_mm_storeu_ps(&models[12][column][0], _mm512_extractf32x4_ps(object0, 3));
+		_mm_storeu_ps(&models[13][column][0], _mm512_extractf32x4_ps(object1, 3));
+		_mm_storeu_ps(&models[14][column][0], _mm512_extractf32x4_ps(object2, 3));
+		_mm_storeu_ps(&models[15][column][0], _mm512_extractf32x4_ps(object3, 3));
+	}
+
+	TRANSFORM_TARGET_AVX512 void ComputeModelsAVX512(const TransformBatch::TRANSFORM_ARRAYS& transforms, int begin, int end, glm::mat4* models)
+	{
+		const __m512 zero = _mm512_setzero_ps();
+		const __m512 one = _mm512_set1_ps(1.0f);
+
+		int i = begin;
+		for (; i + 16 <= end; i += 16)
+		{
+			__m512 sx, cx, sy, cy, sz, cz;
+			SinCosAVX512(_mm512_loadu_ps(&transforms.rotationX[i]), sx, cx);
+			SinCosAVX512(_mm512_loadu_ps(&transforms.rotationY[i]), sy, cy);
+			SinCosAVX512(_mm512_loadu_ps(&transforms.rotationZ[i]), sz, cz);
+
+			__m512 cxsy = _mm512_mul_ps(cx, sy);
+			__m512 sxsy = _mm512_mul_ps(sx, sy);
+			__m512 scaleX = _mm512_loadu_ps(&transforms.scaleX[i]);
+			__m512 scaleY = _mm512_loadu_ps(&transforms.scaleY[i]);
+			__m512 scaleZ = _mm512_loadu_ps(&transforms.scaleZ[i]);
+
+			StoreColumnsAVX512(
+				_mm512_mul_ps(_mm512_mul_ps(cy, cz), scaleX),
+				_mm512_mul_ps(_mm512_fmadd_ps(cx, sz, _mm512_mul_ps(sxsy, cz)), scaleX),
+				_mm512_mul_ps(_mm512_fmsub_ps(sx, sz, _mm512_mul_ps(cxsy, cz)), scaleX),
+				zero, 0, &models[i]);
+			StoreColumnsAVX512(
+				_mm512_sub_ps(zero, _mm512_mul_ps(_mm512_mul_ps(cy, sz), scaleY)),
+				_mm512_mul_ps(_mm512_fmsub_ps(cx, cz, _mm512_mul_ps(sxsy, sz)), scaleY),
+				_mm512_mul_ps(_mm512_fmadd_ps(sx, cz, _mm512_mul_ps(cxsy, sz)), scaleY),
+				zero, 1, &models[i]);
+			StoreColumnsAVX512(
+				_mm512_mul_ps(sy, scaleZ),
+				_mm512_sub_ps(zero, _mm512_mul_ps(_mm512_mul_ps(sx, cy), scaleZ)),
+				_mm512_mul_ps(_mm512_mul_ps(cx, cy), scaleZ),
+				zero, 2, &models[i]);
+			StoreColumnsAVX512(
+				_mm512_loadu_ps(&transforms.positionX[i]),
+				_mm512_loadu_ps(&transforms.positionY[i]),
+				_mm512_loadu_ps(&transforms.positionZ[i]),
+				one, 3, &models[i]);
+		}
+		ComputeModelsScalar(transforms, i, end, models);
+	}
+#endif
+
+	// the kernels that were built, by instruction set - ARM64 uses
+	// the scalar kernel, which the compiler vectorizes already
+	const TRANSFORM_FUNCTION g_TransformFunctions[PhongKernel::INSTRUCTION_SET_COUNT] = {
+		&ComputeModelsScalar,
+#ifdef TRANSFORM_BATCH_X86
+		&ComputeModelsSSE2,
+#else
+		NULL,
+#endif
+		NULL,
+#ifdef TRANSFORM_BATCH_X86
+		&ComputeModelsAVX2,
+		&ComputeModelsAVX512,
+#else
+		NULL,
+		NULL,
+#endif
+	};
+
+	// the values of the benchmark objects
+	struct BENCHMARK_OBJECTS
+	{
+		std::vector<float> values[9];
+		TransformBatch::TRANSFORM_ARRAYS transforms;
+	};
+}
+
+/***********************************************************
+ *  ComputeModels()
+ *
+ *  This method is used to build the model matrices of a
+ *  batch of objects with the kernel that PhongKernel uses.
+ *  The matrices are written to an array in memory, and are
+ *  stored without alignment, so the array can be packed.
+ ***********************************************************/
+void TransformBatch::ComputeModels(const TRANSFORM_ARRAYS& transforms, int count, glm::mat4* models)
+{
+	ComputeModels(PhongKernel::GetInstructionSet(), transforms, count, models);
+}
+
+/***********************************************************
+ *  ComputeModels()
+ *
+ *  This method is used to build the model matrices of a
+ *  batch of objects with the kernel of an instruction set.
+ ***********************************************************/
+void TransformBatch::ComputeModels(PhongKernel::INSTRUCTION_SET instructionSet,
+	const TRANSFORM_ARRAYS& transforms, int count, glm::mat4* models)
+{
+	TRANSFORM_FUNCTION compute = &ComputeModelsScalar;
+	if (PhongKernel::IsSupported(instructionSet) && (NULL != g_TransformFunctions[instructionSet]))
+	{
+		compute = g_TransformFunctions[instructionSet];
+	}
+	compute(transforms, 0, count, models);
+}
+
+/***********************************************************
+ *  ComputeModelReference()
+ *
+ *  This method is used to build the model matrix of one
+ *  object out of the six glm matrices, which is what the
+ *  kernels are checked and measured against.
+ ***********************************************************/
+glm::mat4 TransformBatch::ComputeModelReference(const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	glm::mat4 scaleMatrix = glm::scale(scale);
+	glm::mat4 rotationX = glm::rotate(glm::radians(rotationDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	glm::mat4 rotationY = glm::rotate(glm::radians(rotationDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 rotationZ = glm::rotate(glm::radians(rotationDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 translation = glm::translate(position);
+
+	return(translation * rotationX * rotationY * rotationZ * scaleMatrix);
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used to measure how many model matrices
+ *  per second every supported kernel builds on one core,
+ *  and the glm matrices they replace.  A quarter of the
+ *  objects are turned by multiples of 90 degrees, like
+ *  most of the scene objects.  Every kernel is checked
+ *  against the glm matrices, and the benchmark fails when
+ *  one is off by too much.
+ ***********************************************************/
+bool TransformBatch::RunBenchmark()
+{
+	printf("INFO: Transform batch benchmark on one core\n");
+
+	bool bPassed = true;
+	for (int size = 0; size < 2; size++)
+	{
+		int count = g_BenchmarkCounts[size];
+
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<float> scales(0.1f, 4.0f);
+		std::uniform_real_distribution<float> angles(-360.0f, 360.0f);
+		std::uniform_real_distribution<float> positions(-50.0f, 50.0f);
+		std::uniform_int_distribution<int> quarters(-4, 4);
+
+		BENCHMARK_OBJECTS objects;
+		for (int v = 0; v < 9; v++)
+		{
+			objects.values[v].resize(count);
+		}
+		for (int i = 0; i < count; i++)
+		{
+			bool bQuarterTurns = (i % 4) == 0;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				objects.values[axis][i] = scales(generator);
+				objects.values[3 + axis][i] = bQuarterTurns ? 90.0f * quarters(generator) : angles(generator);
+				objects.values[6 + axis][i] = positions(generator);
+			}
+		}
+		TRANSFORM_ARRAYS& transforms = objects.transforms;
+		transforms.scaleX = &objects.values[0][0];
+		transforms.scaleY = &objects.values[1][0];
+		transforms.scaleZ = &objects.values[2][0];
+		transforms.rotationX = &objects.values[3][0];
+		transforms.rotationY = &objects.values[4][0];
+		transforms.rotationZ = &objects.values[5][0];
+		transforms.positionX = &objects.values[6][0];
+		transforms.positionY = &objects.values[7][0];
+		transforms.positionZ = &objects.values[8][0];
+
+		// the chained glm matrices, as SetTransformations() built them
+		std::vector<glm::mat4> reference(count);
+		long long iterations = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double seconds = 0.0;
+		do
+		{
+			for (int i = 0; i < count; i++)
+			{
+				reference[i] = ComputeModelReference(
+					glm::vec3(transforms.scaleX[i], transforms.scaleY[i], transforms.scaleZ[i]),
+					glm::vec3(transforms.rotationX[i], transforms.rotationY[i], transforms.rotationZ[i]),
+					glm::vec3(transforms.positionX[i], transforms.positionY[i], transforms.positionZ[i]));
+			}
+			iterations++;
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (seconds < g_BenchmarkSeconds);
+
+		double glmNanoseconds = seconds * 1e9 / ((double)iterations * count);
+		printf("INFO: Transform batch %7d objects, glm     %7.2f ns per object\n", count, glmNanoseconds);
+
+		std::vector<glm::mat4> models(count);
+		for (int set = 0; set < PhongKernel::INSTRUCTION_SET_COUNT; set++)
+		{
+			PhongKernel::INSTRUCTION_SET instructionSet = (PhongKernel::INSTRUCTION_SET)set;
+			if (!PhongKernel::IsSupported(instructionSet) || (NULL == g_TransformFunctions[set]))
+			{
+				continue;
+			}
+
+			// the first pass is checked, and warms up the caches
+			ComputeModels(instructionSet, transforms, count, &models[0]);
+			float largestError = 0.0f;
+			for (int i = 0; i < count; i++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					for (int row = 0; row < 4; row++)
+					{
+						float expected = reference[i][column][row];
+						float error = fabsf(models[i][column][row] - expected) / std::max(fabsf(expected), 1.0f);
+						largestError = std::max(largestError, error);
+					}
+				}
+			}
+
+			iterations = 0;
+			start = std::chrono::steady_clock::now();
+			do
+			{
+				ComputeModels(instructionSet, transforms, count, &models[0]);
+				iterations++;
+				seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			} while (seconds < g_BenchmarkSeconds);
+
+			double nanoseconds = seconds * 1e9 / ((double)iterations * count);
+			bool bAccurate = largestError <= g_ErrorTolerance;
+			printf("INFO: Transform batch %7d objects, %-7s %7.2f ns per object (%5.2fx glm), largest error %.2e%s\n",
+				count, PhongKernel::GetInstructionSetName(instructionSet), nanoseconds,
+				(nanoseconds > 0.0) ? glmNanoseconds / nanoseconds : 0.0,
+				largestError, bAccurate ? "" : " - too large");
+			bPassed = bPassed && bAccurate;
+		}
+	}
+
+	PhongKernel::INSTRUCTION_SET active = PhongKernel::GetInstructionSet();
+	printf("INFO: Transform batch kernel in use: %s\n",
+		PhongKernel::GetInstructionSetName((NULL != g_TransformFunctions[active]) ? active : PhongKernel::INSTRUCTIONS_SCALAR));
+	return bPassed;
+}
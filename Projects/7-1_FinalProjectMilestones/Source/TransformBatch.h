@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.h
+// ============
+// build the model matrices of many objects at once from their scale,
+// rotation and position, using the widest SIMD instructions available
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PhongKernel.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TransformBatch
+ *
+ *  This class contains the code for building the model
+ *  matrices of a batch of objects.  The matrix of every
+ *  object is the same as
+ *
+ *      translate * rotateX * rotateY * rotateZ * scale
+ *
+ *  which SetTransformations() used to build out of six
+ *  matrices and four products.  Here the product is written
+ *  out, so every element is a few multiplications of the
+ *  sines and cosines of the angles and the scale.
+ *
+ *  The transformations are passed as a structure of arrays
+ *  so that one instruction works on 4, 8 or 16 objects, and
+ *  the kernel is the one PhongKernel picked for the
+ *  processor.  The sines and cosines come from polynomials
+ *  after the angles are reduced to [-45, 45] degrees, which
+ *  keeps the multiples of 90 degrees exact.
+ ***********************************************************/
+class TransformBatch
+{
+public:
+	// the transformation values of a batch of objects, one
+	// array per component, rotations in degrees
+	struct TRANSFORM_ARRAYS
+	{
+		const float* scaleX;
+		const float* scaleY;
+		const float* scaleZ;
+		const float* rotationX;
+		const float* rotationY;
+		const float* rotationZ;
+		const float* positionX;
+		const float* positionY;
+		const float* positionZ;
+	};
+
+	// write the model matrices of count objects to an array,
+	// with the kernel PhongKernel selected
+	static void ComputeModels(const TRANSFORM_ARRAYS& transforms, int count, glm::mat4* models);
+	// the same with a kernel of an instruction set, or the scalar
+	// one when the kernel was not built
+	static void ComputeModels(PhongKernel::INSTRUCTION_SET instructionSet,
+		const TRANSFORM_ARRAYS& transforms, int count, glm::mat4* models);
+	// the matrix of one object built the way glm chains it
+	static glm::mat4 ComputeModelReference(const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position);
+
+	// measure the objects per second of every supported kernel
+	// against the chained glm matrices, for 10 thousand and for a
+	// million objects
+	static bool RunBenchmark();
+};
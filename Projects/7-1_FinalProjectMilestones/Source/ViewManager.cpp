@@ -8,20 +8,21 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "FrameProfiler.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>    
 
+#include <chrono>
+
 // declaration of the global variables and defines
 namespace
 {
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -37,9 +38,29 @@ namespace
 	float gDeltaTime = 0.0f; 
 	float gLastFrame = 0.0f;
 
+	// fixed time between frames for repeatable runs, the camera
+	// does not follow the user input while it is set
+	float gFixedTimestep = 0.0f;
+
+	// set by the mouse events, and cleared once a frame has seen them
+	bool gMouseActivity = false;
+
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
 	bool bOrthographicProjection = false;
+
+	// records the input, or replays it in place of the window
+	InputRecorder g_InputRecorder;
+
+	// keys stored in a frame of an input recording, one bit each
+	const int g_TrackedKeys[] = {
+		GLFW_KEY_ESCAPE,
+		GLFW_KEY_W, GLFW_KEY_S,
+		GLFW_KEY_A, GLFW_KEY_D,
+		GLFW_KEY_E, GLFW_KEY_Q,
+		GLFW_KEY_P, GLFW_KEY_O
+	};
+	const int g_TrackedKeyCount = sizeof(g_TrackedKeys) / sizeof(g_TrackedKeys[0]);
 }
 
 /***********************************************************
@@ -53,6 +74,13 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_pOffscreenTarget = NULL;
+	m_viewState.view = glm::mat4(1.0f);
+	m_viewState.projection = glm::mat4(1.0f);
+	m_viewState.viewProjection = glm::mat4(1.0f);
+	m_viewState.viewPosition = glm::vec3(0.0f);
+	m_pressedKeys = 0;
+	m_bViewChanged = true;
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 10.0f, 18.0f); //was 0 5 12
@@ -71,6 +99,12 @@ ViewManager::~ViewManager()
 	// free up allocated memory
 	m_pShaderManager = NULL;
 	m_pWindow = NULL;
+	g_InputRecorder.Stop();
+	if (NULL != m_pOffscreenTarget)
+	{
+		delete m_pOffscreenTarget;
+		m_pOffscreenTarget = NULL;
+	}
 	if (NULL != g_pCamera)
 	{
 		delete g_pCamera;
@@ -85,6 +119,8 @@ ViewManager::~ViewManager()
  ***********************************************************/
 GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 {
+	TRACE_SCOPE("CreateDisplayWindow");
+
 	GLFWwindow* window = nullptr;
 
 	// try to create the displayed OpenGL window
@@ -119,13 +155,125 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	return(window);
 }
 
+/***********************************************************
+ *  CreateOffscreenTarget()
+ *
+ *  This method is used to create the framebuffer that the
+ *  scene is rendered into when there is no display window.
+ *  It has the same size as the window so that the rendered
+ *  frames can be compared with the interactive ones.
+ ***********************************************************/
+RenderTarget* ViewManager::CreateOffscreenTarget()
+{
+	TRACE_SCOPE("CreateOffscreenTarget");
+
+	RenderTarget* target = new RenderTarget();
+	if (target->Create(WINDOW_WIDTH, WINDOW_HEIGHT) == false)
+	{
+		std::cout << "Failed to create the offscreen render target" << std::endl;
+		delete target;
+		return NULL;
+	}
+	target->Bind();
+
+	// enable blending for supporting tranparent rendering
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	m_pOffscreenTarget = target;
+
+	return(target);
+}
+
+/***********************************************************
+ *  GetViewportSize()
+ *
+ *  This method is used to get the size of the window and
+ *  of the offscreen framebuffer in pixels.
+ ***********************************************************/
+void ViewManager::GetViewportSize(int& width, int& height) const
+{
+	width = WINDOW_WIDTH;
+	height = WINDOW_HEIGHT;
+}
+
+/***********************************************************
+ *  GetCamera()
+ *
+ *  This method is used to get the camera of the 3D view.
+ ***********************************************************/
+Camera* ViewManager::GetCamera()
+{
+	return(g_pCamera);
+}
+
+/***********************************************************
+ *  GetFrameClock()
+ *
+ *  This method is used to get the time that the frame
+ *  times are measured with.  GLFW is not initialized in
+ *  headless mode, so the standard clock is used there.
+ ***********************************************************/
+float ViewManager::GetFrameClock() const
+{
+	if (NULL != m_pWindow)
+	{
+		return (float)glfwGetTime();
+	}
+
+	static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	return std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+/***********************************************************
+ *  RestartFrameTime()
+ *
+ *  This method is used after the frame loop was blocked
+ *  waiting for events.  Without it, a key pressed at the
+ *  end of a long wait would move the camera as if it had
+ *  been held down for the whole wait.
+ ***********************************************************/
+void ViewManager::RestartFrameTime()
+{
+	gLastFrame = GetFrameClock();
+}
+
+/***********************************************************
+ *  SetFixedTimestep()
+ *
+ *  This method is used to make the frame time independent
+ *  of the clock, so that a run can be repeated exactly.
+ ***********************************************************/
+void ViewManager::SetFixedTimestep(float seconds)
+{
+	gFixedTimestep = seconds;
+}
+
 /***********************************************************
  *  Mouse_Position_Callback()
  *
  *  This method is automatically called from GLFW whenever
  *  the mouse is moved within the active GLFW display window.
  ***********************************************************/
-void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
+void ViewManager::Mouse_Position_Callback(GLFWwindow*, double xMousePos, double yMousePos)
+{
+	// the camera is driven by a script or a replay during repeatable runs
+	if ((gFixedTimestep > 0.0f) || g_InputRecorder.IsReplaying())
+	{
+		return;
+	}
+
+	g_InputRecorder.RecordMousePosition(xMousePos, yMousePos);
+	ApplyMousePosition(xMousePos, yMousePos);
+}
+
+/***********************************************************
+ *  ApplyMousePosition()
+ *
+ *  This method is used to turn the camera for a mouse move
+ *  from the window or from a replay.
+ ***********************************************************/
+void ViewManager::ApplyMousePosition(double xMousePos, double yMousePos)
 {
 	// when the first mouse move event is received, this needs to be recorded so that
 	// all subsequent mouse moves can correctly calculate the X position offset and Y
@@ -144,6 +292,7 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 	// set the current positions into the last position variables
 	gLastX = xMousePos;
 	gLastY = yMousePos;
+	gMouseActivity = true;
 
 	// move the 3D camera according to the calculated offsets
 	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
@@ -155,10 +304,28 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
  *  This method is automatically called from GLFW whenever
  *  the mouse is moved within the active GLFW display window.
  ***********************************************************/
-void ViewManager::Mouse_Scroll_Wheel_Callback(GLFWwindow*, double /*xoffset*/, double yoffset)
+void ViewManager::Mouse_Scroll_Wheel_Callback(GLFWwindow*, double xoffset, double yoffset)
+{
+	if (g_InputRecorder.IsReplaying())
+	{
+		return;
+	}
+
+	g_InputRecorder.RecordMouseScroll(xoffset, yoffset);
+	ApplyMouseScroll(xoffset, yoffset);
+}
+
+/***********************************************************
+ *  ApplyMouseScroll()
+ *
+ *  This method is used to change the camera speed for a
+ *  scroll wheel move from the window or from a replay.
+ ***********************************************************/
+void ViewManager::ApplyMouseScroll(double /*xoffset*/, double yoffset)
 {
 	if (yoffset > 0.0) gMoveSpeedFactor *= 1.15f;   // faster
 	if (yoffset < 0.0) gMoveSpeedFactor /= 1.15f;   // slower
+	gMouseActivity = true;
 }
 
 /***********************************************************
@@ -170,7 +337,7 @@ void ViewManager::Mouse_Scroll_Wheel_Callback(GLFWwindow*, double /*xoffset*/, d
 void ViewManager::ProcessKeyboardEvents()
 {
 	// close the window if the escape key has been pressed
-	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	if ((NULL != m_pWindow) && IsKeyPressed(GLFW_KEY_ESCAPE))
 	{
 		glfwSetWindowShouldClose(m_pWindow, true);
 	}
@@ -182,37 +349,37 @@ void ViewManager::ProcessKeyboardEvents()
 	}
 
 	// process camera zooming in and out
-	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_W))
 	{
 		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_S))
 	{
 		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
 	}
 
 	// process camera panning left and right
-	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_A))
 	{
 		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_D))
 	{
 		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
 	}
 
 	// process camera panning Up and Down
-	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_E))
 	{
 		g_pCamera->ProcessKeyboard(UP, gDeltaTime);
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_Q))
 	{
 		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
 	}
 
 	// process camera panning Perspective and orthographic
-	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_P))
 	{
 		//glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);  // and instance of glViewport
 		bOrthographicProjection = false;  // toggle Perspective
@@ -220,7 +387,7 @@ void ViewManager::ProcessKeyboardEvents()
 		//	<< (bOrthographicProjection ? "Orthographic" : "Perspective") // if false , show Perspective
 		//	<< std::endl;
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_O))
 	{
 		//glOrtho(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT, -1, 1);  // and instance of glOrtho
 		bOrthographicProjection = true;   // Orthographic
@@ -230,6 +397,113 @@ void ViewManager::ProcessKeyboardEvents()
 	}
 }
 
+/***********************************************************
+ *  IsKeyPressed()
+ *
+ *  This method is used to check if a key is held down in
+ *  the current frame.
+ ***********************************************************/
+bool ViewManager::IsKeyPressed(int key) const
+{
+	for (int i = 0; i < g_TrackedKeyCount; i++)
+	{
+		if (g_TrackedKeys[i] == key)
+		{
+			return (m_pressedKeys & (1 << i)) != 0;
+		}
+	}
+	return false;
+}
+
+/***********************************************************
+ *  PollKeys()
+ *
+ *  This method is used to read the tracked keys from the
+ *  display window.
+ ***********************************************************/
+uint16_t ViewManager::PollKeys() const
+{
+	uint16_t keys = 0;
+
+	// there is no keyboard input without a display window
+	if (NULL != m_pWindow)
+	{
+		for (int i = 0; i < g_TrackedKeyCount; i++)
+		{
+			if (glfwGetKey(m_pWindow, g_TrackedKeys[i]) == GLFW_PRESS)
+			{
+				keys |= (uint16_t)(1 << i);
+			}
+		}
+	}
+	return(keys);
+}
+
+/***********************************************************
+ *  StartInputRecording()
+ *
+ *  This method is used to record the input of the session,
+ *  which can be replayed later with StartInputReplay().
+ ***********************************************************/
+bool ViewManager::StartInputRecording(const char* filename)
+{
+	return g_InputRecorder.StartRecording(filename);
+}
+
+/***********************************************************
+ *  StartInputReplay()
+ *
+ *  This method is used to replace the input of the window
+ *  with a recorded session.  The live input is ignored
+ *  while the replay runs.
+ ***********************************************************/
+bool ViewManager::StartInputReplay(const char* filename)
+{
+	return g_InputRecorder.StartReplay(filename);
+}
+
+/***********************************************************
+ *  IsInputReplayFinished()
+ *
+ *  This method is used to check if a replay has used the
+ *  input of every recorded frame.
+ ***********************************************************/
+bool ViewManager::IsInputReplayFinished() const
+{
+	return g_InputRecorder.IsFinished();
+}
+
+/***********************************************************
+ *  ReplayInputEvents()
+ *
+ *  This method is used to apply the recorded mouse events
+ *  that arrived before the next frame, and to take the
+ *  delta time and the keys of that frame from the file.
+ ***********************************************************/
+void ViewManager::ReplayInputEvents()
+{
+	InputRecorder::INPUT_EVENT event;
+	while (g_InputRecorder.ReadEvent(event))
+	{
+		switch (event.type)
+		{
+		case InputRecorder::EVENT_FRAME:
+			gDeltaTime = event.deltaTime;
+			m_pressedKeys = event.keys;
+			return;
+		case InputRecorder::EVENT_MOUSE_POSITION:
+			ApplyMousePosition(event.x, event.y);
+			break;
+		case InputRecorder::EVENT_MOUSE_SCROLL:
+			ApplyMouseScroll(event.x, event.y);
+			break;
+		}
+	}
+
+	// no keys are held down after the end of the replay
+	m_pressedKeys = 0;
+}
+
 /***********************************************************
  *  PrepareSceneView()
  *
@@ -238,24 +512,57 @@ void ViewManager::ProcessKeyboardEvents()
  *  rendering
  ***********************************************************/
 void ViewManager::PrepareSceneView()
+{
+	PROFILE_SCOPE("PrepareSceneView");
+
+	UpdateSceneView();
+	CommitSceneView(m_viewState);
+}
+
+/***********************************************************
+ *  UpdateSceneView()
+ *
+ *  This method is used for processing the input of the
+ *  frame and calculating the view and projection of the
+ *  camera.  It makes no OpenGL calls.
+ ***********************************************************/
+void ViewManager::UpdateSceneView()
 {
 	glm::mat4 view;
 	glm::mat4 projection;
 
 	// per-frame timing
-	float currentFrame = glfwGetTime();
+	float currentFrame = GetFrameClock();
 	gDeltaTime = currentFrame - gLastFrame;
 	gLastFrame = currentFrame;
 
-	// process keyboard, but scale movement speed just for this call
-	float saved = gDeltaTime;
-	gDeltaTime *= gMoveSpeedFactor;   // <-- apply speed factor here
-
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
-
-	gDeltaTime = saved;               // <-- restore so nothing else is affected
+	if (gFixedTimestep > 0.0f)
+	{
+		gDeltaTime = gFixedTimestep;
+	}
+	else
+	{
+		// the keys come from the replayed file or from the window
+		if (g_InputRecorder.IsReplaying())
+		{
+			ReplayInputEvents();
+		}
+		else
+		{
+			m_pressedKeys = PollKeys();
+			g_InputRecorder.RecordFrame(gDeltaTime, m_pressedKeys);
+		}
+
+		// process keyboard, but scale movement speed just for this call
+		float saved = gDeltaTime;
+		gDeltaTime *= gMoveSpeedFactor;   // <-- apply speed factor here
+
+		// process any keyboard events that may be waiting in the 
+		// event queue
+		ProcessKeyboardEvents();
+
+		gDeltaTime = saved;               // <-- restore so nothing else is affected
+	}
 
 	// get the current view matrix from the camera
 	view = g_pCamera->GetViewMatrix();
@@ -267,14 +574,39 @@ void ViewManager::PrepareSceneView()
 		? glm::ortho(-10.0f * aspect, 10.0f * aspect, -10.0f, 10.0f, 0.1f, 100.0f)
 		: glm::perspective(glm::radians(g_pCamera->Zoom),aspect, 0.1f, 100.0f);
 
+	// a held key or a mouse event counts as a change even when the
+	// camera did not move, so that paced frames react right away
+	m_bViewChanged = gMouseActivity || (0 != m_pressedKeys) ||
+		(view != m_viewState.view) || (projection != m_viewState.projection);
+	gMouseActivity = false;
+
+	// the scene manager combines this with the model matrix of
+	// each object, so the shader does a single matrix multiply
+	m_viewState.view = view;
+	m_viewState.projection = projection;
+	m_viewState.viewProjection = projection * view;
+	m_viewState.viewPosition = g_pCamera->Position;
+}
+
+/***********************************************************
+ *  CommitSceneView()
+ *
+ *  This method is used for uploading the camera of a frame
+ *  into the frame constants.
+ ***********************************************************/
+void ViewManager::CommitSceneView(const VIEW_STATE& viewState)
+{
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		// write the camera into the frame constants and upload them,
+		// together with the scene lights, with a single copy
+		FrameUniformBuffer& frameUniforms = m_pShaderManager->GetFrameUniforms();
+		FrameUniformBuffer::FRAME_CONSTANTS& frame = frameUniforms.GetConstants();
+		frame.view = viewState.view;
+		frame.projection = viewState.projection;
+		frame.viewProjection = viewState.viewProjection;
+		frame.viewPosition = viewState.viewPosition;
+		frameUniforms.Commit();
 	}
 }
\ No newline at end of file
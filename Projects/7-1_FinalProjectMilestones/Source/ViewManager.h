@@ -10,14 +10,28 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "RenderTarget.h"
+#include "InputRecorder.h"
 #include "camera.h"
 
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
 // GLFW library
 #include "GLFW/glfw3.h" 
 
 class ViewManager
 {
 public:
+	// the camera of one frame
+	struct VIEW_STATE
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::mat4 viewProjection;
+		glm::vec3 viewPosition;
+	};
+
 	// constructor
 	ViewManager(
 		ShaderManager* pShaderManager);
@@ -34,14 +48,69 @@ private:
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// offscreen framebuffer used instead of a window in headless mode
+	RenderTarget* m_pOffscreenTarget;
+	// camera of the current frame
+	VIEW_STATE m_viewState;
+	// keys held down in the current frame, live or replayed
+	uint16_t m_pressedKeys;
+	// true when the input or the camera changed in the current frame
+	bool m_bViewChanged;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
+	// check a key in the keys of the current frame
+	bool IsKeyPressed(int key) const;
+	// get the tracked keys that are held down in the window
+	uint16_t PollKeys() const;
+	// apply the recorded events up to the end of the next frame
+	void ReplayInputEvents();
+	// get the time of the frame clock in seconds
+	float GetFrameClock() const;
+
+	// move the camera for a mouse event, live or replayed
+	static void ApplyMousePosition(double xMousePos, double yMousePos);
+	static void ApplyMouseScroll(double xoffset, double yoffset);
 
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// create the offscreen framebuffer used instead of a window
+	RenderTarget* CreateOffscreenTarget();
+	// get the size of the window and the offscreen framebuffer
+	void GetViewportSize(int& width, int& height) const;
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+	// the two halves of PrepareSceneView() - the update processes the
+	// input and moves the camera without any OpenGL calls, the commit
+	// uploads a camera into the frame constants
+	void UpdateSceneView();
+	void CommitSceneView(const VIEW_STATE& viewState);
+
+	// get the camera calculated by UpdateSceneView()
+	const VIEW_STATE& GetViewState() const { return m_viewState; }
+	const glm::mat4& GetViewProjection() const { return m_viewState.viewProjection; }
+
+	// true when the last UpdateSceneView() moved the camera, or
+	// there was input that may change the next frame
+	bool HasViewChanged() const { return m_bViewChanged; }
+
+	// get the camera, used to move it along a scripted path
+	Camera* GetCamera();
+
+	// start the next frame time from now, so that the time spent
+	// waiting for input does not count as movement time
+	void RestartFrameTime();
+
+	// advance the frame time by a fixed step instead of the clock and
+	// ignore the keyboard and the mouse - a step of 0 turns it off
+	void SetFixedTimestep(float seconds);
+
+	// record the input of every following frame to a file
+	bool StartInputRecording(const char* filename);
+	// use the input from a file instead of the live input
+	bool StartInputReplay(const char* filename);
+	// true once every frame of the replayed file is used
+	bool IsInputReplayFinished() const;
 };
\ No newline at end of file
@@ -0,0 +1,282 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// pace the frame loop with vsync, a frame rate cap and an adaptive idle rate
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+#include "TraceRecorder.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <mmsystem.h>		// timeBeginPeriod, from winmm.lib
+#else
+#include <time.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// a scene that has not changed for this long is idle
+	const double g_IdleDelaySeconds = 0.5;
+	// length of one sleep of the hybrid wait
+	const std::chrono::microseconds g_SleepStep(1000);
+	// first guess of how long a sleep step takes, before it
+	// has been measured
+	const double g_InitialSleepEstimate = 0.005;
+
+	// get the processor time used by the whole process
+	double GetProcessCpuSeconds()
+	{
+#ifdef _WIN32
+		FILETIME creationTime;
+		FILETIME exitTime;
+		FILETIME kernelTime;
+		FILETIME userTime;
+		if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+		{
+			return 0.0;
+		}
+		unsigned long long kernel = ((unsigned long long)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+		unsigned long long user = ((unsigned long long)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+		return (double)(kernel + user) * 1e-7;
+#else
+		struct timespec time;
+		if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+		{
+			return 0.0;
+		}
+		return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+	}
+}
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer()
+{
+	m_pWindow = NULL;
+	m_bVSync = false;
+	m_targetFPS = 0.0f;
+	m_bAdaptive = false;
+	m_idleFPS = 4.0f;
+
+	m_nextFrame = std::chrono::steady_clock::now();
+	m_lastActivity = m_nextFrame;
+
+	m_sleepMean = g_InitialSleepEstimate;
+	m_sleepM2 = 0.0;
+	m_sleepCount = 1;
+	m_sleepEstimate = g_InitialSleepEstimate;
+
+	m_startTime = m_nextFrame;
+	m_startCpuSeconds = GetProcessCpuSeconds();
+	m_frames = 0;
+	m_idleFrames = 0;
+	m_bTimerPeriodSet = false;
+}
+
+/***********************************************************
+ *  ~FramePacer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	if (m_bTimerPeriodSet)
+	{
+		timeEndPeriod(1);
+	}
+#endif
+	m_pWindow = NULL;
+}
+
+/***********************************************************
+ *  SetWindow()
+ *
+ *  This method is used to set the window whose input
+ *  events end an idle wait early.
+ ***********************************************************/
+void FramePacer::SetWindow(GLFWwindow* window)
+{
+	m_pWindow = window;
+}
+
+/***********************************************************
+ *  SetVSync()
+ *
+ *  This method is used to wait for the vertical blank in
+ *  every buffer swap, or not.  It applies to the OpenGL
+ *  context that is current on the calling thread.
+ ***********************************************************/
+void FramePacer::SetVSync(bool bEnabled)
+{
+	m_bVSync = bEnabled;
+	if (NULL != m_pWindow)
+	{
+		glfwSwapInterval(bEnabled ? 1 : 0);
+	}
+}
+
+/***********************************************************
+ *  SetTargetFPS()
+ *
+ *  This method is used to cap the frame rate.  The sleeps
+ *  of the system are only a millisecond long once the
+ *  timer resolution is raised, which Windows needs.
+ ***********************************************************/
+void FramePacer::SetTargetFPS(float fps)
+{
+	m_targetFPS = (fps > 0.0f) ? fps : 0.0f;
+
+#ifdef _WIN32
+	if ((m_targetFPS > 0.0f) && !m_bTimerPeriodSet)
+	{
+		m_bTimerPeriodSet = (timeBeginPeriod(1) == TIMERR_NOERROR);
+	}
+#endif
+}
+
+/***********************************************************
+ *  SetAdaptive()
+ *
+ *  This method is used to drop to the idle frame rate once
+ *  the scene has not changed for half a second.
+ ***********************************************************/
+void FramePacer::SetAdaptive(bool bEnabled, float idleFPS)
+{
+	m_bAdaptive = bEnabled;
+	if (idleFPS > 0.0f)
+	{
+		m_idleFPS = idleFPS;
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to wait for the start of the next
+ *  frame.  A frame that ran late starts the next one right
+ *  away, without trying to catch up on the missed frames.
+ ***********************************************************/
+void FramePacer::EndFrame(bool bActive)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	m_frames++;
+	if (bActive)
+	{
+		m_lastActivity = now;
+	}
+
+	bool bIdle = m_bAdaptive &&
+		(std::chrono::duration<double>(now - m_lastActivity).count() > g_IdleDelaySeconds);
+	float fps = bIdle ? m_idleFPS : m_targetFPS;
+	if (fps <= 0.0f)
+	{
+		// the buffer swap paces the frames, if vsync is on
+		m_nextFrame = now;
+		return;
+	}
+
+	std::chrono::steady_clock::duration interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(1.0 / fps));
+	m_nextFrame += interval;
+	if (m_nextFrame < now)
+	{
+		m_nextFrame = now;
+	}
+
+	if (bIdle)
+	{
+		m_idleFrames++;
+
+		// any input event ends the wait, so the first frame after
+		// it is not delayed by the idle rate
+		if (NULL != m_pWindow)
+		{
+			TRACE_SCOPE("WaitIdle");
+			double seconds = std::chrono::duration<double>(m_nextFrame - now).count();
+			if (seconds > 0.0)
+			{
+				glfwWaitEventsTimeout(seconds);
+			}
+			return;
+		}
+	}
+
+	WaitUntil(m_nextFrame);
+}
+
+/***********************************************************
+ *  WaitUntil()
+ *
+ *  This method is used to wait for a point in time.  A
+ *  sleep can take longer than asked, so the wait sleeps in
+ *  short steps while more than the usual length of a step
+ *  is left, and spins for the rest.  The length of a step
+ *  is measured as it goes, as the mean plus one standard
+ *  deviation of the steps so far.
+ ***********************************************************/
+void FramePacer::WaitUntil(std::chrono::steady_clock::time_point deadline)
+{
+	TRACE_SCOPE("WaitForFrame");
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	while (std::chrono::duration<double>(deadline - now).count() > m_sleepEstimate)
+	{
+		std::this_thread::sleep_for(g_SleepStep);
+
+		std::chrono::steady_clock::time_point woken = std::chrono::steady_clock::now();
+		double observed = std::chrono::duration<double>(woken - now).count();
+		now = woken;
+
+		// Welford's running mean and variance
+		m_sleepCount++;
+		double delta = observed - m_sleepMean;
+		m_sleepMean += delta / (double)m_sleepCount;
+		m_sleepM2 += delta * (observed - m_sleepMean);
+		m_sleepEstimate = m_sleepMean + sqrt(m_sleepM2 / (double)(m_sleepCount - 1));
+	}
+
+	while (std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print how many frames ran, how
+ *  many of them at the idle rate, and how much of a core
+ *  the process used on average.
+ ***********************************************************/
+void FramePacer::PrintReport() const
+{
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+	double cpuSeconds = GetProcessCpuSeconds() - m_startCpuSeconds;
+	if (seconds <= 0.0)
+	{
+		return;
+	}
+
+	printf("INFO: Frame pacing: %u frames (%u idle) in %.2f s, %.1f fps, CPU time %.2f s (%.0f%% of a core), vsync %s, cap %.0f fps%s\n",
+		m_frames, m_idleFrames, seconds, m_frames / seconds,
+		cpuSeconds, 100.0 * cpuSeconds / seconds,
+		m_bVSync ? "on" : "off", m_targetFPS,
+		m_bAdaptive ? ", adaptive" : "");
+}
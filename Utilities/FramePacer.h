@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// pace the frame loop with vsync, a frame rate cap and an adaptive idle rate
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <GLFW/glfw3.h>
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class contains the code for limiting how often the
+ *  frame loop runs.  Every frame ends with a call to
+ *  EndFrame(), which waits until the next frame is due:
+ *
+ *  - with a frame rate cap, the wait sleeps for most of the
+ *    time and spins for the rest, so the frames start on
+ *    time without keeping a core busy
+ *  - in the adaptive mode, a scene that has not changed
+ *    for a while drops to the idle rate, and the wait ends
+ *    as soon as the window gets an input event
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// constructor
+	FramePacer();
+	// destructor
+	~FramePacer();
+
+	// the window whose events end an idle wait, or NULL
+	void SetWindow(GLFWwindow* window);
+	// turn vsync on or off for the current OpenGL context
+	void SetVSync(bool bEnabled);
+	// frames per second to run at, 0 runs as fast as possible
+	void SetTargetFPS(float fps);
+	// drop to the idle rate while nothing changes
+	void SetAdaptive(bool bEnabled, float idleFPS);
+
+	// true when the frames are paced at all
+	bool IsPacing() const { return (m_targetFPS > 0.0f) || m_bAdaptive; }
+
+	// wait until the next frame is due - bActive is true when
+	// the frame that just ended showed a change
+	void EndFrame(bool bActive);
+
+	// print the frames, the idle frames and the CPU time used
+	void PrintReport() const;
+
+private:
+	GLFWwindow* m_pWindow;
+	bool m_bVSync;
+	float m_targetFPS;
+	bool m_bAdaptive;
+	float m_idleFPS;
+
+	// when the next frame is due, and when the last change was
+	std::chrono::steady_clock::time_point m_nextFrame;
+	std::chrono::steady_clock::time_point m_lastActivity;
+
+	// running mean and variance of how long a short sleep takes,
+	// the sleeps stop once less time than that is left
+	double m_sleepMean;
+	double m_sleepM2;
+	long long m_sleepCount;
+	double m_sleepEstimate;
+
+	// statistics for the report
+	std::chrono::steady_clock::time_point m_startTime;
+	double m_startCpuSeconds;
+	unsigned int m_frames;
+	unsigned int m_idleFrames;
+	bool m_bTimerPeriodSet;
+
+	// sleep and spin until the deadline
+	void WaitUntil(std::chrono::steady_clock::time_point deadline);
+};
@@ -0,0 +1,439 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.cpp
+// ============
+// CPU scope timers and GPU timer queries aggregated into per-frame
+// percentiles
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameProfiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+bool FrameProfiler::s_bEnabled = false;
+
+// declaration of global variables
+namespace
+{
+	// the measurements of one named scope
+	struct SCOPE_STATS
+	{
+		const char* name;
+		// totals of the frame being recorded
+		double cpuFrameMs;
+		int frameCalls;
+		// per-frame totals of the last HISTORY_FRAMES frames
+		float cpuHistory[FrameProfiler::HISTORY_FRAMES];
+		float gpuHistory[FrameProfiler::HISTORY_FRAMES];
+		int cpuCount;
+		int cpuNext;
+		int gpuCount;
+		int gpuNext;
+		// number of calls over all of the recorded frames
+		long long totalCalls;
+	};
+
+	// a pair of timestamp queries around one scope
+	struct GPU_SAMPLE
+	{
+		int scopeID;
+		int startQuery;
+		int endQuery;
+	};
+
+	// the timestamp queries issued during one frame
+	struct QUERY_FRAME
+	{
+		std::vector<GLuint> queries;
+		int usedQueries;
+		std::vector<GPU_SAMPLE> samples;
+		bool bPending;
+	};
+
+	// the scopes are registered by any thread, a scope is filled
+	// in before it is counted so the other threads can read it
+	SCOPE_STATS g_Scopes[FrameProfiler::MAX_SCOPES];
+	std::atomic<int> g_ScopeCount(0);
+	std::mutex g_ScopeMutex;
+
+	// the thread whose scopes are measured, the one that calls
+	// BeginFrame() - the scopes of other threads are only traced
+	std::atomic<std::thread::id> g_ProfiledThread;
+
+	QUERY_FRAME g_QueryFrames[FrameProfiler::QUERY_BUFFERS];
+	int g_QueryFrame = 0;
+
+	// the scope that covers the whole frame
+	int g_FrameScopeID = -1;
+	int g_FrameGpuSample = -1;
+	std::chrono::steady_clock::time_point g_FrameStart;
+	bool g_bInFrame = false;
+
+	// number of recorded frames, and of frames whose GPU times
+	// were not ready when their queries had to be reused
+	long long g_RecordedFrames = 0;
+	long long g_DroppedGpuFrames = 0;
+
+	// get an unused timestamp query of the current frame
+	int AllocateQuery(QUERY_FRAME& frame)
+	{
+		if (frame.usedQueries == (int)frame.queries.size())
+		{
+			size_t oldSize = frame.queries.size();
+			frame.queries.resize(oldSize + 64);
+			glGenQueries(64, &frame.queries[oldSize]);
+		}
+		return(frame.usedQueries++);
+	}
+
+	// add a value to a rolling history
+	void PushHistory(float* history, int& count, int& next, float value)
+	{
+		history[next] = value;
+		next = (next + 1) % FrameProfiler::HISTORY_FRAMES;
+		if (count < FrameProfiler::HISTORY_FRAMES)
+		{
+			count++;
+		}
+	}
+
+	// get a percentile of a rolling history
+	float Percentile(const float* history, int count, float percent, std::vector<float>& sorted)
+	{
+		if (count == 0)
+		{
+			return 0.0f;
+		}
+		sorted.assign(history, history + count);
+		std::sort(sorted.begin(), sorted.end());
+		return sorted[(size_t)(percent * (count - 1) + 0.5f)];
+	}
+
+	// read back the GPU times of a finished frame - the frame is
+	// dropped instead of waiting when the GPU is still behind
+	void CollectQueries(QUERY_FRAME& frame)
+	{
+		if (frame.bPending && (frame.usedQueries > 0))
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available)
+			{
+				double gpuFrameMs[FrameProfiler::MAX_SCOPES] = {};
+				bool bUsed[FrameProfiler::MAX_SCOPES] = {};
+				for (size_t i = 0; i < frame.samples.size(); i++)
+				{
+					const GPU_SAMPLE& sample = frame.samples[i];
+					if (sample.endQuery < 0)
+					{
+						continue;
+					}
+					GLuint64 startTime = 0;
+					GLuint64 endTime = 0;
+					glGetQueryObjectui64v(frame.queries[sample.startQuery], GL_QUERY_RESULT, &startTime);
+					glGetQueryObjectui64v(frame.queries[sample.endQuery], GL_QUERY_RESULT, &endTime);
+					gpuFrameMs[sample.scopeID] += (double)(endTime - startTime) / 1000000.0;
+					bUsed[sample.scopeID] = true;
+				}
+				for (int i = 0; i < g_ScopeCount; i++)
+				{
+					if (bUsed[i])
+					{
+						SCOPE_STATS& scope = g_Scopes[i];
+						PushHistory(scope.gpuHistory, scope.gpuCount, scope.gpuNext, (float)gpuFrameMs[i]);
+					}
+				}
+			}
+			else
+			{
+				g_DroppedGpuFrames++;
+			}
+		}
+
+		frame.usedQueries = 0;
+		frame.samples.clear();
+		frame.bPending = false;
+	}
+}
+
+/***********************************************************
+ *  SetEnabled()
+ *
+ *  This method is used to turn the measurements on or off.
+ ***********************************************************/
+void FrameProfiler::SetEnabled(bool bEnabled)
+{
+	s_bEnabled = bEnabled;
+	g_bInFrame = false;
+}
+
+/***********************************************************
+ *  RegisterScope()
+ *
+ *  This method is used to get the ID of a scope name.  The
+ *  PROFILE_SCOPE() macro calls it once for each scope, so
+ *  the name lookup is not part of the measured time.
+ ***********************************************************/
+int FrameProfiler::RegisterScope(const char* name)
+{
+	std::lock_guard<std::mutex> lock(g_ScopeMutex);
+
+	for (int i = 0; i < g_ScopeCount; i++)
+	{
+		if (strcmp(g_Scopes[i].name, name) == 0)
+		{
+			return(i);
+		}
+	}
+
+	if (g_ScopeCount == MAX_SCOPES)
+	{
+		printf("Too many profiler scopes, ignoring %s\n", name);
+		return(-1);
+	}
+
+	int scopeID = g_ScopeCount;
+	SCOPE_STATS& scope = g_Scopes[scopeID];
+	memset(&scope, 0, sizeof(scope));
+	scope.name = name;
+	g_ScopeCount.store(scopeID + 1);
+
+	return(scopeID);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to mark the start of a frame.
+ ***********************************************************/
+void FrameProfiler::BeginFrame()
+{
+	if (!s_bEnabled)
+	{
+		return;
+	}
+
+	if (g_FrameScopeID < 0)
+	{
+		g_FrameScopeID = RegisterScope("Frame");
+	}
+
+	if (g_ProfiledThread.load(std::memory_order_relaxed) != std::this_thread::get_id())
+	{
+		g_ProfiledThread.store(std::this_thread::get_id());
+	}
+
+	g_FrameStart = std::chrono::steady_clock::now();
+	g_FrameGpuSample = BeginScope(g_FrameScopeID);
+	g_bInFrame = true;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to mark the end of a frame.  The CPU
+ *  totals of the frame are added to the history, and the GPU
+ *  times of the previous frame are read back.
+ ***********************************************************/
+void FrameProfiler::EndFrame()
+{
+	if (!s_bEnabled || !g_bInFrame)
+	{
+		return;
+	}
+
+	EndScope(g_FrameScopeID, g_FrameGpuSample, g_FrameStart);
+	g_bInFrame = false;
+
+	for (int i = 0; i < g_ScopeCount; i++)
+	{
+		SCOPE_STATS& scope = g_Scopes[i];
+		if (scope.frameCalls > 0)
+		{
+			PushHistory(scope.cpuHistory, scope.cpuCount, scope.cpuNext, (float)scope.cpuFrameMs);
+			scope.totalCalls += scope.frameCalls;
+			scope.cpuFrameMs = 0.0;
+			scope.frameCalls = 0;
+		}
+	}
+	g_RecordedFrames++;
+
+	// the queries of the oldest frame are reused for the next one
+	g_QueryFrames[g_QueryFrame].bPending = true;
+	g_QueryFrame = (g_QueryFrame + 1) % QUERY_BUFFERS;
+	CollectQueries(g_QueryFrames[g_QueryFrame]);
+}
+
+/***********************************************************
+ *  BeginScope()
+ *
+ *  This method is used to issue the GPU timestamp at the
+ *  start of a scope.
+ ***********************************************************/
+int FrameProfiler::BeginScope(int scopeID)
+{
+	if (!s_bEnabled || (scopeID < 0) ||
+		(g_ProfiledThread.load(std::memory_order_relaxed) != std::this_thread::get_id()))
+	{
+		return(-1);
+	}
+
+	QUERY_FRAME& frame = g_QueryFrames[g_QueryFrame];
+	GPU_SAMPLE sample;
+	sample.scopeID = scopeID;
+	sample.startQuery = AllocateQuery(frame);
+	sample.endQuery = -1;
+	glQueryCounter(frame.queries[sample.startQuery], GL_TIMESTAMP);
+	frame.samples.push_back(sample);
+
+	return((int)frame.samples.size() - 1);
+}
+
+/***********************************************************
+ *  EndScope()
+ *
+ *  This method is used to add the CPU time of a scope to the
+ *  current frame and to issue the GPU timestamp at its end.
+ *  While a trace is recorded the scope is also added to it.
+ ***********************************************************/
+void FrameProfiler::EndScope(int scopeID, int gpuSample, std::chrono::steady_clock::time_point startTime)
+{
+	if (scopeID < 0)
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+	SCOPE_STATS& scope = g_Scopes[scopeID];
+
+	// the trace records the frame itself
+	if (TraceRecorder::IsEnabled() && (scopeID != g_FrameScopeID))
+	{
+		TraceRecorder::Record(scope.name, "frame", startTime, endTime);
+	}
+
+	if (!s_bEnabled ||
+		(g_ProfiledThread.load(std::memory_order_relaxed) != std::this_thread::get_id()))
+	{
+		return;
+	}
+
+	scope.cpuFrameMs += std::chrono::duration<double, std::milli>(endTime - startTime).count();
+	scope.frameCalls++;
+
+	// the sample is gone when the frame ended inside the scope
+	QUERY_FRAME& frame = g_QueryFrames[g_QueryFrame];
+	if ((gpuSample >= 0) && (gpuSample < (int)frame.samples.size()) &&
+		(frame.samples[gpuSample].scopeID == scopeID))
+	{
+		int endQuery = AllocateQuery(frame);
+		glQueryCounter(frame.queries[endQuery], GL_TIMESTAMP);
+		frame.samples[gpuSample].endQuery = endQuery;
+	}
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print the median, 95th and 99th
+ *  percentile of the CPU and GPU time of every scope over
+ *  the recorded frames.
+ ***********************************************************/
+void FrameProfiler::PrintReport()
+{
+	if (g_RecordedFrames == 0)
+	{
+		return;
+	}
+
+	std::vector<float> sorted;
+	long long historyFrames = (g_RecordedFrames < HISTORY_FRAMES) ? g_RecordedFrames : HISTORY_FRAMES;
+	printf("\nProfile of the last %lld of %lld frames (ms per frame, %lld GPU frames dropped)\n",
+		historyFrames, g_RecordedFrames, g_DroppedGpuFrames);
+	printf("%-28s %8s | %8s %8s %8s | %8s %8s %8s\n",
+		"scope", "calls", "cpu p50", "cpu p95", "cpu p99", "gpu p50", "gpu p95", "gpu p99");
+	for (int i = 0; i < g_ScopeCount; i++)
+	{
+		const SCOPE_STATS& scope = g_Scopes[i];
+		if (scope.cpuCount == 0)
+		{
+			continue;
+		}
+		printf("%-28s %8.1f | %8.3f %8.3f %8.3f | %8.3f %8.3f %8.3f\n",
+			scope.name,
+			(double)scope.totalCalls / g_RecordedFrames,
+			Percentile(scope.cpuHistory, scope.cpuCount, 0.50f, sorted),
+			Percentile(scope.cpuHistory, scope.cpuCount, 0.95f, sorted),
+			Percentile(scope.cpuHistory, scope.cpuCount, 0.99f, sorted),
+			Percentile(scope.gpuHistory, scope.gpuCount, 0.50f, sorted),
+			Percentile(scope.gpuHistory, scope.gpuCount, 0.95f, sorted),
+			Percentile(scope.gpuHistory, scope.gpuCount, 0.99f, sorted));
+	}
+}
+
+/***********************************************************
+ *  WriteReport()
+ *
+ *  This method is used to write the same percentiles as
+ *  PrintReport() into a CSV file.
+ ***********************************************************/
+bool FrameProfiler::WriteReport(const char* filename)
+{
+	FILE* file = fopen(filename, "w");
+	if (NULL == file)
+	{
+		printf("Unable to write profile %s\n", filename);
+		return false;
+	}
+
+	std::vector<float> sorted;
+	fprintf(file, "scope,calls_per_frame,cpu_p50_ms,cpu_p95_ms,cpu_p99_ms,gpu_p50_ms,gpu_p95_ms,gpu_p99_ms\n");
+	for (int i = 0; i < g_ScopeCount; i++)
+	{
+		const SCOPE_STATS& scope = g_Scopes[i];
+		if (scope.cpuCount == 0)
+		{
+			continue;
+		}
+		fprintf(file, "%s,%.2f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+			scope.name,
+			(g_RecordedFrames > 0) ? (double)scope.totalCalls / g_RecordedFrames : 0.0,
+			Percentile(scope.cpuHistory, scope.cpuCount, 0.50f, sorted),
+			Percentile(scope.cpuHistory, scope.cpuCount, 0.95f, sorted),
+			Percentile(scope.cpuHistory, scope.cpuCount, 0.99f, sorted),
+			Percentile(scope.gpuHistory, scope.gpuCount, 0.50f, sorted),
+			Percentile(scope.gpuHistory, scope.gpuCount, 0.95f, sorted),
+			Percentile(scope.gpuHistory, scope.gpuCount, 0.99f, sorted));
+	}
+	fclose(file);
+
+	return true;
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used to free the timestamp queries.  It
+ *  has to be called before the OpenGL context is destroyed.
+ ***********************************************************/
+void FrameProfiler::Shutdown()
+{
+	for (int i = 0; i < QUERY_BUFFERS; i++)
+	{
+		QUERY_FRAME& frame = g_QueryFrames[i];
+		if (!frame.queries.empty())
+		{
+			glDeleteQueries((GLsizei)frame.queries.size(), &frame.queries[0]);
+			frame.queries.clear();
+		}
+		frame.usedQueries = 0;
+		frame.samples.clear();
+		frame.bPending = false;
+	}
+	s_bEnabled = false;
+}
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.h
+// ============
+// CPU scope timers and GPU timer queries aggregated into per-frame
+// percentiles
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <chrono>
+
+#include "TraceRecorder.h"
+#include "FrameUniformBuffer.h"
+
+/***********************************************************
+ *  FrameProfiler
+ *
+ *  This class contains the code for measuring the CPU and
+ *  GPU time of named scopes every frame.  The GPU time is
+ *  read back one frame later from timestamp queries, so the
+ *  CPU never waits for the GPU.  Only the scopes of the
+ *  thread that calls BeginFrame() are measured, the scopes
+ *  of other threads are added to the trace only.
+ ***********************************************************/
+class FrameProfiler
+{
+public:
+	// number of frames kept for the rolling percentiles
+	static const int HISTORY_FRAMES = 512;
+	// number of frames of GPU queries in flight, one more than
+	// the frames the GPU can be behind, so that the queries of a
+	// frame are only reused once their results are ready
+	static const int QUERY_BUFFERS = FrameUniformBuffer::FRAMES_IN_FLIGHT + 1;
+	// largest number of distinct scope names
+	static const int MAX_SCOPES = 64;
+
+	// turn the measurements on or off, the scopes cost a
+	// single branch while the profiler is off
+	static void SetEnabled(bool bEnabled);
+	static bool IsEnabled() { return s_bEnabled; }
+
+	// get the ID for a scope name, called once per scope
+	static int RegisterScope(const char* name);
+
+	// mark the start and the end of a frame
+	static void BeginFrame();
+	static void EndFrame();
+
+	// mark the start and the end of a scope, the returned
+	// value has to be passed to EndScope()
+	static int BeginScope(int scopeID);
+	static void EndScope(int scopeID, int gpuSample, std::chrono::steady_clock::time_point startTime);
+
+	// print the percentiles of every scope
+	static void PrintReport();
+	// write the percentiles of every scope to a CSV file
+	static bool WriteReport(const char* filename);
+	// free the GPU queries while the context is still current
+	static void Shutdown();
+
+private:
+	// true while measurements are taken
+	static bool s_bEnabled;
+};
+
+/***********************************************************
+ *  ProfileScope
+ *
+ *  This class measures the time from its construction to
+ *  the end of the enclosing block.  The scope is also added
+ *  to the trace while a trace is being recorded.
+ ***********************************************************/
+class ProfileScope
+{
+public:
+	explicit ProfileScope(int scopeID)
+	{
+		m_scopeID = -1;
+		if (FrameProfiler::IsEnabled() || TraceRecorder::IsEnabled())
+		{
+			m_scopeID = scopeID;
+			m_startTime = std::chrono::steady_clock::now();
+			m_gpuSample = FrameProfiler::BeginScope(scopeID);
+		}
+	}
+	~ProfileScope()
+	{
+		if (m_scopeID >= 0)
+		{
+			FrameProfiler::EndScope(m_scopeID, m_gpuSample, m_startTime);
+		}
+	}
+
+private:
+	int m_scopeID;
+	int m_gpuSample;
+	std::chrono::steady_clock::time_point m_startTime;
+
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+};
+
+// measure the rest of the enclosing block under the passed in name,
+// defining DISABLE_FRAME_PROFILER removes the scopes from the build
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#ifndef DISABLE_FRAME_PROFILER
+#define PROFILE_SCOPE(name) \
+	static const int PROFILE_CONCAT(profileScopeID, __LINE__) = FrameProfiler::RegisterScope(name); \
+	ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileScopeID, __LINE__))
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameuniformbuffer.cpp
+// ============
+// per-frame camera and light constants shared by all shader programs
+// through one persistently mapped uniform buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameUniformBuffer.h"
+
+#include <iostream>
+#include <cstring>
+
+// the C++ structures have to match the std140 layout of the GLSL block
+static_assert(sizeof(FrameUniformBuffer::LIGHT_SOURCE) == 64, "LightSource must match std140");
+static_assert(sizeof(FrameUniformBuffer::FRAME_CONSTANTS) == 208 + 64 * FrameUniformBuffer::TOTAL_LIGHTS, "FrameConstants must match std140");
+
+const char* const FrameUniformBuffer::BLOCK_NAME = "FrameConstants";
+
+/***********************************************************
+ *  FrameUniformBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameUniformBuffer::FrameUniformBuffer()
+{
+	m_bufferID = 0;
+	m_pMappedBuffer = NULL;
+	m_regionSize = 0;
+	m_frameIndex = 0;
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		m_frameFences[i] = NULL;
+	}
+	memset(&m_constants, 0, sizeof(m_constants));
+}
+
+/***********************************************************
+ *  ~FrameUniformBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameUniformBuffer::~FrameUniformBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create the uniform buffer with
+ *  one copy of the frame constants per frame in flight.
+ *  With buffer storage support the buffer stays mapped for
+ *  its whole lifetime, otherwise it is updated with
+ *  glBufferSubData() every frame.
+ ***********************************************************/
+bool FrameUniformBuffer::Create()
+{
+	if (m_bufferID != 0)
+	{
+		return true;
+	}
+
+	// every copy has to start at a valid binding offset
+	GLint offsetAlignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	m_regionSize = ((sizeof(FRAME_CONSTANTS) + offsetAlignment - 1) / offsetAlignment) * offsetAlignment;
+
+	glGenBuffers(1, &m_bufferID);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+
+	if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, m_regionSize * FRAMES_IN_FLIGHT, NULL, flags);
+		m_pMappedBuffer = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, m_regionSize * FRAMES_IN_FLIGHT, flags);
+		if (NULL == m_pMappedBuffer)
+		{
+			// the immutable storage cannot be updated with
+			// glBufferSubData(), so a buffer that can be replaces it
+			std::cout << "Failed to map the frame uniform buffer, it is updated every frame instead" << std::endl;
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			glDeleteBuffers(1, &m_bufferID);
+			glGenBuffers(1, &m_bufferID);
+			glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+		}
+	}
+
+	if (NULL == m_pMappedBuffer)
+	{
+		glBufferData(GL_UNIFORM_BUFFER, m_regionSize * FRAMES_IN_FLIGHT, NULL, GL_DYNAMIC_DRAW);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to free the uniform buffer and the
+ *  fences of the frames in flight.
+ ***********************************************************/
+void FrameUniformBuffer::Destroy()
+{
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		if (NULL != m_frameFences[i])
+		{
+			glDeleteSync(m_frameFences[i]);
+			m_frameFences[i] = NULL;
+		}
+	}
+
+	if (m_bufferID != 0)
+	{
+		if (NULL != m_pMappedBuffer)
+		{
+			glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			m_pMappedBuffer = NULL;
+		}
+		glDeleteBuffers(1, &m_bufferID);
+		m_bufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  Commit()
+ *
+ *  This method is used to copy the frame constants into the
+ *  copy of the buffer that belongs to the current frame and
+ *  to bind that copy to the shared binding point.  It only
+ *  waits when the GPU is still reading the copy from three
+ *  frames ago.
+ ***********************************************************/
+void FrameUniformBuffer::Commit()
+{
+	if (m_bufferID == 0)
+	{
+		Create();
+	}
+
+	GLintptr offset = m_regionSize * m_frameIndex;
+
+	if (NULL != m_pMappedBuffer)
+	{
+		// make sure the GPU is done with this copy before overwriting it
+		GLsync fence = m_frameFences[m_frameIndex];
+		if (NULL != fence)
+		{
+			GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			while (result == GL_TIMEOUT_EXPIRED)
+			{
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			}
+			glDeleteSync(fence);
+			m_frameFences[m_frameIndex] = NULL;
+		}
+
+		memcpy(m_pMappedBuffer + offset, &m_constants, sizeof(m_constants));
+	}
+	else
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(m_constants), &m_constants);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, BINDING_POINT, m_bufferID, offset, sizeof(m_constants));
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is called after all of the draw commands of
+ *  the frame have been submitted.  A fence is placed behind
+ *  them and the next frame moves on to the next copy.
+ ***********************************************************/
+void FrameUniformBuffer::EndFrame()
+{
+	if (m_bufferID == 0)
+	{
+		return;
+	}
+
+	if (NULL != m_pMappedBuffer)
+	{
+		if (NULL != m_frameFences[m_frameIndex])
+		{
+			glDeleteSync(m_frameFences[m_frameIndex]);
+		}
+		m_frameFences[m_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	m_frameIndex = (m_frameIndex + 1) % FRAMES_IN_FLIGHT;
+}
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameuniformbuffer.h
+// ============
+// per-frame camera and light constants shared by all shader programs
+// through one persistently mapped uniform buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  FrameUniformBuffer
+ *
+ *  This class contains the code for filling the frame
+ *  constants uniform block.  The buffer holds one copy of
+ *  the constants for each frame that can be in flight, so
+ *  the CPU never writes into a copy the GPU still reads.
+ ***********************************************************/
+class FrameUniformBuffer
+{
+public:
+	// uniform block binding point used by every shader program
+	static const GLuint BINDING_POINT = 0;
+	// name of the uniform block in the GLSL code
+	static const char* const BLOCK_NAME;
+	// number of copies of the frame constants in the buffer
+	static const int FRAMES_IN_FLIGHT = 3;
+	// largest number of lights in the uniform block - TOTAL_LIGHTS
+	// in GLSL, lightCount says how many of them are used
+	static const int TOTAL_LIGHTS = 16;
+
+	// std140 layout of the LightSource structure
+	struct LIGHT_SOURCE
+	{
+		glm::vec3 position;
+		float focalStrength;
+		glm::vec3 ambientColor;
+		float specularIntensity;
+		glm::vec3 diffuseColor;
+		float padding0;
+		glm::vec3 specularColor;
+		float padding1;
+	};
+
+	// std140 layout of the FrameConstants uniform block
+	struct FRAME_CONSTANTS
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::mat4 viewProjection;
+		glm::vec3 viewPosition;
+		int lightCount;
+		LIGHT_SOURCE lightSources[TOTAL_LIGHTS];
+	};
+
+	// constructor
+	FrameUniformBuffer();
+	// destructor
+	~FrameUniformBuffer();
+
+	// create the uniform buffer - needs a current OpenGL context
+	bool Create();
+	// free the uniform buffer and the frame fences
+	void Destroy();
+
+	// the CPU copy of the constants, written during the frame
+	FRAME_CONSTANTS& GetConstants() { return m_constants; }
+
+	// copy the constants into the buffer and bind them
+	void Commit();
+	// mark the end of the GPU work that reads the current copy
+	void EndFrame();
+
+private:
+	// the OpenGL uniform buffer
+	GLuint m_bufferID;
+	// persistently mapped buffer memory, NULL without buffer storage
+	unsigned char* m_pMappedBuffer;
+	// size of one copy, rounded up to the offset alignment
+	GLsizeiptr m_regionSize;
+	// fences for the frames that are still in flight
+	GLsync m_frameFences[FRAMES_IN_FLIGHT];
+	// copy of the constants used by the current frame
+	int m_frameIndex;
+	// CPU copy of the constants
+	FRAME_CONSTANTS m_constants;
+};
@@ -0,0 +1,259 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.cpp
+// ============
+// create an OpenGL context without a window or display server, used for
+// benchmarking and automated runs on headless Linux hosts
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HeadlessContext.h"
+
+#include <iostream>
+#include <cstring>
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef __linux__
+// declaration of global variables
+namespace
+{
+	// the context versions that are tried, newest first - the
+	// shaders need at least OpenGL 4.4
+	const int g_ContextVersions[][2] = {
+		{ 4, 6 }, { 4, 5 }, { 4, 4 }
+	};
+
+	// check an extension in an EGL extension string
+	bool HasExtension(const char* extensions, const char* name)
+	{
+		if (NULL == extensions)
+		{
+			return false;
+		}
+
+		size_t length = strlen(name);
+		const char* found = strstr(extensions, name);
+		while (NULL != found)
+		{
+			if (((found == extensions) || (found[-1] == ' ')) &&
+				((found[length] == ' ') || (found[length] == '\0')))
+			{
+				return true;
+			}
+			found = strstr(found + length, name);
+		}
+
+		return false;
+	}
+}
+#endif
+
+/***********************************************************
+ *  HeadlessContext()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HeadlessContext::HeadlessContext()
+{
+	m_pDisplay = NULL;
+	m_pContext = NULL;
+	m_pSurface = NULL;
+}
+
+/***********************************************************
+ *  ~HeadlessContext()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create an OpenGL core profile
+ *  context through EGL and to make it current on the
+ *  calling thread.
+ ***********************************************************/
+bool HeadlessContext::Create()
+{
+#ifdef __linux__
+	EGLDisplay display = EGL_NO_DISPLAY;
+
+	// prefer the surfaceless platform, which needs no display server
+	// and falls back to the llvmpipe software rasterizer without a GPU
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (NULL != getPlatformDisplay)
+		{
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		}
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major = 0;
+	EGLint minor = 0;
+	if ((display == EGL_NO_DISPLAY) || (eglInitialize(display, &major, &minor) == EGL_FALSE))
+	{
+		std::cout << "Failed to initialize an EGL display" << std::endl;
+		return false;
+	}
+	m_pDisplay = display;
+
+	if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+	{
+		std::cout << "EGL display does not support desktop OpenGL" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	// rendering goes into a framebuffer object, so the surface only
+	// matters when the display cannot make a context current without one
+	bool bSurfaceless = HasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, bSurfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	EGLConfig config = NULL;
+	EGLint numConfigs = 0;
+	if ((eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) == EGL_FALSE) || (numConfigs == 0))
+	{
+		std::cout << "No suitable EGL configuration found" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	EGLContext context = EGL_NO_CONTEXT;
+	for (size_t i = 0; (i < sizeof(g_ContextVersions) / sizeof(g_ContextVersions[0])) && (context == EGL_NO_CONTEXT); i++)
+	{
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, g_ContextVersions[i][0],
+			EGL_CONTEXT_MINOR_VERSION, g_ContextVersions[i][1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	}
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cout << "Failed to create an OpenGL 4.4+ core context through EGL" << std::endl;
+		Destroy();
+		return false;
+	}
+	m_pContext = context;
+
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (!bSurfaceless)
+	{
+		const EGLint surfaceAttributes[] = {
+			EGL_WIDTH, 1,
+			EGL_HEIGHT, 1,
+			EGL_NONE
+		};
+		surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+		m_pSurface = surface;
+	}
+
+	if (eglMakeCurrent(display, surface, surface, context) == EGL_FALSE)
+	{
+		std::cout << "Failed to make the EGL context current" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	std::cout << "INFO: Headless EGL " << major << "." << minor << " context created ("
+		<< (bSurfaceless ? "surfaceless" : "pbuffer") << ")" << std::endl;
+
+	return true;
+#else
+	std::cout << "Headless rendering is only supported on Linux" << std::endl;
+	return false;
+#endif
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to release the context, the surface
+ *  and the EGL display.
+ ***********************************************************/
+void HeadlessContext::Destroy()
+{
+#ifdef __linux__
+	if (NULL != m_pDisplay)
+	{
+		eglMakeCurrent((EGLDisplay)m_pDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (NULL != m_pSurface)
+		{
+			eglDestroySurface((EGLDisplay)m_pDisplay, (EGLSurface)m_pSurface);
+		}
+		if (NULL != m_pContext)
+		{
+			eglDestroyContext((EGLDisplay)m_pDisplay, (EGLContext)m_pContext);
+		}
+		eglTerminate((EGLDisplay)m_pDisplay);
+	}
+#endif
+	m_pDisplay = NULL;
+	m_pContext = NULL;
+	m_pSurface = NULL;
+}
+
+/***********************************************************
+ *  MakeCurrent()
+ *
+ *  This method is used to make the context current on the
+ *  calling thread.  It has to be released by the thread
+ *  that used it before.
+ ***********************************************************/
+bool HeadlessContext::MakeCurrent()
+{
+#ifdef __linux__
+	if (NULL == m_pDisplay)
+	{
+		return false;
+	}
+
+	if (eglMakeCurrent((EGLDisplay)m_pDisplay, (EGLSurface)m_pSurface, (EGLSurface)m_pSurface, (EGLContext)m_pContext) == EGL_FALSE)
+	{
+		std::cout << "Failed to make the EGL context current" << std::endl;
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+/***********************************************************
+ *  ReleaseCurrent()
+ *
+ *  This method is used to release the context from the
+ *  calling thread.
+ ***********************************************************/
+void HeadlessContext::ReleaseCurrent()
+{
+#ifdef __linux__
+	if (NULL != m_pDisplay)
+	{
+		eglMakeCurrent((EGLDisplay)m_pDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	}
+#endif
+}
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.h
+// ============
+// create an OpenGL context without a window or display server, used for
+// benchmarking and automated runs on headless Linux hosts
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  HeadlessContext
+ *
+ *  This class contains the code for creating an OpenGL core
+ *  context through EGL.  The surfaceless Mesa platform is
+ *  used when it is available, which works with llvmpipe on
+ *  hosts without a GPU, otherwise a pbuffer surface on the
+ *  default display.  Rendering has to go into a framebuffer
+ *  object since there is no window to present to.
+ ***********************************************************/
+class HeadlessContext
+{
+public:
+	// constructor
+	HeadlessContext();
+	// destructor
+	~HeadlessContext();
+
+	// create the context and make it current
+	bool Create();
+	// release the context and the EGL display
+	void Destroy();
+
+	// make the context current on the calling thread, or
+	// release it so that another thread can take it
+	bool MakeCurrent();
+	void ReleaseCurrent();
+
+private:
+	// EGL handles, kept as void pointers so that this header
+	// does not pull the EGL headers into the rest of the code
+	void* m_pDisplay;
+	void* m_pContext;
+	void* m_pSurface;
+};
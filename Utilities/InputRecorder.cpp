@@ -0,0 +1,262 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputrecorder.cpp
+// ============
+// record timestamped input events to a compact binary file and play them
+// back in place of the live window input
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InputRecorder.h"
+
+#include <string.h>
+
+// declaration of global variables
+namespace
+{
+	// identifies an input recording, followed by the format version
+	const char g_InputMagic[4] = { 'I', 'N', 'P', '1' };
+	const uint32_t g_InputVersion = 1;
+}
+
+/***********************************************************
+ *  InputRecorder()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InputRecorder::InputRecorder()
+{
+	m_pFile = NULL;
+	m_recordedFrames = 0;
+	m_bReplaying = false;
+	m_replayIndex = 0;
+}
+
+/***********************************************************
+ *  ~InputRecorder()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InputRecorder::~InputRecorder()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  StartRecording()
+ *
+ *  This method is used to create the input file.  The
+ *  events are written in the byte order of the machine,
+ *  with no padding between the values.
+ ***********************************************************/
+bool InputRecorder::StartRecording(const char* filename)
+{
+	Stop();
+
+	m_pFile = fopen(filename, "wb");
+	if (NULL == m_pFile)
+	{
+		printf("Unable to write input recording %s\n", filename);
+		return false;
+	}
+
+	fwrite(g_InputMagic, sizeof(g_InputMagic), 1, m_pFile);
+	fwrite(&g_InputVersion, sizeof(g_InputVersion), 1, m_pFile);
+
+	m_lastEventTime = std::chrono::steady_clock::now();
+	m_recordedFrames = 0;
+	return true;
+}
+
+/***********************************************************
+ *  StartReplay()
+ *
+ *  This method is used to read a whole input file into
+ *  memory, so the replay never waits for the disk.
+ ***********************************************************/
+bool InputRecorder::StartReplay(const char* filename)
+{
+	Stop();
+
+	FILE* file = fopen(filename, "rb");
+	if (NULL == file)
+	{
+		printf("Unable to read input recording %s\n", filename);
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	if ((fread(magic, sizeof(magic), 1, file) != 1) ||
+		(fread(&version, sizeof(version), 1, file) != 1) ||
+		(memcmp(magic, g_InputMagic, sizeof(magic)) != 0) ||
+		(version != g_InputVersion))
+	{
+		printf("%s is not an input recording\n", filename);
+		fclose(file);
+		return false;
+	}
+
+	m_replayData.clear();
+	unsigned char buffer[4096];
+	size_t count = 0;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		m_replayData.insert(m_replayData.end(), buffer, buffer + count);
+	}
+	fclose(file);
+
+	m_replayIndex = 0;
+	m_bReplaying = true;
+	return true;
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used to close the recording, or to end
+ *  the replay.
+ ***********************************************************/
+void InputRecorder::Stop()
+{
+	if (NULL != m_pFile)
+	{
+		fclose(m_pFile);
+		m_pFile = NULL;
+		printf("INFO: Recorded the input of %u frames\n", m_recordedFrames);
+	}
+
+	m_bReplaying = false;
+	m_replayData.clear();
+	m_replayIndex = 0;
+}
+
+/***********************************************************
+ *  WriteEventHeader()
+ *
+ *  This method is used to write the type of an event and
+ *  the time since the previous event in microseconds.
+ ***********************************************************/
+void InputRecorder::WriteEventHeader(EVENT_TYPE type)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	long long elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastEventTime).count();
+	m_lastEventTime = now;
+
+	uint8_t eventType = (uint8_t)type;
+	uint32_t timeUs = (elapsedUs > 0xFFFFFFFFLL) ? 0xFFFFFFFFu : (uint32_t)elapsedUs;
+	fwrite(&eventType, sizeof(eventType), 1, m_pFile);
+	fwrite(&timeUs, sizeof(timeUs), 1, m_pFile);
+}
+
+/***********************************************************
+ *  RecordMousePosition()
+ *
+ *  This method is used to record a mouse move.
+ ***********************************************************/
+void InputRecorder::RecordMousePosition(double x, double y)
+{
+	if (NULL == m_pFile)
+	{
+		return;
+	}
+
+	WriteEventHeader(EVENT_MOUSE_POSITION);
+	fwrite(&x, sizeof(x), 1, m_pFile);
+	fwrite(&y, sizeof(y), 1, m_pFile);
+}
+
+/***********************************************************
+ *  RecordMouseScroll()
+ *
+ *  This method is used to record a scroll wheel move.
+ ***********************************************************/
+void InputRecorder::RecordMouseScroll(double x, double y)
+{
+	if (NULL == m_pFile)
+	{
+		return;
+	}
+
+	WriteEventHeader(EVENT_MOUSE_SCROLL);
+	fwrite(&x, sizeof(x), 1, m_pFile);
+	fwrite(&y, sizeof(y), 1, m_pFile);
+}
+
+/***********************************************************
+ *  RecordFrame()
+ *
+ *  This method is used to record the delta time and the
+ *  keys that were pressed in a frame.
+ ***********************************************************/
+void InputRecorder::RecordFrame(float deltaTime, uint16_t keys)
+{
+	if (NULL == m_pFile)
+	{
+		return;
+	}
+
+	WriteEventHeader(EVENT_FRAME);
+	fwrite(&deltaTime, sizeof(deltaTime), 1, m_pFile);
+	fwrite(&keys, sizeof(keys), 1, m_pFile);
+	m_recordedFrames++;
+}
+
+/***********************************************************
+ *  ReadValue()
+ *
+ *  This method is used to copy the next value out of the
+ *  replayed file.
+ ***********************************************************/
+bool InputRecorder::ReadValue(void* pValue, size_t size)
+{
+	if (m_replayIndex + size > m_replayData.size())
+	{
+		// a truncated event ends the replay
+		m_replayIndex = m_replayData.size();
+		return false;
+	}
+
+	memcpy(pValue, &m_replayData[m_replayIndex], size);
+	m_replayIndex += size;
+	return true;
+}
+
+/***********************************************************
+ *  ReadEvent()
+ *
+ *  This method is used to get the next event of the replay.
+ ***********************************************************/
+bool InputRecorder::ReadEvent(INPUT_EVENT& event)
+{
+	if (!m_bReplaying || IsFinished())
+	{
+		return false;
+	}
+
+	uint8_t eventType = 0;
+	if (!ReadValue(&eventType, sizeof(eventType)) ||
+		!ReadValue(&event.timeUs, sizeof(event.timeUs)))
+	{
+		return false;
+	}
+
+	event.type = (EVENT_TYPE)eventType;
+	event.x = 0.0;
+	event.y = 0.0;
+	event.deltaTime = 0.0f;
+	event.keys = 0;
+
+	switch (event.type)
+	{
+	case EVENT_FRAME:
+		return ReadValue(&event.deltaTime, sizeof(event.deltaTime)) &&
+			ReadValue(&event.keys, sizeof(event.keys));
+	case EVENT_MOUSE_POSITION:
+	case EVENT_MOUSE_SCROLL:
+		return ReadValue(&event.x, sizeof(event.x)) &&
+			ReadValue(&event.y, sizeof(event.y));
+	}
+
+	printf("Unknown input event %d, the replay is stopped\n", (int)eventType);
+	m_replayIndex = m_replayData.size();
+	return false;
+}
@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputrecorder.h
+// ============
+// record timestamped input events to a compact binary file and play them
+// back in place of the live window input
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+
+/***********************************************************
+ *  InputRecorder
+ *
+ *  This class contains the code for recording the input of
+ *  a session and replaying it later.  Every frame is one
+ *  event holding its delta time and the pressed keys, and
+ *  the mouse events that arrive between two frames are
+ *  stored in order before it.  The values are stored with
+ *  their full precision, so a replay moves the camera
+ *  exactly like the recorded session did.
+ ***********************************************************/
+class InputRecorder
+{
+public:
+	// kinds of recorded events
+	enum EVENT_TYPE
+	{
+		EVENT_FRAME = 1,
+		EVENT_MOUSE_POSITION = 2,
+		EVENT_MOUSE_SCROLL = 3
+	};
+
+	// one recorded event - x and y are used by the mouse events,
+	// deltaTime and keys by the frame events
+	struct INPUT_EVENT
+	{
+		EVENT_TYPE type;
+		uint32_t timeUs;		// since the previous event
+		double x;
+		double y;
+		float deltaTime;
+		uint16_t keys;			// one bit per tracked key
+	};
+
+	// constructor
+	InputRecorder();
+	// destructor
+	~InputRecorder();
+
+	// create the input file and record every following event
+	bool StartRecording(const char* filename);
+	// read an input file to play it back
+	bool StartReplay(const char* filename);
+	// close the input file and stop recording or replaying
+	void Stop();
+
+	bool IsRecording() const { return NULL != m_pFile; }
+	bool IsReplaying() const { return m_bReplaying; }
+	// true once a replay has used every recorded event
+	bool IsFinished() const { return m_bReplaying && (m_replayIndex >= m_replayData.size()); }
+
+	// add a live event to the recording
+	void RecordMousePosition(double x, double y);
+	void RecordMouseScroll(double x, double y);
+	void RecordFrame(float deltaTime, uint16_t keys);
+
+	// get the next recorded event, false at the end of the replay
+	bool ReadEvent(INPUT_EVENT& event);
+
+private:
+	// file being recorded
+	FILE* m_pFile;
+	std::chrono::steady_clock::time_point m_lastEventTime;
+	unsigned int m_recordedFrames;
+
+	// contents of the file being replayed
+	bool m_bReplaying;
+	std::vector<unsigned char> m_replayData;
+	size_t m_replayIndex;
+
+	// write the type and the time of a new event
+	void WriteEventHeader(EVENT_TYPE type);
+	// copy the next value of the replay
+	bool ReadValue(void* pValue, size_t size);
+};
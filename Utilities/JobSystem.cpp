@@ -0,0 +1,329 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// a small work-stealing job scheduler with counters that jobs can wait on
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+#include "TraceRecorder.h"
+
+#include <stdio.h>
+
+// declaration of global variables
+namespace
+{
+	// the pool that the calling thread is a worker of, and its
+	// index in that pool
+	thread_local const JobSystem* t_pJobSystem = NULL;
+	thread_local int t_workerIndex = 0;
+}
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem()
+{
+	m_workerCount = 1;
+	m_queuedJobs = 0;
+	m_bStopping = false;
+	m_queues.push_back(new WORKER_QUEUE());
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	Shutdown();
+
+	for (size_t i = 0; i < m_queues.size(); i++)
+	{
+		delete m_queues[i];
+	}
+	m_queues.clear();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to create the worker queues and
+ *  start one thread for every worker except the first.
+ ***********************************************************/
+void JobSystem::Initialize(int workerCount)
+{
+	Shutdown();
+
+	if (workerCount <= 0)
+	{
+		workerCount = (int)std::thread::hardware_concurrency();
+	}
+	if (workerCount < 1)
+	{
+		workerCount = 1;
+	}
+
+	m_workerCount = workerCount;
+	while ((int)m_queues.size() < m_workerCount)
+	{
+		m_queues.push_back(new WORKER_QUEUE());
+	}
+
+	m_bStopping = false;
+	t_pJobSystem = this;
+	t_workerIndex = 0;
+	for (int i = 1; i < m_workerCount; i++)
+	{
+		m_threads.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+	}
+
+	printf("INFO: Job system running %d worker(s)\n", m_workerCount);
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used to stop the worker threads.  The
+ *  jobs that are still queued are run first.
+ ***********************************************************/
+void JobSystem::Shutdown()
+{
+	// the calling thread finishes whatever the workers left
+	JOB job;
+	while (TakeJob(0, job))
+	{
+		Execute(job);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_bStopping = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (size_t i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+	m_threads.clear();
+	m_workerCount = 1;
+}
+
+/***********************************************************
+ *  GetWorkerIndex()
+ *
+ *  This method is used to get the queue of the calling
+ *  thread.  Threads that are not workers of this pool,
+ *  such as a render thread, share the queue of worker 0.
+ ***********************************************************/
+int JobSystem::GetWorkerIndex() const
+{
+	if (t_pJobSystem == this)
+	{
+		return t_workerIndex;
+	}
+	return 0;
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used to add a job to the back of the
+ *  queue of the calling worker.  Without worker threads
+ *  the job is run right away.
+ ***********************************************************/
+void JobSystem::Run(const std::function<void()>& job, JOB_COUNTER* pCounter)
+{
+	if (NULL != pCounter)
+	{
+		pCounter->count.fetch_add(1);
+	}
+
+	JOB queuedJob;
+	queuedJob.function = job;
+	queuedJob.pCounter = pCounter;
+
+	if (m_threads.empty())
+	{
+		Execute(queuedJob);
+		return;
+	}
+
+	// the count is raised under the wake lock, so that a worker
+	// that is about to sleep cannot miss the job, and before the
+	// job is queued, so that taking it never makes it negative
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_queuedJobs.fetch_add(1);
+	}
+
+	WORKER_QUEUE* queue = m_queues[GetWorkerIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(queuedJob);
+	}
+	m_wakeCondition.notify_one();
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used to wait for every job of a counter.
+ *  The waiting thread runs queued jobs in the meantime,
+ *  which also lets a job wait for other jobs without
+ *  blocking its worker.
+ ***********************************************************/
+void JobSystem::Wait(JOB_COUNTER* pCounter)
+{
+	if (NULL == pCounter)
+	{
+		return;
+	}
+
+	int workerIndex = GetWorkerIndex();
+	JOB job;
+	while (pCounter->count.load() > 0)
+	{
+		if (TakeJob(workerIndex, job))
+		{
+			Execute(job);
+		}
+		else
+		{
+			// the last jobs are running on other workers
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used to split a loop into ranges that
+ *  are run as jobs.  The ranges are queued on the calling
+ *  worker, so the other workers steal them from the front
+ *  while the caller works from the back.
+ ***********************************************************/
+void JobSystem::ParallelFor(int count, int grainSize, const std::function<void(int, int)>& body)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	if (grainSize < 1)
+	{
+		grainSize = 1;
+	}
+
+	// a single range is not worth a job
+	if (m_threads.empty() || (count <= grainSize))
+	{
+		body(0, count);
+		return;
+	}
+
+	JOB_COUNTER counter;
+	for (int begin = 0; begin < count; begin += grainSize)
+	{
+		int end = (begin + grainSize < count) ? begin + grainSize : count;
+		Run([&body, begin, end]() { body(begin, end); }, &counter);
+	}
+	Wait(&counter);
+}
+
+/***********************************************************
+ *  TakeJob()
+ *
+ *  This method is used to get the newest job of the own
+ *  queue, or else the oldest job of another queue.
+ ***********************************************************/
+bool JobSystem::TakeJob(int workerIndex, JOB& job)
+{
+	if (m_queuedJobs.load() == 0)
+	{
+		return false;
+	}
+
+	WORKER_QUEUE* queue = m_queues[workerIndex];
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (!queue->jobs.empty())
+		{
+			job = queue->jobs.back();
+			queue->jobs.pop_back();
+			m_queuedJobs.fetch_sub(1);
+			return true;
+		}
+	}
+
+	for (int i = 1; i < m_workerCount; i++)
+	{
+		WORKER_QUEUE* victim = m_queues[(workerIndex + i) % m_workerCount];
+		std::lock_guard<std::mutex> lock(victim->mutex);
+		if (!victim->jobs.empty())
+		{
+			job = victim->jobs.front();
+			victim->jobs.pop_front();
+			m_queuedJobs.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/***********************************************************
+ *  Execute()
+ *
+ *  This method is used to run a job and decrement its
+ *  counter.
+ ***********************************************************/
+void JobSystem::Execute(JOB& job)
+{
+	job.function();
+	job.function = nullptr;
+
+	if (NULL != job.pCounter)
+	{
+		job.pCounter->count.fetch_sub(1);
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is the body of the worker threads.  A
+ *  worker without jobs sleeps until one is queued.
+ ***********************************************************/
+void JobSystem::WorkerLoop(int workerIndex)
+{
+	t_pJobSystem = this;
+	t_workerIndex = workerIndex;
+
+	char threadName[32];
+	snprintf(threadName, sizeof(threadName), "Worker %d", workerIndex);
+	TraceRecorder::SetThreadName(threadName);
+
+	JOB job;
+	while (true)
+	{
+		if (TakeJob(workerIndex, job))
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		while ((m_queuedJobs.load() == 0) && !m_bStopping)
+		{
+			m_wakeCondition.wait(lock);
+		}
+		if (m_bStopping && (m_queuedJobs.load() == 0))
+		{
+			break;
+		}
+	}
+}
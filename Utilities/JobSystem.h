@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// a small work-stealing job scheduler with counters that jobs can wait on
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class contains the code for running small jobs on
+ *  a pool of worker threads.  Every worker has its own
+ *  queue: it adds and takes its jobs at the back, and a
+ *  worker that runs out of jobs steals the oldest job from
+ *  the front of another queue.  The thread that creates
+ *  the pool is worker 0, it has no thread of its own and
+ *  only runs jobs while it waits for a counter.
+ *
+ *  A counter is passed with every job and counts the jobs
+ *  that have not finished yet.  Waiting for a counter is
+ *  how a job, or the frame, depends on a group of jobs.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// the unfinished jobs of a group
+	struct JOB_COUNTER
+	{
+		std::atomic<int> count;
+
+		JOB_COUNTER() : count(0) {}
+	};
+
+	// constructor
+	JobSystem();
+	// destructor
+	~JobSystem();
+
+	// start the worker threads - 0 workers uses one per core,
+	// and 1 worker runs every job on the calling thread
+	void Initialize(int workerCount);
+	// finish the queued jobs and stop the worker threads
+	void Shutdown();
+
+	// number of threads that run jobs, the calling thread included
+	int GetWorkerCount() const { return m_workerCount; }
+
+	// queue a job, the counter is decremented once it has run
+	void Run(const std::function<void()>& job, JOB_COUNTER* pCounter);
+	// run queued jobs until the counter reaches zero
+	void Wait(JOB_COUNTER* pCounter);
+
+	// call the body for the ranges [begin, end) that split
+	// 0 to count into pieces of grainSize items, and wait
+	// for all of them
+	void ParallelFor(int count, int grainSize, const std::function<void(int, int)>& body);
+
+private:
+	// one queued job
+	struct JOB
+	{
+		std::function<void()> function;
+		JOB_COUNTER* pCounter;
+	};
+
+	// the jobs of one worker
+	struct WORKER_QUEUE
+	{
+		std::mutex mutex;
+		std::deque<JOB> jobs;
+	};
+
+	int m_workerCount;
+	std::vector<WORKER_QUEUE*> m_queues;
+	std::vector<std::thread> m_threads;
+
+	// the sleeping workers are woken when a job is queued
+	std::atomic<int> m_queuedJobs;
+	std::atomic<bool> m_bStopping;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+
+	// get the index of the calling worker, 0 for other threads
+	int GetWorkerIndex() const;
+	// take a job from the own queue, or steal one
+	bool TakeJob(int workerIndex, JOB& job);
+	// run a job and count it as finished
+	void Execute(JOB& job);
+	// body of the worker threads
+	void WorkerLoop(int workerIndex);
+};
@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.cpp
+// ============
+// offscreen framebuffer object with color and depth attachments
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTarget.h"
+
+#include <iostream>
+#include <fstream>
+#include <stdint.h>
+
+// declaration of global variables and helpers for the PNG writer
+namespace
+{
+	// largest payload of a stored (uncompressed) deflate block
+	const size_t g_MaxStoredBlock = 65535;
+
+	// CRC-32 as used by the PNG chunks
+	uint32_t UpdateCRC(uint32_t crc, const unsigned char* data, size_t length)
+	{
+		static uint32_t table[256];
+		static bool bTableReady = false;
+		if (!bTableReady)
+		{
+			for (uint32_t n = 0; n < 256; n++)
+			{
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++)
+				{
+					c = (c & 1) ? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+				}
+				table[n] = c;
+			}
+			bTableReady = true;
+		}
+
+		crc = ~crc;
+		for (size_t i = 0; i < length; i++)
+		{
+			crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	// append a 32 bit big endian value
+	void AppendUint32(std::vector<unsigned char>& buffer, uint32_t value)
+	{
+		buffer.push_back((unsigned char)(value >> 24));
+		buffer.push_back((unsigned char)(value >> 16));
+		buffer.push_back((unsigned char)(value >> 8));
+		buffer.push_back((unsigned char)value);
+	}
+
+	// write one PNG chunk with its length and checksum
+	void WriteChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data)
+	{
+		std::vector<unsigned char> chunk;
+		AppendUint32(chunk, (uint32_t)data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		AppendUint32(chunk, UpdateCRC(0, &chunk[4], chunk.size() - 4));
+		file.write((const char*)&chunk[0], chunk.size());
+	}
+}
+
+/***********************************************************
+ *  RenderTarget()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderTarget::RenderTarget()
+{
+	m_framebufferID = 0;
+	m_colorBufferID = 0;
+	m_depthBufferID = 0;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  ~RenderTarget()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderTarget::~RenderTarget()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create the framebuffer object
+ *  with an RGBA color attachment and a depth attachment.
+ ***********************************************************/
+bool RenderTarget::Create(int width, int height)
+{
+	Destroy();
+
+	m_width = width;
+	m_height = height;
+
+	glGenRenderbuffers(1, &m_colorBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &m_depthBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBufferID);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Framebuffer is not complete, status:" << status << std::endl;
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to free the framebuffer object and
+ *  its attachments.
+ ***********************************************************/
+void RenderTarget::Destroy()
+{
+	if (m_framebufferID != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (m_colorBufferID != 0)
+	{
+		glDeleteRenderbuffers(1, &m_colorBufferID);
+		m_colorBufferID = 0;
+	}
+	if (m_depthBufferID != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthBufferID);
+		m_depthBufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used to direct the following draw
+ *  commands into the framebuffer object.
+ ***********************************************************/
+void RenderTarget::Bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, m_width, m_height);
+}
+
+/***********************************************************
+ *  Unbind()
+ *
+ *  This method is used to direct the following draw
+ *  commands into the default framebuffer again.
+ ***********************************************************/
+void RenderTarget::Unbind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  ReadPixels()
+ *
+ *  This method is used to read the color attachment back
+ *  into client memory.
+ ***********************************************************/
+void RenderTarget::ReadPixels(std::vector<unsigned char>& pixels)
+{
+	pixels.resize((size_t)m_width * m_height * 4);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebufferID);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  SavePNG()
+ *
+ *  This method is used to save the color attachment as an
+ *  RGBA PNG image.  The image data is stored without
+ *  compression, which keeps the writer small and fast.
+ ***********************************************************/
+bool RenderTarget::SavePNG(const char* filename)
+{
+	std::vector<unsigned char> pixels;
+	ReadPixels(pixels);
+
+	return(WritePNG(filename, m_width, m_height, pixels));
+}
+
+/***********************************************************
+ *  WritePNG()
+ *
+ *  This method is used to save RGBA rows, the first row at
+ *  the bottom of the image, as a PNG image file.
+ ***********************************************************/
+bool RenderTarget::WritePNG(const char* filename, int width, int height, const std::vector<unsigned char>& pixels)
+{
+	std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write image:" << filename << std::endl;
+		return false;
+	}
+
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	file.write((const char*)signature, sizeof(signature));
+
+	// image header - 8 bits per channel, RGBA, no interlacing
+	std::vector<unsigned char> header;
+	AppendUint32(header, (uint32_t)width);
+	AppendUint32(header, (uint32_t)height);
+	header.push_back(8);
+	header.push_back(6);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	WriteChunk(file, "IHDR", header);
+
+	// PNG rows start at the top of the image and each one is
+	// prefixed with its filter type, which is always "none" here
+	size_t rowSize = (size_t)width * 4;
+	std::vector<unsigned char> raw;
+	raw.reserve((rowSize + 1) * height);
+	for (int y = height - 1; y >= 0; y--)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize);
+	}
+
+	// zlib stream made of stored deflate blocks
+	std::vector<unsigned char> data;
+	data.reserve(raw.size() + raw.size() / g_MaxStoredBlock * 5 + 16);
+	data.push_back(0x78);
+	data.push_back(0x01);
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	size_t offset = 0;
+	do
+	{
+		size_t blockSize = raw.size() - offset;
+		if (blockSize > g_MaxStoredBlock)
+		{
+			blockSize = g_MaxStoredBlock;
+		}
+		bool bFinal = (offset + blockSize == raw.size());
+
+		data.push_back(bFinal ? 1 : 0);
+		data.push_back((unsigned char)(blockSize & 0xff));
+		data.push_back((unsigned char)(blockSize >> 8));
+		data.push_back((unsigned char)(~blockSize & 0xff));
+		data.push_back((unsigned char)((~blockSize >> 8) & 0xff));
+		data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+
+		for (size_t i = offset; i < offset + blockSize; i++)
+		{
+			adlerA = (adlerA + raw[i]) % 65521;
+			adlerB = (adlerB + adlerA) % 65521;
+		}
+		offset += blockSize;
+	} while (offset < raw.size());
+	AppendUint32(data, (adlerB << 16) | adlerA);
+	WriteChunk(file, "IDAT", data);
+
+	WriteChunk(file, "IEND", std::vector<unsigned char>());
+
+	file.close();
+
+	std::cout << "Saved image:" << filename << ", width:" << width << ", height:" << height << std::endl;
+
+	return true;
+}
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.h
+// ============
+// offscreen framebuffer object with color and depth attachments
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <vector>
+
+/***********************************************************
+ *  RenderTarget
+ *
+ *  This class contains the code for rendering into an
+ *  offscreen framebuffer object, and for reading back and
+ *  saving the rendered image.
+ ***********************************************************/
+class RenderTarget
+{
+public:
+	// constructor
+	RenderTarget();
+	// destructor
+	~RenderTarget();
+
+	// create the framebuffer with the passed in size
+	bool Create(int width, int height);
+	// free the framebuffer and its attachments
+	void Destroy();
+
+	// direct the following draw commands into the framebuffer
+	void Bind();
+	// direct the following draw commands into the default framebuffer
+	void Unbind();
+
+	// read the color attachment as tightly packed RGBA rows,
+	// the first row is the bottom of the image
+	void ReadPixels(std::vector<unsigned char>& pixels);
+	// save the color attachment as a PNG image file
+	bool SavePNG(const char* filename);
+	// save RGBA rows, the first row is the bottom of the image
+	static bool WritePNG(const char* filename, int width, int height, const std::vector<unsigned char>& pixels);
+
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	GLuint GetFramebuffer() const { return m_framebufferID; }
+
+private:
+	// the OpenGL framebuffer and its attachments
+	GLuint m_framebufferID;
+	GLuint m_colorBufferID;
+	GLuint m_depthBufferID;
+	// size of the attachments
+	int m_width;
+	int m_height;
+};
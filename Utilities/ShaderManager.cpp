@@ -9,111 +9,1170 @@ using namespace std;
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <chrono>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
 
 #include <GL/glew.h>
 
 #include "ShaderManager.h"
+#include "TraceRecorder.h"
+
+// declaration of the global variables and defines
+namespace
+{
+	// identifies a program binary cache file written by this code
+	const uint32_t g_BinaryCacheMagic = 0x42505343; // "CSPB"
+	// bump whenever the layout of the cache file changes
+	const uint32_t g_BinaryCacheVersion = 1;
+
+	// header stored in front of every cached program binary
+	struct PROGRAM_BINARY_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t hash;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+	};
+
+	// FNV-1a 64 bit hash, continued from the passed in hash value
+	uint64_t HashBytes(const char* data, size_t length, uint64_t hash)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= (uint8_t)data[i];
+			hash *= 0x100000001b3ULL;
+		}
+		return(hash);
+	}
+
+	// hash a string including its terminator, so that the
+	// boundaries between the hashed strings are significant
+	uint64_t HashString(const std::string& value, uint64_t hash)
+	{
+		return(HashBytes(value.c_str(), value.size() + 1, hash));
+	}
+
+	// hash a string returned from glGetString()
+	uint64_t HashGLString(GLenum name, uint64_t hash)
+	{
+		const GLubyte* value = glGetString(name);
+		if (NULL == value)
+		{
+			return(HashString("", hash));
+		}
+		return(HashString((const char*)value, hash));
+	}
+}
 
 /***********************************************************
- *  LoadShaders()
+ *  ShaderManager()
  *
- *  This method is called to load the shader data from 
- *  external GLSL compatible files.
+ *  The constructor for the class
  ***********************************************************/
-GLuint ShaderManager::LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+ShaderManager::ShaderManager()
+{
+	m_programID = 0;
+	m_activeProgram = 0;
+	m_bParallelCompileEnabled = true;
+	m_bStartupReported = false;
+	m_uniformProgramID = 0;
+	m_pUniformValues = &m_programUniforms[0];
+	m_uniformUploads = 0;
+	m_uniformSkips = 0;
+	m_bWatching = false;
+	m_bReloadRequested = false;
+	// linked program binaries are cached relative to the working folder
+	m_binaryCacheDirectory = "shadercache";
+}
 
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+/***********************************************************
+ *  ~ShaderManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderManager::~ShaderManager()
+{
+	// stop the shader file watcher thread
+	EnableHotReload(false);
+}
 
-	// Read the Vertex Shader code from the file
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if(VertexShaderStream.is_open()){
-		std::stringstream sstr;
-		sstr << VertexShaderStream.rdbuf();
-		VertexShaderCode = sstr.str();
-		VertexShaderStream.close();
-	}else{
-		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
-		getchar();
+/***********************************************************
+ *  ReadShaderFile()
+ *
+ *  This method is used to read the whole contents of a
+ *  GLSL source file into the passed in string.
+ ***********************************************************/
+bool ShaderManager::ReadShaderFile(const char* file_path, std::string& shaderCode)
+{
+	std::ifstream ShaderStream(file_path, std::ios::in | std::ios::binary);
+	if (!ShaderStream.is_open())
+	{
+		printf("Impossible to open %s. Are you in the right directory ?\n", file_path);
+		return false;
+	}
+
+	// size the string once and read the file in a single call
+	ShaderStream.seekg(0, std::ios::end);
+	std::streamoff length = ShaderStream.tellg();
+	ShaderStream.seekg(0, std::ios::beg);
+	shaderCode.resize((size_t)std::max<std::streamoff>(length, 0));
+	if (length > 0)
+	{
+		ShaderStream.read(&shaderCode[0], length);
+	}
+	ShaderStream.close();
+
+	return true;
+}
+
+/***********************************************************
+ *  InjectShaderDefines()
+ *
+ *  This method is used to insert the #define lines for a
+ *  shader permutation directly after the #version line.
+ ***********************************************************/
+std::string ShaderManager::InjectShaderDefines(const std::string& shaderCode, const std::string& defines)
+{
+	if (defines.empty())
+	{
+		return(shaderCode);
+	}
+
+	// the #version directive has to stay the first line of the shader
+	size_t insertAt = 0;
+	if (shaderCode.compare(0, 8, "#version") == 0)
+	{
+		insertAt = shaderCode.find('\n');
+		insertAt = (insertAt == std::string::npos) ? shaderCode.size() : insertAt + 1;
+	}
+
+	std::string result = shaderCode.substr(0, insertAt);
+	if (!result.empty() && result[result.size() - 1] != '\n')
+	{
+		result += '\n';
+	}
+	result += defines;
+	if (defines[defines.size() - 1] != '\n')
+	{
+		result += '\n';
+	}
+	result += shaderCode.substr(insertAt);
+
+	return(result);
+}
+
+/***********************************************************
+ *  SetBinaryCacheDirectory()
+ *
+ *  This method is used to set the folder where the linked
+ *  program binaries are cached.  An empty path disables
+ *  the program binary cache.
+ ***********************************************************/
+void ShaderManager::SetBinaryCacheDirectory(const char* directory)
+{
+	m_binaryCacheDirectory = (NULL == directory) ? "" : directory;
+}
+
+/***********************************************************
+ *  GetBinaryCachePath()
+ *
+ *  This method is used to build the cache file path for the
+ *  program binary that belongs to the passed in hash.
+ ***********************************************************/
+std::string ShaderManager::GetBinaryCachePath(uint64_t hash) const
+{
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "%016llx.bin", (unsigned long long)hash);
+	return(m_binaryCacheDirectory + "/" + fileName);
+}
+
+/***********************************************************
+ *  HashProgramSources()
+ *
+ *  This method is used to calculate the key of a program
+ *  binary from the shader sources, the permutation defines
+ *  and the strings identifying the OpenGL driver.
+ ***********************************************************/
+uint64_t ShaderManager::HashProgramSources(
+	const std::string& vertexCode,
+	const std::string& fragmentCode,
+	const std::string& defines)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	hash = HashString(vertexCode, hash);
+	hash = HashString(fragmentCode, hash);
+	hash = HashString(defines, hash);
+	hash = HashGLString(GL_VENDOR, hash);
+	hash = HashGLString(GL_RENDERER, hash);
+	hash = HashGLString(GL_VERSION, hash);
+	hash = HashGLString(GL_SHADING_LANGUAGE_VERSION, hash);
+
+	return(hash);
+}
+
+/***********************************************************
+ *  IsBinaryCacheSupported()
+ *
+ *  This method is used to check whether the driver is able
+ *  to save and restore linked program binaries.
+ ***********************************************************/
+bool ShaderManager::IsBinaryCacheSupported() const
+{
+	if (m_binaryCacheDirectory.empty())
+	{
+		return false;
+	}
+
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+
+	return(numFormats > 0);
+}
+
+/***********************************************************
+ *  LoadProgramBinary()
+ *
+ *  This method is used to create a program from a cached
+ *  program binary.  Zero is returned when there is no valid
+ *  cache entry or the driver rejects the stored binary.
+ ***********************************************************/
+GLuint ShaderManager::LoadProgramBinary(uint64_t hash)
+{
+	std::string cachePath = GetBinaryCachePath(hash);
+	std::ifstream CacheStream(cachePath.c_str(), std::ios::in | std::ios::binary);
+	if (!CacheStream.is_open())
+	{
 		return 0;
 	}
 
-	// Read the Fragment Shader code from the file
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if(FragmentShaderStream.is_open()){
-		std::stringstream sstr;
-		sstr << FragmentShaderStream.rdbuf();
-		FragmentShaderCode = sstr.str();
-		FragmentShaderStream.close();
+	PROGRAM_BINARY_HEADER header;
+	if (!CacheStream.read((char*)&header, sizeof(header)) ||
+		(header.magic != g_BinaryCacheMagic) ||
+		(header.version != g_BinaryCacheVersion) ||
+		(header.hash != hash) ||
+		(header.binaryLength == 0))
+	{
+		return 0;
+	}
+
+	std::vector<char> binary(header.binaryLength);
+	if (!CacheStream.read(&binary[0], header.binaryLength))
+	{
+		return 0;
+	}
+	CacheStream.close();
+
+	GLuint ProgramID = glCreateProgram();
+	glProgramBinary(ProgramID, header.binaryFormat, &binary[0], header.binaryLength);
+
+	// the driver refuses binaries from a different driver build, in
+	// which case the program is compiled from the GLSL source again
+	GLint Result = GL_FALSE;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	if (Result != GL_TRUE)
+	{
+		printf("Discarding stale program binary %s\n", cachePath.c_str());
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
+
+	printf("Loaded program binary %s\n", cachePath.c_str());
+	BindUniformBlocks(ProgramID);
+
+	return ProgramID;
+}
+
+/***********************************************************
+ *  SaveProgramBinary()
+ *
+ *  This method is used to write the binary of a linked
+ *  program into the program binary cache.
+ ***********************************************************/
+void ShaderManager::SaveProgramBinary(GLuint ProgramID, uint64_t hash)
+{
+	GLint binaryLength = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(binaryLength);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(ProgramID, binaryLength, NULL, &binaryFormat, &binary[0]);
+
+	// make sure the cache folder exists - an already existing
+	// folder is not an error
+#ifdef _WIN32
+	_mkdir(m_binaryCacheDirectory.c_str());
+#else
+	mkdir(m_binaryCacheDirectory.c_str(), 0755);
+#endif
+
+	std::string cachePath = GetBinaryCachePath(hash);
+	std::ofstream CacheStream(cachePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!CacheStream.is_open())
+	{
+		printf("Unable to write program binary %s\n", cachePath.c_str());
+		return;
+	}
+
+	PROGRAM_BINARY_HEADER header;
+	header.magic = g_BinaryCacheMagic;
+	header.version = g_BinaryCacheVersion;
+	header.hash = hash;
+	header.binaryFormat = binaryFormat;
+	header.binaryLength = (uint32_t)binaryLength;
+
+	CacheStream.write((const char*)&header, sizeof(header));
+	CacheStream.write(&binary[0], binaryLength);
+	CacheStream.close();
+}
+
+/***********************************************************
+ *  SetParallelCompile()
+ *
+ *  This method is used to enable or disable the use of the
+ *  KHR_parallel_shader_compile extension.  When it is off,
+ *  or the driver lacks the extension, the programs are
+ *  compiled serially while they are queued.
+ ***********************************************************/
+void ShaderManager::SetParallelCompile(bool bEnable)
+{
+	m_bParallelCompileEnabled = bEnable;
+}
+
+/***********************************************************
+ *  IsParallelCompileSupported()
+ *
+ *  This method is used to check whether programs can be
+ *  compiled and linked in the background by the driver.
+ ***********************************************************/
+bool ShaderManager::IsParallelCompileSupported() const
+{
+	if (m_bParallelCompileEnabled == false)
+	{
+		return false;
 	}
 
+	return(GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile);
+}
+
+/***********************************************************
+ *  SubmitShader()
+ *
+ *  This method is used to hand one shader stage to the
+ *  driver for compilation.  The compile status is not
+ *  queried here so that the call never waits on the driver.
+ ***********************************************************/
+GLuint ShaderManager::SubmitShader(GLenum shaderType, const std::string& shaderCode, const char* file_path)
+{
+	GLuint ShaderID = glCreateShader(shaderType);
+
+	printf("Compiling shader : %s\n", file_path);
+	char const * SourcePointer = shaderCode.c_str();
+	glShaderSource(ShaderID, 1, &SourcePointer , NULL);
+	glCompileShader(ShaderID);
+
+	return ShaderID;
+}
+
+/***********************************************************
+ *  CheckShader()
+ *
+ *  This method is used to report the compile status and
+ *  the info log of a submitted shader stage.
+ ***********************************************************/
+bool ShaderManager::CheckShader(GLuint ShaderID, const std::string& file_path)
+{
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
 
+	// Check the shader
+	glGetShaderiv(ShaderID, GL_COMPILE_STATUS, &Result);
+	glGetShaderiv(ShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	if ( InfoLogLength > 1 ){
+		std::vector<char> ShaderErrorMessage(InfoLogLength+1);
+		glGetShaderInfoLog(ShaderID, InfoLogLength, NULL, &ShaderErrorMessage[0]);
+		printf("%s:\n%s\n", file_path.c_str(), &ShaderErrorMessage[0]);
+	}
+
+	if (Result != GL_TRUE)
+	{
+		printf("Compiling shader : %s...failed\n", file_path.c_str());
+		return false;
+	}
 
-	// Compile Vertex Shader
-	printf("Compiling shader : %s...", vertex_file_path);
-	char const * VertexSourcePointer = VertexShaderCode.c_str();
-	glShaderSource(VertexShaderID, 1, &VertexSourcePointer , NULL);
-	glCompileShader(VertexShaderID);
+	return true;
+}
 
-	// Check Vertex Shader
-	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 0 ){
-		std::vector<char> VertexShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
-		printf("\n%s\n", &VertexShaderErrorMessage[0]);
+/***********************************************************
+ *  BuildProgram()
+ *
+ *  This method is used to read the GLSL files of a program
+ *  and either restore it from the program binary cache or
+ *  submit it for compilation and linking.  The program is
+ *  left pending when it still has to be finished.
+ ***********************************************************/
+bool ShaderManager::BuildProgram(SHADER_PROGRAM& program)
+{
+	TRACE_SCOPE("BuildProgram", program.vertexPath.c_str());
+
+	program.vertexShaderID = 0;
+	program.fragmentShaderID = 0;
+	program.programID = 0;
+	program.sourceHash = 0;
+	program.bPending = false;
+	program.bLinked = false;
+
+	// Read the Vertex Shader and the Fragment Shader code from the files
+	std::string VertexShaderCode;
+	std::string FragmentShaderCode;
+	if (!ReadShaderFile(program.vertexPath.c_str(), VertexShaderCode) ||
+		!ReadShaderFile(program.fragmentPath.c_str(), FragmentShaderCode))
+	{
+		return false;
 	}
 
-	printf("success\n");
+	// try to restore the linked program from the binary cache, which
+	// skips the GLSL compilation entirely on a warm startup
+	if (IsBinaryCacheSupported())
+	{
+		program.sourceHash = HashProgramSources(VertexShaderCode, FragmentShaderCode, program.defines);
+		program.programID = LoadProgramBinary(program.sourceHash);
+		if (program.programID != 0)
+		{
+			program.bLinked = true;
+			return true;
+		}
+	}
 
-	// Compile Fragment Shader
-	printf("Compiling shader : %s...", fragment_file_path);
-	char const * FragmentSourcePointer = FragmentShaderCode.c_str();
-	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer , NULL);
-	glCompileShader(FragmentShaderID);
+	// Compile the Vertex Shader and the Fragment Shader
+	program.vertexShaderID = SubmitShader(
+		GL_VERTEX_SHADER,
+		InjectShaderDefines(VertexShaderCode, program.defines),
+		program.vertexPath.c_str());
+	program.fragmentShaderID = SubmitShader(
+		GL_FRAGMENT_SHADER,
+		InjectShaderDefines(FragmentShaderCode, program.defines),
+		program.fragmentPath.c_str());
 
-	// Check Fragment Shader
-	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 0 ){
-		std::vector<char> FragmentShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
-		printf("\n%s\n", &FragmentShaderErrorMessage[0]);
+	// Link the program - with parallel compile support the link is
+	// queued behind the two compiles and does not block here
+	printf("Linking shader program : %s + %s\n", program.vertexPath.c_str(), program.fragmentPath.c_str());
+	program.programID = glCreateProgram();
+	if (program.sourceHash != 0)
+	{
+		glProgramParameteri(program.programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	}
+	glAttachShader(program.programID, program.vertexShaderID);
+	glAttachShader(program.programID, program.fragmentShaderID);
+	glLinkProgram(program.programID);
+	program.bPending = true;
 
-	printf("success\n");
+	return true;
+}
 
-	// Link the program
-	printf("Linking shader program...");
-	GLuint ProgramID = glCreateProgram();
-	m_programID = ProgramID;
-	glAttachShader(ProgramID, VertexShaderID);
-	glAttachShader(ProgramID, FragmentShaderID);
-	glLinkProgram(ProgramID);
+/***********************************************************
+ *  QueueShaders()
+ *
+ *  This method is called to submit a shader program for
+ *  compilation and linking.  A valid program binary from
+ *  the cache is used directly.  Otherwise, with parallel
+ *  compile support the driver compiles and links in the
+ *  background and the caller can continue with other work
+ *  until PollShaders() or WaitForShaders() is called.
+ *  The returned handle identifies the program, -1 is
+ *  returned when the shader files could not be read.
+ ***********************************************************/
+int ShaderManager::QueueShaders(const char* vertex_file_path, const char* fragment_file_path, const char* defines)
+{
+	TRACE_SCOPE("QueueShaders");
+
+	if (m_programs.empty())
+	{
+		m_queueStartTime = std::chrono::steady_clock::now();
+
+		// let the driver use as many compiler threads as it likes
+		if (IsParallelCompileSupported())
+		{
+			if (GLEW_KHR_parallel_shader_compile)
+			{
+				glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+			}
+			else
+			{
+				glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+			}
+		}
+	}
+
+	SHADER_PROGRAM program;
+	program.vertexPath = vertex_file_path;
+	program.fragmentPath = fragment_file_path;
+	program.defines = (NULL == defines) ? "" : defines;
+	if (BuildProgram(program) == false)
+	{
+		return -1;
+	}
+
+	m_programs.push_back(program);
+	int handle = (int)m_programs.size() - 1;
+
+	// without the extension every query would block anyway, so
+	// finish the program right away to keep the old serial order
+	if (!IsParallelCompileSupported())
+	{
+		FinishProgram(m_programs[handle]);
+	}
+
+	return handle;
+}
+
+/***********************************************************
+ *  FinishProgram()
+ *
+ *  This method is used to check the link result of a
+ *  submitted program, release its shader objects and store
+ *  the linked program in the program binary cache.
+ ***********************************************************/
+bool ShaderManager::FinishProgram(SHADER_PROGRAM& program)
+{
+	if (program.bPending == false)
+	{
+		return(program.bLinked);
+	}
+
+	TRACE_SCOPE("FinishProgram", program.vertexPath.c_str());
+
+	GLint Result = GL_FALSE;
+	int InfoLogLength;
 
 	// Check the program
-	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
-	glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 1 ){
-		std::vector<char> ProgramErrorMessage(InfoLogLength+1);
-		glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
-		printf("\n%s\n", &ProgramErrorMessage[0]);
+	glGetProgramiv(program.programID, GL_LINK_STATUS, &Result);
+	if (Result != GL_TRUE)
+	{
+		// the compile logs explain most link failures
+		CheckShader(program.vertexShaderID, program.vertexPath);
+		CheckShader(program.fragmentShaderID, program.fragmentPath);
+
+		glGetProgramiv(program.programID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+		if ( InfoLogLength > 1 ){
+			std::vector<char> ProgramErrorMessage(InfoLogLength+1);
+			glGetProgramInfoLog(program.programID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
+			printf("\n%s\n", &ProgramErrorMessage[0]);
+		}
 	}
 
-	printf("success\n");
-	
-	glDetachShader(ProgramID, VertexShaderID);
-	glDetachShader(ProgramID, FragmentShaderID);
-	
-	glDeleteShader(VertexShaderID);
-	glDeleteShader(FragmentShaderID);
+	glDetachShader(program.programID, program.vertexShaderID);
+	glDetachShader(program.programID, program.fragmentShaderID);
 
-	return ProgramID;
+	glDeleteShader(program.vertexShaderID);
+	glDeleteShader(program.fragmentShaderID);
+	program.vertexShaderID = 0;
+	program.fragmentShaderID = 0;
+	program.bPending = false;
+
+	if (Result != GL_TRUE)
+	{
+		printf("Linking shader program : %s + %s...failed\n", program.vertexPath.c_str(), program.fragmentPath.c_str());
+		glDeleteProgram(program.programID);
+		program.programID = 0;
+		program.bLinked = false;
+		return false;
+	}
+
+	program.bLinked = true;
+	BindUniformBlocks(program.programID);
+
+	// store the linked program so the next startup can skip compiling
+	if (program.sourceHash != 0)
+	{
+		SaveProgramBinary(program.programID, program.sourceHash);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  BindUniformBlocks()
+ *
+ *  This method is used to attach the frame constants block
+ *  of a linked program to the binding point shared by all
+ *  of the programs.
+ ***********************************************************/
+void ShaderManager::BindUniformBlocks(GLuint ProgramID)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(ProgramID, FrameUniformBuffer::BLOCK_NAME);
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(ProgramID, blockIndex, FrameUniformBuffer::BINDING_POINT);
+	}
+}
+
+/***********************************************************
+ *  PollShaders()
+ *
+ *  This method is used to finish every queued program that
+ *  the driver has completed, without blocking.  True is
+ *  returned once no program is pending any more.
+ ***********************************************************/
+bool ShaderManager::PollShaders()
+{
+	bool bAllDone = true;
+
+	for (size_t i = 0; i < m_programs.size(); i++)
+	{
+		if (m_programs[i].bPending == false)
+		{
+			continue;
+		}
+
+		GLint bCompleted = GL_TRUE;
+		if (IsParallelCompileSupported())
+		{
+			glGetProgramiv(m_programs[i].programID, GL_COMPLETION_STATUS_KHR, &bCompleted);
+		}
+
+		if (bCompleted == GL_TRUE)
+		{
+			FinishProgram(m_programs[i]);
+		}
+		else
+		{
+			bAllDone = false;
+		}
+	}
+
+	return(bAllDone);
+}
+
+/***********************************************************
+ *  WaitForShaders()
+ *
+ *  This method is used to block until all of the queued
+ *  programs are linked, and to report the startup time
+ *  spent on the shaders.  The active program is selected
+ *  once it is ready.  False is returned when any program
+ *  failed to compile or link.
+ ***********************************************************/
+bool ShaderManager::WaitForShaders()
+{
+	TRACE_SCOPE("WaitForShaders");
+
+	std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+
+	bool bSuccess = true;
+	for (size_t i = 0; i < m_programs.size(); i++)
+	{
+		if (FinishProgram(m_programs[i]) == false)
+		{
+			bSuccess = false;
+		}
+	}
+
+	std::chrono::steady_clock::time_point waitEnd = std::chrono::steady_clock::now();
+	if (!m_programs.empty() && !m_bStartupReported)
+	{
+		// the blocked time is what the startup actually pays for the
+		// shaders, the rest overlapped with the texture and mesh work
+		printf("INFO: %d shader program(s) ready in %.2f ms, %.2f ms blocked (parallel compile %s)\n",
+			(int)m_programs.size(),
+			std::chrono::duration<double, std::milli>(waitEnd - m_queueStartTime).count(),
+			std::chrono::duration<double, std::milli>(waitEnd - waitStart).count(),
+			IsParallelCompileSupported() ? "on" : "off");
+		m_bStartupReported = true;
+	}
+
+	if ((m_activeProgram >= 0) && (m_activeProgram < (int)m_programs.size()))
+	{
+		m_programID = m_programs[m_activeProgram].programID;
+	}
+
+	return(bSuccess);
+}
+
+/***********************************************************
+ *  SelectProgram()
+ *
+ *  This method is used to make a queued program, such as a
+ *  shader permutation, the active program.
+ ***********************************************************/
+bool ShaderManager::SelectProgram(int handle)
+{
+	if ((handle < 0) || (handle >= (int)m_programs.size()))
+	{
+		return false;
+	}
+
+	FinishProgram(m_programs[handle]);
+
+	m_activeProgram = handle;
+	m_programID = m_programs[handle].programID;
+	use();
+
+	// uniforms are per program object, so a program that is
+	// used for the first time receives all of the values set
+	// so far, and one used before still holds its own
+	SelectUniformState();
+
+	return(m_programID != 0);
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method is used to get the OpenGL program of a
+ *  queued program, which is zero until it has been linked.
+ ***********************************************************/
+GLuint ShaderManager::GetProgram(int handle) const
+{
+	if ((handle < 0) || (handle >= (int)m_programs.size()) ||
+		(m_programs[handle].bLinked == false))
+	{
+		return 0;
+	}
+
+	return(m_programs[handle].programID);
+}
+
+/***********************************************************
+ *  LoadShaders()
+ *
+ *  This method is called to load the shader data from
+ *  external GLSL compatible files.  The program is queued
+ *  and waited for immediately, and becomes the active
+ *  program.
+ ***********************************************************/
+GLuint ShaderManager::LoadShaders(const char * vertex_file_path,const char * fragment_file_path, const char * defines){
+
+	TRACE_SCOPE("LoadShaders");
+	int handle = QueueShaders(vertex_file_path, fragment_file_path, defines);
+	if (handle < 0)
+	{
+		return 0;
+	}
+
+	m_activeProgram = handle;
+	WaitForShaders();
+
+	return(GetProgram(handle));
+}
+
+/***********************************************************
+ *  StoreUniform()
+ *
+ *  This method is used to remember the value of a uniform
+ *  and to upload it into the active program.  The upload is
+ *  skipped when the program already holds the same value.
+ ***********************************************************/
+void ShaderManager::StoreUniform(const std::string& name, UNIFORM_TYPE type, const void* pValue) const
+{
+	// the program was changed since the last uniform was set
+	if (m_uniformProgramID != m_programID)
+	{
+		SelectUniformState();
+	}
+
+	size_t valueSize = 0;
+	switch (type)
+	{
+	case UNIFORM_INT:	valueSize = sizeof(int); break;
+	case UNIFORM_FLOAT:	valueSize = sizeof(float); break;
+	case UNIFORM_VEC2:	valueSize = sizeof(float) * 2; break;
+	case UNIFORM_VEC3:	valueSize = sizeof(float) * 3; break;
+	case UNIFORM_VEC4:	valueSize = sizeof(float) * 4; break;
+	case UNIFORM_MAT2:	valueSize = sizeof(float) * 4; break;
+	case UNIFORM_MAT3:	valueSize = sizeof(float) * 9; break;
+	case UNIFORM_MAT4:	valueSize = sizeof(float) * 16; break;
+	}
+
+	UNIFORM_VALUES::iterator found = m_pUniformValues->find(name);
+	if (found == m_pUniformValues->end())
+	{
+		// first time this uniform is set - look up its location once
+		UNIFORM_VALUE uniform;
+		uniform.location = glGetUniformLocation(m_programID, name.c_str());
+		uniform.type = type;
+		memcpy(uniform.floatValues, pValue, valueSize);
+		found = m_pUniformValues->insert(std::make_pair(name, uniform)).first;
+	}
+	else
+	{
+		if ((found->second.type == type) &&
+			(memcmp(found->second.floatValues, pValue, valueSize) == 0))
+		{
+			m_uniformSkips++;
+			return;
+		}
+		found->second.type = type;
+		memcpy(found->second.floatValues, pValue, valueSize);
+	}
+
+	UploadUniform(found->second);
+}
+
+/***********************************************************
+ *  UploadUniform()
+ *
+ *  This method is used to upload a remembered uniform value
+ *  into the active program.
+ ***********************************************************/
+void ShaderManager::UploadUniform(const UNIFORM_VALUE& uniform) const
+{
+	if (uniform.location < 0)
+	{
+		return;
+	}
+	m_uniformUploads++;
+
+	switch (uniform.type)
+	{
+	case UNIFORM_INT:
+		glUniform1i(uniform.location, uniform.intValue);
+		break;
+	case UNIFORM_FLOAT:
+		glUniform1f(uniform.location, uniform.floatValues[0]);
+		break;
+	case UNIFORM_VEC2:
+		glUniform2fv(uniform.location, 1, uniform.floatValues);
+		break;
+	case UNIFORM_VEC3:
+		glUniform3fv(uniform.location, 1, uniform.floatValues);
+		break;
+	case UNIFORM_VEC4:
+		glUniform4fv(uniform.location, 1, uniform.floatValues);
+		break;
+	case UNIFORM_MAT2:
+		glUniformMatrix2fv(uniform.location, 1, GL_FALSE, uniform.floatValues);
+		break;
+	case UNIFORM_MAT3:
+		glUniformMatrix3fv(uniform.location, 1, GL_FALSE, uniform.floatValues);
+		break;
+	case UNIFORM_MAT4:
+		glUniformMatrix4fv(uniform.location, 1, GL_FALSE, uniform.floatValues);
+		break;
+	}
+}
+
+/***********************************************************
+ *  SelectUniformState()
+ *
+ *  This method is used to switch the remembered values to
+ *  the ones of the active program.  A program seen for the
+ *  first time starts with a copy of the values of the
+ *  previous one, which are uploaded into it, and a program
+ *  seen before already holds its values, so nothing is
+ *  uploaded.  The active program has to be bound with use()
+ *  before this method is called.
+ ***********************************************************/
+void ShaderManager::SelectUniformState() const
+{
+	std::unordered_map<GLuint, UNIFORM_VALUES>::iterator found = m_programUniforms.find(m_programID);
+	if (found != m_programUniforms.end())
+	{
+		m_uniformProgramID = m_programID;
+		m_pUniformValues = &found->second;
+		return;
+	}
+
+	UNIFORM_VALUES& values = m_programUniforms[m_programID];
+	values = *m_pUniformValues;
+	m_pUniformValues = &values;
+	ApplyUniformState();
+}
+
+/***********************************************************
+ *  ApplyUniformState()
+ *
+ *  This method is used to look up the uniform locations in
+ *  the active program again and to upload every remembered
+ *  uniform value of it.  The active program has to be
+ *  bound with use() before this method is called.
+ ***********************************************************/
+void ShaderManager::ApplyUniformState() const
+{
+	if (m_uniformProgramID != m_programID)
+	{
+		m_pUniformValues = &m_programUniforms[m_programID];
+	}
+	m_uniformProgramID = m_programID;
+
+	UNIFORM_VALUES::iterator it;
+	for (it = m_pUniformValues->begin(); it != m_pUniformValues->end(); ++it)
+	{
+		it->second.location = (m_programID != 0) ? glGetUniformLocation(m_programID, it->first.c_str()) : -1;
+		UploadUniform(it->second);
+	}
+}
+
+/***********************************************************
+ *  EnableHotReload()
+ *
+ *  This method is used to start or stop watching the GLSL
+ *  files of all queued programs.  When one of the files
+ *  changes, the programs are rebuilt by ProcessHotReload().
+ ***********************************************************/
+void ShaderManager::EnableHotReload(bool bEnable)
+{
+	if (m_watchThread.joinable())
+	{
+		m_bWatching = false;
+		m_watchThread.join();
+	}
+
+	if (bEnable == false)
+	{
+		return;
+	}
+
+	// collect the files to watch - the thread gets its own copy
+	std::vector<std::string> filePaths;
+	for (size_t i = 0; i < m_programs.size(); i++)
+	{
+		if (std::find(filePaths.begin(), filePaths.end(), m_programs[i].vertexPath) == filePaths.end())
+		{
+			filePaths.push_back(m_programs[i].vertexPath);
+		}
+		if (std::find(filePaths.begin(), filePaths.end(), m_programs[i].fragmentPath) == filePaths.end())
+		{
+			filePaths.push_back(m_programs[i].fragmentPath);
+		}
+	}
+
+	if (filePaths.empty())
+	{
+		return;
+	}
+
+	m_bWatching = true;
+	m_watchThread = std::thread(&ShaderManager::WatchShaderFiles, this, filePaths);
+
+	printf("INFO: Watching %d shader file(s) for changes\n", (int)filePaths.size());
+}
+
+/***********************************************************
+ *  WatchShaderFiles()
+ *
+ *  This method is the body of the shader file watcher
+ *  thread.  It never touches OpenGL, it only raises the
+ *  reload request flag for the render thread.
+ ***********************************************************/
+void ShaderManager::WatchShaderFiles(std::vector<std::string> filePaths)
+{
+	TraceRecorder::SetThreadName("Shader Watcher");
+
+#ifdef __linux__
+	// editors often save by writing a new file and renaming it over
+	// the old one, so the folders are watched instead of the files
+	int inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFD < 0)
+	{
+		printf("Unable to watch the shader files, inotify_init1() failed\n");
+		return;
+	}
+
+	std::vector<int> watchIDs;
+	std::vector<std::string> fileNames;
+	for (size_t i = 0; i < filePaths.size(); i++)
+	{
+		size_t slash = filePaths[i].find_last_of('/');
+		std::string folder = (slash == std::string::npos) ? "." : filePaths[i].substr(0, slash);
+		fileNames.push_back((slash == std::string::npos) ? filePaths[i] : filePaths[i].substr(slash + 1));
+		watchIDs.push_back(inotify_add_watch(inotifyFD, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE));
+	}
+
+	// the events are aligned like the inotify_event structure
+	alignas(struct inotify_event) char buffer[4096];
+	while (m_bWatching)
+	{
+		struct pollfd pollFD;
+		pollFD.fd = inotifyFD;
+		pollFD.events = POLLIN;
+		pollFD.revents = 0;
+
+		// wake up regularly to notice when the watching is stopped
+		if (poll(&pollFD, 1, 200) <= 0)
+		{
+			continue;
+		}
+
+		TRACE_SCOPE("ShaderFileEvents");
+		ssize_t length = read(inotifyFD, buffer, sizeof(buffer));
+		for (ssize_t offset = 0; offset < length; )
+		{
+			const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+			if (event->len > 0)
+			{
+				for (size_t i = 0; i < fileNames.size(); i++)
+				{
+					if ((watchIDs[i] == event->wd) && (fileNames[i] == event->name))
+					{
+						m_bReloadRequested = true;
+					}
+				}
+			}
+			offset += sizeof(struct inotify_event) + event->len;
+		}
+	}
+
+	close(inotifyFD);
+#else
+	// without inotify the modification times are polled
+	std::vector<time_t> modifiedTimes(filePaths.size(), 0);
+	for (size_t i = 0; i < filePaths.size(); i++)
+	{
+		struct stat fileInfo;
+		if (stat(filePaths[i].c_str(), &fileInfo) == 0)
+		{
+			modifiedTimes[i] = fileInfo.st_mtime;
+		}
+	}
+
+	while (m_bWatching)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+		for (size_t i = 0; i < filePaths.size(); i++)
+		{
+			struct stat fileInfo;
+			if ((stat(filePaths[i].c_str(), &fileInfo) == 0) &&
+				(fileInfo.st_mtime != modifiedTimes[i]))
+			{
+				modifiedTimes[i] = fileInfo.st_mtime;
+				m_bReloadRequested = true;
+			}
+		}
+	}
+#endif
 }
 
+/***********************************************************
+ *  ProcessHotReload()
+ *
+ *  This method is called once per frame.  When a watched
+ *  shader file has changed, every program is rebuilt in the
+ *  background.  A rebuilt program replaces the live one only
+ *  when it linked successfully, and the remembered uniform
+ *  values are re-applied to it.  On failure the old program
+ *  stays in use.  It returns true when a program was swapped,
+ *  so that a frame drawn with the old one is not reused.
+ ***********************************************************/
+bool ShaderManager::ProcessHotReload()
+{
+	bool bReloaded = false;
+
+	if (m_bReloadRequested.exchange(false))
+	{
+		TRACE_SCOPE("RebuildShaders");
+
+		// rebuilds that are still compiling are out of date now
+		for (size_t i = 0; i < m_reloads.size(); i++)
+		{
+			SHADER_PROGRAM& program = m_reloads[i].program;
+			if (program.bPending)
+			{
+				glDeleteShader(program.vertexShaderID);
+				glDeleteShader(program.fragmentShaderID);
+			}
+			glDeleteProgram(program.programID);
+		}
+		m_reloads.clear();
+
+		for (size_t i = 0; i < m_programs.size(); i++)
+		{
+			PROGRAM_RELOAD reload;
+			reload.handle = (int)i;
+			reload.program.vertexPath = m_programs[i].vertexPath;
+			reload.program.fragmentPath = m_programs[i].fragmentPath;
+			reload.program.defines = m_programs[i].defines;
+			reload.startTime = std::chrono::steady_clock::now();
+			if (BuildProgram(reload.program))
+			{
+				m_reloads.push_back(reload);
+			}
+		}
+	}
 
+	for (size_t i = 0; i < m_reloads.size(); )
+	{
+		PROGRAM_RELOAD& reload = m_reloads[i];
+
+		// keep rendering with the old program while the driver compiles
+		if (reload.program.bPending && IsParallelCompileSupported())
+		{
+			GLint bCompleted = GL_FALSE;
+			glGetProgramiv(reload.program.programID, GL_COMPLETION_STATUS_KHR, &bCompleted);
+			if (bCompleted != GL_TRUE)
+			{
+				i++;
+				continue;
+			}
+		}
+
+		if (FinishProgram(reload.program))
+		{
+			// swap the live program for the rebuilt one
+			GLuint oldProgramID = m_programs[reload.handle].programID;
+			m_programs[reload.handle] = reload.program;
+
+			// the rebuilt program takes over the values of the old
+			// one, uploaded into it while it is bound - a program
+			// that was never used has no values yet and receives
+			// them on its first use
+			std::unordered_map<GLuint, UNIFORM_VALUES>::iterator found = m_programUniforms.find(oldProgramID);
+			if (found != m_programUniforms.end())
+			{
+				UNIFORM_VALUES values;
+				values.swap(found->second);
+				m_programUniforms.erase(found);
+				m_programUniforms[reload.program.programID].swap(values);
+
+				GLuint activeProgramID = m_programID;
+				m_programID = reload.program.programID;
+				use();
+				ApplyUniformState();
+				if (reload.handle != m_activeProgram)
+				{
+					m_programID = activeProgramID;
+					use();
+					SelectUniformState();
+				}
+			}
+			else if (reload.handle == m_activeProgram)
+			{
+				m_programID = reload.program.programID;
+				use();
+				SelectUniformState();
+			}
+			glDeleteProgram(oldProgramID);
+			bReloaded = true;
+
+			printf("INFO: Reloaded shader program %s + %s in %.2f ms\n",
+				reload.program.vertexPath.c_str(),
+				reload.program.fragmentPath.c_str(),
+				std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - reload.startTime).count());
+		}
+		else
+		{
+			printf("INFO: Keeping the previous shader program\n");
+		}
+
+		m_reloads.erase(m_reloads.begin() + i);
+	}
+
+	return(bReloaded);
+}
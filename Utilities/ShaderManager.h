@@ -10,15 +10,71 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+
+#include "FrameUniformBuffer.h"
 
 class ShaderManager
 {
 public:
+	// constructor
+	ShaderManager();
+	// destructor
+	~ShaderManager();
+
 	unsigned int m_programID;
 	
+	// load, compile and link the shader program - the optional
+	// defines are inserted after the #version line of both shaders
 	GLuint LoadShaders(
 		const char* vertex_file_path, 
-		const char* fragment_file_path);
+		const char* fragment_file_path,
+		const char* defines = NULL);
+
+	// set the folder for cached program binaries, empty disables it
+	void SetBinaryCacheDirectory(const char* directory);
+
+	// submit a program for compilation without waiting for it,
+	// returns a handle to the program or -1 on failure
+	int QueueShaders(
+		const char* vertex_file_path,
+		const char* fragment_file_path,
+		const char* defines = NULL);
+	// finish the programs the driver has completed, true when
+	// there are no pending programs left
+	bool PollShaders();
+	// block until all queued programs are linked
+	bool WaitForShaders();
+	// make a queued program the active program
+	bool SelectProgram(int handle);
+	// get the linked program for a handle
+	GLuint GetProgram(int handle) const;
+	// allow or prevent the use of KHR_parallel_shader_compile
+	void SetParallelCompile(bool bEnable);
+
+	// watch the GLSL files of the queued programs for changes
+	void EnableHotReload(bool bEnable);
+	// rebuild changed programs and swap them in once linked,
+	// called once per frame from the render thread - true when
+	// a program was swapped
+	bool ProcessHotReload();
+	// re-apply all of the remembered uniform values of the
+	// active program
+	void ApplyUniformState() const;
+
+	// camera and light constants shared by all of the programs
+	FrameUniformBuffer& GetFrameUniforms() { return m_frameUniforms; }
+
+	// number of uniform values uploaded, and of redundant ones
+	// that were skipped, since the last reset
+	unsigned int GetUniformUploads() const { return m_uniformUploads; }
+	unsigned int GetUniformSkips() const { return m_uniformSkips; }
+	void ResetUniformStatistics() { m_uniformUploads = 0; m_uniformSkips = 0; }
 
 	// activate the shader
 	// ------------------------------------------------------------------------
@@ -27,77 +83,198 @@ public:
 		glUseProgram(m_programID);
 	}
 
-	// utility uniform functions
+	// utility uniform functions - the values are remembered so
+	// they can be re-applied when the program is swapped
 	// ------------------------------------------------------------------------
 	inline void setBoolValue(const std::string &name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), (int)value);
+		int intValue = (int)value;
+		StoreUniform(name, UNIFORM_INT, &intValue);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setIntValue(const std::string &name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
+		StoreUniform(name, UNIFORM_INT, &value);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setFloatValue(const std::string &name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(m_programID, name.c_str()), value);
+		StoreUniform(name, UNIFORM_FLOAT, &value);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setVec2Value(const std::string &name, const glm::vec2 &value) const
 	{
-		glUniform2fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		StoreUniform(name, UNIFORM_VEC2, &value[0]);
 	}
 
 	inline void setVec2Value(const std::string &name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(m_programID, name.c_str()), x, y);
+		setVec2Value(name, glm::vec2(x, y));
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setVec3Value(const std::string &name, const glm::vec3 &value) const
 	{
-		glUniform3fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		StoreUniform(name, UNIFORM_VEC3, &value[0]);
 	}
 	inline void setVec3Value(const std::string &name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(m_programID, name.c_str()), x, y, z);
+		setVec3Value(name, glm::vec3(x, y, z));
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setVec4Value(const std::string &name, const glm::vec4 &value) const
 	{
-		glUniform4fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		StoreUniform(name, UNIFORM_VEC4, &value[0]);
 	}
 	inline void setVec4Value(const std::string &name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(m_programID, name.c_str()), x, y, z, w);
+		setVec4Value(name, glm::vec4(x, y, z, w));
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setMat2Value(const std::string &name, const glm::mat2 &mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		StoreUniform(name, UNIFORM_MAT2, &mat[0][0]);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setMat3Value(const std::string &name, const glm::mat3 &mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		StoreUniform(name, UNIFORM_MAT3, &mat[0][0]);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setMat4Value(const std::string &name, const glm::mat4 &mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+		StoreUniform(name, UNIFORM_MAT4, glm::value_ptr(mat));
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setSampler2DValue(const std::string& name, const int &value) const
 	{
-		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
+		StoreUniform(name, UNIFORM_INT, &value);
 	}
+
+private:
+	// the value types that can be stored for a uniform
+	enum UNIFORM_TYPE
+	{
+		UNIFORM_INT,
+		UNIFORM_FLOAT,
+		UNIFORM_VEC2,
+		UNIFORM_VEC3,
+		UNIFORM_VEC4,
+		UNIFORM_MAT2,
+		UNIFORM_MAT3,
+		UNIFORM_MAT4
+	};
+
+	// last value set for a uniform of the active program
+	struct UNIFORM_VALUE
+	{
+		GLint location;
+		UNIFORM_TYPE type;
+		union
+		{
+			int intValue;
+			float floatValues[16];
+		};
+	};
+
+	// uniform values by name for each program, and the program
+	// that the values being set belong to - every program keeps
+	// its own values, so a switch between programs uploads none
+	typedef std::unordered_map<std::string, UNIFORM_VALUE> UNIFORM_VALUES;
+	mutable std::unordered_map<GLuint, UNIFORM_VALUES> m_programUniforms;
+	mutable UNIFORM_VALUES* m_pUniformValues;
+	mutable GLuint m_uniformProgramID;
+	// uploaded and skipped uniform values since the last reset
+	mutable unsigned int m_uniformUploads;
+	mutable unsigned int m_uniformSkips;
+
+	// remember a uniform value and upload it when it has changed
+	void StoreUniform(const std::string& name, UNIFORM_TYPE type, const void* pValue) const;
+	// upload a remembered uniform value to the active program
+	void UploadUniform(const UNIFORM_VALUE& uniform) const;
+	// make the values of the active program the ones being set,
+	// a program without values yet receives the ones set so far
+	void SelectUniformState() const;
+
+	// stores the state of a program submitted with QueueShaders()
+	struct SHADER_PROGRAM
+	{
+		std::string vertexPath;
+		std::string fragmentPath;
+		std::string defines;
+		GLuint vertexShaderID;
+		GLuint fragmentShaderID;
+		GLuint programID;
+		uint64_t sourceHash;	// program binary cache key, 0 when not cached
+		bool bPending;			// submitted but not finished yet
+		bool bLinked;			// linked successfully and usable
+	};
+
+	// a rebuild of a changed program, swapped in once it is linked
+	struct PROGRAM_RELOAD
+	{
+		int handle;
+		SHADER_PROGRAM program;
+		std::chrono::steady_clock::time_point startTime;
+	};
+
+	// all of the queued programs and permutations
+	std::vector<SHADER_PROGRAM> m_programs;
+	// handle of the program that m_programID refers to
+	int m_activeProgram;
+	// whether KHR_parallel_shader_compile may be used
+	bool m_bParallelCompileEnabled;
+	// startup timing of the shader compilation
+	std::chrono::steady_clock::time_point m_queueStartTime;
+	bool m_bStartupReported;
+
+	// hot reload state - the watcher thread only sets the flag,
+	// all of the OpenGL work happens in ProcessHotReload()
+	std::vector<PROGRAM_RELOAD> m_reloads;
+	std::thread m_watchThread;
+	std::atomic<bool> m_bWatching;
+	std::atomic<bool> m_bReloadRequested;
+
+	// body of the shader file watcher thread
+	void WatchShaderFiles(std::vector<std::string> filePaths);
+	// read, hash and submit a program for compilation
+	bool BuildProgram(SHADER_PROGRAM& program);
+
+	// uniform buffer bound to the frame constants block
+	FrameUniformBuffer m_frameUniforms;
+
+	// folder where the linked program binaries are cached
+	std::string m_binaryCacheDirectory;
+
+	// read a GLSL source file into memory
+	bool ReadShaderFile(const char* file_path, std::string& shaderCode);
+	// insert permutation defines after the #version line
+	std::string InjectShaderDefines(const std::string& shaderCode, const std::string& defines);
+	// compile a single shader stage without waiting for the result
+	GLuint SubmitShader(GLenum shaderType, const std::string& shaderCode, const char* file_path);
+	// report the compile status of a shader stage
+	bool CheckShader(GLuint ShaderID, const std::string& file_path);
+	// check the link result and release the shader stages
+	bool FinishProgram(SHADER_PROGRAM& program);
+	// connect the uniform blocks to their shared binding points
+	void BindUniformBlocks(GLuint ProgramID);
+	bool IsParallelCompileSupported() const;
+
+	// program binary cache support
+	bool IsBinaryCacheSupported() const;
+	uint64_t HashProgramSources(
+		const std::string& vertexCode,
+		const std::string& fragmentCode,
+		const std::string& defines);
+	std::string GetBinaryCachePath(uint64_t hash) const;
+	GLuint LoadProgramBinary(uint64_t hash);
+	void SaveProgramBinary(GLuint ProgramID, uint64_t hash);
 };
\ No newline at end of file
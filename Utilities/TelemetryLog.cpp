@@ -0,0 +1,308 @@
+///////////////////////////////////////////////////////////////////////////////
+// telemetrylog.cpp
+// ============
+// per-frame runtime metrics written to a CSV or binary columnar file by a
+// background thread
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TelemetryLog.h"
+
+#include <string.h>
+#include <stddef.h>
+#include <vector>
+
+#include "TraceRecorder.h"
+
+// declaration of global variables
+namespace
+{
+	// value types of the columns
+	enum COLUMN_TYPE
+	{
+		COLUMN_DOUBLE = 'd',
+		COLUMN_FLOAT = 'f',
+		COLUMN_UINT32 = 'u'
+	};
+
+	// one column of the log and where its value is in a sample
+	struct COLUMN
+	{
+		const char* name;
+		COLUMN_TYPE type;
+		size_t offset;
+	};
+
+	const COLUMN g_Columns[] = {
+		{ "timestamp_ms",    COLUMN_DOUBLE, offsetof(TelemetryLog::TELEMETRY_SAMPLE, timestampMs) },
+		{ "frame",           COLUMN_UINT32, offsetof(TelemetryLog::TELEMETRY_SAMPLE, frame) },
+		{ "frame_ms",        COLUMN_FLOAT,  offsetof(TelemetryLog::TELEMETRY_SAMPLE, frameMs) },
+		{ "draw_calls",      COLUMN_UINT32, offsetof(TelemetryLog::TELEMETRY_SAMPLE, drawCalls) },
+		{ "triangles",       COLUMN_UINT32, offsetof(TelemetryLog::TELEMETRY_SAMPLE, triangles) },
+		{ "uniform_uploads", COLUMN_UINT32, offsetof(TelemetryLog::TELEMETRY_SAMPLE, uniformUploads) },
+		{ "uniform_skips",   COLUMN_UINT32, offsetof(TelemetryLog::TELEMETRY_SAMPLE, uniformSkips) },
+		{ "R",               COLUMN_FLOAT,  offsetof(TelemetryLog::TELEMETRY_SAMPLE, lightRadius) },
+		{ "H",               COLUMN_FLOAT,  offsetof(TelemetryLog::TELEMETRY_SAMPLE, lightHeight) }
+	};
+	const int g_ColumnCount = sizeof(g_Columns) / sizeof(g_Columns[0]);
+
+	// identifies the binary columnar format
+	const char g_BinaryMagic[4] = { 'T', 'L', 'M', '1' };
+
+	// how often the writer thread empties the ring buffer
+	const int g_FlushIntervalMs = 100;
+
+	// get the size of a value of a column
+	size_t GetColumnSize(COLUMN_TYPE type)
+	{
+		return (type == COLUMN_DOUBLE) ? sizeof(double) : 4;
+	}
+}
+
+/***********************************************************
+ *  TelemetryLog()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TelemetryLog::TelemetryLog()
+{
+	m_pSamples = new TELEMETRY_SAMPLE[CAPACITY];
+	m_writeIndex = 0;
+	m_readIndex = 0;
+	m_droppedSamples = 0;
+	m_pFile = NULL;
+	m_bBinary = false;
+	m_bRunning = false;
+	m_openTime = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  ~TelemetryLog()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TelemetryLog::~TelemetryLog()
+{
+	Close();
+	delete[] m_pSamples;
+	m_pSamples = NULL;
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used to create the log file, write its
+ *  column header and start the writer thread.
+ ***********************************************************/
+bool TelemetryLog::Open(const char* filename)
+{
+	Close();
+
+	size_t length = strlen(filename);
+	m_bBinary = (length > 4) && (strcmp(filename + length - 4, ".bin") == 0);
+
+	m_pFile = fopen(filename, m_bBinary ? "wb" : "w");
+	if (NULL == m_pFile)
+	{
+		printf("Unable to write telemetry %s\n", filename);
+		return false;
+	}
+
+	m_writeIndex = 0;
+	m_readIndex = 0;
+	m_droppedSamples = 0;
+	m_openTime = std::chrono::steady_clock::now();
+	WriteHeader();
+
+	m_bRunning = true;
+	m_writerThread = std::thread(&TelemetryLog::WriteSamples, this);
+
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to stop the writer thread, write the
+ *  samples that are still in the ring buffer and close the
+ *  log file.
+ ***********************************************************/
+void TelemetryLog::Close()
+{
+	if (NULL == m_pFile)
+	{
+		return;
+	}
+
+	m_bRunning = false;
+	if (m_writerThread.joinable())
+	{
+		m_writerThread.join();
+	}
+	Flush();
+
+	if (m_droppedSamples > 0)
+	{
+		printf("Telemetry dropped %u samples, the writer could not keep up\n", (unsigned int)m_droppedSamples);
+	}
+
+	fclose(m_pFile);
+	m_pFile = NULL;
+}
+
+/***********************************************************
+ *  GetElapsedMs()
+ *
+ *  This method is used to get the timestamp for a sample.
+ ***********************************************************/
+double TelemetryLog::GetElapsedMs() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_openTime).count();
+}
+
+/***********************************************************
+ *  Push()
+ *
+ *  This method is called by the render thread to add the
+ *  sample of a frame.  It only copies the sample into the
+ *  ring buffer.
+ ***********************************************************/
+bool TelemetryLog::Push(const TELEMETRY_SAMPLE& sample)
+{
+	if (NULL == m_pFile)
+	{
+		return false;
+	}
+
+	uint64_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+	if (writeIndex - m_readIndex.load(std::memory_order_acquire) >= (uint64_t)CAPACITY)
+	{
+		m_droppedSamples.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	m_pSamples[writeIndex % CAPACITY] = sample;
+	m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+
+	return true;
+}
+
+/***********************************************************
+ *  WriteSamples()
+ *
+ *  This method is the body of the writer thread.  It wakes
+ *  up regularly and writes the samples that were added
+ *  since the last time.
+ ***********************************************************/
+void TelemetryLog::WriteSamples()
+{
+	TraceRecorder::SetThreadName("Telemetry Writer");
+
+	while (m_bRunning)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(g_FlushIntervalMs));
+		Flush();
+	}
+}
+
+/***********************************************************
+ *  Flush()
+ *
+ *  This method is used to write the samples between the
+ *  read and the write index.  The CSV format writes one
+ *  line per sample, the binary format writes a block with
+ *  the sample count followed by every column in turn.
+ ***********************************************************/
+void TelemetryLog::Flush()
+{
+	uint64_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+	uint64_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+	if (readIndex == writeIndex)
+	{
+		return;
+	}
+
+	TRACE_SCOPE("FlushTelemetry");
+
+	if (m_bBinary)
+	{
+		uint32_t count = (uint32_t)(writeIndex - readIndex);
+		fwrite(&count, sizeof(count), 1, m_pFile);
+
+		std::vector<unsigned char> column;
+		for (int c = 0; c < g_ColumnCount; c++)
+		{
+			size_t valueSize = GetColumnSize(g_Columns[c].type);
+			column.resize(count * valueSize);
+			for (uint64_t i = readIndex; i < writeIndex; i++)
+			{
+				const unsigned char* sample = (const unsigned char*)&m_pSamples[i % CAPACITY];
+				memcpy(&column[(size_t)(i - readIndex) * valueSize], sample + g_Columns[c].offset, valueSize);
+			}
+			fwrite(&column[0], valueSize, count, m_pFile);
+		}
+	}
+	else
+	{
+		for (uint64_t i = readIndex; i < writeIndex; i++)
+		{
+			const unsigned char* sample = (const unsigned char*)&m_pSamples[i % CAPACITY];
+			for (int c = 0; c < g_ColumnCount; c++)
+			{
+				const void* value = sample + g_Columns[c].offset;
+				if (c > 0)
+				{
+					fputc(',', m_pFile);
+				}
+				switch (g_Columns[c].type)
+				{
+				case COLUMN_DOUBLE:
+					fprintf(m_pFile, "%.3f", *(const double*)value);
+					break;
+				case COLUMN_FLOAT:
+					fprintf(m_pFile, "%.3f", *(const float*)value);
+					break;
+				case COLUMN_UINT32:
+					fprintf(m_pFile, "%u", *(const uint32_t*)value);
+					break;
+				}
+			}
+			fputc('\n', m_pFile);
+		}
+	}
+	fflush(m_pFile);
+
+	// the slots can be reused once they are written
+	m_readIndex.store(writeIndex, std::memory_order_release);
+}
+
+/***********************************************************
+ *  WriteHeader()
+ *
+ *  This method is used to write the column names.  The
+ *  binary header also holds the value type of each column.
+ ***********************************************************/
+void TelemetryLog::WriteHeader()
+{
+	if (m_bBinary)
+	{
+		fwrite(g_BinaryMagic, sizeof(g_BinaryMagic), 1, m_pFile);
+		uint32_t columnCount = g_ColumnCount;
+		fwrite(&columnCount, sizeof(columnCount), 1, m_pFile);
+		for (int c = 0; c < g_ColumnCount; c++)
+		{
+			unsigned char type = (unsigned char)g_Columns[c].type;
+			unsigned char nameLength = (unsigned char)strlen(g_Columns[c].name);
+			fwrite(&type, 1, 1, m_pFile);
+			fwrite(&nameLength, 1, 1, m_pFile);
+			fwrite(g_Columns[c].name, 1, nameLength, m_pFile);
+		}
+	}
+	else
+	{
+		for (int c = 0; c < g_ColumnCount; c++)
+		{
+			fprintf(m_pFile, (c > 0) ? ",%s" : "%s", g_Columns[c].name);
+		}
+		fputc('\n', m_pFile);
+	}
+}
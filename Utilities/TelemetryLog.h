@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// telemetrylog.h
+// ============
+// per-frame runtime metrics written to a CSV or binary columnar file by a
+// background thread
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+/***********************************************************
+ *  TelemetryLog
+ *
+ *  This class contains the code for logging one sample of
+ *  metrics per frame.  The render thread adds the samples
+ *  to a preallocated ring buffer, and a background thread
+ *  writes them to the file, so the render thread never
+ *  waits for file I/O.  A sample is dropped when the ring
+ *  buffer is full.
+ ***********************************************************/
+class TelemetryLog
+{
+public:
+	// number of samples the ring buffer holds
+	static const int CAPACITY = 4096;
+
+	// the metrics of one frame
+	struct TELEMETRY_SAMPLE
+	{
+		double timestampMs;			// since the log was opened
+		uint32_t frame;
+		float frameMs;
+		uint32_t drawCalls;
+		uint32_t triangles;
+		uint32_t uniformUploads;	// uniform values sent to the driver
+		uint32_t uniformSkips;		// redundant uniform values filtered out
+		float lightRadius;			// R in SetupSceneLights()
+		float lightHeight;			// H in SetupSceneLights()
+	};
+
+	// constructor
+	TelemetryLog();
+	// destructor
+	~TelemetryLog();
+
+	// open the log file and start the writer thread - a file
+	// name ending in .bin selects the binary columnar format,
+	// any other name is written as CSV
+	bool Open(const char* filename);
+	// write the remaining samples and close the file
+	void Close();
+
+	// true while the log file is open
+	bool IsOpen() const { return NULL != m_pFile; }
+
+	// get the time since the log was opened
+	double GetElapsedMs() const;
+
+	// add a sample without blocking, false is returned when
+	// the sample was dropped because the ring buffer is full
+	bool Push(const TELEMETRY_SAMPLE& sample);
+
+private:
+	// the ring buffer, written by the render thread and read
+	// by the writer thread
+	TELEMETRY_SAMPLE* m_pSamples;
+	std::atomic<uint64_t> m_writeIndex;
+	std::atomic<uint64_t> m_readIndex;
+	std::atomic<uint32_t> m_droppedSamples;
+
+	// the log file and the thread that writes it
+	FILE* m_pFile;
+	bool m_bBinary;
+	std::thread m_writerThread;
+	std::atomic<bool> m_bRunning;
+	std::chrono::steady_clock::time_point m_openTime;
+
+	// body of the writer thread
+	void WriteSamples();
+	// write every sample currently in the ring buffer
+	void Flush();
+	// write the column header of the selected format
+	void WriteHeader();
+};
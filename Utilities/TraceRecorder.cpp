@@ -0,0 +1,276 @@
+///////////////////////////////////////////////////////////////////////////////
+// tracerecorder.cpp
+// ============
+// record timed events from every thread and export them as a Chrome
+// trace event JSON file, for viewing in chrome://tracing or Perfetto
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TraceRecorder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <mutex>
+
+std::atomic<bool> TraceRecorder::s_bEnabled(false);
+
+// declaration of global variables
+namespace
+{
+	// one finished event
+	struct TRACE_EVENT
+	{
+		const char* name;
+		const char* category;
+		long long startNs;
+		long long durationNs;
+		char detail[TraceRecorder::MAX_DETAIL_LENGTH + 1];
+	};
+
+	// the events of one thread - only the owning thread writes
+	// them, the count is published after each event is complete
+	struct THREAD_BUFFER
+	{
+		int threadID;
+		char threadName[32];
+		TRACE_EVENT events[TraceRecorder::EVENTS_PER_THREAD];
+		std::atomic<unsigned long long> writeCount;
+	};
+
+	// every thread that recorded an event - the lock is only
+	// taken once per thread, when its buffer is created
+	std::mutex g_BufferMutex;
+	std::vector<THREAD_BUFFER*> g_Buffers;
+	thread_local THREAD_BUFFER* t_pBuffer = NULL;
+
+	// trace settings and the time that the trace starts at
+	std::string g_Filename;
+	int g_MaxFrames = 0;
+	int g_RecordedFrames = 0;
+	std::chrono::steady_clock::time_point g_StartTime;
+	std::chrono::steady_clock::time_point g_FrameStart;
+
+	// get the buffer of the calling thread
+	THREAD_BUFFER* GetThreadBuffer()
+	{
+		if (NULL == t_pBuffer)
+		{
+			THREAD_BUFFER* buffer = new THREAD_BUFFER();
+			buffer->threadName[0] = '\0';
+			buffer->writeCount.store(0, std::memory_order_relaxed);
+
+			std::lock_guard<std::mutex> lock(g_BufferMutex);
+			buffer->threadID = (int)g_Buffers.size() + 1;
+			g_Buffers.push_back(buffer);
+			t_pBuffer = buffer;
+		}
+		return(t_pBuffer);
+	}
+
+	// write a string as a JSON string value
+	void WriteJSONString(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if ((*c == '"') || (*c == '\\'))
+			{
+				fputc('\\', file);
+				fputc(*c, file);
+			}
+			else if ((unsigned char)*c < 0x20)
+			{
+				fprintf(file, "\\u%04x", (unsigned char)*c);
+			}
+			else
+			{
+				fputc(*c, file);
+			}
+		}
+		fputc('"', file);
+	}
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to start recording.  The trace file
+ *  is written by Write(), normally when the app exits.
+ ***********************************************************/
+void TraceRecorder::Start(const char* filename, int maxFrames)
+{
+	g_Filename = filename;
+	g_MaxFrames = maxFrames;
+	g_RecordedFrames = 0;
+	g_StartTime = std::chrono::steady_clock::now();
+	s_bEnabled.store(true);
+}
+
+/***********************************************************
+ *  SetThreadName()
+ *
+ *  This method is used to give the calling thread a name
+ *  in the trace viewer.
+ ***********************************************************/
+void TraceRecorder::SetThreadName(const char* name)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	THREAD_BUFFER* buffer = GetThreadBuffer();
+	strncpy(buffer->threadName, name, sizeof(buffer->threadName) - 1);
+	buffer->threadName[sizeof(buffer->threadName) - 1] = '\0';
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to mark the start of a frame.
+ ***********************************************************/
+void TraceRecorder::BeginFrame()
+{
+	if (IsEnabled())
+	{
+		g_FrameStart = std::chrono::steady_clock::now();
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to record the frame as an event.
+ *  Recording stops once the requested number of frames
+ *  has been traced.
+ ***********************************************************/
+void TraceRecorder::EndFrame()
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	char detail[32];
+	snprintf(detail, sizeof(detail), "frame %d", g_RecordedFrames);
+	Record("Frame", "frame", g_FrameStart, std::chrono::steady_clock::now(), detail);
+
+	g_RecordedFrames++;
+	if (g_RecordedFrames >= g_MaxFrames)
+	{
+		s_bEnabled.store(false);
+	}
+}
+
+/***********************************************************
+ *  Record()
+ *
+ *  This method is used to add a finished event to the ring
+ *  buffer of the calling thread.
+ ***********************************************************/
+void TraceRecorder::Record(
+	const char* name,
+	const char* category,
+	std::chrono::steady_clock::time_point startTime,
+	std::chrono::steady_clock::time_point endTime,
+	const char* detail)
+{
+	THREAD_BUFFER* buffer = GetThreadBuffer();
+
+	unsigned long long index = buffer->writeCount.load(std::memory_order_relaxed);
+	TRACE_EVENT& event = buffer->events[index % EVENTS_PER_THREAD];
+	event.name = name;
+	event.category = category;
+	event.startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(startTime - g_StartTime).count();
+	event.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+	event.detail[0] = '\0';
+	if (NULL != detail)
+	{
+		strncpy(event.detail, detail, MAX_DETAIL_LENGTH);
+		event.detail[MAX_DETAIL_LENGTH] = '\0';
+	}
+	buffer->writeCount.store(index + 1, std::memory_order_release);
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used to write the recorded events into a
+ *  Chrome trace event JSON file.  Recording is stopped
+ *  first, so the other threads should be idle by now.
+ ***********************************************************/
+bool TraceRecorder::Write()
+{
+	if (g_Filename.empty())
+	{
+		return false;
+	}
+	s_bEnabled.store(false);
+
+	FILE* file = fopen(g_Filename.c_str(), "w");
+	if (NULL == file)
+	{
+		printf("Unable to write trace %s\n", g_Filename.c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(g_BufferMutex);
+
+	size_t totalEvents = 0;
+	unsigned long long lostEvents = 0;
+	bool bFirst = true;
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (size_t i = 0; i < g_Buffers.size(); i++)
+	{
+		const THREAD_BUFFER* buffer = g_Buffers[i];
+
+		if (buffer->threadName[0] != '\0')
+		{
+			fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":",
+				bFirst ? "" : ",\n", buffer->threadID);
+			WriteJSONString(file, buffer->threadName);
+			fprintf(file, "}}");
+			bFirst = false;
+		}
+
+		// only the newest events are left in a ring buffer that wrapped
+		unsigned long long count = buffer->writeCount.load(std::memory_order_acquire);
+		unsigned long long first = 0;
+		if (count > (unsigned long long)EVENTS_PER_THREAD)
+		{
+			first = count - EVENTS_PER_THREAD;
+			lostEvents += first;
+		}
+
+		for (unsigned long long index = first; index < count; index++)
+		{
+			const TRACE_EVENT& event = buffer->events[index % EVENTS_PER_THREAD];
+			fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"cat\":\"%s\",\"name\":",
+				bFirst ? "" : ",\n", buffer->threadID, event.category);
+			WriteJSONString(file, event.name);
+			fprintf(file, ",\"ts\":%.3f,\"dur\":%.3f", event.startNs / 1000.0, event.durationNs / 1000.0);
+			if (event.detail[0] != '\0')
+			{
+				fprintf(file, ",\"args\":{\"detail\":");
+				WriteJSONString(file, event.detail);
+				fprintf(file, "}");
+			}
+			fprintf(file, "}");
+			bFirst = false;
+			totalEvents++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	printf("INFO: Wrote %d trace events from %d thread(s) to %s",
+		(int)totalEvents, (int)g_Buffers.size(), g_Filename.c_str());
+	if (lostEvents > 0)
+	{
+		printf(", %llu older events were overwritten", lostEvents);
+	}
+	printf("\n");
+
+	return true;
+}
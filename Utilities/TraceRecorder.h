@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// tracerecorder.h
+// ============
+// record timed events from every thread and export them as a Chrome
+// trace event JSON file, for viewing in chrome://tracing or Perfetto
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <atomic>
+#include <cstddef>
+
+/***********************************************************
+ *  TraceRecorder
+ *
+ *  This class contains the code for recording the startup
+ *  and the first frames of the application as a timeline.
+ *  Every thread writes its events into its own ring buffer
+ *  without any locking, the buffers are only read when the
+ *  trace file is written.
+ ***********************************************************/
+class TraceRecorder
+{
+public:
+	// number of events kept per thread, older events are
+	// overwritten once a ring buffer is full
+	static const int EVENTS_PER_THREAD = 32768;
+	// longest detail string stored with an event
+	static const int MAX_DETAIL_LENGTH = 63;
+
+	// start recording, the trace stops by itself after the
+	// passed in number of frames
+	static void Start(const char* filename, int maxFrames);
+	static bool IsEnabled() { return s_bEnabled.load(std::memory_order_relaxed); }
+
+	// name the calling thread in the trace
+	static void SetThreadName(const char* name);
+
+	// mark the start and the end of a frame of the main loop
+	static void BeginFrame();
+	static void EndFrame();
+
+	// add a finished event of the calling thread, the name and
+	// the category have to be string literals
+	static void Record(
+		const char* name,
+		const char* category,
+		std::chrono::steady_clock::time_point startTime,
+		std::chrono::steady_clock::time_point endTime,
+		const char* detail = NULL);
+
+	// write the recorded events to the trace file
+	static bool Write();
+
+private:
+	// true while events are recorded
+	static std::atomic<bool> s_bEnabled;
+};
+
+/***********************************************************
+ *  TraceScope
+ *
+ *  This class records the time from its construction to the
+ *  end of the enclosing block as one trace event.
+ ***********************************************************/
+class TraceScope
+{
+public:
+	TraceScope(const char* name, const char* detail = NULL)
+	{
+		m_name = NULL;
+		if (TraceRecorder::IsEnabled())
+		{
+			m_name = name;
+			m_detail = detail;
+			m_startTime = std::chrono::steady_clock::now();
+		}
+	}
+	~TraceScope()
+	{
+		if (NULL != m_name)
+		{
+			TraceRecorder::Record(m_name, "scope", m_startTime, std::chrono::steady_clock::now(), m_detail);
+		}
+	}
+
+private:
+	const char* m_name;
+	const char* m_detail;
+	std::chrono::steady_clock::time_point m_startTime;
+
+	TraceScope(const TraceScope&);
+	TraceScope& operator=(const TraceScope&);
+};
+
+// record the rest of the enclosing block as a trace event, the optional
+// second argument is shown as the detail of the event
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(...) TraceScope TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
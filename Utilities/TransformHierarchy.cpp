@@ -0,0 +1,266 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformhierarchy.cpp
+// ============
+// position, rotation and scale of objects linked to parent objects, with
+// cached world matrices
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformHierarchy.h"
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	const double g_RadiansPerDegree = 3.14159265358979323846 / 180.0;
+
+	// the sine and cosine of an angle in degrees, reduced to the
+	// closest multiple of 90 degrees first so that the multiples
+	// themselves come out exact
+	void SinCosDegrees(double degrees, double& sine, double& cosine)
+	{
+		double quadrant = floor((degrees / 90.0) + 0.5);
+		double radians = (degrees - (quadrant * 90.0)) * g_RadiansPerDegree;
+		double s = sin(radians);
+		double c = cos(radians);
+		switch ((((long long)quadrant % 4) + 4) % 4)
+		{
+		case 0: sine = s; cosine = c; break;
+		case 1: sine = c; cosine = -s; break;
+		case 2: sine = -s; cosine = -c; break;
+		default: sine = -c; cosine = s; break;
+		}
+	}
+}
+
+/***********************************************************
+ *  TransformHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransformHierarchy::TransformHierarchy()
+{
+	m_firstDirty = 0;
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used to add a node without any scale,
+ *  rotation or offset from its parent.  The parent has to
+ *  be added first, which keeps the parents before their
+ *  children in the array.
+ ***********************************************************/
+int TransformHierarchy::AddNode(int parent)
+{
+	int node = (int)m_nodes.size();
+	if ((parent < NO_PARENT) || (parent >= node))
+	{
+		printf("ERROR: Parent %d of transform node %d was not added before it\n", parent, node);
+		return -1;
+	}
+
+	TRANSFORM_NODE newNode;
+	newNode.parent = parent;
+	newNode.position = glm::vec3(0.0f);
+	newNode.rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	newNode.scale = glm::vec3(1.0f);
+	newNode.rotationDegrees = glm::vec3(0.0f);
+	newNode.bEulerValid = false;
+	newNode.bDirty = false;
+	newNode.bUpdated = false;
+	newNode.world = glm::mat4(1.0f);
+	newNode.normalMatrix = glm::mat3(1.0f);
+	newNode.worldScale = 1.0f;
+	m_nodes.push_back(newNode);
+
+	MarkDirty(node);
+	return node;
+}
+
+/***********************************************************
+ *  SetParent()
+ *
+ *  This method is used to attach a node to another parent.
+ *  The transformation of the node is kept, so it moves with
+ *  the new parent from then on.
+ ***********************************************************/
+bool TransformHierarchy::SetParent(int node, int parent)
+{
+	if ((parent < NO_PARENT) || (parent >= node))
+	{
+		printf("ERROR: Parent %d of transform node %d was not added before it\n", parent, node);
+		return false;
+	}
+
+	if (m_nodes[node].parent != parent)
+	{
+		m_nodes[node].parent = parent;
+		MarkDirty(node);
+	}
+	return true;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove all the nodes.
+ ***********************************************************/
+void TransformHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_firstDirty = 0;
+}
+
+/***********************************************************
+ *  SetPosition()
+ *
+ *  This method is used to set the offset of a node from
+ *  its parent.
+ ***********************************************************/
+void TransformHierarchy::SetPosition(int node, const glm::vec3& position)
+{
+	if (m_nodes[node].position != position)
+	{
+		m_nodes[node].position = position;
+		MarkDirty(node);
+	}
+}
+
+/***********************************************************
+ *  SetRotation()
+ *
+ *  This method is used to set the rotation of a node
+ *  relative to its parent.  The authored angles no longer
+ *  describe it afterwards.
+ ***********************************************************/
+void TransformHierarchy::SetRotation(int node, const glm::quat& rotation)
+{
+	m_nodes[node].bEulerValid = false;
+	if (m_nodes[node].rotation != rotation)
+	{
+		m_nodes[node].rotation = rotation;
+		MarkDirty(node);
+	}
+}
+
+/***********************************************************
+ *  SetScale()
+ *
+ *  This method is used to set the scale of a node, which
+ *  is applied before its rotation.
+ ***********************************************************/
+void TransformHierarchy::SetScale(int node, const glm::vec3& scale)
+{
+	if (m_nodes[node].scale != scale)
+	{
+		m_nodes[node].scale = scale;
+		MarkDirty(node);
+	}
+}
+
+/***********************************************************
+ *  SetEulerTransform()
+ *
+ *  This method is used to set the transformation of a node
+ *  from the values a scene is written with.  A scene that
+ *  sets the same values every frame only compares them.
+ ***********************************************************/
+void TransformHierarchy::SetEulerTransform(int node, const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	TRANSFORM_NODE& transform = m_nodes[node];
+	if (!transform.bEulerValid || (transform.rotationDegrees != rotationDegrees))
+	{
+		SetRotation(node, EulerToQuaternion(rotationDegrees));
+		transform.rotationDegrees = rotationDegrees;
+		transform.bEulerValid = true;
+	}
+	SetScale(node, scale);
+	SetPosition(node, position);
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used to build the matrices of a node and
+ *  the nodes below it in the next update.
+ ***********************************************************/
+void TransformHierarchy::MarkDirty(int node)
+{
+	m_nodes[node].bDirty = true;
+	m_firstDirty = std::min(m_firstDirty, node);
+}
+
+/***********************************************************
+ *  UpdateWorldMatrices()
+ *
+ *  This method is used to build the world matrices of the
+ *  nodes that changed.  A node is built when it is dirty
+ *  or when its parent was built in the same update, and
+ *  the nodes before the first dirty one are skipped.
+ ***********************************************************/
+int TransformHierarchy::UpdateWorldMatrices()
+{
+	int nodeCount = (int)m_nodes.size();
+	int updatedCount = 0;
+
+	for (int i = m_firstDirty; i < nodeCount; i++)
+	{
+		TRANSFORM_NODE& node = m_nodes[i];
+		const TRANSFORM_NODE* pParent = (node.parent != NO_PARENT) ? &m_nodes[node.parent] : NULL;
+
+		// a parent before the first dirty node did not change
+		node.bUpdated = node.bDirty || ((NULL != pParent) && (node.parent >= m_firstDirty) && pParent->bUpdated);
+		if (!node.bUpdated)
+		{
+			continue;
+		}
+
+		glm::mat3 rotation = glm::mat3_cast(node.rotation);
+		glm::mat4 local(
+			glm::vec4(rotation[0] * node.scale.x, 0.0f),
+			glm::vec4(rotation[1] * node.scale.y, 0.0f),
+			glm::vec4(rotation[2] * node.scale.z, 0.0f),
+			glm::vec4(node.position, 1.0f));
+		node.world = (NULL != pParent) ? (pParent->world * local) : local;
+
+		// the normal matrix keeps the normals correct for rotated and
+		// non-uniformly scaled objects
+		glm::mat3 linear(node.world);
+		node.normalMatrix = glm::inverseTranspose(linear);
+		node.worldScale = std::max(glm::length(linear[0]), std::max(glm::length(linear[1]), glm::length(linear[2])));
+
+		node.bDirty = false;
+		updatedCount++;
+	}
+
+	m_firstDirty = nodeCount;
+	return updatedCount;
+}
+
+/***********************************************************
+ *  EulerToQuaternion()
+ *
+ *  This method is used to convert authored angles to the
+ *  rotation that rotating around X, then Y, then Z gives,
+ *  the same as chaining the three rotation matrices.  The
+ *  product is calculated in double precision.
+ ***********************************************************/
+glm::quat TransformHierarchy::EulerToQuaternion(const glm::vec3& rotationDegrees)
+{
+	double sines[3];
+	double cosines[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		SinCosDegrees(0.5 * (double)rotationDegrees[axis], sines[axis], cosines[axis]);
+	}
+
+	glm::dquat rotationX(cosines[0], sines[0], 0.0, 0.0);
+	glm::dquat rotationY(cosines[1], 0.0, sines[1], 0.0);
+	glm::dquat rotationZ(cosines[2], 0.0, 0.0, sines[2]);
+	return glm::quat(rotationX * rotationY * rotationZ);
+}
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformhierarchy.h
+// ============
+// position, rotation and scale of objects linked to parent objects, with
+// cached world matrices
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TransformHierarchy
+ *
+ *  This class contains the code for the transformations of
+ *  objects that can be attached to other objects.  Every
+ *  node keeps its position, rotation and scale relative to
+ *  its parent, the rotation as a quaternion, and caches its
+ *  world matrix together with the normal matrix.
+ *
+ *  Changing a node marks it dirty, and the next update only
+ *  builds the matrices of the dirty nodes and of the nodes
+ *  below them.  The nodes are kept in an array where every
+ *  parent comes before its children, so the update is one
+ *  pass starting at the first dirty node, and an update of
+ *  nodes that did not change returns at once.
+ ***********************************************************/
+class TransformHierarchy
+{
+public:
+	// the parent of a node that is not attached to another one
+	static const int NO_PARENT = -1;
+
+	// constructor
+	TransformHierarchy();
+
+	// add a node below a parent added before it, or at the top
+	// with NO_PARENT - returns the node, or -1 for a wrong parent
+	int AddNode(int parent);
+	// attach a node to another parent added before it
+	bool SetParent(int node, int parent);
+	int GetParent(int node) const { return m_nodes[node].parent; }
+	int GetNodeCount() const { return (int)m_nodes.size(); }
+	// remove all the nodes
+	void Clear();
+
+	// set the transformation of a node relative to its parent
+	void SetPosition(int node, const glm::vec3& position);
+	void SetRotation(int node, const glm::quat& rotation);
+	void SetScale(int node, const glm::vec3& scale);
+	// set the transformation from authored values, with the
+	// rotation in degrees around X, then Y, then Z - the angles
+	// are only converted when they differ from the last ones,
+	// and the node is only dirty when a value changed
+	void SetEulerTransform(int node, const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position);
+
+	const glm::vec3& GetPosition(int node) const { return m_nodes[node].position; }
+	const glm::quat& GetRotation(int node) const { return m_nodes[node].rotation; }
+	const glm::vec3& GetScale(int node) const { return m_nodes[node].scale; }
+
+	// build the matrices of the dirty nodes and the nodes below
+	// them - returns the number of nodes that were built
+	int UpdateWorldMatrices();
+
+	// the cached matrices of a node, as of the last update
+	const glm::mat4& GetWorldMatrix(int node) const { return m_nodes[node].world; }
+	const glm::mat3& GetNormalMatrix(int node) const { return m_nodes[node].normalMatrix; }
+	// the longest axis of the world matrix, which scales the
+	// bounding sphere of the node
+	float GetWorldScale(int node) const { return m_nodes[node].worldScale; }
+
+	// the rotation of the angles in degrees around X, then Y, then
+	// Z, which keeps the multiples of 90 degrees exact
+	static glm::quat EulerToQuaternion(const glm::vec3& rotationDegrees);
+
+private:
+	struct TRANSFORM_NODE
+	{
+		int parent;
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+		// the angles the rotation was last authored with
+		glm::vec3 rotationDegrees;
+		bool bEulerValid;
+		// the transformation changed since the last update
+		bool bDirty;
+		// the world matrix was built by the current update
+		bool bUpdated;
+		glm::mat4 world;
+		glm::mat3 normalMatrix;
+		float worldScale;
+	};
+
+	std::vector<TRANSFORM_NODE> m_nodes;
+	// the first dirty node, or the node count when none is dirty
+	int m_firstDirty;
+
+	// mark a node for the next update
+	void MarkDirty(int node);
+};
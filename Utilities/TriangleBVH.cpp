@@ -0,0 +1,340 @@
+///////////////////////////////////////////////////////////////////////////////
+// trianglebvh.cpp
+// ============
+// a bounding volume hierarchy over world space triangles for casting rays
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TriangleBVH.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+// declaration of global variables
+namespace
+{
+	// number of bins the node centers are sorted into when
+	// looking for the cheapest split
+	const int g_SplitBins = 12;
+	// cost of visiting a node, relative to testing one triangle
+	const float g_TraversalCost = 0.125f;
+	// deepest tree that the traversal stack can hold
+	const int g_MaxDepth = 64;
+
+	// half of the surface area of a box
+	float HalfArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		glm::vec3 size = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+		return((size.x * size.y) + (size.y * size.z) + (size.z * size.x));
+	}
+}
+
+/***********************************************************
+ *  TriangleBVH()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TriangleBVH::TriangleBVH()
+{
+	m_depth = 0;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used to build the tree over a list of
+ *  triangles, replacing the previous tree.
+ ***********************************************************/
+void TriangleBVH::Build(const std::vector<glm::vec3>& positions)
+{
+	m_nodes.clear();
+	m_triangles.clear();
+	m_depth = 0;
+
+	int triangleCount = (int)(positions.size() / 3);
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	std::vector<BVH_TRIANGLE> triangles(triangleCount);
+	std::vector<BUILD_ITEM> items(triangleCount);
+	for (int i = 0; i < triangleCount; i++)
+	{
+		const glm::vec3& p0 = positions[i * 3];
+		const glm::vec3& p1 = positions[i * 3 + 1];
+		const glm::vec3& p2 = positions[i * 3 + 2];
+
+		triangles[i].corner = p0;
+		triangles[i].edge1 = p1 - p0;
+		triangles[i].edge2 = p2 - p0;
+
+		items[i].boundsMin = glm::min(p0, glm::min(p1, p2));
+		items[i].boundsMax = glm::max(p0, glm::max(p1, p2));
+		items[i].center = (items[i].boundsMin + items[i].boundsMax) * 0.5f;
+		items[i].triangle = i;
+	}
+
+	// a binary tree has fewer than two nodes per triangle
+	m_nodes.reserve(triangleCount * 2);
+	m_triangles.reserve(triangleCount);
+	BuildNode(items, 0, triangleCount, 1, triangles);
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used to add the node that holds the
+ *  items [begin, end), and then its two children.  The
+ *  items are split where the surface area heuristic says
+ *  rays are cheapest to cast, and a node becomes a leaf
+ *  when no split is cheaper than testing its triangles.
+ ***********************************************************/
+void TriangleBVH::BuildNode(std::vector<BUILD_ITEM>& items, int begin, int end, int depth, const std::vector<BVH_TRIANGLE>& triangles)
+{
+	int nodeIndex = (int)m_nodes.size();
+	m_nodes.push_back(BVH_NODE());
+	m_depth = std::max(m_depth, depth);
+
+	glm::vec3 boundsMin(FLT_MAX);
+	glm::vec3 boundsMax(-FLT_MAX);
+	glm::vec3 centerMin(FLT_MAX);
+	glm::vec3 centerMax(-FLT_MAX);
+	for (int i = begin; i < end; i++)
+	{
+		boundsMin = glm::min(boundsMin, items[i].boundsMin);
+		boundsMax = glm::max(boundsMax, items[i].boundsMax);
+		centerMin = glm::min(centerMin, items[i].center);
+		centerMax = glm::max(centerMax, items[i].center);
+	}
+	m_nodes[nodeIndex].boundsMin = boundsMin;
+	m_nodes[nodeIndex].boundsMax = boundsMax;
+	m_nodes[nodeIndex].secondChild = -1;
+	m_nodes[nodeIndex].firstTriangle = 0;
+	m_nodes[nodeIndex].triangleCount = 0;
+
+	int count = end - begin;
+	glm::vec3 centerSize = centerMax - centerMin;
+	int axis = 0;
+	if (centerSize.y > centerSize[axis])
+	{
+		axis = 1;
+	}
+	if (centerSize.z > centerSize[axis])
+	{
+		axis = 2;
+	}
+
+	// find the cheapest split between the bins of the longest axis
+	int split = -1;
+	if ((count > MAX_LEAF_TRIANGLES) && (centerSize[axis] > 0.0f) && (depth < g_MaxDepth))
+	{
+		glm::vec3 binMin[g_SplitBins];
+		glm::vec3 binMax[g_SplitBins];
+		int binCount[g_SplitBins];
+		for (int b = 0; b < g_SplitBins; b++)
+		{
+			binMin[b] = glm::vec3(FLT_MAX);
+			binMax[b] = glm::vec3(-FLT_MAX);
+			binCount[b] = 0;
+		}
+
+		float binScale = (float)g_SplitBins / centerSize[axis];
+		for (int i = begin; i < end; i++)
+		{
+			int b = std::min(g_SplitBins - 1, (int)((items[i].center[axis] - centerMin[axis]) * binScale));
+			binMin[b] = glm::min(binMin[b], items[i].boundsMin);
+			binMax[b] = glm::max(binMax[b], items[i].boundsMax);
+			binCount[b]++;
+		}
+
+		// the area and the count of the bins right of every split
+		float rightArea[g_SplitBins];
+		int rightCount[g_SplitBins];
+		glm::vec3 sweepMin(FLT_MAX);
+		glm::vec3 sweepMax(-FLT_MAX);
+		int sweepCount = 0;
+		for (int b = g_SplitBins - 1; b > 0; b--)
+		{
+			sweepMin = glm::min(sweepMin, binMin[b]);
+			sweepMax = glm::max(sweepMax, binMax[b]);
+			sweepCount += binCount[b];
+			rightArea[b] = HalfArea(sweepMin, sweepMax);
+			rightCount[b] = sweepCount;
+		}
+
+		float parentArea = HalfArea(boundsMin, boundsMax);
+		float bestCost = (float)count;
+		sweepMin = glm::vec3(FLT_MAX);
+		sweepMax = glm::vec3(-FLT_MAX);
+		sweepCount = 0;
+		for (int b = 0; b < g_SplitBins - 1; b++)
+		{
+			sweepMin = glm::min(sweepMin, binMin[b]);
+			sweepMax = glm::max(sweepMax, binMax[b]);
+			sweepCount += binCount[b];
+			if ((sweepCount == 0) || (rightCount[b + 1] == 0) || (parentArea <= 0.0f))
+			{
+				continue;
+			}
+
+			float cost = g_TraversalCost + ((HalfArea(sweepMin, sweepMax) * sweepCount) + (rightArea[b + 1] * rightCount[b + 1])) / parentArea;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				split = b;
+			}
+		}
+
+		// large leaves are split anyway, in the middle, so that a
+		// bad split estimate cannot leave a slow leaf behind
+		if ((split < 0) && (count > MAX_LEAF_TRIANGLES * 4))
+		{
+			split = (g_SplitBins / 2) - 1;
+		}
+
+		if (split >= 0)
+		{
+			float splitPosition = centerMin[axis] + ((float)(split + 1) / binScale);
+			BUILD_ITEM* pMiddle = std::partition(&items[begin], &items[begin] + count,
+				[axis, splitPosition](const BUILD_ITEM& item) { return item.center[axis] < splitPosition; });
+			int middle = (int)(pMiddle - &items[0]);
+			if ((middle == begin) || (middle == end))
+			{
+				split = -1;
+			}
+			else
+			{
+				BuildNode(items, begin, middle, depth + 1, triangles);
+				int secondChild = (int)m_nodes.size();
+				BuildNode(items, middle, end, depth + 1, triangles);
+				m_nodes[nodeIndex].secondChild = secondChild;
+				return;
+			}
+		}
+	}
+
+	// a leaf, its triangles are stored in the order of the leaves
+	m_nodes[nodeIndex].firstTriangle = (int)m_triangles.size();
+	m_nodes[nodeIndex].triangleCount = count;
+	for (int i = begin; i < end; i++)
+	{
+		m_triangles.push_back(triangles[items[i].triangle]);
+	}
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used to find out whether anything lies
+ *  on a ray before the passed in distance.  The traversal
+ *  stops at the first hit, since it does not matter which
+ *  triangle is the closest.
+ ***********************************************************/
+bool TriangleBVH::IsOccluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+	if (m_nodes.empty())
+	{
+		return false;
+	}
+
+	// a zero component becomes an infinite slope, which the box
+	// test handles, so it is nudged away from zero only to keep
+	// the sign
+	glm::vec3 inverseDirection;
+	for (int i = 0; i < 3; i++)
+	{
+		float d = direction[i];
+		if (fabsf(d) < 1e-20f)
+		{
+			d = (d < 0.0f) ? -1e-20f : 1e-20f;
+		}
+		inverseDirection[i] = 1.0f / d;
+	}
+
+	int stack[g_MaxDepth + 1];
+	int stackSize = 0;
+	int nodeIndex = 0;
+	for (;;)
+	{
+		const BVH_NODE& node = m_nodes[nodeIndex];
+		if (HitsBox(origin, inverseDirection, maxDistance, node.boundsMin, node.boundsMax))
+		{
+			if (node.triangleCount > 0)
+			{
+				for (int i = 0; i < node.triangleCount; i++)
+				{
+					if (HitsTriangle(origin, direction, maxDistance, m_triangles[node.firstTriangle + i]))
+					{
+						return true;
+					}
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.secondChild;
+				nodeIndex = nodeIndex + 1;
+				continue;
+			}
+		}
+
+		if (stackSize == 0)
+		{
+			return false;
+		}
+		nodeIndex = stack[--stackSize];
+	}
+}
+
+/***********************************************************
+ *  HitsBox()
+ *
+ *  This method is used to clip a ray against the slabs of
+ *  a box.
+ ***********************************************************/
+bool TriangleBVH::HitsBox(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+	glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+
+	float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float leave = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	return(enter <= leave);
+}
+
+/***********************************************************
+ *  HitsTriangle()
+ *
+ *  This method is used to intersect a ray with a triangle,
+ *  with the Moller-Trumbore test.  Both sides of the
+ *  triangle are hit, like the meshes are drawn.
+ ***********************************************************/
+bool TriangleBVH::HitsTriangle(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const BVH_TRIANGLE& triangle)
+{
+	glm::vec3 p = glm::cross(direction, triangle.edge2);
+	float determinant = glm::dot(triangle.edge1, p);
+	if (fabsf(determinant) < 1e-12f)
+	{
+		return false;
+	}
+
+	float inverseDeterminant = 1.0f / determinant;
+	glm::vec3 s = origin - triangle.corner;
+	float u = glm::dot(s, p) * inverseDeterminant;
+	if ((u < 0.0f) || (u > 1.0f))
+	{
+		return false;
+	}
+
+	glm::vec3 q = glm::cross(s, triangle.edge1);
+	float v = glm::dot(direction, q) * inverseDeterminant;
+	if ((v < 0.0f) || (u + v > 1.0f))
+	{
+		return false;
+	}
+
+	float t = glm::dot(triangle.edge2, q) * inverseDeterminant;
+	return((t > 0.0f) && (t < maxDistance));
+}
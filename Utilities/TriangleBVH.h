@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// trianglebvh.h
+// ============
+// a bounding volume hierarchy over world space triangles for casting rays
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TriangleBVH
+ *
+ *  This class contains the code for a bounding volume
+ *  hierarchy that answers ray queries against a list of
+ *  triangles.  The tree is built top down, splitting the
+ *  triangles with the surface area heuristic over a few
+ *  bins of their centers, and is kept as a flat array of
+ *  nodes where the first child of a node directly follows
+ *  it.  Once built, the tree is only read, so any number
+ *  of threads can cast rays through it at the same time.
+ ***********************************************************/
+class TriangleBVH
+{
+public:
+	// most triangles in a leaf
+	static const int MAX_LEAF_TRIANGLES = 4;
+
+	// constructor
+	TriangleBVH();
+
+	// build the tree over a list of triangles, three positions each
+	void Build(const std::vector<glm::vec3>& positions);
+
+	// true when a triangle is hit by the ray from the origin along
+	// the direction, closer than the distance - the direction does
+	// not have to be normalized, the distance is in its units
+	bool IsOccluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+
+	int GetTriangleCount() const { return (int)m_triangles.size(); }
+	int GetNodeCount() const { return (int)m_nodes.size(); }
+	int GetDepth() const { return m_depth; }
+
+private:
+	// a node is a leaf when it has triangles, otherwise its
+	// children are the next node and the node at secondChild
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		int secondChild;
+		glm::vec3 boundsMax;
+		int firstTriangle;
+		int triangleCount;
+	};
+
+	// a triangle as a corner and two edges, which is what the
+	// ray intersection uses
+	struct BVH_TRIANGLE
+	{
+		glm::vec3 corner;
+		glm::vec3 edge1;
+		glm::vec3 edge2;
+	};
+
+	// a triangle while the tree is built
+	struct BUILD_ITEM
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		glm::vec3 center;
+		int triangle;
+	};
+
+	std::vector<BVH_NODE> m_nodes;
+	std::vector<BVH_TRIANGLE> m_triangles;
+	int m_depth;
+
+	// add the node of the items [begin, end) and its children
+	void BuildNode(std::vector<BUILD_ITEM>& items, int begin, int end, int depth, const std::vector<BVH_TRIANGLE>& triangles);
+	// true when the ray enters the box before the distance
+	static bool HitsBox(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	// true when the ray hits the triangle between 0 and the distance
+	static bool HitsTriangle(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const BVH_TRIANGLE& triangle);
+};
@@ -9,21 +9,37 @@ struct Material
     float shininess;
 }; 
 
+// the members are ordered so that the std140 layout matches
+// FrameUniformBuffer::LIGHT_SOURCE on the C++ side
 struct LightSource 
 {
     vec3 position;	
+    float focalStrength;
     vec3 ambientColor;
+    float specularIntensity;
     vec3 diffuseColor;
     vec3 specularColor;
-    float focalStrength;
-    float specularIntensity;
 };
 
-#define TOTAL_LIGHTS 4
+// must match FrameUniformBuffer::TOTAL_LIGHTS on the C++ side
+#define TOTAL_LIGHTS 16
+
+// camera and light constants, updated once per frame and shared
+// by all shader programs through a single uniform buffer
+layout(std140, binding = 0) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 viewPosition;
+    int lightCount;
+    LightSource lightSources[TOTAL_LIGHTS];
+};
 
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+in vec2 fragmentLightmapCoordinate;
 
 out vec4 outFragmentColor;
 
@@ -31,14 +47,41 @@ uniform bool bUseTexture=false;
 uniform bool bUseLighting=false;
 uniform vec4 objectColor = vec4(1.0f);
 uniform sampler2D objectTexture;
-uniform vec3 viewPosition;
 uniform vec2 UVscale = vec2(1.0f, 1.0f);
-uniform LightSource lightSources[TOTAL_LIGHTS];
 uniform Material material;
+// the ambient and diffuse lighting baked by the LightmapBaker
+uniform bool bUseLightmap = false;
+uniform sampler2D lightmapTexture;
+
+// must match LightmapBaker::LIGHTMAP_RANGE on the C++ side
+#define LIGHTMAP_RANGE 2.0
+// the distance of every fragment from the first lights, drawn by
+// the ShadowMapper into one cube map per light
+uniform bool bUseShadows = false;
+// the unit must match ShadowMapper::SHADOW_TEXTURE_UNIT, a sampler
+// of another type must never share a unit with objectTexture
+layout(binding = 14) uniform samplerCubeArrayShadow shadowMaps;
+uniform int shadowLightCount = 0;
+// one over the range of the maps, and the size of a texel of
+// the maps at a distance of one from the light
+uniform vec2 shadowParameters = vec2(0.02, 0.004);
+// the light the ShadowMapper is drawing the map of, and one
+// over the range of the map
+uniform vec4 shadowLight;
 
 // function prototypes
-vec3 CalcLightSource(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection);
+vec3 CalcLightSource(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection, float shadow);
+vec3 CalcSpecular(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection);
+float CalcShadow(int index, vec3 lightNormal, vec3 vertexPosition);
 
+#ifdef SHADOW_DEPTH
+// the depth of the shadow maps is the distance from the light,
+// so one map works for all six faces of the cube
+void main()
+{
+   gl_FragDepth = length(fragmentPosition - shadowLight.xyz) * shadowLight.w;
+}
+#else
 void main()
 {
    if(bUseLighting == true)
@@ -48,10 +91,23 @@ void main()
       vec3 viewDirection = normalize(viewPosition - fragmentPosition);
       vec3 phongResult = vec3(0.0f);
 
-      for(int i = 0; i < TOTAL_LIGHTS; i++)
+      if(bUseLightmap == true)
+      {
+         // the baked lighting only lacks the part that depends
+         // on the camera
+         phongResult = texture(lightmapTexture, fragmentLightmapCoordinate).rgb * LIGHTMAP_RANGE;
+         for(int i = 0; i < lightCount; i++)
+         {
+            phongResult += CalcSpecular(lightSources[i], lightNormal, fragmentPosition, viewDirection) * CalcShadow(i, lightNormal, fragmentPosition);
+         }
+      }
+      else
       {
-         phongResult += CalcLightSource(lightSources[i], lightNormal, fragmentPosition, viewDirection); 
-      }   
+         for(int i = 0; i < lightCount; i++)
+         {
+            phongResult += CalcLightSource(lightSources[i], lightNormal, fragmentPosition, viewDirection, CalcShadow(i, lightNormal, fragmentPosition)); 
+         }   
+      }
     
       if(bUseTexture == true)
       {
@@ -75,9 +131,10 @@ void main()
       }
    }
 }
+#endif
 
 // calculates the color when using a directional light.
-vec3 CalcLightSource(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+vec3 CalcLightSource(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection, float shadow)
 {
    vec3 ambient;
    vec3 diffuse;
@@ -104,5 +161,50 @@ vec3 CalcLightSource(LightSource light, vec3 lightNormal, vec3 vertexPosition, v
    float specularComponent = pow(max(dot(viewDirection, reflectDir), 0.0), light.focalStrength);
    specular = (light.specularIntensity * material.shininess) * specularComponent * material.specularColor;
   
-   return(ambient + diffuse + specular);
+   return(ambient + (diffuse * shadow) + (specular * shadow));
+}
+
+// calculates only the specular part of a light, for the lightmapped objects
+vec3 CalcSpecular(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+   vec3 lightDirection = normalize(light.position - vertexPosition); 
+   vec3 reflectDir = reflect(-lightDirection, lightNormal);
+   float specularComponent = pow(max(dot(viewDirection, reflectDir), 0.0), light.focalStrength);
+   return((light.specularIntensity * material.shininess) * specularComponent * material.specularColor);
+}
+
+// calculates how much of a light reaches the fragment, from 0 in the
+// shadow to 1, filtered over 3 x 3 texels of the shadow map
+float CalcShadow(int index, vec3 lightNormal, vec3 vertexPosition)
+{
+   if((bUseShadows == false) || (index >= shadowLightCount))
+   {
+      return(1.0);
+   }
+
+   vec3 lightPosition = lightSources[index].position;
+   float texelSize = shadowParameters.y * length(vertexPosition - lightPosition);
+
+   // move the point off the surface, on the side of the light, so
+   // that the surface does not shadow itself between the texels
+   vec3 toLight = lightPosition - vertexPosition;
+   vec3 offsetNormal = (dot(lightNormal, toLight) < 0.0) ? -lightNormal : lightNormal;
+   vec3 direction = (vertexPosition + (offsetNormal * (texelSize * 1.5))) - lightPosition;
+   float reference = (length(direction) - texelSize) * shadowParameters.x;
+
+   // the taps are spread across the direction to the light
+   vec3 helper = (abs(direction.y) < abs(direction.x)) ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+   vec3 axisU = normalize(cross(direction, helper)) * texelSize;
+   vec3 axisV = normalize(cross(direction, axisU)) * texelSize;
+
+   float lit = 0.0;
+   for(int y = -1; y <= 1; y++)
+   {
+      for(int x = -1; x <= 1; x++)
+      {
+         vec3 tap = direction + (axisU * float(x)) + (axisV * float(y));
+         lit += texture(shadowMaps, vec4(tap, float(index)), reference);
+      }
+   }
+   return(lit / 9.0);
 }
\ No newline at end of file
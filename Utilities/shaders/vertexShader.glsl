@@ -2,19 +2,26 @@
 layout (location = 0) in vec3 inVertexPosition;
 layout (location = 1) in vec3 inVertexNormal;
 layout (location = 2) in vec2 inTextureCoordinate;
+// only set for the lightmapped mesh
+layout (location = 3) in vec2 inLightmapCoordinate;
 
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+out vec2 fragmentLightmapCoordinate;
 
+// the matrices are combined once per object on the CPU
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 modelViewProjection;
+uniform mat3 normalMatrix;
 
 void main()
 {
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = inVertexNormal;
+   vec4 vertexPosition = vec4(inVertexPosition, 1.0f);
+
+   fragmentPosition = vec3(model * vertexPosition);
+   gl_Position = modelViewProjection * vertexPosition;
+   fragmentVertexNormal = normalMatrix * inVertexNormal;
    fragmentTextureCoordinate = inTextureCoordinate;
+   fragmentLightmapCoordinate = inLightmapCoordinate;
 }
\ No newline at end of file